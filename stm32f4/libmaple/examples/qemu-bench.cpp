@@ -0,0 +1,158 @@
+// Benchmark suite for the QEMU build (make qemu-bench), also usable
+// on hardware.  Each benchmark runs a fixed number of iterations and
+// prints one line over SerialUSB:
+//
+//     bench <name> <iterations> <cycles>
+//
+// Cycles come from dwt_cycles(): the DWT counter on hardware, SysTick
+// in QEMU builds.  Under QEMU -icount the runner turns them back into
+// instruction counts.  The suite ends with "done", and QEMU builds
+// then exit through semihosting.
+
+#include <string.h>
+
+#include "wirish.h"
+#include "ring_buffer.h"
+#include "libraries/FreeRTOS/MapleFreeRTOS.h"
+#ifdef LIBMAPLE_QEMU
+#include "semihost.h"
+#endif
+
+#define COMM SerialUSB
+
+class NullPrint : public Print {
+public:
+    NullPrint() : count(0) {}
+    void write(uint8 ch) { count++; }
+    uint32 count;
+};
+
+static NullPrint nullOut;
+static uint8 rbStorage[64];
+static ring_buffer rb;
+static uint8 src[1024];
+static uint8 dst[1024];
+static xQueueHandle queue;
+volatile uint32 sink;
+
+typedef void (*benchFn)(uint32 iter);
+
+static void report(const char *name, uint32 iterations, uint32 cycles) {
+    COMM.print("bench ");
+    COMM.print(name);
+    COMM.print(' ');
+    COMM.print(iterations);
+    COMM.print(' ');
+    COMM.println(cycles);
+}
+
+static void run(const char *name, benchFn fn, uint32 iterations) {
+    uint32 start = dwt_cycles();
+    for (uint32 i = 0; i < iterations; i++) {
+        fn(i);
+    }
+    report(name, iterations, dwt_cycles() - start);
+}
+
+static void benchEmpty(uint32 i) {
+    sink = i;
+}
+
+static void benchPrintDec(uint32 i) {
+    nullOut.print(i * 2654435761U);
+}
+
+static void benchPrintHex(uint32 i) {
+    nullOut.print(i * 2654435761U, HEX);
+}
+
+static void benchPrintDouble(uint32 i) {
+    nullOut.print(i * 0.37, 2);
+}
+
+static void benchRingBuffer(uint32 i) {
+    rb_insert(&rb, (uint8)i);
+    sink = rb_remove(&rb);
+}
+
+static void benchMemcpy1k(uint32 i) {
+    memcpy(dst, src, sizeof(dst));
+}
+
+static void benchMemset1k(uint32 i) {
+    memset(dst, (uint8)i, sizeof(dst));
+}
+
+static void benchMap(uint32 i) {
+    sink = map(i & 4095, 0, 4095, 0, 65535);
+}
+
+static void benchRandom(uint32 i) {
+    sink = random(0, 1000);
+}
+
+static void benchQueue(uint32 i) {
+    uint32 v = i;
+    xQueueSend(queue, &v, 0);
+    xQueueReceive(queue, &v, 0);
+    sink = v;
+}
+
+static void benchDigitalWrite(uint32 i) {
+    digitalWrite(BOARD_LED_PIN, i & 1);
+}
+
+static void benchGpioWriteBit(uint32 i) {
+    gpio_write_bit(PIN_MAP[BOARD_LED_PIN].gpio_device,
+                   PIN_MAP[BOARD_LED_PIN].gpio_bit, i & 1);
+}
+
+static void benchFastPin(uint32 i) {
+    FastPin<BOARD_LED_PIN>::write(i & 1);
+}
+
+void setup() {
+    pinMode(BOARD_LED_PIN, OUTPUT);
+    rb_init(&rb, sizeof(rbStorage), rbStorage);
+    queue = xQueueCreate(16, sizeof(uint32));
+
+    COMM.println("qemu-bench start");
+    run("empty_loop", benchEmpty, 10000);
+    run("print_uint32_dec", benchPrintDec, 2000);
+    run("print_uint32_hex", benchPrintHex, 2000);
+    run("print_double_2", benchPrintDouble, 1000);
+    run("rb_insert_remove", benchRingBuffer, 10000);
+    run("memcpy_1k", benchMemcpy1k, 500);
+    run("memset_1k", benchMemset1k, 500);
+    run("map_adc_to_pwm", benchMap, 10000);
+    run("random_range", benchRandom, 2000);
+    run("queue_send_receive", benchQueue, 2000);
+    run("digital_write", benchDigitalWrite, 10000);
+    run("gpio_write_bit", benchGpioWriteBit, 10000);
+    run("fastpin_write", benchFastPin, 10000);
+    COMM.println("done");
+
+#ifdef LIBMAPLE_QEMU
+    semihost_exit(0);
+#endif
+}
+
+void loop() {
+    toggleLED();
+    delay(500);
+}
+
+// Force init to be called *first*, i.e. before static object allocation.
+// Otherwise, statically allocated objects that need libmaple may fail.
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+/*
+  Injected ADC conversions synchronised to PWM.
+
+  TIMER1 runs 20 kHz center-aligned PWM on PE9 (channel 1), like one
+  leg of a motor bridge.  AdcInjected samples PA1 and PA2 on ADC1 at
+  the top of every period, where the low-side current is steady,
+  triggered by channel 4's compare; the hardware subtracts the 2048
+  mid-scale offset, so the handler gets signed values.
+
+  The handler accumulates the results; every second, Serial2 shows
+  their averages and the latency from the sampling instant to the
+  handler call, which includes the two conversions (about 0.7 us at
+  15-cycle sampling) and the interrupt entry.
+
+  This code is released into the public domain.
+ */
+
+#include "wirish.h"
+#include "libraries/AdcInjected/AdcInjected.h"
+
+// 168 MHz / (2 * 4200) = 20 kHz
+#define PWM_RELOAD 4200
+
+AdcInjected currents(ADC1);
+
+volatile int32 sumA;
+volatile int32 sumB;
+volatile uint32 samples;
+
+void got_currents(const int16 *i, uint8 count) {
+    sumA += i[0];
+    sumB += i[1];
+    samples++;
+}
+
+void setup() {
+    static const uint8 pins[] = {Port2Pin('A', 1), Port2Pin('A', 2)};
+
+    Serial2.begin(115200);
+
+    pinMode(Port2Pin('E', 9), PWM);
+    timer_pause(TIMER1);
+    timer_set_prescaler(TIMER1, 0);
+    timer_set_reload(TIMER1, PWM_RELOAD);
+    TIMER1->regs.adv->CR1 |= TIMER_CR1_CKD_CMS_CENTER1;
+    timer_set_compare(TIMER1, 1, PWM_RELOAD / 4);
+    TIMER1->regs.adv->BDTR |= TIMER_BDTR_MOE;
+
+    currents.setPins(pins, 2);
+    currents.setOffset(1, 2048);
+    currents.setOffset(2, 2048);
+    currents.attachInterrupt(got_currents);
+    currents.begin(TIMER1, ADC_INJ_CC4);
+    // Counting up, just before the top
+    currents.setSamplePoint(PWM_RELOAD - 1);
+
+    timer_generate_update(TIMER1);
+    timer_resume(TIMER1);
+}
+
+void loop() {
+    delay(1000);
+
+    noInterrupts();
+    int32 a = sumA, b = sumB;
+    uint32 n = samples;
+    sumA = sumB = 0;
+    samples = 0;
+    interrupts();
+
+    if (n) {
+        Serial2.print("A=");
+        Serial2.print(a / (int32)n);
+        Serial2.print(" B=");
+        Serial2.print(b / (int32)n);
+        Serial2.print(' ');
+    }
+    currents.printStats(Serial2);
+    currents.resetStats();
+}
+
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
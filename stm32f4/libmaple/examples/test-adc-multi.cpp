@@ -0,0 +1,132 @@
+/*
+  Dual and triple ADC modes through AdcScan::beginMulti().
+
+  Two captures, switched by sending 't' or 's' on Serial2:
+
+  t: triple interleaved.  ADC1, ADC2 and ADC3 convert PA1 in turn,
+     5 ADC clocks apart, continuously: 15 clocks per conversion at
+     12 bits and 3-clock sampling, so three ADCs make one sample every
+     5 clocks.  At the 42 MHz ADC clock setupADC_F2() leaves (above
+     the 36 MHz datasheet limit) that is 8.4 MSPS; 7.2 MSPS at 36 MHz.
+     DMA mode 2 moves two results per 32-bit transfer.
+
+  s: dual simultaneous.  ADC1 converts PA1, PA2 and ADC2 PA3, PB0 at
+     the same instants, 10000 times a second off TIMER3, like phase
+     currents sampled in lockstep.  DMA mode 2 again: each 32-bit
+     transfer is one ADC1 and one ADC2 result from the same instant.
+
+  Every second, the statistics and the first samples of the latest
+  half buffer are printed on Serial2.  At 8.4 MSPS the DMA interrupt
+  comes every 30 us with this buffer; the load figure shows what it
+  costs.
+
+  This code is released into the public domain.
+ */
+
+#include "wirish.h"
+#include "libraries/AdcScan/AdcScan.h"
+
+#define HALF 256
+uint16 samples[2 * HALF] __attribute__((aligned(4)));
+const uint16 * volatile latest;
+
+AdcScan scan(ADC1);
+
+// PA1 is ADC123 channel 1
+static const uint8 scopeChannel[] = {1};
+// PA1, PA2 on ADC1; PA3, PB0 (channels 3, 8) on ADC2
+static const uint8 phaseA[] = {1, 2};
+static const uint8 phaseB[] = {3, 8};
+
+void got_samples(const uint16 *buf, uint32 count) {
+    latest = buf;
+}
+
+void startTriple(void) {
+    adc_multi_config cfg;
+
+    cfg.mode = ADC_MULTI_TRIPLE_INTERLEAVED;
+    cfg.dma = ADC_MULTI_DMA_MODE2;
+    cfg.prescaler = ADC_PRE_PCLK2_DIV_2;
+    cfg.resolution = ADC_RES_12BIT;
+    cfg.smp = ADC_SMPR_3;
+    cfg.delay = 5;
+    cfg.continuous = 1;
+    cfg.length = 1;
+    cfg.channels[0] = cfg.channels[1] = cfg.channels[2] = scopeChannel;
+    if (!scan.beginMulti(&cfg, NULL, 0)) {
+        Serial2.println("triple interleaved: bad configuration");
+    }
+}
+
+void startDual(void) {
+    adc_multi_config cfg;
+
+    cfg.mode = ADC_MULTI_DUAL_SIMULTANEOUS;
+    cfg.dma = ADC_MULTI_DMA_MODE2;
+    cfg.prescaler = ADC_PRE_PCLK2_DIV_2;
+    cfg.resolution = ADC_RES_12BIT;
+    cfg.smp = ADC_SMPR_56;
+    cfg.delay = 0;
+    cfg.continuous = 0;
+    cfg.length = 2;
+    cfg.channels[0] = phaseA;
+    cfg.channels[1] = phaseB;
+    cfg.channels[2] = NULL;
+    if (!scan.beginMulti(&cfg, TIMER3, 10000)) {
+        Serial2.println("dual simultaneous: bad configuration");
+    }
+}
+
+void setup() {
+    pinMode(Port2Pin('A', 1), INPUT_ANALOG);
+    pinMode(Port2Pin('A', 2), INPUT_ANALOG);
+    pinMode(Port2Pin('A', 3), INPUT_ANALOG);
+    pinMode(Port2Pin('B', 0), INPUT_ANALOG);
+
+    Serial2.begin(115200);
+    scan.setBuffer(samples, 2 * HALF);
+    scan.attachInterrupt(got_samples);
+    startTriple();
+}
+
+void loop() {
+    static uint32 last = 0;
+
+    if (Serial2.available()) {
+        switch (Serial2.read()) {
+        case 't':
+            startTriple();
+            break;
+        case 's':
+            startDual();
+            break;
+        }
+    }
+    if (millis() - last < 1000) {
+        return;
+    }
+    last = millis();
+    scan.printStats(Serial2);
+    const uint16 *buf = latest;
+    if (buf) {
+        for (uint8 i = 0; i < 8; i++) {
+            Serial2.print(buf[i]);
+            Serial2.print(' ');
+        }
+        Serial2.println();
+    }
+}
+
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
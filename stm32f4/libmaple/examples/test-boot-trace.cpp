@@ -0,0 +1,40 @@
+// Prints how long each startup stage took, from reset through the
+// bootloader and init() to the end of setup(). Press the button to
+// print it again.
+//
+// Build with -DBOARD_INIT_ADC=0 -DBOARD_INIT_TIMERS=0 to see the time
+// saved by configuring the ADCs and timers on first use instead.
+
+#include "wirish.h"
+
+#define COMM Serial2
+
+void setup() {
+    pinMode(BOARD_LED_PIN, OUTPUT);
+    pinMode(BOARD_BUTTON_PIN, INPUT);
+    COMM.begin(115200);
+    boot_trace_mark(BOOT_TAG('s','e','t','p'));
+    bootTraceDump(COMM);
+}
+
+void loop() {
+    if (isButtonPressed()) {
+        bootTraceDump(COMM);
+        toggleLED();
+    }
+}
+
+// Force init to be called *first*, i.e. before static object allocation.
+// Otherwise, statically allocated objects that need libmaple may fail.
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
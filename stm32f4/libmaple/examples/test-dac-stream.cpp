@@ -0,0 +1,140 @@
+/*
+  PCM playback from an SD card through DacStream.
+
+  Plays PLAY.WAV, 16-bit PCM, from the card's root directory: mono on
+  PA4, stereo on PA4 (left) and PA5 (right) through DHR12RD, at the
+  file's own sample rate off TIMER6.  The DMA interrupt only notes
+  which half has been played; loop() reads the next block from the
+  card into it, and has half a buffer's time to do so (23 ms at
+  44.1 kHz stereo).
+
+  Without a card, or without PLAY.WAV, it plays a 440 Hz hardware
+  triangle instead.  Statistics are printed on Serial2 every second.
+
+  The card is on SPI2 (PB13-15), with chip select on pin 74 as
+  Sd2Card expects.  PA5 is also SPI1's clock, so SPI1 cannot be used
+  with a stereo stream.
+
+  This code is released into the public domain.
+ */
+
+#include "wirish.h"
+#include "libraries/mapleSDfat/Sd2Card.h"
+#include "libraries/mapleSDfat/SdFat.h"
+#include "libraries/DacStream/DacStream.h"
+
+#define BUFFER 2048
+uint16 buffer[BUFFER] __attribute__((aligned(4)));
+
+HardwareSPI spi(2);
+Sd2Card card;
+SdVolume volume;
+SdFile root;
+SdFile file;
+
+DacStream *out;
+DacStream mono(DAC_STREAM_CH1);
+DacStream stereo(DAC_STREAM_DUAL);
+
+uint16 * volatile played;
+bool playing;
+
+void refill(uint16 *samples, uint32 count) {
+    // Called twice from begin(), before the first read
+    if (!playing) {
+        for (uint32 i = 0; i < count; i++) {
+            samples[i] = 2048;
+        }
+        return;
+    }
+    played = samples;
+}
+
+// Read the next count samples into dst, as 12-bit unsigned
+void readBlock(uint16 *dst, uint32 count) {
+    static int16 pcm[256];
+
+    while (count) {
+        uint32 n = count > 256 ? 256 : count;
+        int16 got = file.read(pcm, n * 2);
+        uint32 samples = got > 0 ? got / 2 : 0;
+        for (uint32 i = 0; i < samples; i++) {
+            dst[i] = (uint16)((pcm[i] + 32768) >> 4);
+        }
+        if (samples < n) {
+            // End of file: silence, and start over
+            for (uint32 i = samples; i < n; i++) {
+                dst[i] = 2048;
+            }
+            file.seekSet(44);
+        }
+        dst += n;
+        count -= n;
+    }
+}
+
+// Canonical 44-byte header: format at 20, channels 22, rate 24, bits 34
+bool openWav(uint8 *channels, uint32 *rate) {
+    uint8 header[44];
+
+    if (!card.init(&spi) || !volume.init(&card) || !root.openRoot(&volume) ||
+        !file.open(&root, "PLAY.WAV", O_READ) ||
+        file.read(header, 44) != 44) {
+        return false;
+    }
+    *channels = header[22];
+    *rate = header[24] | header[25] << 8 | (uint32)header[26] << 16;
+    return header[20] == 1 && header[34] == 16 &&
+        (*channels == 1 || *channels == 2);
+}
+
+void setup() {
+    uint8 channels;
+    uint32 rate;
+
+    Serial2.begin(115200);
+    spi.begin(SPI_9MHZ, MSBFIRST, 0);
+
+    if (!openWav(&channels, &rate)) {
+        Serial2.println("no PLAY.WAV; 440 Hz triangle");
+        // 2^(11 + 1) steps per period
+        mono.beginWave(TIMER6, 440 * 4096, DAC_WAVE_TRIANGLE, 11, 1024);
+        out = &mono;
+        return;
+    }
+    out = channels == 2 ? &stereo : &mono;
+    out->setBuffer(buffer, BUFFER);
+    out->attachRefill(refill);
+    out->begin(TIMER6, rate);
+    playing = true;
+    Serial2.print("playing ");
+    Serial2.print(rate);
+    Serial2.println(channels == 2 ? " Hz stereo" : " Hz mono");
+}
+
+void loop() {
+    static uint32 last = 0;
+
+    uint16 *half = played;
+    if (half) {
+        played = NULL;
+        readBlock(half, BUFFER / 2);
+    }
+    if (millis() - last >= 1000) {
+        last = millis();
+        out->printStats(Serial2);
+    }
+}
+
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+  DShot600 frames to four ESCs on TIMER8.
+
+  Connect the ESCs' signal inputs to PC6, PC7, PC8 and PC9, TIMER8's
+  channels 1 to 4.  REMOVE THE PROPELLERS: after two seconds of zero
+  throttle to arm them, the motors ramp slowly up to an eighth of
+  full throttle and back.
+  Frames go out at 2 kHz, all four in one DMA burst; Serial2 shows
+  the statistics every second.
+
+  This code is released into the public domain.
+ */
+
+#include "wirish.h"
+#include "libraries/DShot/DShot.h"
+
+#define MOTORS 4
+#define FRAME_MICROS 500
+#define ARM_MILLIS 2000
+#define TOP_THROTTLE 250
+
+DShot escs(TIMER8, 1, MOTORS);
+uint32 started;
+uint32 lastPrint;
+
+void setup() {
+    Serial2.begin(115200);
+    for (uint8 m = 0; m < MOTORS; m++) {
+        pinMode(Port2Pin('C', 6 + m), PWM);
+    }
+    if (!escs.begin(BITSTREAM_DSHOT600)) {
+        Serial2.println("dshot: cannot use TIMER8");
+    }
+    started = millis();
+}
+
+void loop() {
+    uint32 elapsed = millis() - started;
+    uint16 throttle = 0;
+
+    // Triangle from 0 to TOP_THROTTLE and back every 8 seconds
+    if (elapsed >= ARM_MILLIS) {
+        uint32 phase = (elapsed - ARM_MILLIS) % 8000;
+        uint32 ramp = phase < 4000 ? phase : 8000 - phase;
+        throttle = (uint16)(BITSTREAM_DSHOT_MIN_THROTTLE +
+                            ramp * TOP_THROTTLE / 4000);
+    }
+    for (uint8 m = 0; m < MOTORS; m++) {
+        escs.write(m, throttle);
+    }
+    escs.update();
+    delayMicroseconds(FRAME_MICROS);
+
+    if (millis() - lastPrint >= 1000) {
+        lastPrint = millis();
+        escs.printStats(Serial2);
+    }
+}
+
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Exercises the DWT cycle-counter timing functions: checks delay
+// accuracy against the cycle counter, compares micros() with millis(),
+// and profiles a few code sections. Results go out Serial2.
+
+#include "wirish.h"
+
+#define COMM Serial2
+
+ProfileSection microsSection("micros");
+ProfileSection nanosSection("nanos");
+ProfileSection delay10Section("delay 10us");
+ProfileSection mathSection("1k mults");
+
+volatile uint32 sink;
+
+void setup() {
+    pinMode(BOARD_LED_PIN, OUTPUT);
+    COMM.begin(115200);
+}
+
+void loop() {
+    for (int i = 0; i < 100; i++) {
+        {
+            ProfileScope p(microsSection);
+            sink = micros();
+        }
+        {
+            ProfileScope p(nanosSection);
+            sink = (uint32)nanos();
+        }
+        {
+            ProfileScope p(delay10Section);
+            delayMicroseconds(10);
+        }
+        {
+            ProfileScope p(mathSection);
+            uint32 x = i;
+            for (int j = 0; j < 1000; j++) {
+                x = x * 1664525 + 1013904223;
+            }
+            sink = x;
+        }
+    }
+
+    uint32 ms0 = millis();
+    uint32 us0 = micros();
+    delay(100);
+    COMM.print("delay(100): millis ");
+    COMM.print(millis() - ms0);
+    COMM.print(", micros ");
+    COMM.println(micros() - us0);
+
+    profileDump(COMM);
+    profileReset();
+    COMM.println();
+    toggleLED();
+    delay(1000);
+}
+
+// Force init to be called *first*, i.e. before static object allocation.
+// Otherwise, statically allocated objects that need libmaple may fail.
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+  Quadrature encoder decoding in TIMER3's encoder mode.
+
+  Connect the encoder's A and B outputs to PB4 and PB5, TIMER3's
+  channel 1 and 2 inputs, and its index (Z) output, if it has one, to
+  PB6.  Every 100 ms Serial2 shows the position in quadrature counts,
+  the index pulses seen and the velocity in counts per second.
+
+  The timer counts every edge of both inputs in hardware, so no
+  interrupt is taken per count.  The 16-bit counter is extended to 32
+  bits with two compare interrupts per 16384 counts, and the position
+  is reset to zero on every index pulse.
+
+  This code is released into the public domain.
+ */
+
+#include "wirish.h"
+#include "libraries/QuadratureEncoder/QuadratureEncoder.h"
+
+#define INDEX_PIN Port2Pin('B', 6)
+
+QuadratureEncoder encoder(TIMER3);
+
+void setup() {
+    Serial2.begin(115200);
+
+    // PB4 and PB5 are already on TIMER3's alternate function
+    gpio_set_mode(GPIOB, 4, GPIO_AF_INPUT_PD);
+    gpio_set_mode(GPIOB, 5, GPIO_AF_INPUT_PD);
+    pinMode(INDEX_PIN, INPUT_PULLDOWN);
+
+    // Filter 3 ignores glitches shorter than 8 timer clocks
+    encoder.begin(TIMER_ENCODER_TI12, 3);
+    encoder.attachIndex(INDEX_PIN, RISING);
+}
+
+void loop() {
+    delay(100);
+    Serial2.print("pos=");
+    Serial2.print(encoder.read());
+    Serial2.print(" index=");
+    Serial2.print(encoder.getIndexCount());
+    Serial2.print(" velocity=");
+    Serial2.print(encoder.getVelocity(100000));
+    Serial2.println();
+}
+
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+// GPIO toggle benchmark: times 1000 writes of BOARD_LED_PIN through
+// digitalWrite(), gpio_write_bit(), a raw BSRR store and FastPin<>,
+// and checks that FastPin and FastPort leave the pin in the state
+// asked for.  Cycles per write go out Serial2.
+
+#include "wirish.h"
+
+#define COMM Serial2
+#define WRITES 1000
+
+typedef FastPin<BOARD_LED_PIN> led;
+
+static gpio_dev *ledDev;
+static uint8 ledBit;
+
+static void report(const char *name, uint32 cycles) {
+    COMM.print(name);
+    COMM.print(": ");
+    COMM.print(cycles / WRITES);
+    COMM.print('.');
+    COMM.print((cycles % WRITES) / (WRITES / 10));
+    COMM.println(" cycles/write");
+}
+
+static void benchDigitalWrite(void) {
+    uint32 start = dwt_cycles();
+    for (int i = 0; i < WRITES; i += 2) {
+        digitalWrite(BOARD_LED_PIN, HIGH);
+        digitalWrite(BOARD_LED_PIN, LOW);
+    }
+    report("digitalWrite", dwt_cycles() - start);
+}
+
+static void benchGpioWriteBit(void) {
+    uint32 start = dwt_cycles();
+    for (int i = 0; i < WRITES; i += 2) {
+        gpio_write_bit(ledDev, ledBit, 1);
+        gpio_write_bit(ledDev, ledBit, 0);
+    }
+    report("gpio_write_bit", dwt_cycles() - start);
+}
+
+static void benchRawBsrr(void) {
+    __io uint32 *bsrr = fastpin_bsrr(ledDev->regs);
+    uint32 mask = BIT(ledBit);
+    uint32 start = dwt_cycles();
+    for (int i = 0; i < WRITES; i += 2) {
+        *bsrr = mask;
+        *bsrr = mask << 16;
+    }
+    report("raw BSRR", dwt_cycles() - start);
+}
+
+static void benchFastPin(void) {
+    uint32 start = dwt_cycles();
+    for (int i = 0; i < WRITES; i += 2) {
+        led::high();
+        led::low();
+    }
+    report("FastPin", dwt_cycles() - start);
+}
+
+static void benchFastPinToggle(void) {
+    uint32 start = dwt_cycles();
+    for (int i = 0; i < WRITES; i++) {
+        led::toggle();
+    }
+    report("FastPin::toggle", dwt_cycles() - start);
+}
+
+static void check(const char *what, uint32 expected) {
+    uint32 odr = (led::regs()->ODR & led::mask()) ? 1 : 0;
+    if (odr != expected) {
+        COMM.print("FAIL ");
+        COMM.println(what);
+    }
+}
+
+void setup() {
+    pinMode(BOARD_LED_PIN, OUTPUT);
+    COMM.begin(115200);
+    ledDev = PIN_MAP[BOARD_LED_PIN].gpio_device;
+    ledBit = PIN_MAP[BOARD_LED_PIN].gpio_bit;
+    if (led::regs() != ledDev->regs || led::mask() != BIT(ledBit)) {
+        COMM.println("FAIL FastPin table does not match PIN_MAP");
+    }
+}
+
+void loop() {
+    led::high();
+    check("high", 1);
+    led::write(0);
+    check("write(0)", 0);
+    led::toggle();
+    check("toggle", 1);
+    FastPin<BOARD_LED_PIN>::low();
+    check("low", 0);
+
+    benchDigitalWrite();
+    benchGpioWriteBit();
+    benchRawBsrr();
+    benchFastPin();
+    benchFastPinToggle();
+    COMM.println();
+    delay(1000);
+}
+
+// Force init to be called *first*, i.e. before static object allocation.
+// Otherwise, statically allocated objects that need libmaple may fail.
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+  Frequency and duty measurement with timer input capture.
+
+  TIMER1 makes a 10 kHz, 25% duty PWM signal on PE9.  Connect PE9 to
+  PB4, TIMER3's channel 1 input.
+
+  Every second the measurement switches between the two ways
+  InputCapture works, and Serial2 shows the results:
+
+  - Ring mode: each rising edge's timestamp goes into a ring by DMA;
+    the frequency is averaged over the newest 32 periods.  The timer
+    is prescaled by 8 so those 3.2 ms fit in one wrap of its 16-bit
+    counter.
+
+  - PWM input mode: the timer latches each period and pulse width, so
+    the duty is measured too.
+
+  Neither takes an interrupt per edge; ring mode takes one per trip
+  round the ring.
+
+  This code is released into the public domain.
+ */
+
+#include "wirish.h"
+#include "libraries/InputCapture/InputCapture.h"
+
+// 168 MHz / 16800 = 10 kHz
+#define PWM_RELOAD 16800
+
+static uint32 ring[64];
+InputCapture probe(TIMER3, 1);
+bool pwmMode;
+
+void setup() {
+    Serial2.begin(115200);
+
+    pinMode(Port2Pin('E', 9), PWM);
+    timer_pause(TIMER1);
+    timer_set_prescaler(TIMER1, 0);
+    timer_set_reload(TIMER1, PWM_RELOAD - 1);
+    timer_set_compare(TIMER1, 1, PWM_RELOAD / 4);
+    TIMER1->regs.adv->BDTR |= TIMER_BDTR_MOE;
+    timer_generate_update(TIMER1);
+    timer_resume(TIMER1);
+
+    // PB4 is already on TIMER3's alternate function
+    gpio_set_mode(GPIOB, 4, GPIO_AF_INPUT_PD);
+    probe.setBuffer(ring, 64);
+}
+
+void loop() {
+    if (pwmMode) {
+        probe.beginPwm(1000);
+    } else {
+        probe.begin(TIMER_IC_RISING, TIMER_IC_DIV1, 2, 8);
+    }
+    delay(1000);
+
+    Serial2.print(pwmMode ? "pwm:  freq=" : "ring: freq=");
+    Serial2.print(probe.getFrequency(32));
+    if (pwmMode) {
+        Serial2.print(" duty=");
+        Serial2.print(probe.getDuty());
+    } else {
+        Serial2.print(" captures=");
+        Serial2.print(probe.getCaptures());
+    }
+    Serial2.println();
+    probe.end();
+    pwmMode = !pwmMode;
+}
+
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
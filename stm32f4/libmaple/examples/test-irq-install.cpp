@@ -0,0 +1,94 @@
+// Interrupt entry latency with and without libmaple's dispatch.
+//
+// Raises the TIMER4 update interrupt from software (EGR.UG) and times
+// the cycles from that write to the handler's first statement, first
+// through timer_attach_interrupt() and the __irq_tim4 dispatcher,
+// then with nvic_install_handler() pointing the vector straight at
+// the handler. Min/avg/max go out Serial2; they include one DWT
+// counter read.
+
+#include "wirish.h"
+
+#define COMM Serial2
+#define RUNS 1000
+
+static volatile uint32 entered;
+static volatile uint32 hits;
+
+static void dispatched(void) {
+    entered = dwt_cycles();
+    hits++;
+}
+
+static void direct(void) {
+    entered = dwt_cycles();
+    // The dispatcher isn't here to clear the flag for us.
+    TIMER4->regs.gen->SR = ~TIMER_SR_UIF;
+    hits++;
+}
+
+static void measure(const char *name) {
+    uint32 min = 0xFFFFFFFF;
+    uint32 max = 0;
+    uint32 total = 0;
+
+    for (int i = 0; i < RUNS; i++) {
+        uint32 before = hits;
+        uint32 start = dwt_cycles();
+        timer_generate_update(TIMER4);
+        while (hits == before)
+            ;
+        uint32 latency = entered - start;
+        total += latency;
+        if (latency < min) {
+            min = latency;
+        }
+        if (latency > max) {
+            max = latency;
+        }
+    }
+
+    COMM.print(name);
+    COMM.print(": min ");
+    COMM.print(min);
+    COMM.print(" avg ");
+    COMM.print(total / RUNS);
+    COMM.print(" max ");
+    COMM.print(max);
+    COMM.println(" cycles");
+}
+
+void setup() {
+    pinMode(BOARD_LED_PIN, OUTPUT);
+    COMM.begin(115200);
+
+    timer_pause(TIMER4);
+    timer_attach_interrupt(TIMER4, TIMER_UPDATE_INTERRUPT, dispatched);
+}
+
+void loop() {
+    nvic_remove_handler(NVIC_TIMER4);
+    measure("timer_attach_interrupt");
+
+    nvic_install_handler(NVIC_TIMER4, direct);
+    measure("nvic_install_handler  ");
+
+    COMM.println();
+    toggleLED();
+    delay(1000);
+}
+
+// Force init to be called *first*, i.e. before static object allocation.
+// Otherwise, statically allocated objects that need libmaple may fail.
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Interrupt latency and jitter per NVIC priority, with the
+// IrqLatency library.
+//
+// Wire D20/PB4 (TIMER3 CH1) to D21/PB5 (TIMER3 CH2, EXTI line 5).
+// Each trigger source -- software pend, compare match, EXTI from the
+// compare output, input capture of it -- is measured at several
+// priorities, first bare metal with a busy TIMER4 interrupt at
+// priority NOISE_PRIORITY, then from a FreeRTOS task that keeps
+// entering short critical sections.  Priorities 11-15 are masked by
+// those (configMAX_SYSCALL_INTERRUPT_PRIORITY), which shows as a tail
+// up to CRITICAL_CYCLES long.
+//
+// Each result is a histogram in cycles plus a line
+//
+//     bench irq_latency_<source>_p<priority> <samples> <total cycles>
+//
+// for support/scripts/qemu-bench.py.  QEMU builds have neither the
+// pins nor a DWT, so they only run the software source, and exit
+// through semihosting after "done".
+
+#include "wirish.h"
+#include "libraries/FreeRTOS/MapleFreeRTOS.h"
+#include "libraries/IrqLatency/IrqLatency.h"
+#ifdef LIBMAPLE_QEMU
+#include "semihost.h"
+#endif
+
+#define COMM SerialUSB
+
+#define OUT_PIN 20
+#define IN_PIN 21
+#define SOFTWARE_IRQ NVIC_EXTI4
+#define SAMPLES 1000
+#define NOISE_PRIORITY 6
+#define NOISE_CYCLES 500
+#define CRITICAL_CYCLES 1000
+
+static const uint8 priorities[] = {0, 4, 8, 10, 11, 12, 15};
+
+static IrqLatency lat;
+static LatencyHistogram hist(4);
+static HardwareTimer noise(4);
+static char label[24];
+
+static void noiseIsr(void) {
+    dwt_delay_cycles(NOISE_CYCLES);
+}
+
+static void criticalLoad(void) {
+    taskENTER_CRITICAL();
+    uint32 start = dwt_cycles();
+    while (dwt_cycles() - start < CRITICAL_CYCLES) {
+        lat.poll();
+    }
+    taskEXIT_CRITICAL();
+}
+
+static void makeLabel(const char *prefix, const char *source, uint8 prio) {
+    char *p = label;
+    while (*prefix) {
+        *p++ = *prefix++;
+    }
+    while (*source) {
+        *p++ = *source++;
+    }
+    *p++ = '_';
+    *p++ = 'p';
+    if (prio >= 10) {
+        *p++ = '0' + prio / 10;
+    }
+    *p++ = '0' + prio % 10;
+    *p = '\0';
+}
+
+static bool begin(const char *source) {
+    switch (source[0]) {
+    case 's':
+        lat.beginSoftware(SOFTWARE_IRQ);
+        return true;
+    case 'c':
+        return source[1] == 'm' ? lat.beginCompare(OUT_PIN)
+                                : lat.beginCapture(OUT_PIN, IN_PIN);
+    case 'e':
+        return lat.beginExti(OUT_PIN, IN_PIN);
+    }
+    return false;
+}
+
+static void sweep(const char *prefix, const char *source, voidFuncPtr load) {
+    if (!begin(source)) {
+        COMM.print("# ");
+        COMM.print(source);
+        COMM.println(": no timer channel on the pins");
+        return;
+    }
+    for (uint8 i = 0; i < sizeof(priorities); i++) {
+        makeLabel(prefix, source, priorities[i]);
+        lat.setPriority(priorities[i]);
+        hist.reset();
+        uint32 n = lat.measure(hist, SAMPLES, load);
+        if (n < SAMPLES) {
+            COMM.print("# ");
+            COMM.print(label);
+            COMM.println(": timed out, check the wire");
+        }
+        hist.dump(COMM, label);
+        COMM.print("bench irq_latency_");
+        COMM.print(label);
+        COMM.print(' ');
+        COMM.print(hist.getSamples());
+        COMM.print(' ');
+        COMM.println(hist.getMean() * hist.getSamples());
+    }
+    lat.end();
+}
+
+static void sweepAll(const char *prefix, voidFuncPtr load) {
+    sweep(prefix, "sw", load);
+#ifndef LIBMAPLE_QEMU
+    sweep(prefix, "cmp", load);
+    sweep(prefix, "exti", load);
+    sweep(prefix, "cap", load);
+#endif
+}
+
+static void rtosTask(void *pvParameters) {
+    sweepAll("rtos_", criticalLoad);
+    COMM.println("done");
+#ifdef LIBMAPLE_QEMU
+    semihost_exit(0);
+#endif
+    for (;;) {
+        vTaskDelay(1000);
+        toggleLED();
+    }
+}
+
+void setup() {
+    pinMode(BOARD_LED_PIN, OUTPUT);
+
+#ifndef LIBMAPLE_QEMU
+    noise.pause();
+    noise.setPeriod(50);
+    noise.setMode(TIMER_CH1, TIMER_OUTPUT_COMPARE);
+    noise.setCompare(TIMER_CH1, 1);
+    noise.attachCompare1Interrupt(noiseIsr);
+    nvic_irq_set_priority(NVIC_TIMER4, NOISE_PRIORITY);
+    noise.refresh();
+    noise.resume();
+#endif
+    sweepAll("", NULL);
+    noise.pause();
+
+    xTaskCreate(rtosTask,
+                (signed portCHAR *)"Latency",
+                configMINIMAL_STACK_SIZE * 4,
+                NULL,
+                tskIDLE_PRIORITY + 2,
+                NULL);
+    vTaskStartScheduler();
+}
+
+void loop() {
+}
+
+// Force init to be called *first*, i.e. before static object allocation.
+// Otherwise, statically allocated objects that need libmaple may fail.
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+/*
+  Three-phase complementary PWM on TIMER1 with dead time and break.
+
+  TIMER1 drives a half-bridge per phase at 20 kHz, center-aligned,
+  with 500 ns of dead time between each high side (PE9, PE11, PE13)
+  and its low side (PE8, PE10, PE12).  Pulling PE15 (BKIN) high turns
+  every output off in hardware; typing 'r' on Serial2 turns them back
+  on, 's' stops them from software.
+
+  The duty cycles rotate through a slow sine-like pattern, all three
+  changing on the same PWM period.  Every second Serial2 shows the
+  break count and the latency from setDuty() to the update that put
+  the new duties on the pins, in CPU cycles.
+
+  Scope the high and low sides of a phase together to see the dead
+  time.  Leave the bridge unpowered while trying this out.
+
+  This code is released into the public domain.
+ */
+
+#include "wirish.h"
+#include "libraries/MotorPwm/MotorPwm.h"
+
+MotorPwm bridge(TIMER1);
+
+static const uint8 wave[12] = {
+    50, 75, 93, 100, 93, 75, 50, 25, 7, 0, 7, 25,
+};
+
+static void onBreak(void) {
+    Serial2.println("break");
+}
+
+void setup() {
+    Serial2.begin(115200);
+
+    // The board only routes TIMER1's main outputs; add CHxN and BKIN
+    for (uint8 pin = 8; pin <= 12; pin += 2) {
+        gpio_set_mode(GPIOE, pin, GPIO_AF_OUTPUT_PP);
+        gpio_set_af_mode(GPIOE, pin, 1);
+    }
+    gpio_set_mode(GPIOE, 15, GPIO_AF_INPUT_PD);
+    gpio_set_af_mode(GPIOE, 15, 1);
+
+    if (!bridge.begin(20000, 500)) {
+        Serial2.println("begin failed");
+        return;
+    }
+    bridge.enableBreak(true);
+    bridge.attachBreak(onBreak);
+    bridge.measureLatency(true);
+    bridge.enableOutputs();
+}
+
+void loop() {
+    static uint8 step;
+    uint32 period = bridge.getPeriod();
+
+    for (uint8 i = 0; i < 100; i++) {
+        bridge.setDuty(period * wave[step % 12] / 100,
+                       period * wave[(step + 4) % 12] / 100,
+                       period * wave[(step + 8) % 12] / 100);
+        step++;
+        delay(10);
+    }
+
+    while (Serial2.available()) {
+        switch (Serial2.read()) {
+        case 'r':
+            bridge.enableOutputs();
+            break;
+        case 's':
+            bridge.emergencyStop();
+            break;
+        }
+    }
+    Serial2.print(bridge.outputsEnabled() ? "on  " : "off ");
+    bridge.printStats(Serial2);
+}
+
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
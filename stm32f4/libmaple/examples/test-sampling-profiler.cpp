@@ -0,0 +1,66 @@
+// Samples the program counter with timer 4 while running two
+// workloads of different cost, and dumps the histogram out Serial2
+// every few seconds.  Capture the output into a file and resolve it
+// with:
+//
+//     support/scripts/profsym.py build/discovery_f4.elf capture.txt
+
+#include "wirish.h"
+#include "libraries/SamplingProfiler/SamplingProfiler.h"
+
+#define COMM Serial2
+
+SamplingProfiler profiler(4);
+
+volatile uint32 sink;
+
+// About three quarters of the samples should land here...
+void __attribute__((noinline)) heavyWork(void) {
+    uint32 x = sink;
+    for (int i = 0; i < 3000; i++) {
+        x = x * 1664525 + 1013904223;
+    }
+    sink = x;
+}
+
+// ...and about one quarter here.
+void __attribute__((noinline)) lightWork(void) {
+    uint32 x = sink;
+    for (int i = 0; i < 1000; i++) {
+        x = (x >> 3) ^ (x << 7) ^ i;
+    }
+    sink = x;
+}
+
+void setup() {
+    pinMode(BOARD_LED_PIN, OUTPUT);
+    COMM.begin(115200);
+    profiler.begin(100);
+}
+
+void loop() {
+    uint32 start = millis();
+    while (millis() - start < 3000) {
+        heavyWork();
+        lightWork();
+    }
+
+    profiler.dump(COMM);
+    profiler.reset();
+    toggleLED();
+}
+
+// Force init to be called *first*, i.e. before static object allocation.
+// Otherwise, statically allocated objects that need libmaple may fail.
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+// SoftTimer demo and cost check.
+//
+// Runs NR_TIMERS periodic SoftTimers with periods from 1 to 4 s next
+// to an LED blinker, and once a second prints how many handlers ran
+// and the cycles one stop()+start() pair took on the busy wheel.
+// Set TICKLESS to 1 to drive the wheel from TIMER2 instead of
+// SysTick.
+
+#include "wirish.h"
+
+#define COMM Serial2
+#define NR_TIMERS 500
+#define TICKLESS 0
+
+static volatile uint32 calls;
+
+static void count(void) {
+    calls++;
+}
+
+static void blink(void) {
+    toggleLED();
+}
+
+static SoftTimer timers[NR_TIMERS];
+static SoftTimer blinker(blink);
+static HardwareTimer tickTimer(2);
+
+void setup() {
+    pinMode(BOARD_LED_PIN, OUTPUT);
+    COMM.begin(115200);
+
+#if TICKLESS
+    SoftTimer::beginTickless(tickTimer);
+#endif
+    blinker.start(250, 250);
+
+    for (int i = 0; i < NR_TIMERS; i++) {
+        timers[i].attachInterrupt(count);
+        timers[i].start(1 + i, 1000 + 3 * i);
+    }
+}
+
+void loop() {
+    static uint32 next = 1000;
+    static int victim;
+
+    if (SoftTimer::now() < next) {
+        return;
+    }
+    next += 1000;
+
+    uint32 start = dwt_cycles();
+    timers[victim].stop();
+    timers[victim].start(1 + victim, 1000 + 3 * victim);
+    uint32 cycles = dwt_cycles() - start;
+    victim = (victim + 1) % NR_TIMERS;
+
+    COMM.print("t=");
+    COMM.print(SoftTimer::now());
+    COMM.print(" ms  handlers ");
+    COMM.print(calls);
+    COMM.print("  restart ");
+    COMM.print(cycles);
+    COMM.println(" cycles");
+}
+
+// Force init to be called *first*, i.e. before static object allocation.
+// Otherwise, statically allocated objects that need libmaple may fail.
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
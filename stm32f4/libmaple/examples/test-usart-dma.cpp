@@ -2,13 +2,18 @@
  * @file test-usart-dma.cpp
  * @author Marti Bolivar <mbolivar@leaflabs.com>
  *
- * Simple test of DMA used with a USART receiver.
+ * Simple test of DMA used with a USART receiver, driven by the
+ * event loop.
  *
  * Configures a USART receiver for use with DMA.  Received bytes are
  * placed into a buffer, with an interrupt firing when the buffer is
- * full.  At that point, the USART transmitter will print the contents
- * of the byte buffer.  The buffer is continually filled and refilled
- * in this manner.
+ * full.  The interrupt only posts an event; the event loop then has
+ * the USART transmitter print the contents of the byte buffer.  The
+ * buffer is continually filled and refilled in this manner.
+ *
+ * A software timer posts a status event every STATUS_MS, which blinks
+ * the LED and prints the DMA registers and the event loop's latency
+ * and load figures.  Between events the core sleeps.
  *
  * This example isn't very robust; don't use it in production.  In
  * particular, since the buffer keeps filling (DMA_CIRC_MODE is set),
@@ -26,63 +31,100 @@
 #include "wirish.h"
 
 #define BAUD 9600
+#define STATUS_MS 100
 
 #define USART USART2
 #define USART_HWSER Serial2
 #define USART_DMA_DEV DMA1
+#ifdef STM32F2
+#define USART_RX_DMA_STREAM DMA_STREAM5
+#define USART_RX_DMA_CHANNEL DMA_CH4
+#else
 #define USART_RX_DMA_CHANNEL DMA_CH6
+#endif
 #define USART_TX BOARD_USART2_TX_PIN
 #define USART_RX BOARD_USART2_RX_PIN
 
 #define BUF_SIZE 8
 uint8 rx_buf[BUF_SIZE];
 
-dma_irq_cause irq_cause;
-
-volatile uint32 irq_fired = 0;
+SoftTimer status_timer;
 
 void init_usart(void);
 void init_dma_xfer(void);
 void rx_dma_irq(void);
+void status_tick(void);
+void print_buffer(uint32 irq_count);
+void print_status(uint32 now);
 
 void setup(void) {
     pinMode(BOARD_LED_PIN, OUTPUT);
 
     init_dma_xfer();
     init_usart();
+
+    SoftTimer::begin();
+    status_timer.attachInterrupt(status_tick);
+    status_timer.start(STATUS_MS, STATUS_MS);
 }
 
 void loop(void) {
-    toggleLED();
-    delay(100);
+    Events.run();
+}
 
-    dma_channel_reg_map *ch_regs = dma_channel_regs(USART_DMA_DEV,
-                                                    USART_RX_DMA_CHANNEL);
-    if (irq_fired) {
-        USART_HWSER.println("** IRQ **");
-        irq_fired = 0;
-    }
-    USART_HWSER.print("[");
-    USART_HWSER.print(millis());
-    USART_HWSER.print("]\tISR bits: 0x");
-    uint8 isr_bits = dma_get_isr_bits(USART_DMA_DEV, USART_RX_DMA_CHANNEL);
-    USART_HWSER.print(isr_bits, HEX);
-    USART_HWSER.print("\tCCR: 0x");
-    USART_HWSER.print(ch_regs->CCR, HEX);
-    USART_HWSER.print("\tCNDTR: 0x");
-    USART_HWSER.print(ch_regs->CNDTR, HEX);
-    USART_HWSER.print("\tBuffer contents: ");
-     for (int i = 0; i < BUF_SIZE; i++) {
+/*
+ * Interrupt side: post and return
+ */
+
+void rx_dma_irq(void) {
+    static uint32 irq_count;
+    Events.post(print_buffer, ++irq_count);
+}
+
+void status_tick(void) {
+    Events.post(print_status, millis());
+}
+
+/*
+ * Event handlers, called from loop()
+ */
+
+void print_buffer(uint32 irq_count) {
+    USART_HWSER.print("** IRQ ");
+    USART_HWSER.print(irq_count);
+    USART_HWSER.print(" **\tBuffer contents: ");
+    for (int i = 0; i < BUF_SIZE; i++) {
         USART_HWSER.print('\'');
         USART_HWSER.print(rx_buf[i]);
         USART_HWSER.print('\'');
         if (i < BUF_SIZE - 1) USART_HWSER.print(", ");
     }
     USART_HWSER.println();
-    if (isr_bits == 0x7) {
-        USART_HWSER.println("** Clearing ISR bits.");
-        dma_clear_isr_bits(USART_DMA_DEV, USART_RX_DMA_CHANNEL);
-    }
+}
+
+void print_status(uint32 now) {
+    toggleLED();
+
+    USART_HWSER.print("[");
+    USART_HWSER.print(now);
+#ifdef STM32F2
+    dma_stream_reg_map *regs = dma_stream_regs(USART_DMA_DEV,
+                                               USART_RX_DMA_STREAM);
+    USART_HWSER.print("]\tCR: 0x");
+    USART_HWSER.print(regs->CR, HEX);
+    USART_HWSER.print("\tNDTR: 0x");
+    USART_HWSER.print(regs->NDTR, HEX);
+#else
+    dma_channel_reg_map *regs = dma_channel_regs(USART_DMA_DEV,
+                                                 USART_RX_DMA_CHANNEL);
+    USART_HWSER.print("]\tCCR: 0x");
+    USART_HWSER.print(regs->CCR, HEX);
+    USART_HWSER.print("\tCNDTR: 0x");
+    USART_HWSER.print(regs->CNDTR, HEX);
+#endif
+    USART_HWSER.print('\t');
+    Events.printStats(USART_HWSER);
+    Events.resetStats();
 }
 
 /* Configure USART receiver for use with DMA */
@@ -94,6 +136,16 @@ void init_usart(void) {
 /* Configure DMA transmission */
 void init_dma_xfer(void) {
     dma_init(USART_DMA_DEV);
+#ifdef STM32F2
+    dma_setup_transfer(USART_DMA_DEV, USART_RX_DMA_STREAM,
+                       USART_RX_DMA_CHANNEL,
+                       &USART->regs->DR, DMA_SIZE_8BITS,
+                       rx_buf,           DMA_SIZE_8BITS,
+                       (DMA_MINC_MODE | DMA_CIRC_MODE | DMA_TRNS_CMPLT));
+    dma_set_num_transfers(USART_DMA_DEV, USART_RX_DMA_STREAM, BUF_SIZE);
+    dma_attach_interrupt(USART_DMA_DEV, USART_RX_DMA_STREAM, rx_dma_irq);
+    dma_enable(USART_DMA_DEV, USART_RX_DMA_STREAM);
+#else
     dma_setup_transfer(USART_DMA_DEV, USART_RX_DMA_CHANNEL,
                        &USART->regs->DR, DMA_SIZE_8BITS,
                        rx_buf,           DMA_SIZE_8BITS,
@@ -101,10 +153,7 @@ void init_dma_xfer(void) {
     dma_set_num_transfers(USART_DMA_DEV, USART_RX_DMA_CHANNEL, BUF_SIZE);
     dma_attach_interrupt(USART_DMA_DEV, USART_RX_DMA_CHANNEL, rx_dma_irq);
     dma_enable(USART_DMA_DEV, USART_RX_DMA_CHANNEL);
-}
-
-void rx_dma_irq(void) {
-    irq_fired = true;
+#endif
 }
 
 // Force init to be called *first*, i.e. before static object allocation.
@@ -0,0 +1,71 @@
+/*
+  A rainbow running along a WS2812 LED string.
+
+  Connect the string's data input to PB4, TIMER3's channel 1, through
+  a 3.3 V to 5 V level shifter if the string needs one.  The frame is
+  sent by DMA, so loop() carries on while the LEDs update; Serial2
+  shows the statistics every second.
+
+  This code is released into the public domain.
+ */
+
+#include "wirish.h"
+#include "libraries/WS2812/WS2812.h"
+
+#define LEDS 60
+
+static uint8 pixels[3 * LEDS];
+WS2812 strip(TIMER3, 1, pixels, LEDS);
+uint8 hue;
+uint32 lastPrint;
+
+// Hue 0..255 round the colour wheel
+static void wheel(uint16 led, uint8 h) {
+    uint8 up = (uint8)((h % 85) * 3);
+    uint8 down = (uint8)(255 - up);
+
+    if (h < 85) {
+        strip.setPixel(led, down, up, 0);
+    } else if (h < 170) {
+        strip.setPixel(led, 0, down, up);
+    } else {
+        strip.setPixel(led, up, 0, down);
+    }
+}
+
+void setup() {
+    Serial2.begin(115200);
+    pinMode(Port2Pin('B', 4), PWM);
+    if (!strip.begin()) {
+        Serial2.println("ws2812: cannot use TIMER3");
+    }
+}
+
+void loop() {
+    while (strip.busy())
+        ;
+    for (uint16 led = 0; led < LEDS; led++) {
+        wheel(led, (uint8)(hue + led * 256 / LEDS));
+    }
+    strip.show();
+    hue++;
+    delay(10);
+
+    if (millis() - lastPrint >= 1000) {
+        lastPrint = millis();
+        strip.printStats(Serial2);
+    }
+}
+
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
@@ -16,8 +16,8 @@
     D6 via ~200ohms to VGA Red     (1)
     D7 via ~200ohms to VGA Green   (2)
     D8 via ~200ohms to VGA Blue    (3)
-    D11 to VGA VSync               (14)  (swapped?)
-    D12 to VGA HSync               (13)  (swapped?)
+    D12 to VGA VSync               (14)
+    D11 to VGA HSync               (13)
     GND to VGA Ground              (5)
     GND to VGA Sync Ground         (10)
 
@@ -34,41 +34,38 @@
 
 #include "wirish.h"
 
-// Pinouts -- you also must change the GPIO macros below if you change
-// these
-#define VGA_R 6     // STM32: A8
-#define VGA_G 7     // STM32: A9
-#define VGA_B 8     // STM32: A10
-#define VGA_V 11    // STM32: A6
-#define VGA_H 12    // STM32: A7
-
-// These low level (and STM32 specific) macros make GPIO writes much
-// faster
-#define ABSRR ((volatile uint32*)0x40010810)
-#define ABRR  ((volatile uint32*)0x40010814)
-
-#define RBIT 8                  // (see pinouts)
-#define GBIT 9
-#define BBIT 10
-
-#define VGA_R_HIGH *ABSRR = BIT(RBIT)
-#define VGA_R_LOW  *ABRR  = BIT(RBIT)
-#define VGA_G_HIGH *ABSRR = BIT(GBIT)
-#define VGA_G_LOW  *ABRR  = BIT(GBIT)
-#define VGA_B_HIGH *ABSRR = BIT(BBIT)
-#define VGA_B_LOW  *ABRR  = BIT(BBIT)
-
-#define ON_COLOR   BIT(RBIT)
-#define OFF_COLOR  (BIT(RBIT) | BIT(GBIT) | BIT(BBIT))
+// Pinouts.  R, G and B must be on the same GPIO port.
+#define VGA_R 6
+#define VGA_G 7
+#define VGA_B 8
+#define VGA_V 12
+#define VGA_H 11
+
+// FastPin resolves these at compile time, so each macro is a single
+// store to the pin's BSRR on whichever board this is built for.
+typedef FastPin<VGA_R> pinR;
+typedef FastPin<VGA_G> pinG;
+typedef FastPin<VGA_B> pinB;
+typedef FastPin<VGA_V> pinV;
+typedef FastPin<VGA_H> pinH;
+
+#define VGA_R_HIGH pinR::high()
+#define VGA_R_LOW  pinR::low()
+#define VGA_G_HIGH pinG::high()
+#define VGA_G_LOW  pinG::low()
+#define VGA_B_HIGH pinB::high()
+#define VGA_B_LOW  pinB::low()
+
+#define ON_COLOR   pinR::mask()
+#define OFF_COLOR  (pinR::mask() | pinG::mask() | pinB::mask())
 
 // set has priority, so clear every bit and set some given bits:
-#define VGA_COLOR(c) (*ABSRR = c |                                      \
-                      BIT(RBIT+16) | BIT(GBIT+16) | BIT(BBIT+16))
+#define VGA_COLOR(c) (*pinR::bsrr() = (c) | ((uint32)OFF_COLOR << 16))
 
-#define VGA_V_HIGH *ABSRR = BIT(6)
-#define VGA_V_LOW  *ABRR  = BIT(6)
-#define VGA_H_HIGH *ABSRR = BIT(7)
-#define VGA_H_LOW  *ABRR  = BIT(7)
+#define VGA_V_HIGH pinV::high()
+#define VGA_V_LOW  pinV::low()
+#define VGA_H_HIGH pinH::high()
+#define VGA_H_LOW  pinH::low()
 
 void isr_porch(void);
 void isr_start(void);
@@ -0,0 +1,196 @@
+/*
+  VGA Oscilloscope demo, sampled by timer and DMA.
+
+  The same toy as vga-scope.cpp, but instead of an analogRead() in
+  the horizontal sync interrupt, AdcScan samples ANALOG_PIN once per
+  scan line, triggered by TIMER3, and DMA fills a double buffer.  Each
+  half buffer, the handler turns its samples into trace positions for
+  the next lines drawn, so the sync interrupts only read a byte per
+  line and their timing no longer depends on the ADC.
+
+  Connect a signal to ANALOG_PIN (0V -- 3.3V only); an attached VGA
+  monitor will display it, one sample per scan line, scrolling down.
+  The thick blue line corresponds roughly to 0V.
+
+  SysTick stays on so that the statistics printed on Serial2 every
+  second have a time base; the sync timer gets the top interrupt
+  priority instead, so that nothing else can delay it by more than an
+  interrupt entry.
+
+  How to wire this to a VGA port (STM32F4 Discovery):
+  PE7  via ~200ohms to VGA Red     (1)
+  PE8  via ~200ohms to VGA Green   (2)
+  PE10 via ~200ohms to VGA Blue    (3)
+  PE12 to VGA VSync                (14)
+  PE15 to VGA HSync                (13)
+  GND to VGA Ground                (5)
+  GND to VGA Sync Ground           (10)
+
+  This code is released into the public domain.
+ */
+
+#include "wirish.h"
+#include "libraries/AdcScan/AdcScan.h"
+
+#define ANALOG_PIN Port2Pin('A', 1)
+
+#define RBIT 7
+#define GBIT 8
+#define BBIT 10
+#define VBIT 12
+#define HBIT 15
+
+typedef FastPort<'E'> vga;
+
+#define COLOR_WHITE (BIT(RBIT) | BIT(GBIT) | BIT(BBIT))
+#define COLOR_BLACK 0
+#define COLOR_BLUE  BIT(BBIT)
+#define COLOR_MASK  COLOR_WHITE
+
+#define BORDER_COLOR COLOR_BLUE
+
+#define VGA_COLOR(c) vga::write(COLOR_MASK, (c))
+
+// 31.47 kHz lines from the 84 MHz APB1 timer clock
+#define LINE_TICKS  2669
+#define LINE_RATE   31469
+#define VISIBLE     480
+#define LINES       523
+
+// One sample per line; each half buffer covers half the screen
+#define HALF (VISIBLE / 2)
+uint16 samples[2 * HALF];
+
+AdcScan scan(ADC1);
+
+const uint16 x_max = 120;       // empirically (and sloppily) determined
+volatile uint8 trace[VISIBLE];
+uint16 traceHead = 0;
+
+void isr_porch(void);
+void isr_start(void);
+void isr_stop(void);
+void isr_update(void);
+void got_samples(const uint16 *buf, uint32 count);
+
+void setup() {
+    pinMode(BOARD_LED_PIN, OUTPUT);
+    digitalWrite(BOARD_LED_PIN, 1);
+    pinMode(Port2Pin('E', RBIT), OUTPUT);
+    pinMode(Port2Pin('E', GBIT), OUTPUT);
+    pinMode(Port2Pin('E', BBIT), OUTPUT);
+    pinMode(Port2Pin('E', VBIT), OUTPUT);
+    pinMode(Port2Pin('E', HBIT), OUTPUT);
+
+    Serial2.begin(9600);
+    Serial2.println("Time to kill the radio star...");
+
+    vga::clear(COLOR_WHITE);
+    vga::set(BIT(VBIT) | BIT(HBIT));
+
+    static const uint8 pins[] = {ANALOG_PIN};
+    scan.setPins(pins, 1);
+    scan.setBuffer(samples, 2 * HALF);
+    scan.attachInterrupt(got_samples);
+    scan.begin(TIMER3, LINE_RATE);
+
+    nvic_irq_set_priority(NVIC_TIMER4, 0);
+    timer_pause(TIMER4);
+    timer_set_prescaler(TIMER4, 0);
+    timer_set_mode(TIMER4, 1, TIMER_OUTPUT_COMPARE);
+    timer_set_mode(TIMER4, 2, TIMER_OUTPUT_COMPARE);
+    timer_set_mode(TIMER4, 3, TIMER_OUTPUT_COMPARE);
+    timer_set_mode(TIMER4, 4, TIMER_OUTPUT_COMPARE);
+    timer_set_reload(TIMER4, LINE_TICKS - 1);
+    timer_set_compare(TIMER4, 1, 233);
+    timer_set_compare(TIMER4, 2, 292);
+    timer_set_compare(TIMER4, 3, 2531);
+    timer_set_compare(TIMER4, 4, 1);
+    timer_attach_interrupt(TIMER4, 1, isr_porch);
+    timer_attach_interrupt(TIMER4, 2, isr_start);
+    timer_attach_interrupt(TIMER4, 3, isr_stop);
+    timer_attach_interrupt(TIMER4, 4, isr_update);
+
+    timer_set_count(TIMER4, 0);
+    timer_resume(TIMER4);
+}
+
+// DMA interrupt: scale a half buffer into the trace
+void got_samples(const uint16 *buf, uint32 count) {
+    for (uint32 i = 0; i < count; i++) {
+        trace[traceHead] = (uint8)(buf[i] * x_max / 4096);
+        if (++traceHead == VISIBLE) {
+            traceHead = 0;
+        }
+    }
+}
+
+uint16 y = 0;
+uint16 val = 0;
+bool v_active = true;
+
+void isr_porch(void) {
+    vga::set(BIT(HBIT));
+    y++;
+    if (y >= LINES) {
+        y = 1;
+        v_active = true;
+        return;
+    }
+    if (y >= 492) {
+        vga::set(BIT(VBIT));
+        return;
+    }
+    if (y >= 490) {
+        vga::clear(BIT(VBIT));
+        return;
+    }
+    if (y >= 479) {
+        v_active = false;
+        return;
+    }
+    val = trace[y];
+}
+
+void isr_start(void) {
+    if (!v_active) {
+        return;
+    }
+    VGA_COLOR(BORDER_COLOR);
+    for (int x = 0; x < val; x++) {
+        VGA_COLOR(COLOR_BLACK);
+    }
+    VGA_COLOR(COLOR_WHITE);
+    VGA_COLOR(COLOR_BLACK);
+}
+
+void isr_stop(void) {
+    if (!v_active) {
+        return;
+    }
+    VGA_COLOR(COLOR_BLACK);
+}
+
+void isr_update(void) {
+    vga::clear(BIT(HBIT));
+}
+
+void loop() {
+    toggleLED();
+    delay(1000);
+    scan.printStats(Serial2);
+    scan.resetStats();
+}
+
+__attribute__((constructor)) void premain() {
+    init();
+}
+
+int main(void) {
+    setup();
+
+    while (true) {
+        loop();
+    }
+    return 0;
+}
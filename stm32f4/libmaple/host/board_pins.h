@@ -0,0 +1,77 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file board_pins.h
+ * @brief Check a board's FastPin tables against its PIN_MAP.
+ *
+ * BOARD_PIN_PORTS and BOARD_PIN_BITS repeat the GPIO port and bit of
+ * every PIN_MAP entry for boards whose pins do not follow Port2Pin.
+ * Each host/test_pins_<board>.cpp defines BOARD_<board>, includes
+ * this header, and checks the two against each other with
+ * BOARD_PINS_TEST().  The board's PIN_MAP goes in its own namespace so
+ * that the boards do not clash with each other or with the one the
+ * host build is configured for.
+ */
+
+#ifndef _BOARD_PINS_H_
+#define _BOARD_PINS_H_
+
+#include "hosttest.h"
+#include "gpio.h"
+#include "rcc.h"
+#include "fsmc.h"
+#include "timer.h"
+#include "wirish_debug.h"
+#include "wirish_types.h"
+
+static gpio_dev *board_pins_port(char port) {
+    gpio_dev *const ports[] = {
+        GPIOA, GPIOB, GPIOC, GPIOD, GPIOE, GPIOF, GPIOG,
+    };
+    if (port < 'A' || port > 'G') {
+        return NULL;
+    }
+    return ports[port - 'A'];
+}
+
+#define BOARD_PINS_TEST(board)                                          \
+    namespace board##_pins {                                            \
+    static const char ports[] = BOARD_PIN_PORTS;                        \
+    static const uint8 bits[] = { BOARD_PIN_BITS };                     \
+    }                                                                   \
+                                                                        \
+    HOST_TEST(board_pins_##board) {                                     \
+        using namespace board##_pins;                                   \
+        CHECK(sizeof(ports) - 1 == BOARD_NR_GPIO_PINS);                 \
+        CHECK(sizeof(bits) == BOARD_NR_GPIO_PINS);                      \
+        for (uint32 i = 0; i < BOARD_NR_GPIO_PINS; i++) {               \
+            CHECK(PIN_MAP[i].gpio_device == board_pins_port(ports[i])); \
+            CHECK(PIN_MAP[i].gpio_bit == bits[i]);                      \
+        }                                                               \
+    }
+
+#endif
@@ -0,0 +1,67 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file freertos_port.c
+ * @brief FreeRTOS port layer for the host build.
+ *
+ * Replaces utility/port.c so the kernel's queue and list code can run
+ * on the host.  There is one thread of execution and no tick, so the
+ * scheduler never starts and blocking calls must use a zero timeout.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+static unsigned portBASE_TYPE criticalNesting;
+
+portSTACK_TYPE *pxPortInitialiseStack(portSTACK_TYPE *pxTopOfStack,
+                                      pdTASK_CODE pxCode,
+                                      void *pvParameters) {
+    return pxTopOfStack;
+}
+
+portBASE_TYPE xPortStartScheduler(void) {
+    return pdFALSE;
+}
+
+void vPortEndScheduler(void) {
+}
+
+void vPortYieldFromISR(void) {
+}
+
+void vPortEnterCritical(void) {
+    criticalNesting++;
+}
+
+void vPortExitCritical(void) {
+    criticalNesting--;
+}
+
+void vApplicationStackOverflowHook(xTaskHandle *pxTask,
+                                   signed char *pcTaskName) {
+}
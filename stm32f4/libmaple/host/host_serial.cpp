@@ -0,0 +1,71 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file host_serial.cpp
+ * @brief HardwareSerial for the host build.
+ *
+ * Replaces HardwareSerial.cpp: output goes to stdout and nothing is
+ * ever received.  Only SerialDebug exists, for the library code (the
+ * FAT layer) that reports errors through it.
+ */
+
+#include <stdio.h>
+
+#include "HardwareSerial.h"
+
+static HardwareSerial hostSerial(NULL, 0, 0);
+HardwareSerial &SerialDebug = hostSerial;
+
+HardwareSerial::HardwareSerial(usart_dev *usart_device,
+                               uint8 tx_pin,
+                               uint8 rx_pin) {
+    this->usart_device = usart_device;
+    this->tx_pin = tx_pin;
+    this->rx_pin = rx_pin;
+}
+
+void HardwareSerial::begin(uint32 baud) {
+}
+
+void HardwareSerial::end(void) {
+}
+
+int HardwareSerial::read(void) {
+    return -1;
+}
+
+uint32 HardwareSerial::available(void) {
+    return 0;
+}
+
+void HardwareSerial::write(unsigned char ch) {
+    putchar(ch);
+}
+
+void HardwareSerial::flush(void) {
+    fflush(stdout);
+}
@@ -0,0 +1,129 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file hostbench.cpp
+ * @brief Runner for the host build's tests and benchmarks.
+ *
+ *     hostbench [-t | -b] [filter]
+ *
+ * -t runs only tests, -b only benchmarks.  Benchmark lines have the
+ * form "bench <name> <ns per iteration>" so CI can diff them between
+ * builds.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hosttest.h"
+
+volatile uint32 host_sink;
+
+static HostCase *hostCases;
+static HostCase **hostCasesTail = &hostCases;
+static uint32 hostFailures;
+
+/* Keep registration order, which is link order and then file order */
+static void hostRegister(HostCase *c) {
+    c->next = NULL;
+    *hostCasesTail = c;
+    hostCasesTail = &c->next;
+}
+
+HostCase::HostCase(const char *name, host_test_fn test)
+    : name(name), test(test), bench(NULL), iterations(0) {
+    hostRegister(this);
+}
+
+HostCase::HostCase(const char *name, host_bench_fn bench, uint32 iterations)
+    : name(name), test(NULL), bench(bench), iterations(iterations) {
+    hostRegister(this);
+}
+
+void host_check_failed(const char *file, int line, const char *expr) {
+    printf("    %s:%d: CHECK(%s) failed\n", file, line, expr);
+    hostFailures++;
+}
+
+/* libmaple's ASSERT() ends here on the host; count it as a failed check. */
+extern "C" void _fail(const char *file, int line, const char *exp) {
+    printf("    %s:%d: ASSERT(%s) failed\n", file, line, exp);
+    hostFailures++;
+}
+
+static void runBench(HostCase *c) {
+    /* One untimed pass warms caches and branch predictors */
+    uint32 warm = c->iterations / 10 + 1;
+    for (uint32 i = 0; i < warm; i++) {
+        c->bench(i);
+    }
+
+    uint64 start = sim_nanos();
+    for (uint32 i = 0; i < c->iterations; i++) {
+        c->bench(i);
+    }
+    uint64 elapsed = sim_nanos() - start;
+    printf("bench %-32s %10.2f ns\n", c->name,
+           (double)elapsed / c->iterations);
+}
+
+int main(int argc, char **argv) {
+    bool tests = true, benches = true;
+    const char *filter = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-t")) {
+            benches = false;
+        } else if (!strcmp(argv[i], "-b")) {
+            tests = false;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    uint32 run = 0, failed = 0;
+    for (HostCase *c = hostCases; c != NULL; c = c->next) {
+        if (filter && !strstr(c->name, filter)) {
+            continue;
+        }
+        sim_reset();
+        if (c->test && tests) {
+            uint32 before = hostFailures;
+            c->test();
+            run++;
+            if (hostFailures != before) {
+                failed++;
+            }
+            printf("%s %s\n", hostFailures == before ? "pass " : "FAIL ",
+                   c->name);
+        } else if (c->bench && benches) {
+            runBench(c);
+        }
+    }
+
+    printf("%u tests, %u failed\n", run, failed);
+    return failed ? 1 : 0;
+}
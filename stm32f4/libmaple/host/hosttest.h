@@ -0,0 +1,92 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file hosttest.h
+ * @brief Tests and benchmarks for the host build.
+ *
+ * Each test_*.cpp file registers its cases at file scope:
+ *
+ *     HOST_TEST(rb_wraps) {
+ *         ...
+ *         CHECK(rb_remove(&rb) == 3);
+ *     }
+ *
+ *     HOST_BENCH(rb_insert_remove, 1000000) {
+ *         rb_insert(&rb, (uint8)iter);
+ *         sink += rb_remove(&rb);
+ *     }
+ *
+ * A benchmark body runs the given number of iterations, with the loop
+ * counter available as iter, and is reported in nanoseconds per
+ * iteration.  hostbench runs everything, or the cases whose names
+ * contain its argument, and exits non-zero if a check failed.
+ */
+
+#ifndef _HOSTTEST_H_
+#define _HOSTTEST_H_
+
+#include "libmaple_types.h"
+#include "sim.h"
+
+typedef void (*host_test_fn)(void);
+typedef void (*host_bench_fn)(uint32 iter);
+
+struct HostCase {
+    HostCase(const char *name, host_test_fn test);
+    HostCase(const char *name, host_bench_fn bench, uint32 iterations);
+
+    const char *name;
+    host_test_fn test;
+    host_bench_fn bench;
+    uint32 iterations;
+    HostCase *next;
+};
+
+/** Record a failed check; used by CHECK(). */
+void host_check_failed(const char *file, int line, const char *expr);
+
+#define CHECK(expr) do {                                        \
+        if (!(expr)) {                                          \
+            host_check_failed(__FILE__, __LINE__, #expr);       \
+        }                                                       \
+    } while (0)
+
+#define HOST_TEST(name)                                         \
+    static void host_test_##name(void);                         \
+    static HostCase host_case_##name(#name, host_test_##name);  \
+    static void host_test_##name(void)
+
+#define HOST_BENCH(name, iterations)                            \
+    static void host_bench_##name(uint32 iter);                 \
+    static HostCase host_case_##name(#name, host_bench_##name,  \
+                                     iterations);               \
+    static void host_bench_##name(uint32 iter)
+
+/** Keeps benchmark results alive past the optimizer. */
+extern volatile uint32 host_sink;
+
+#endif
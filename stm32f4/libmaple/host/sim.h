@@ -0,0 +1,80 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file sim.h
+ * @brief Simulated register maps for the host build.
+ *
+ * The host build ("make host") runs libmaple and wirish code on Linux.
+ * Peripheral register structs are reached through fixed addresses
+ * such as USART1_BASE; sim.c maps ordinary zeroed memory at those
+ * addresses before main(), so register code reads and writes plain
+ * memory and the rest of the library runs unchanged.  Nothing reacts
+ * to register writes: tests preset status bits with sim_reg_write()
+ * and inspect what the code wrote.
+ *
+ * The bit-band alias windows are plain memory too, so a bit-band
+ * write does not show up in the aliased register.
+ */
+
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include "libmaple_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Peripheral window, APB1 through the AHB2 USB OTG core */
+#define SIM_PERIPH_BASE 0x40000000UL
+#define SIM_PERIPH_SIZE 0x10100000UL
+
+/** Cortex-M private peripherals: ITM, DWT, NVIC, SCB, SysTick */
+#define SIM_CORE_BASE   0xE0000000UL
+#define SIM_CORE_SIZE   0x00100000UL
+
+/** Zero every simulated register. */
+void sim_reset(void);
+
+/** Read a simulated 32-bit register by address. */
+static inline uint32 sim_reg_read(uint32 addr) {
+    return *(volatile uint32*)(unsigned long)addr;
+}
+
+/** Write a simulated 32-bit register by address. */
+static inline void sim_reg_write(uint32 addr, uint32 val) {
+    *(volatile uint32*)(unsigned long)addr = val;
+}
+
+/** Monotonic host time in nanoseconds, for benchmarks. */
+uint64 sim_nanos(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file sim_sd.cpp
+ * @brief RAM-backed SD card for the host build.
+ */
+
+#include <string.h>
+
+#include "sim_sd.h"
+#include "Sd2Card.h"
+
+static uint8 *simImage;
+static uint32 simBlocks;
+static uint32 simReads;
+static uint32 simWrites;
+
+void sim_sd_attach(uint8 *image, uint32 blocks) {
+    simImage = image;
+    simBlocks = blocks;
+    simReads = 0;
+    simWrites = 0;
+}
+
+uint32 sim_sd_reads(void) {
+    return simReads;
+}
+
+uint32 sim_sd_writes(void) {
+    return simWrites;
+}
+
+uint8_t Sd2Card::init(HardwareSPI *s) {
+    errorCode_ = inBlock_ = partialBlockRead_ = 0;
+    if (simImage == NULL) {
+        error(SD_CARD_ERROR_CMD0);
+        return false;
+    }
+    type(SD_CARD_TYPE_SDHC);
+    return true;
+}
+
+uint32_t Sd2Card::cardSize(void) {
+    return simBlocks;
+}
+
+uint8_t Sd2Card::erase(uint32_t firstBlock, uint32_t lastBlock) {
+    if (lastBlock >= simBlocks || firstBlock > lastBlock) {
+        error(SD_CARD_ERROR_ERASE);
+        return false;
+    }
+    memset(simImage + firstBlock * 512, 0,
+           (lastBlock - firstBlock + 1) * 512);
+    return true;
+}
+
+uint8_t Sd2Card::eraseSingleBlockEnable(void) {
+    return true;
+}
+
+void Sd2Card::partialBlockRead(uint8_t value) {
+    partialBlockRead_ = value;
+}
+
+uint8_t Sd2Card::readBlock(uint32_t block, uint8_t *dst) {
+    return readData(block, 0, 512, dst);
+}
+
+uint8_t Sd2Card::readData(uint32_t block,
+                          uint16_t offset, uint16_t count, uint8_t *dst) {
+    if (block >= simBlocks || offset + count > 512) {
+        error(SD_CARD_ERROR_CMD17);
+        return false;
+    }
+    memcpy(dst, simImage + block * 512 + offset, count);
+    simReads++;
+    return true;
+}
+
+void Sd2Card::readEnd(void) {
+    inBlock_ = 0;
+}
+
+uint8_t Sd2Card::readRegister(uint8_t cmd, void *buf) {
+    memset(buf, 0, 16);
+    return true;
+}
+
+uint8_t Sd2Card::setSckRate(uint8_t sckRateID) {
+    return sckRateID <= 6;
+}
+
+uint8_t Sd2Card::writeBlock(uint32_t blockNumber, const uint8_t *src) {
+    if (blockNumber >= simBlocks) {
+        error(SD_CARD_ERROR_CMD24);
+        return false;
+    }
+    memcpy(simImage + blockNumber * 512, src, 512);
+    simWrites++;
+    return true;
+}
+
+uint8_t Sd2Card::writeStart(uint32_t blockNumber, uint32_t eraseCount) {
+    if (blockNumber >= simBlocks) {
+        error(SD_CARD_ERROR_CMD25);
+        return false;
+    }
+    block_ = blockNumber;
+    return true;
+}
+
+uint8_t Sd2Card::writeData(const uint8_t *src) {
+    if (!writeBlock(block_, src)) {
+        return false;
+    }
+    block_++;
+    return true;
+}
+
+uint8_t Sd2Card::writeStop(void) {
+    return true;
+}
@@ -0,0 +1,51 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file sim_sd.h
+ * @brief RAM-backed SD card for the host build.
+ *
+ * sim_sd.cpp replaces Sd2Card.cpp on the host: the Sd2Card block
+ * interface reads and writes a caller-supplied image instead of
+ * talking SPI, so the FAT layer above it runs unchanged.
+ */
+
+#ifndef _SIM_SD_H_
+#define _SIM_SD_H_
+
+#include "libmaple_types.h"
+
+/**
+ * Back every Sd2Card with an image of the given number of 512-byte
+ * blocks.  Pass NULL to make init() fail as with no card inserted.
+ */
+void sim_sd_attach(uint8 *image, uint32 blocks);
+
+/** Blocks read and written since the image was attached. */
+uint32 sim_sd_reads(void);
+uint32 sim_sd_writes(void);
+
+#endif
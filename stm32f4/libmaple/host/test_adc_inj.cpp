@@ -0,0 +1,85 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_adc_inj.cpp
+ * @brief Injected sequence, offset and trigger register values.
+ */
+
+#include "hosttest.h"
+#include "adc.h"
+
+HOST_TEST(adc_inj_jsqr_right_aligned) {
+    static const uint8 one[] = {5};
+    static const uint8 three[] = {1, 2, 3};
+    static const uint8 four[] = {10, 11, 12, 13};
+
+    /* JL = 0, only JSQ4 */
+    CHECK(adc_inj_jsqr(one, 1) == (5u << 15));
+    /* JL = 2, JSQ2..JSQ4 */
+    CHECK(adc_inj_jsqr(three, 3) == (2u << 20 | 1 << 5 | 2 << 10 | 3 << 15));
+    CHECK(adc_inj_jsqr(four, 4) ==
+          (3u << 20 | 10 | 11 << 5 | 12 << 10 | 13 << 15));
+}
+
+HOST_TEST(adc_inj_setup_registers) {
+    static const uint8 phases[] = {1, 2};
+
+    sim_reset();
+    adc_set_inj_sequence(ADC2, phases, 2);
+    CHECK(ADC2->regs->JSQR == (1u << 20 | 1 << 10 | 2 << 15));
+    CHECK(ADC2->regs->CR1 & ADC_CR1_SCAN);
+
+    adc_set_inj_offset(ADC2, 1, 2048);
+    adc_set_inj_offset(ADC2, 4, 0x1FFF);
+    CHECK(ADC2->regs->JOFR1 == 2048);
+    CHECK(ADC2->regs->JOFR2 == 0);
+    CHECK(ADC2->regs->JOFR4 == 0xFFF);
+
+    ADC1->regs->CR2 = ADC_CR2_ADON | ADC_CR2_JEXTSEL;
+    adc_set_inj_trigger(ADC1, ADC_JEXT_TIM8_CC4, ADC_JEXTEN_RISING);
+    CHECK(ADC1->regs->CR2 == (ADC_CR2_ADON | 0xE << 16 | 1 << 20));
+    adc_set_inj_trigger(ADC1, ADC_JEXT_TIM1_CC4, ADC_JEXTEN_NONE);
+    CHECK(ADC1->regs->CR2 == ADC_CR2_ADON);
+}
+
+HOST_TEST(adc_inj_read_signed) {
+    static const uint8 three[] = {1, 2, 3};
+    int16 results[4] = {0, 0, 0, 0x55};
+
+    sim_reset();
+    adc_set_inj_sequence(ADC1, three, 3);
+    /* Offset results are sign-extended into the data registers */
+    ADC1->regs->JDR1 = 0xFFF6;
+    ADC1->regs->JDR2 = 100;
+    ADC1->regs->JDR3 = 0xF800;
+    ADC1->regs->JDR4 = 7;
+    CHECK(adc_inj_read(ADC1, results) == 3);
+    CHECK(results[0] == -10);
+    CHECK(results[1] == 100);
+    CHECK(results[2] == -2048);
+    CHECK(results[3] == 0x55);
+}
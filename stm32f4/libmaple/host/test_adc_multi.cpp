@@ -0,0 +1,166 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_adc_multi.cpp
+ * @brief Multi-ADC mode checks and register setup.
+ */
+
+#include "hosttest.h"
+#include "adc.h"
+
+static const uint8 ch1[] = {1};
+static const uint8 phases[3][3] = {{1, 2, 3}, {2, 3, 1}, {3, 1, 2}};
+
+static adc_multi_config triple_interleaved(void) {
+    adc_multi_config cfg;
+    cfg.mode = ADC_MULTI_TRIPLE_INTERLEAVED;
+    cfg.dma = ADC_MULTI_DMA_MODE2;
+    cfg.prescaler = ADC_PRE_PCLK2_DIV_2;
+    cfg.resolution = ADC_RES_12BIT;
+    cfg.smp = ADC_SMPR_3;
+    cfg.delay = 5;
+    cfg.continuous = 1;
+    cfg.length = 1;
+    cfg.channels[0] = cfg.channels[1] = cfg.channels[2] = ch1;
+    return cfg;
+}
+
+static adc_multi_config triple_simultaneous(void) {
+    adc_multi_config cfg = triple_interleaved();
+    cfg.mode = ADC_MULTI_TRIPLE_SIMULTANEOUS;
+    cfg.dma = ADC_MULTI_DMA_MODE1;
+    cfg.continuous = 0;
+    cfg.length = 3;
+    cfg.channels[0] = phases[0];
+    cfg.channels[1] = phases[1];
+    cfg.channels[2] = phases[2];
+    return cfg;
+}
+
+HOST_TEST(adc_multi_check_rules) {
+    adc_multi_config cfg = triple_interleaved();
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_OK);
+
+    cfg.delay = 4;
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_BAD_DELAY);
+    cfg.delay = 21;
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_BAD_DELAY);
+    /* 15-clock sampling overlaps the next ADC's at a delay of 10 */
+    cfg.delay = 10;
+    cfg.smp = ADC_SMPR_15;
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_BAD_DELAY);
+    cfg.delay = 16;
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_OK);
+
+    cfg.dma = ADC_MULTI_DMA_MODE3;
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_BAD_DMA);
+    cfg.resolution = ADC_RES_8BIT;
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_OK);
+
+    cfg.channels[2] = phases[2];
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_CHANNEL_MISMATCH);
+
+    cfg = triple_simultaneous();
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_OK);
+    cfg.channels[2] = phases[1];
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_CHANNEL_CLASH);
+
+    cfg = triple_simultaneous();
+    cfg.mode = ADC_MULTI_DUAL_SIMULTANEOUS;
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_BAD_DMA);
+    cfg.dma = ADC_MULTI_DMA_MODE2;
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_OK);
+    cfg.length = 0;
+    CHECK(adc_multi_check(&cfg) == ADC_MULTI_BAD_LENGTH);
+}
+
+HOST_TEST(adc_multi_ccr_bits) {
+    adc_multi_config cfg = triple_interleaved();
+    uint32 keep = ADC_CCR_TSVREFE;
+    uint32 ccr = adc_multi_ccr(&cfg, keep | ADC_CCR_ADCPRE | ADC_CCR_DELAY);
+
+    CHECK((ccr & ADC_CCR_MULTI) == 0x17);
+    CHECK((ccr & ADC_CCR_DELAY) == 0);
+    CHECK((ccr & ADC_CCR_DMA) == ADC_MULTI_DMA_MODE2);
+    CHECK(ccr & ADC_CCR_DDS);
+    CHECK((ccr & ADC_CCR_ADCPRE) == ADC_PRE_PCLK2_DIV_2);
+    CHECK(ccr & ADC_CCR_TSVREFE);
+
+    cfg.delay = 20;
+    cfg.dma = ADC_MULTI_DMA_NONE;
+    cfg.prescaler = ADC_PRE_PCLK2_DIV_8;
+    ccr = adc_multi_ccr(&cfg, 0);
+    CHECK((ccr & ADC_CCR_DELAY) == (15 << 8));
+    CHECK(!(ccr & (ADC_CCR_DDS | ADC_CCR_DMA)));
+    CHECK((ccr & ADC_CCR_ADCPRE) == (0x3 << 16));
+
+    /* No delay outside the interleaved modes */
+    cfg = triple_simultaneous();
+    cfg.delay = 20;
+    CHECK((adc_multi_ccr(&cfg, 0) & ADC_CCR_DELAY) == 0);
+}
+
+HOST_TEST(adc_multi_rates) {
+    adc_multi_config cfg = triple_interleaved();
+
+    /* Three ADCs 5 clocks apart, 15 clocks each: 7.2 MSPS at 36 MHz */
+    CHECK(adc_multi_rate(&cfg, 36000000) == 7200000);
+    cfg.mode = ADC_MULTI_DUAL_INTERLEAVED;
+    CHECK(adc_multi_rate(&cfg, 36000000) == 4800000);
+    cfg.delay = 8;
+    cfg.resolution = ADC_RES_6BIT;
+    CHECK(adc_multi_rate(&cfg, 36000000) == 4500000);
+    cfg = triple_simultaneous();
+    CHECK(adc_multi_rate(&cfg, 36000000) == 7200000);
+}
+
+HOST_TEST(adc_multi_setup_registers) {
+    adc_multi_config cfg = triple_simultaneous();
+
+    sim_reset();
+    ADC3->regs->CR2 = ADC_CR2_ADON | ADC_EXT_TIM8_TRGO | ADC_CR2_EXTEN_RISING;
+    ADC_COMMON->CCR = ADC_CCR_TSVREFE;
+    CHECK(adc_multi_setup(&cfg) == ADC_MULTI_OK);
+    CHECK(ADC1->regs->SQR3 == (1 | 2 << 5 | 3 << 10));
+    CHECK(ADC2->regs->SQR3 == (2 | 3 << 5 | 1 << 10));
+    CHECK(ADC3->regs->SQR3 == (3 | 1 << 5 | 2 << 10));
+    CHECK((ADC1->regs->SQR1 & ADC_SQR1_L) == (2 << 20));
+    CHECK(ADC2->regs->CR1 & ADC_CR1_SCAN);
+    /* Slave triggers off, ADON kept */
+    CHECK(ADC3->regs->CR2 == ADC_CR2_ADON);
+    CHECK(ADC_COMMON->CCR == (ADC_CCR_TSVREFE | 0x16 | ADC_MULTI_DMA_MODE1 |
+                              ADC_CCR_DDS | ADC_PRE_PCLK2_DIV_2));
+
+    cfg.channels[1] = phases[0];
+    CHECK(adc_multi_setup(&cfg) == ADC_MULTI_CHANNEL_CLASH);
+    CHECK((ADC_COMMON->CCR & ADC_CCR_MULTI) == 0x16);
+
+    adc_multi_stop();
+    CHECK(ADC_COMMON->CCR == (ADC_CCR_TSVREFE | ADC_PRE_PCLK2_DIV_2));
+    CHECK(!(ADC2->regs->CR1 & ADC_CR1_SCAN));
+    CHECK((ADC1->regs->SQR1 & ADC_SQR1_L) == 0);
+}
@@ -0,0 +1,118 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_bitstream.cpp
+ * @brief WS2812 and DShot pulse-width coding.
+ */
+
+#include "hosttest.h"
+#include "bitstream.h"
+
+HOST_TEST(bitstream_timing) {
+    bitstream_timing t;
+
+    /* 168 MHz: 210 ticks per WS2812 bit, 0.4 and 0.8 us high */
+    CHECK(bitstream_ws2812_timing(&t, 168000000) == 0);
+    CHECK(t.reload == 209 && t.zero == 67 && t.one == 134);
+
+    /* 84 MHz APB1 timers */
+    CHECK(bitstream_dshot_timing(&t, 84000000, BITSTREAM_DSHOT600) == 0);
+    CHECK(t.reload == 139 && t.zero == 53 && t.one == 105);
+    CHECK(bitstream_dshot_timing(&t, 168000000, BITSTREAM_DSHOT300) == 0);
+    CHECK(t.reload == 559 && t.zero == 210 && t.one == 420);
+    CHECK(bitstream_dshot_timing(&t, 168000000, BITSTREAM_DSHOT150) == 0);
+    CHECK(t.reload == 1119 && t.zero == 420 && t.one == 840);
+
+    /* Too slow to tell 0 from 1, too slow a bit for 16 bits */
+    CHECK(bitstream_dshot_timing(&t, 1000000, BITSTREAM_DSHOT600) < 0);
+    CHECK(bitstream_timing_calc(&t, 168000000, 1000, 300, 600) < 0);
+    CHECK(bitstream_timing_calc(&t, 168000000, 800000, 600, 300) < 0);
+}
+
+HOST_TEST(bitstream_dshot_frame) {
+    /* value 1046: 10000010110, no telemetry, checksum 0110 */
+    CHECK(bitstream_dshot_frame(1046, 0) == 0x82C6);
+    CHECK(bitstream_dshot_frame(1046, 1) == 0x82D7);
+    CHECK(bitstream_dshot_frame(0, 0) == 0x0000);
+    CHECK(bitstream_dshot_frame(48, 0) == 0x0606);
+    CHECK(bitstream_dshot_frame(5000, 0) == bitstream_dshot_frame(2047, 0));
+    CHECK(bitstream_dshot_frame(2047, 0) == 0xFFEE);
+}
+
+HOST_TEST(bitstream_encode_dshot_rows) {
+    bitstream_timing t = {139, 53, 105};
+    uint16 slots[2 * 16];
+    uint16 frame = bitstream_dshot_frame(1046, 0);
+
+    /* Two motors interleaved, as one burst writes CCR1 and CCR2 */
+    bitstream_encode_word(&t, frame, 16, slots, 2);
+    bitstream_encode_word(&t, 0xFFFF, 16, slots + 1, 2);
+    for (uint32 bit = 0; bit < 16; bit++) {
+        uint16 expect = (frame & (0x8000 >> bit)) ? 105 : 53;
+        CHECK(slots[2 * bit] == expect);
+        CHECK(slots[2 * bit + 1] == 105);
+    }
+}
+
+HOST_TEST(bitstream_encode_halves) {
+    bitstream_timing t = {209, 67, 134};
+    /* Two LEDs, GRB */
+    const uint8 pixels[6] = {0xFF, 0x00, 0x81, 0x0F, 0xF0, 0x55};
+    uint16 slots[20];
+    uint32 bit = 0;
+    uint32 n;
+
+    /* Refill 20 slots at a time, as a double buffer would */
+    n = bitstream_encode(&t, pixels, bit, 48, slots, 20, 1);
+    CHECK(n == 20);
+    CHECK(slots[0] == 134 && slots[7] == 134);
+    CHECK(slots[8] == 67 && slots[15] == 67);
+    CHECK(slots[16] == 134 && slots[17] == 67 && slots[19] == 67);
+    bit += n;
+
+    n = bitstream_encode(&t, pixels, bit, 48, slots, 20, 1);
+    CHECK(n == 20);
+    /* Bits 20 to 23 of 0x81, then 0x0F, 0xF0 */
+    CHECK(slots[0] == 67 && slots[2] == 67 && slots[3] == 134);
+    CHECK(slots[4] == 67 && slots[7] == 67);
+    CHECK(slots[8] == 134 && slots[11] == 134);
+    CHECK(slots[12] == 134 && slots[15] == 134 && slots[16] == 67);
+    bit += n;
+
+    /* The last 8 bits, then idle low */
+    n = bitstream_encode(&t, pixels, bit, 48, slots, 20, 1);
+    CHECK(n == 8);
+    CHECK(slots[0] == 67 && slots[1] == 134 && slots[7] == 134);
+    for (uint32 i = 8; i < 20; i++) {
+        CHECK(slots[i] == 0);
+    }
+    bit += n;
+
+    n = bitstream_encode(&t, pixels, bit, 48, slots, 20, 1);
+    CHECK(n == 0 && slots[0] == 0 && slots[19] == 0);
+    CHECK(bitstream_encode(&t, pixels, 60, 48, slots, 4, 1) == 0);
+}
@@ -0,0 +1,72 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_dac.cpp
+ * @brief DAC trigger, waveform and DMA control bits.
+ */
+
+#include "hosttest.h"
+#include "libmaple.h"
+#include "dac.h"
+
+HOST_TEST(dac_channel_control_bits) {
+    sim_reset();
+    DAC->regs->CR = DAC_CR_EN1 | DAC_CR_EN2;
+
+    dac_set_trigger(DAC, 1, DAC_TRIG_TIMER6);
+    dac_set_trigger(DAC, 2, DAC_TRIG_TIMER7);
+    CHECK(DAC->regs->CR == (DAC_CR_EN1 | DAC_CR_TEN1 |
+                            DAC_CR_EN2 | DAC_CR_TEN2 | 2 << 19));
+    dac_set_trigger(DAC, 1, DAC_TRIG_SOFTWARE);
+    CHECK((DAC->regs->CR & DAC_CR_TSEL1) == (7 << 3));
+
+    dac_set_wave(DAC, 2, DAC_WAVE_TRIANGLE, 12);
+    CHECK((DAC->regs->CR & DAC_CR_WAVE2) == (2 << 22));
+    CHECK((DAC->regs->CR & DAC_CR_MAMP2) == (11 << 24));
+    dac_set_wave(DAC, 1, DAC_WAVE_NOISE, 4);
+    CHECK((DAC->regs->CR & (DAC_CR_WAVE1 | DAC_CR_MAMP1)) ==
+          (1 << 6 | 3 << 8));
+    dac_set_wave(DAC, 2, DAC_WAVE_NONE, 0);
+    CHECK(!(DAC->regs->CR & (DAC_CR_WAVE2 | DAC_CR_MAMP2)));
+
+    dac_set_dma(DAC, 2, 1);
+    CHECK(DAC->regs->CR & DAC_CR_DMAEN2);
+    CHECK(!(DAC->regs->CR & DAC_CR_DMAEN1));
+    dac_set_dma(DAC, 2, 0);
+    dac_disable_trigger(DAC, 1);
+    dac_disable_trigger(DAC, 2);
+    CHECK(DAC->regs->CR == (DAC_CR_EN1 | DAC_CR_EN2 | 1 << 6 | 3 << 8));
+}
+
+HOST_TEST(dac_dual_writes) {
+    sim_reset();
+    CHECK(dac_pack_dual(0x123, 0xFABC) == 0x0ABC0123);
+    dac_write_dual(DAC, 4095, 1);
+    CHECK(DAC->regs->DHR12RD == 0x00010FFF);
+    CHECK(DAC_DHR12RD_ADDRESS == &DAC->regs->DHR12RD);
+    CHECK(dac_dhr12r(DAC, 2) == &DAC->regs->DHR12R2);
+}
@@ -0,0 +1,284 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_decimate.cpp
+ * @brief decimate.h filters against direct computations, and their
+ *        cost per block of synthetic ADC samples.
+ *
+ * On the host the SIMD variants run on emulated SADD16/SMLAD, so the
+ * benchmarks compare the C paths' shapes rather than the target's
+ * speed-up.
+ */
+
+#include <math.h>
+#include "hosttest.h"
+#include "decimate.h"
+
+#define BLOCK 4096
+
+static uint16 samples[BLOCK];
+static uint16 outputs[BLOCK];
+
+/* A 12-bit sine plus noise from a fixed LCG */
+static void synthesize(void) {
+    static bool done = false;
+    uint32 seed = 12345;
+
+    if (done) {
+        return;
+    }
+    for (uint32 i = 0; i < BLOCK; i++) {
+        seed = seed * 1664525 + 1013904223;
+        double v = 2048 + 1500 * sin(i * 0.01) + (int)(seed >> 24) - 128;
+        samples[i] = v < 0 ? 0 : v > 4095 ? 4095 : (uint16)v;
+    }
+    done = true;
+}
+
+static const int16 lowpass[16] = {
+    -300, -500, 0, 1400, 3200, 4900, 6100, 6600,
+    6600, 6100, 4900, 3200, 1400, 0, -500, -300,
+};
+
+HOST_TEST(decim_simd_matches_c) {
+    static uint16 full[100];
+    static int16 x[67], c[67];
+
+    synthesize();
+    for (uint32 i = 0; i < 100; i++) {
+        full[i] = 4095;         /* Fullest lanes */
+    }
+    for (uint32 n = 0; n <= 100; n++) {
+        CHECK(decim_sum_simd(samples + 1, n) == decim_sum_c(samples + 1, n));
+        CHECK(decim_sum_simd(full, n) == 4095 * n);
+    }
+    for (uint32 i = 0; i < 67; i++) {
+        x[i] = (int16)(samples[i] * 8);
+        c[i] = (int16)(i * 997 % 4001 - 2000);
+    }
+    for (uint32 n = 0; n <= 67; n++) {
+        CHECK(decim_dot_simd(x, c, n) == decim_dot_c(x, c, n));
+        CHECK(decim_dot_simd(x + 1, c, n - (n > 0)) ==
+              decim_dot_c(x + 1, c, n - (n > 0)));
+    }
+}
+
+HOST_TEST(decim_avg_oversample_and_mean) {
+    decim_avg st;
+    static const uint16 in[] = {1, 2, 4, 100, 100, 101};
+    uint16 out[8];
+
+    /* 4095 * 256 needs 20 bits: a shift of 3 is not enough */
+    CHECK(decim_avg_init(&st, 256, 3) == -1);
+    CHECK(decim_avg_init(&st, 256, 4) == 0);
+    CHECK(decim_avg_init(&st, 0, 0) == -1);
+
+    /* 16x oversampling, 2 extra bits */
+    CHECK(decim_avg_init(&st, 16, 2) == 0);
+    uint16 constant[40];
+    for (uint32 i = 0; i < 40; i++) {
+        constant[i] = 1001;
+    }
+    CHECK(decim_avg_process(&st, constant, 40, out) == 2);
+    CHECK(out[0] == 4004 && out[1] == 4004);
+    /* The 8 left over count towards the next output */
+    CHECK(decim_avg_process(&st, constant, 8, out) == 1);
+    CHECK(out[0] == 4004);
+
+    CHECK(decim_mean_init(&st, 3) == 0);
+    CHECK(decim_avg_process(&st, in, 6, out) == 2);
+    CHECK(out[0] == 2);
+    CHECK(out[1] == 100);
+}
+
+HOST_TEST(decim_avg_blocks_split_anywhere) {
+    decim_avg whole, split;
+    static uint16 a[BLOCK / 16], b[BLOCK / 16 + 1];
+
+    synthesize();
+    decim_avg_init(&whole, 12, 0);
+    decim_avg_init(&split, 12, 0);
+    uint32 na = decim_avg_process(&whole, samples, 1000, a);
+    uint32 nb = 0;
+    for (uint32 i = 0; i < 1000; i += 7) {
+        uint32 n = 1000 - i < 7 ? 1000 - i : 7;
+        nb += decim_avg_process(&split, samples + i, n, b + nb);
+    }
+    CHECK(na == 1000 / 12);
+    CHECK(nb == na);
+    for (uint32 i = 0; i < na; i++) {
+        CHECK(a[i] == b[i]);
+    }
+}
+
+/* Order-K CIC: K running sums of R samples, keeping every R-th */
+static void cicReference(const uint16 *in, uint32 n, uint8 order,
+                         uint32 ratio, uint8 shift, uint16 *out) {
+    static uint32 stage[5][BLOCK];
+
+    for (uint32 i = 0; i < n; i++) {
+        stage[0][i] = in[i];
+    }
+    for (uint8 k = 1; k <= order; k++) {
+        for (uint32 i = 0; i < n; i++) {
+            uint32 sum = 0;
+            for (uint32 j = 0; j < ratio && j <= i; j++) {
+                sum += stage[k - 1][i - j];
+            }
+            stage[k][i] = sum;
+        }
+    }
+    for (uint32 m = 0; (m + 1) * ratio <= n; m++) {
+        out[m] = (uint16)(stage[order][(m + 1) * ratio - 1] >> shift);
+    }
+}
+
+HOST_TEST(decim_cic_matches_running_sums) {
+    static uint16 expect[BLOCK];
+    decim_cic st;
+
+    synthesize();
+    CHECK(decim_cic_init(&st, 4, 1024, 28) == -1);   /* 52-bit gain */
+    CHECK(decim_cic_init(&st, 3, 8, 4) == -1);       /* 17-bit output */
+    CHECK(decim_cic_init(&st, 5, 2, 0) == -1);
+
+    static const struct { uint8 order; uint32 ratio; uint8 shift; } cases[] = {
+        {1, 16, 0}, {2, 4, 0}, {3, 8, 9}, {4, 5, 10}, {4, 16, 16},
+    };
+    for (uint32 c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        CHECK(decim_cic_init(&st, cases[c].order, cases[c].ratio,
+                             cases[c].shift) == 0);
+        uint32 n = decim_cic_process(&st, samples, 500, outputs);
+        n += decim_cic_process(&st, samples + 500, 1500, outputs + n);
+        cicReference(samples, 2000, cases[c].order, cases[c].ratio,
+                     cases[c].shift, expect);
+        CHECK(n == 2000 / cases[c].ratio);
+        for (uint32 i = 0; i < n; i++) {
+            CHECK(outputs[i] == expect[i]);
+        }
+    }
+}
+
+HOST_TEST(decim_fir_matches_convolution) {
+    static const int16 bad[3] = {32767, -32767, 2};
+    static const int16 coeffs[7] = {-2000, 3000, 9000, 16000, 9000, 3000, -2000};
+    decim_fir st;
+
+    synthesize();
+    CHECK(decim_fir_init(&st, bad, 2, 1) == 0);
+    CHECK(decim_fir_init(&st, bad, 3, 1) == -1);
+    CHECK(decim_fir_init(&st, coeffs, 0, 1) == -1);
+    CHECK(decim_fir_init(&st, coeffs, 7, 3) == 0);
+
+    uint32 n = decim_fir_process(&st, samples, 301, outputs);
+    CHECK(n == 100);
+    for (uint32 m = 0; m < n; m++) {
+        int32 acc = 0;
+        uint32 at = 3 * m + 2;
+        for (uint32 k = 0; k < 7 && k <= at; k++) {
+            acc += coeffs[k] * samples[at - k];
+        }
+        acc = (acc + (1 << 14)) >> 15;
+        CHECK(outputs[m] == (acc < 0 ? 0 : acc));
+    }
+}
+
+HOST_TEST(decim_pipeline_chains_stages) {
+    static uint16 mid[BLOCK], expect[BLOCK];
+    static decim_fir fir, fir2;
+    decim_pipeline p;
+    decim_cic cic;
+
+    synthesize();
+    p.stage = DECIM_STAGE_CIC;
+    p.fir = NULL;
+    CHECK(decim_cic_init(&p.first.cic, 3, 8, 6) == 0);
+    CHECK(decim_pipeline_ratio(&p) == 8);
+    CHECK(decim_fir_init(&fir, lowpass, 16, 2) == 0);
+    p.fir = &fir;
+    CHECK(decim_pipeline_ratio(&p) == 16);
+
+    uint32 n = decim_pipeline_process(&p, samples, BLOCK, outputs);
+    decim_cic_init(&cic, 3, 8, 6);
+    decim_fir_init(&fir2, lowpass, 16, 2);
+    uint32 m = decim_cic_process(&cic, samples, BLOCK, mid);
+    CHECK(decim_fir_process(&fir2, mid, m, expect) == n);
+    CHECK(n == BLOCK / 16);
+    for (uint32 i = 0; i < n; i++) {
+        CHECK(outputs[i] == expect[i]);
+    }
+}
+
+HOST_BENCH(decim_sum_c_4k, 20000) {
+    synthesize();
+    host_sink += decim_sum_c(samples, BLOCK) + iter;
+}
+
+HOST_BENCH(decim_sum_simd_4k, 20000) {
+    synthesize();
+    host_sink += decim_sum_simd(samples, BLOCK) + iter;
+}
+
+HOST_BENCH(decim_avg16_4k, 20000) {
+    static decim_avg st;
+    if (iter == 0) {
+        synthesize();
+        decim_avg_init(&st, 16, 2);
+    }
+    host_sink += decim_avg_process(&st, samples, BLOCK, outputs);
+}
+
+HOST_BENCH(decim_cic3_16_4k, 20000) {
+    static decim_cic st;
+    if (iter == 0) {
+        synthesize();
+        decim_cic_init(&st, 3, 16, 8);
+    }
+    host_sink += decim_cic_process(&st, samples, BLOCK, outputs);
+}
+
+HOST_BENCH(decim_fir16_by4_4k, 20000) {
+    static decim_fir st;
+    if (iter == 0) {
+        synthesize();
+        decim_fir_init(&st, lowpass, 16, 4);
+    }
+    host_sink += decim_fir_process(&st, samples, BLOCK, outputs);
+}
+
+HOST_BENCH(decim_pipeline_cic_fir_4k, 20000) {
+    static decim_pipeline p;
+    static decim_fir fir;
+    if (iter == 0) {
+        synthesize();
+        p.stage = DECIM_STAGE_CIC;
+        decim_cic_init(&p.first.cic, 3, 8, 6);
+        decim_fir_init(&fir, lowpass, 16, 2);
+        p.fir = &fir;
+    }
+    host_sink += decim_pipeline_process(&p, samples, BLOCK, outputs);
+}
@@ -0,0 +1,124 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_event_queue.cpp
+ * @brief event_queue.h ordering, overflow and interrupted posts.
+ */
+
+#include "hosttest.h"
+#include "event_queue.h"
+
+static event_queue q;
+
+static void record(void *arg, uint32 data) {
+    *(uint32*)arg = data;
+}
+
+HOST_TEST(eq_fifo_across_laps) {
+    uint32 out = 0;
+    event ev;
+    uint32 next = 0;
+
+    event_queue_init(&q);
+    CHECK(!event_queue_ready(&q));
+    CHECK(!event_queue_take(&q, &ev));
+    /* Uneven batches so head and tail wrap at different points */
+    for (uint32 lap = 0; lap < 100; lap++) {
+        uint32 batch = 1 + lap % EVENT_QUEUE_SIZE;
+        for (uint32 i = 0; i < batch; i++) {
+            CHECK(event_queue_post(&q, record, &out, next + i, lap) == 0);
+        }
+        CHECK(event_queue_depth(&q) == batch);
+        for (uint32 i = 0; i < batch; i++) {
+            CHECK(event_queue_ready(&q));
+            CHECK(event_queue_take(&q, &ev));
+            ev.handler(ev.arg, ev.data);
+            CHECK(out == next + i);
+            CHECK(ev.stamp == lap);
+        }
+        next += batch;
+    }
+    CHECK(!event_queue_ready(&q));
+    CHECK(q.dropped == 0);
+    CHECK(q.high_water == EVENT_QUEUE_SIZE);
+}
+
+HOST_TEST(eq_full_drops) {
+    event ev;
+
+    event_queue_init(&q);
+    for (uint32 i = 0; i < EVENT_QUEUE_SIZE; i++) {
+        CHECK(event_queue_post(&q, record, NULL, i, 0) == 0);
+    }
+    CHECK(event_queue_post(&q, record, NULL, 99, 0) == -1);
+    CHECK(event_queue_post(&q, record, NULL, 99, 0) == -1);
+    CHECK(q.dropped == 2);
+    CHECK(event_queue_take(&q, &ev) && ev.data == 0);
+    CHECK(event_queue_post(&q, record, NULL, 100, 0) == 0);
+    for (uint32 i = 1; i < EVENT_QUEUE_SIZE; i++) {
+        CHECK(event_queue_take(&q, &ev) && ev.data == i);
+    }
+    CHECK(event_queue_take(&q, &ev) && ev.data == 100);
+    CHECK(!event_queue_take(&q, &ev));
+}
+
+/*
+ * An interrupt handler that interrupts another's post between its
+ * claim of a cell and its publishing of the event: the later event
+ * goes in the next cell and the consumer waits for the earlier one.
+ */
+HOST_TEST(eq_interrupted_post) {
+    event ev;
+
+    event_queue_init(&q);
+    /* Low-priority post: claim cell 0 and stop there */
+    uint32 claimed = q.head;
+    q.head = claimed + 1;
+    /* High-priority post runs to completion */
+    CHECK(event_queue_post(&q, record, NULL, 2, 0) == 0);
+    CHECK(event_queue_depth(&q) == 2);
+    CHECK(!event_queue_ready(&q));
+    CHECK(!event_queue_take(&q, &ev));
+    /* Low-priority post resumes and publishes */
+    q.cells[claimed].ev.handler = record;
+    q.cells[claimed].ev.data = 1;
+    q.cells[claimed].seq = claimed + 1;
+    CHECK(event_queue_take(&q, &ev) && ev.data == 1);
+    CHECK(event_queue_take(&q, &ev) && ev.data == 2);
+    CHECK(!event_queue_ready(&q));
+}
+
+HOST_BENCH(eq_post_take, 10000000) {
+    event ev;
+
+    if (iter == 0) {
+        event_queue_init(&q);
+    }
+    event_queue_post(&q, record, NULL, iter, iter);
+    event_queue_take(&q, &ev);
+    host_sink += ev.data;
+}
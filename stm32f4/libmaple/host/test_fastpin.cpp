@@ -0,0 +1,84 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_fastpin.cpp
+ * @brief FastPin and FastPort against the simulated GPIO ports.
+ */
+
+#include "hosttest.h"
+#include "FastPin.h"
+
+/* discovery_f4: GPIOD at 0x40020C00, BSRR at +0x18 */
+#define GPIOD_ODR       0x40020C14
+#define GPIOD_BSRR      0x40020C18
+
+typedef FastPin<Port2Pin('D', 12)> pd12;
+
+HOST_TEST(fastpin_table_matches_port2pin) {
+    CHECK(pd12::regs() == GPIOD_BASE);
+    CHECK(pd12::mask() == BIT(12));
+    CHECK(FastPin<Port2Pin('E', 2)>::mask() == BIT(2));
+    CHECK(FastPin<Port2Pin('A', 0)>::regs() == GPIOA_BASE);
+}
+
+HOST_TEST(fastpin_writes_bsrr) {
+    pd12::high();
+    CHECK(sim_reg_read(GPIOD_BSRR) == BIT(12));
+    pd12::low();
+    CHECK(sim_reg_read(GPIOD_BSRR) == BIT(12 + 16));
+    pd12::write(1);
+    CHECK(sim_reg_read(GPIOD_BSRR) == BIT(12));
+}
+
+HOST_TEST(fastpin_toggle_follows_odr) {
+    sim_reg_write(GPIOD_ODR, BIT(12));
+    pd12::toggle();
+    CHECK(sim_reg_read(GPIOD_BSRR) == BIT(12 + 16));
+    sim_reg_write(GPIOD_ODR, 0);
+    pd12::toggle();
+    CHECK(sim_reg_read(GPIOD_BSRR) == BIT(12));
+}
+
+HOST_TEST(fastpin_read_idr) {
+    GPIOD_BASE->IDR = BIT(12);
+    CHECK(pd12::read() == 1);
+    GPIOD_BASE->IDR = ~(uint32)BIT(12);
+    CHECK(pd12::read() == 0);
+}
+
+HOST_TEST(fastport_write_is_one_store) {
+    FastPort<'D'>::write(0x00FF, 0x0055);
+    CHECK(sim_reg_read(GPIOD_BSRR) == (0x00AAU << 16 | 0x0055));
+    sim_reg_write(GPIOD_ODR, 0x0F0F);
+    FastPort<'D'>::toggle(0x00FF);
+    CHECK(sim_reg_read(GPIOD_BSRR) == (0x000FU << 16 | 0x00F0));
+}
+
+HOST_BENCH(fastpin_high_low, 10000000) {
+    pd12::high();
+    pd12::low();
+}
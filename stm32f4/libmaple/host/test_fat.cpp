@@ -0,0 +1,151 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_fat.cpp
+ * @brief FAT layer (mapleSDfat) on a RAM-backed card.
+ */
+
+#include <string.h>
+
+#include "hosttest.h"
+#include "sim_sd.h"
+#include "SdFat.h"
+
+/* 16 MB super floppy, 1 KB clusters: just enough clusters for FAT16 */
+#define IMAGE_BLOCKS 32768
+#define FAT_BLOCKS   64
+#define ROOT_ENTRIES 512
+
+static uint8 image[IMAGE_BLOCKS * 512];
+static Sd2Card card;
+static SdVolume volume;
+static SdFile root;
+static SdFile file;
+static uint8 data[4096];
+
+static void formatImage(void) {
+    /* Forget files left open on the previous image */
+    file.close();
+    root.close();
+    memset(image, 0, sizeof(image));
+
+    fbs_t *fbs = (fbs_t*)image;
+    fbs->jmpToBootCode[0] = 0xEB;
+    fbs->jmpToBootCode[1] = 0x3C;
+    fbs->jmpToBootCode[2] = 0x90;
+    memcpy(fbs->oemName, "LIBMAPLE", 8);
+    fbs->bpb.bytesPerSector = 512;
+    fbs->bpb.sectorsPerCluster = 2;
+    fbs->bpb.reservedSectorCount = 1;
+    fbs->bpb.fatCount = 2;
+    fbs->bpb.rootDirEntryCount = ROOT_ENTRIES;
+    fbs->bpb.totalSectors16 = 0;
+    fbs->bpb.totalSectors32 = IMAGE_BLOCKS;
+    fbs->bpb.mediaType = 0xF8;
+    fbs->bpb.sectorsPerFat16 = FAT_BLOCKS;
+    fbs->bootSectorSig0 = 0x55;
+    fbs->bootSectorSig1 = 0xAA;
+
+    for (int i = 0; i < 2; i++) {
+        uint8 *fat = image + (1 + i * FAT_BLOCKS) * 512;
+        fat[0] = 0xF8;
+        fat[1] = 0xFF;
+        fat[2] = 0xFF;
+        fat[3] = 0xFF;
+    }
+}
+
+static bool mountImage(void) {
+    sim_sd_attach(image, IMAGE_BLOCKS);
+    return card.init((HardwareSPI*)NULL) &&
+        volume.init(&card, 0) &&
+        root.openRoot(&volume);
+}
+
+HOST_TEST(fat_mounts_fat16) {
+    formatImage();
+    CHECK(mountImage());
+    CHECK(volume.fatType() == 16);
+    root.close();
+}
+
+HOST_TEST(fat_write_read_back) {
+    formatImage();
+    CHECK(mountImage());
+
+    for (uint32 i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8)(i * 7 + 3);
+    }
+    CHECK(file.open(&root, "DATA.BIN", O_CREAT | O_WRITE | O_TRUNC));
+    for (int i = 0; i < 5; i++) {
+        CHECK(file.write(data, sizeof(data)) == (int16_t)sizeof(data));
+    }
+    CHECK(file.close());
+
+    uint8 back[sizeof(data)];
+    CHECK(file.open(&root, "DATA.BIN", O_READ));
+    CHECK(file.fileSize() == 5 * sizeof(data));
+    for (int i = 0; i < 5; i++) {
+        CHECK(file.read(back, sizeof(back)) == (int16_t)sizeof(back));
+        CHECK(!memcmp(back, data, sizeof(data)));
+    }
+    CHECK(file.read(back, 1) == 0);
+    file.close();
+
+    CHECK(SdFile::remove(&root, "DATA.BIN"));
+    CHECK(!file.open(&root, "DATA.BIN", O_READ));
+    root.close();
+}
+
+HOST_TEST(fat_no_card) {
+    sim_sd_attach(NULL, 0);
+    CHECK(!card.init((HardwareSPI*)NULL));
+}
+
+HOST_BENCH(fat_append_4k, 2000) {
+    if (iter == 0) {
+        formatImage();
+        mountImage();
+        file.open(&root, "BENCH.BIN", O_CREAT | O_WRITE | O_TRUNC);
+    }
+    if (file.fileSize() > 8 * 1024 * 1024) {
+        file.seekSet(0);
+    }
+    host_sink += file.write(data, sizeof(data));
+}
+
+HOST_BENCH(fat_read_4k, 2000) {
+    uint8 back[sizeof(data)];
+    if (iter == 0) {
+        file.close();
+        file.open(&root, "BENCH.BIN", O_READ);
+    }
+    if (file.read(back, sizeof(back)) <= 0) {
+        file.seekSet(0);
+    }
+    host_sink += back[iter % sizeof(back)];
+}
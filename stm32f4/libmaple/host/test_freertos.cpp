@@ -0,0 +1,115 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_freertos.cpp
+ * @brief FreeRTOS queue and list code, without the scheduler.
+ */
+
+#include "hosttest.h"
+
+extern "C" {
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "list.h"
+}
+
+static xQueueHandle queue;
+
+HOST_TEST(queue_fifo_order) {
+    if (queue == NULL) {
+        queue = xQueueCreate(16, sizeof(uint32));
+    }
+    CHECK(queue != NULL);
+
+    uint32 v;
+    for (uint32 i = 0; i < 16; i++) {
+        CHECK(xQueueSend(queue, &i, 0) == pdTRUE);
+    }
+    v = 99;
+    CHECK(xQueueSend(queue, &v, 0) == errQUEUE_FULL);
+    CHECK(uxQueueMessagesWaiting(queue) == 16);
+    for (uint32 i = 0; i < 16; i++) {
+        CHECK(xQueueReceive(queue, &v, 0) == pdTRUE);
+        CHECK(v == i);
+    }
+    CHECK(xQueueReceive(queue, &v, 0) == pdFALSE);
+}
+
+HOST_TEST(list_sorted_insert) {
+    xList list;
+    xListItem items[5];
+    portTickType values[5] = { 30, 10, 50, 20, 40 };
+
+    vListInitialise(&list);
+    for (int i = 0; i < 5; i++) {
+        vListInitialiseItem(&items[i]);
+        listSET_LIST_ITEM_VALUE(&items[i], values[i]);
+        vListInsert(&list, &items[i]);
+    }
+    CHECK(listCURRENT_LIST_LENGTH(&list) == 5);
+
+    portTickType last = 0;
+    xListItem *item = (xListItem*)list.xListEnd.pxNext;
+    for (int i = 0; i < 5; i++) {
+        CHECK(listGET_LIST_ITEM_VALUE(item) > last);
+        last = listGET_LIST_ITEM_VALUE(item);
+        item = (xListItem*)item->pxNext;
+    }
+    for (int i = 0; i < 5; i++) {
+        vListRemove(&items[i]);
+    }
+    CHECK(listLIST_IS_EMPTY(&list));
+}
+
+HOST_BENCH(queue_send_receive, 1000000) {
+    if (queue == NULL) {
+        queue = xQueueCreate(16, sizeof(uint32));
+    }
+    uint32 v = iter;
+    xQueueSend(queue, &v, 0);
+    xQueueReceive(queue, &v, 0);
+    host_sink += v;
+}
+
+HOST_BENCH(list_insert_remove_8, 200000) {
+    static xList list;
+    static xListItem items[8];
+    if (iter == 0) {
+        vListInitialise(&list);
+        for (int i = 0; i < 8; i++) {
+            vListInitialiseItem(&items[i]);
+        }
+    }
+    for (int i = 0; i < 8; i++) {
+        listSET_LIST_ITEM_VALUE(&items[i], (iter * 2654435761U + i * 40503U) & 0xFFFF);
+        vListInsert(&list, &items[i]);
+    }
+    for (int i = 0; i < 8; i++) {
+        vListRemove(&items[i]);
+    }
+    host_sink += listCURRENT_LIST_LENGTH(&list);
+}
@@ -0,0 +1,58 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_math.cpp
+ * @brief wirish_math helpers.
+ */
+
+#include "hosttest.h"
+#include "wirish_math.h"
+
+HOST_TEST(random_stays_in_range) {
+    randomSeed(1234);
+    for (int i = 0; i < 10000; i++) {
+        long r = random(-5, 17);
+        CHECK(r >= -5 && r < 17);
+    }
+    CHECK(random(0) == 0);
+    CHECK(random(9, 3) == 9);
+}
+
+HOST_TEST(map_and_constrain) {
+    CHECK(map(512, 0, 1023, 0, 255) == 127);
+    CHECK(map(0, 0, 4095, 100, -100) == 100);
+    CHECK(constrain(300, 0, 255) == 255);
+    CHECK(constrain(-3, 0, 255) == 0);
+}
+
+HOST_BENCH(random_range, 1000000) {
+    host_sink += random(0, 1000);
+}
+
+HOST_BENCH(map_adc_to_pwm, 2000000) {
+    host_sink += map(iter & 4095, 0, 4095, 0, 65535);
+}
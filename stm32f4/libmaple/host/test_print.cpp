@@ -0,0 +1,119 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_print.cpp
+ * @brief Print formatting and throughput.
+ */
+
+#include <string.h>
+
+#include "hosttest.h"
+#include "Print.h"
+
+class BufferPrint : public Print {
+public:
+    BufferPrint() : len(0) { buf[0] = '\0'; }
+
+    void write(uint8 ch) {
+        if (len < sizeof(buf) - 1) {
+            buf[len++] = ch;
+            buf[len] = '\0';
+        }
+    }
+
+    void clear(void) { len = 0; buf[0] = '\0'; }
+    bool is(const char *s) const { return !strcmp(buf, s); }
+
+    char buf[128];
+    uint32 len;
+};
+
+static BufferPrint out;
+
+HOST_TEST(print_integers) {
+    out.clear();
+    out.print(0);
+    out.print(' ');
+    out.print(-42);
+    out.print(' ');
+    out.print(4294967295U);
+    out.print(' ');
+    out.print(-9223372036854775807LL - 1);
+    CHECK(out.is("0 -42 4294967295 -9223372036854775808"));
+}
+
+HOST_TEST(print_bases) {
+    out.clear();
+    out.print(255, HEX);
+    out.print(' ');
+    out.print(5, BIN);
+    out.print(' ');
+    out.print(8, OCT);
+    out.print(' ');
+    out.print(0x0801ABCDU, HEX);
+    CHECK(out.is("FF 101 10 801ABCD"));
+}
+
+HOST_TEST(print_floats) {
+    out.clear();
+    out.print(1.999, 2);
+    out.print(' ');
+    out.print(-0.5, 1);
+    out.print(' ');
+    out.print(3.0, 0);
+    CHECK(out.is("2.00 -0.5 3"));
+}
+
+HOST_TEST(println_ends_crlf) {
+    out.clear();
+    out.println("ab");
+    CHECK(out.is("ab\r\n"));
+}
+
+HOST_BENCH(print_uint32_dec, 200000) {
+    out.clear();
+    out.print(iter * 2654435761U);
+    host_sink += out.len;
+}
+
+HOST_BENCH(print_uint32_hex, 200000) {
+    out.clear();
+    out.print(iter * 2654435761U, HEX);
+    host_sink += out.len;
+}
+
+HOST_BENCH(print_double_2, 100000) {
+    out.clear();
+    out.print(iter * 0.37, 2);
+    host_sink += out.len;
+}
+
+HOST_BENCH(print_string_32, 200000) {
+    out.clear();
+    out.print("the quick brown fox jumps over..");
+    host_sink += out.len;
+}
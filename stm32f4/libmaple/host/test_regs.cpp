@@ -0,0 +1,97 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_regs.cpp
+ * @brief Register-level code against the simulated register maps.
+ */
+
+#include "hosttest.h"
+#include "usart.h"
+#include "spi.h"
+#include "gpio.h"
+
+HOST_TEST(usart_tx_waits_for_txe) {
+    uint8 byte = 'x';
+    CHECK(usart_tx(USART2, &byte, 1) == 0);
+
+    USART2->regs->SR = USART_SR_TXE;
+    CHECK(usart_tx(USART2, &byte, 1) == 1);
+    CHECK(USART2->regs->DR == 'x');
+    CHECK(sim_reg_read(0x40004404) == 'x');
+}
+
+HOST_TEST(usart_putudec_digits) {
+    /* DR only keeps the last byte; the count of bytes is all we see */
+    USART2->regs->SR = USART_SR_TXE;
+    usart_putudec(USART2, 4294967295U);
+    CHECK(USART2->regs->DR == '5');
+}
+
+HOST_BENCH(usart_putstr_16, 1000000) {
+    USART2->regs->SR = USART_SR_TXE;
+    usart_putstr(USART2, "0123456789abcdef");
+    host_sink += USART2->regs->DR;
+}
+
+HOST_TEST(usart_regs_tx_matches_usart_tx) {
+    uint8 buf[2] = {'a', 'b'};
+    USART2_BASE->SR = 0;
+    CHECK(usart_regs_tx(USART2_BASE, buf, 2) == 0);
+    USART2_BASE->SR = USART_SR_TXE;
+    CHECK(usart_regs_tx(USART2_BASE, buf, 2) == 2);
+    CHECK(USART2->regs->DR == 'b');
+}
+
+HOST_TEST(spi_regs_tx_frame_size) {
+    uint16 words[1] = {0x1234};
+    SPI1_BASE->SR = SPI_SR_TXE;
+    SPI1_BASE->CR1 = SPI_CR1_DFF_8_BIT;
+    CHECK(spi_regs_tx(SPI1_BASE, words, 1) == 1);
+    CHECK(SPI1_BASE->DR == 0x34);
+    SPI1_BASE->CR1 = SPI_CR1_DFF_16_BIT;
+    CHECK(spi_regs_tx(SPI1_BASE, words, 1) == 1);
+    CHECK(SPI1_BASE->DR == 0x1234);
+}
+
+HOST_TEST(gpio_regs_write_bit_bsrr) {
+    gpio_regs_write_bit(GPIOD_BASE, 13, 1);
+    CHECK(GPIOD_BASE->BSRRL == BIT(13));
+    gpio_regs_write_bit(GPIOD_BASE, 13, 0);
+    CHECK(GPIOD_BASE->BSRRH == BIT(13));
+}
+
+HOST_BENCH(usart_tx_dev_16, 1000000) {
+    static const uint8 buf[16] = "0123456789abcde";
+    USART2->regs->SR = USART_SR_TXE;
+    host_sink += usart_tx(USART2, buf, sizeof(buf));
+}
+
+HOST_BENCH(usart_regs_tx_16, 1000000) {
+    static const uint8 buf[16] = "0123456789abcde";
+    USART2_BASE->SR = USART_SR_TXE;
+    host_sink += usart_regs_tx(USART2_BASE, buf, sizeof(buf));
+}
@@ -0,0 +1,89 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_ring_buffer.cpp
+ * @brief ring_buffer.h behaviour and cost per operation.
+ */
+
+#include "hosttest.h"
+#include "ring_buffer.h"
+
+static uint8 storage[64];
+static ring_buffer rb;
+
+HOST_TEST(rb_fill_and_drain) {
+    rb_init(&rb, 8, storage);
+    CHECK(rb_is_empty(&rb));
+    for (int i = 0; i < 7; i++) {
+        CHECK(rb_safe_insert(&rb, i));
+    }
+    CHECK(rb_is_full(&rb));
+    CHECK(!rb_safe_insert(&rb, 99));
+    CHECK(rb_full_count(&rb) == 7);
+    for (int i = 0; i < 7; i++) {
+        CHECK(rb_safe_remove(&rb) == i);
+    }
+    CHECK(rb_safe_remove(&rb) == -1);
+}
+
+HOST_TEST(rb_wraps) {
+    rb_init(&rb, 4, storage);
+    for (int i = 0; i < 100; i++) {
+        rb_insert(&rb, i);
+        rb_insert(&rb, i + 1);
+        CHECK(rb_full_count(&rb) == 2);
+        CHECK(rb_remove(&rb) == i);
+        CHECK(rb_remove(&rb) == (uint8)(i + 1));
+    }
+}
+
+HOST_TEST(rb_push_insert_drops_oldest) {
+    rb_init(&rb, 4, storage);
+    rb_insert(&rb, 1);
+    rb_insert(&rb, 2);
+    rb_insert(&rb, 3);
+    CHECK(rb_push_insert(&rb, 4) == 1);
+    CHECK(rb_remove(&rb) == 2);
+}
+
+HOST_BENCH(rb_insert_remove, 2000000) {
+    if (iter == 0) {
+        rb_init(&rb, sizeof(storage), storage);
+    }
+    rb_insert(&rb, (uint8)iter);
+    host_sink += rb_remove(&rb);
+}
+
+HOST_BENCH(rb_safe_insert_full_count, 2000000) {
+    if (iter == 0) {
+        rb_init(&rb, sizeof(storage), storage);
+    }
+    if (!rb_safe_insert(&rb, (uint8)iter)) {
+        rb_reset(&rb);
+    }
+    host_sink += rb_full_count(&rb);
+}
@@ -0,0 +1,451 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_timer.cpp
+ * @brief 32-bit timers, period calculation, input capture, encoder
+ *        mode, DMA bursts and complementary PWM.
+ */
+
+#include "hosttest.h"
+#include "timer.h"
+#include "timer_burst.h"
+#include "timer_capture.h"
+#include "timer_encoder.h"
+
+HOST_TEST(timer_32bit_registers) {
+    sim_reset();
+    CHECK(timer_is_32bit(TIMER2));
+    CHECK(timer_is_32bit(TIMER5));
+    CHECK(!timer_is_32bit(TIMER1));
+    CHECK(!timer_is_32bit(TIMER3));
+    CHECK(timer_max_reload(TIMER2) == 0xFFFFFFFFUL);
+    CHECK(timer_max_reload(TIMER4) == 0xFFFF);
+
+    timer_set_reload(TIMER5, 0x12345678);
+    timer_set_compare(TIMER5, TIMER_CH3, 0x0ABCDEF0);
+    timer_set_count(TIMER5, 0x80000001);
+    CHECK(timer_get_reload(TIMER5) == 0x12345678);
+    CHECK(timer_get_compare(TIMER5, TIMER_CH3) == 0x0ABCDEF0);
+    CHECK(TIMER5->regs.gen->CCR3 == 0x0ABCDEF0);
+    CHECK(timer_get_count(TIMER5) == 0x80000001);
+}
+
+HOST_TEST(timer_period_16bit) {
+    uint32 factor, reload;
+
+    /* 1 ms at 84 MHz: 84000 ticks needs a prescaler of 2. */
+    CHECK(timer_calc_period(84000000, 1000, 0xFFFF, &factor, &reload) == 0);
+    CHECK(factor == 2);
+    CHECK(reload == 41999);
+
+    /* Fits unprescaled. */
+    CHECK(timer_calc_period(168000000, 100, 0xFFFF, &factor, &reload) == 0);
+    CHECK(factor == 1);
+    CHECK(reload == 16799);
+
+    /* Exactly 65536 ticks is still unprescaled. */
+    CHECK(timer_calc_period(65536000, 1000, 0xFFFF, &factor, &reload) == 0);
+    CHECK(factor == 1);
+    CHECK(reload == 0xFFFF);
+
+    /* 1 s at 84 MHz: smallest factor is ceil(84e6 / 65536) = 1282. */
+    CHECK(timer_calc_period(84000000, 1000000, 0xFFFF,
+                            &factor, &reload) == 0);
+    CHECK(factor == 1282);
+    CHECK(reload == 65522);
+    CHECK(reload <= 0xFFFF);
+
+    /* 60 s does not fit: clamp to the longest period. */
+    CHECK(timer_calc_period(84000000, 60000000, 0xFFFF,
+                            &factor, &reload) == -1);
+    CHECK(factor == 65536);
+    CHECK(reload == 0xFFFF);
+
+    /* Too short to count. */
+    CHECK(timer_calc_period(1000000, 1, 0xFFFF, &factor, &reload) == -1);
+    CHECK(factor == 1);
+    CHECK(reload == 1);
+}
+
+HOST_TEST(timer_period_32bit) {
+    uint32 factor, reload;
+
+    /* 1 s at 84 MHz runs unprescaled on a 32-bit timer. */
+    CHECK(timer_calc_period(84000000, 1000000, 0xFFFFFFFFUL,
+                            &factor, &reload) == 0);
+    CHECK(factor == 1);
+    CHECK(reload == 83999999);
+
+    /* 60 s is 5.04e9 ticks: a prescaler of 2 is needed. */
+    CHECK(timer_calc_period(84000000, 60000000, 0xFFFFFFFFUL,
+                            &factor, &reload) == 0);
+    CHECK(factor == 2);
+    CHECK(reload == 2519999999UL);
+}
+
+HOST_TEST(timer_input_capture_bits) {
+    sim_reset();
+    timer_gen_reg_map *regs = TIMER3->regs.gen;
+
+    timer_ic_setup(TIMER3, 2, TIMER_IC_FALLING, TIMER_IC_DIV4, 5);
+    CHECK(regs->CCMR1 == (uint32)(1 | 2 << 2 | 5 << 4) << 8);
+    /* CCxE goes through the bit-band alias, which the sim keeps apart */
+    CHECK(regs->CCER == TIMER_CCER_CC2P);
+    CHECK(*bb_perip(&regs->CCER, TIMER_CCER_CC2E_BIT) == 1);
+
+    timer_ic_setup(TIMER3, 3, TIMER_IC_BOTH, TIMER_IC_DIV1, 15);
+    CHECK(regs->CCMR2 == (1 | 15 << 4));
+    CHECK((regs->CCER & 0xF00) == (TIMER_CCER_CC3NP | TIMER_CCER_CC3P));
+
+    timer_ic_setup(TIMER3, 2, TIMER_IC_RISING, TIMER_IC_DIV1, 0);
+    CHECK(regs->CCMR1 == 1 << 8);
+    CHECK((regs->CCER & 0xF0) == 0);
+}
+
+HOST_TEST(timer_pwm_input_bits) {
+    sim_reset();
+    timer_gen_reg_map *regs = TIMER4->regs.gen;
+
+    CHECK(timer_ic_set_pwm_input(TIMER4, 1, TIMER_IC_RISING, 3) == 0);
+    CHECK(regs->CCMR1 == ((1 | 3 << 4) | (2 | 3 << 4) << 8));
+    CHECK(regs->CCER == TIMER_CCER_CC2P);
+    CHECK(*bb_perip(&regs->CCER, TIMER_CCER_CC1E_BIT) == 1);
+    CHECK(*bb_perip(&regs->CCER, TIMER_CCER_CC2E_BIT) == 1);
+    CHECK(regs->SMCR == (TIMER_SMCR_TS_TI1FP1 | TIMER_SMCR_SMS_RESET));
+
+    CHECK(timer_ic_set_pwm_input(TIMER4, 2, TIMER_IC_FALLING, 0) == 0);
+    CHECK(regs->CCMR1 == (2 | 1 << 8));
+    CHECK(regs->CCER == TIMER_CCER_CC2P);
+    CHECK(regs->SMCR == (TIMER_SMCR_TS_TI2FP2 | TIMER_SMCR_SMS_RESET));
+
+    CHECK(timer_ic_set_pwm_input(TIMER4, 3, TIMER_IC_RISING, 0) == -1);
+    CHECK(timer_ic_set_pwm_input(TIMER4, 1, TIMER_IC_BOTH, 0) == -1);
+    CHECK(timer_ic_set_pwm_input(TIMER6, 1, TIMER_IC_RISING, 0) == -1);
+}
+
+HOST_TEST(timer_capture_dma_streams) {
+    dma_dev *dma;
+    dma_stream stream;
+    dma_channel request;
+
+    CHECK(timer_capture_dma_request(TIMER2, 1, &dma, &stream, &request) == 0);
+    CHECK(dma == DMA1 && stream == DMA_STREAM5 && request == DMA_CH3);
+    CHECK(timer_capture_dma_request(TIMER8, 4, &dma, &stream, &request) == 0);
+    CHECK(dma == DMA2 && stream == DMA_STREAM7 && request == DMA_CH7);
+    CHECK(timer_capture_dma_request(TIMER4, 4, &dma, &stream, &request) < 0);
+    CHECK(timer_capture_dma_request(TIMER6, 1, &dma, &stream, &request) < 0);
+}
+
+HOST_TEST(timer_capture_ring) {
+    static uint32 ring[8];
+    timer_capture cap;
+    uint32 stamp;
+
+    sim_reset();
+    CHECK(timer_capture_init(&cap, TIMER3, 1, ring, 2) < 0);
+    CHECK(timer_capture_init(&cap, TIMER3, 1, ring, 8) == 0);
+    CHECK(cap.dma == DMA1 && cap.stream == DMA_STREAM4);
+    dma_stream_reg_map *regs = dma_stream_regs(DMA1, DMA_STREAM4);
+
+    regs->NDTR = 8;
+    CHECK(timer_capture_count(&cap) == 0);
+    CHECK(timer_capture_read(&cap, &stamp) == -1);
+    CHECK(timer_capture_span(&cap, 1) == 0);
+
+    for (uint32 i = 0; i < 5; i++) {
+        ring[i] = 100 * (i + 1);
+    }
+    regs->NDTR = 3;
+    CHECK(timer_capture_count(&cap) == 5);
+    CHECK(timer_capture_span(&cap, 4) == 400);
+    CHECK(timer_capture_span(&cap, 5) == 0);
+    CHECK(timer_capture_read(&cap, &stamp) == 0 && stamp == 100);
+    CHECK(timer_capture_read(&cap, &stamp) == 0 && stamp == 200);
+    CHECK(timer_capture_available(&cap) == 3);
+
+    /* 16-bit counter wrapping between captures */
+    ring[5] = 65500;
+    ring[6] = 64;
+    regs->NDTR = 1;
+    CHECK(timer_capture_span(&cap, 1) == 100);
+
+    /* Two laps later the reader has lost captures 2 to 10 */
+    timer_capture_lap(&cap);
+    timer_capture_lap(&cap);
+    regs->NDTR = 6;
+    CHECK(timer_capture_count(&cap) == 18);
+    CHECK(timer_capture_available(&cap) == 7);
+    CHECK(cap.overruns == 9);
+    ring[3] = 1234;
+    CHECK(timer_capture_read(&cap, &stamp) == 0 && stamp == 1234);
+
+    /* A wrap whose interrupt is still pending */
+    DMA1->regs->HISR = DMA_ISR_TCIF;
+    regs->NDTR = 7;
+    CHECK(timer_capture_count(&cap) == 25);
+}
+
+HOST_TEST(timer_encoder_mode_bits) {
+    sim_reset();
+    timer_gen_reg_map *regs = TIMER4->regs.gen;
+
+    regs->SMCR = TIMER_SMCR_TS_TI1FP1 | TIMER_SMCR_SMS_RESET;
+    CHECK(timer_encoder_setup(TIMER4, TIMER_ENCODER_TI12, 6, 1) == 0);
+    CHECK(regs->CCMR1 == ((1 | 6 << 4) | (1 | 6 << 4) << 8));
+    CHECK(regs->CCER == TIMER_CCER_CC1P);
+    CHECK(regs->SMCR == (TIMER_SMCR_TS_TI1FP1 | TIMER_SMCR_SMS_ENCODER3));
+    CHECK(regs->ARR == 0xFFFF);
+    CHECK(regs->PSC == 0);
+    CHECK(timer_encoder_setup(TIMER6, TIMER_ENCODER_TI1, 0, 0) == -1);
+}
+
+HOST_TEST(timer_encoder_16bit_extension) {
+    static timer_encoder enc;
+    timer_gen_reg_map *regs = TIMER3->regs.gen;
+
+    sim_reset();
+    regs->CNT = 0x1000;
+    timer_encoder_init(&enc, TIMER3);
+    CHECK(timer_encoder_read(&enc) == 0);
+    regs->CNT = 0x4000;
+    CHECK(timer_encoder_read(&enc) == 0x3000);
+    timer_encoder_sync(&enc);
+    CHECK(regs->CCR3 == 0x8000 && regs->CCR4 == 0x0000);
+
+    /* Forward through the wrap, syncing every 0x4000 counts */
+    regs->CNT = 0x8000;
+    timer_encoder_sync(&enc);
+    regs->CNT = 0xC000;
+    timer_encoder_sync(&enc);
+    regs->CNT = 0x0000;
+    timer_encoder_sync(&enc);
+    CHECK(regs->CCR3 == 0x4000 && regs->CCR4 == 0xC000);
+    regs->CNT = 0x0123;
+    CHECK(timer_encoder_read(&enc) == 0x10123 - 0x1000);
+
+    /* A sync 0x3000 counts late still reads right */
+    regs->CNT = 0x7000;
+    CHECK(timer_encoder_read(&enc) == 0x17000 - 0x1000);
+    timer_encoder_sync(&enc);
+
+    /* Backward, dithering across the wrap point */
+    regs->CNT = 0x3000;
+    timer_encoder_sync(&enc);
+    regs->CNT = 0x0001;
+    CHECK(timer_encoder_read(&enc) == 0x10001 - 0x1000);
+    regs->CNT = 0xFFFF;
+    timer_encoder_sync(&enc);
+    regs->CNT = 0x0002;
+    timer_encoder_sync(&enc);
+    regs->CNT = 0xFFFE;
+    timer_encoder_sync(&enc);
+    CHECK(timer_encoder_read(&enc) == 0xFFFE - 0x1000);
+    regs->CNT = 0xA000;
+    CHECK(timer_encoder_read(&enc) == 0xA000 - 0x1000);
+    timer_encoder_sync(&enc);
+    regs->CNT = 0x6000;
+    timer_encoder_sync(&enc);
+    regs->CNT = 0x2000;
+    CHECK(timer_encoder_read(&enc) == 0x1000);
+    timer_encoder_sync(&enc);
+    regs->CNT = 0xE000;
+    CHECK(timer_encoder_read(&enc) == -0x3000);
+
+    timer_encoder_write(&enc, 500);
+    CHECK(timer_encoder_read(&enc) == 500);
+    regs->CNT = 0xE010;
+    CHECK(timer_encoder_read(&enc) == 516);
+}
+
+HOST_TEST(timer_encoder_32bit) {
+    static timer_encoder enc;
+    timer_gen_reg_map *regs = TIMER5->regs.gen;
+
+    sim_reset();
+    timer_encoder_init(&enc, TIMER5);
+    CHECK(enc.wide);
+    regs->CNT = 0xFFFFFFF0;
+    CHECK(timer_encoder_read(&enc) == -16);
+    regs->CNT = 0x12345678;
+    CHECK(timer_encoder_read(&enc) == 0x12345678);
+    timer_encoder_write(&enc, -1);
+    regs->CNT = 0x12345679;
+    CHECK(timer_encoder_read(&enc) == 0);
+}
+
+static void burst_handler(void) {
+}
+
+HOST_TEST(timer_burst_dma_streams) {
+    dma_dev *dma;
+    dma_stream stream;
+    dma_channel request;
+
+    CHECK(timer_burst_dma_request(TIMER1, &dma, &stream, &request) == 0);
+    CHECK(dma == DMA2 && stream == DMA_STREAM5 && request == DMA_CH6);
+    CHECK(timer_burst_dma_request(TIMER3, &dma, &stream, &request) == 0);
+    CHECK(dma == DMA1 && stream == DMA_STREAM2 && request == DMA_CH5);
+    CHECK(timer_burst_dma_request(TIMER2, &dma, &stream, &request) < 0);
+    CHECK(timer_burst_dma_request(TIMER6, &dma, &stream, &request) < 0);
+}
+
+HOST_TEST(timer_burst_send_once) {
+    static timer_burst burst;
+    static uint16 slots[2 * 17];
+    timer_adv_reg_map *regs = TIMER8->regs.adv;
+    dma_stream_reg_map *dregs = dma_stream_regs(DMA2, DMA_STREAM1);
+
+    sim_reset();
+    CHECK(timer_burst_init(&burst, TIMER8, 4, 2) < 0);
+    CHECK(timer_burst_init(&burst, TIMER5, 1, 1) < 0);
+    regs->CCR1 = 100;
+    CHECK(timer_burst_init(&burst, TIMER8, 1, 2) == 0);
+    CHECK(regs->CCMR1 == 0x6868);
+    CHECK(*bb_perip(&regs->CCER, 0) && *bb_perip(&regs->CCER, 4));
+    CHECK(regs->CCR1 == 0 && (regs->BDTR & TIMER_BDTR_MOE));
+
+    CHECK(timer_burst_send(&burst, slots, 17, burst_handler) == 0);
+    CHECK(regs->DCR == (TIMER_DCR_DBA_CCR1 | TIMER_DCR_DBL_2BYTE));
+    CHECK(dregs->PAR == (uint32)(unsigned long)&regs->DMAR);
+    CHECK(dregs->M0AR == (uint32)(unsigned long)slots);
+    CHECK(dregs->NDTR == 34);
+    CHECK((dregs->CR >> 25) == DMA_CH7);
+    CHECK(dregs->CR & DMA_SCR_MINC);
+    CHECK(!(dregs->CR & (DMA_SCR_DBM | DMA_SCR_CIRC)));
+    CHECK(*bb_perip(&regs->DIER, TIMER_DIER_UDE_BIT));
+
+    /* Transfer complete stops the update requests */
+    CHECK(timer_burst_finish(&burst) == 0);
+    DMA2->regs->LISR = DMA_ISR_TCIF << 6;
+    CHECK(timer_burst_finish(&burst) == 1);
+    CHECK(burst.finished == 1);
+    CHECK(!*bb_perip(&regs->DIER, TIMER_DIER_UDE_BIT));
+}
+
+HOST_TEST(timer_burst_stream_double_buffer) {
+    static timer_burst burst;
+    static uint16 slots[2][8];
+    timer_gen_reg_map *regs = TIMER3->regs.gen;
+    dma_stream_reg_map *dregs = dma_stream_regs(DMA1, DMA_STREAM2);
+
+    sim_reset();
+    CHECK(timer_burst_init(&burst, TIMER3, 3, 1) == 0);
+    CHECK(regs->CCMR2 == 0x68);
+    CHECK(timer_burst_stream(&burst, slots[0], NULL, 8, burst_handler) < 0);
+    CHECK(timer_burst_stream(&burst, slots[0], slots[1], 8,
+                             burst_handler) == 0);
+    CHECK(regs->DCR == TIMER_DCR_DBA_CCR3);
+    CHECK(dregs->CR & DMA_SCR_DBM);
+    CHECK(dregs->M1AR == (uint32)(unsigned long)slots[1]);
+    CHECK(dregs->NDTR == 8);
+
+    /* Each finished buffer is refilled while the other plays */
+    DMA1->regs->LISR = DMA_ISR_TCIF << 16;
+    CHECK(timer_burst_finish(&burst) == 1);
+    CHECK(*bb_perip(&regs->DIER, TIMER_DIER_UDE_BIT));
+    dregs->CR |= DMA_SCR_CT;
+    CHECK(timer_burst_idle_buffer(&burst) == slots[0]);
+    dregs->CR &= ~DMA_SCR_CT;
+    CHECK(timer_burst_idle_buffer(&burst) == slots[1]);
+
+    regs->CCR3 = 42;
+    timer_burst_stop(&burst);
+    CHECK(regs->CCR3 == 0);
+    CHECK(!*bb_perip(&regs->DIER, TIMER_DIER_UDE_BIT));
+}
+
+HOST_TEST(timer_dead_time_encoding) {
+    /* Each DTG range: exact ticks, then rounded up to the next step */
+    CHECK(timer_dead_time_dtg(0) == 0);
+    CHECK(timer_dead_time_dtg(127) == 127);
+    CHECK(timer_dead_time_dtg(128) == 0x80);
+    CHECK(timer_dead_time_dtg(129) == 0x81);
+    CHECK(timer_dead_time_dtg(254) == 0xBF);
+    CHECK(timer_dead_time_dtg(255) == 0xC0);
+    CHECK(timer_dead_time_dtg(504) == 0xDF);
+    CHECK(timer_dead_time_dtg(505) == 0xE0);
+    CHECK(timer_dead_time_dtg(1008) == 0xFF);
+    CHECK(timer_dead_time_dtg(2000) == 0xFF);
+
+    CHECK(timer_dead_time_ticks(0x7F) == 127);
+    CHECK(timer_dead_time_ticks(0x81) == 130);
+    CHECK(timer_dead_time_ticks(0xC0) == 256);
+    CHECK(timer_dead_time_ticks(0xE0) == 512);
+    CHECK(timer_dead_time_ticks(0xFF) == 1008);
+}
+
+HOST_TEST(timer_complementary_pwm_bits) {
+    timer_adv_reg_map *regs = TIMER1->regs.adv;
+
+    sim_reset();
+    timer_set_mode(TIMER1, TIMER_CH2, TIMER_PWM_COMPLEMENTARY);
+    CHECK((regs->CCMR1 >> 8) == (TIMER_OC_MODE_PWM_1 | TIMER_OC_PE));
+    CHECK(*bb_perip(&regs->CCER, TIMER_CCER_CC2E_BIT));
+    CHECK(*bb_perip(&regs->CCER, TIMER_CCER_CC2NE_BIT));
+    timer_set_mode(TIMER1, TIMER_CH2, TIMER_DISABLED);
+    CHECK(!*bb_perip(&regs->CCER, TIMER_CCER_CC2E_BIT));
+    CHECK(!*bb_perip(&regs->CCER, TIMER_CCER_CC2NE_BIT));
+
+    /* No complementary outputs on general purpose timers */
+    timer_set_mode(TIMER3, TIMER_CH1, TIMER_PWM_COMPLEMENTARY);
+    CHECK(!*bb_perip(&TIMER3->regs.gen->CCER, TIMER_CCER_CC1NE_BIT));
+
+    regs->CR1 = TIMER_CR1_DIR | TIMER_CR1_ARPE;
+    timer_set_count_mode(TIMER1, TIMER_COUNT_CENTER_BOTH);
+    CHECK(regs->CR1 == (TIMER_CR1_CKD_CMS_CENTER3 | TIMER_CR1_ARPE));
+    timer_set_count_mode(TIMER1, TIMER_COUNT_EDGE);
+    CHECK(regs->CR1 == TIMER_CR1_ARPE);
+
+    timer_set_ccx_preload(TIMER1, 1, 0);
+    CHECK(regs->CR2 == TIMER_CR2_CCPC);
+    timer_set_ccx_preload(TIMER1, 1, 1);
+    CHECK(regs->CR2 == (TIMER_CR2_CCPC | TIMER_CR2_CCUS));
+    timer_set_ccx_preload(TIMER1, 0, 1);
+    CHECK(regs->CR2 == 0);
+}
+
+HOST_TEST(timer_break_and_dead_time) {
+    timer_adv_reg_map *regs = TIMER1->regs.adv;
+
+    sim_reset();
+    regs->BDTR = TIMER_BDTR_OSSR;
+    CHECK(timer_set_dead_time(TIMER1, 300) == 304);
+    CHECK(regs->BDTR == (TIMER_BDTR_OSSR | 0xC6));
+    timer_break_setup(TIMER1, 1, 1, 0);
+    CHECK(regs->BDTR == (TIMER_BDTR_OSSR | TIMER_BDTR_BKE |
+                         TIMER_BDTR_BKP | 0xC6));
+    timer_break_setup(TIMER1, 1, 0, 1);
+    CHECK(regs->BDTR == (TIMER_BDTR_OSSR | TIMER_BDTR_BKE |
+                         TIMER_BDTR_AOE | 0xC6));
+    timer_break_setup(TIMER1, 0, 0, 0);
+    CHECK(regs->BDTR == (TIMER_BDTR_OSSR | 0xC6));
+
+    regs->BDTR |= TIMER_BDTR_MOE;
+    CHECK(timer_get_main_output(TIMER1));
+    regs->BDTR &= ~TIMER_BDTR_MOE;
+    CHECK(!timer_get_main_output(TIMER1));
+}
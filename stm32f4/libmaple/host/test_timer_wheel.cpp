@@ -0,0 +1,278 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file test_timer_wheel.cpp
+ * @brief timer_wheel.h behaviour, and its cost against a sorted list.
+ */
+
+#include "hosttest.h"
+#include "timer_wheel.h"
+
+static timer_wheel tw;
+
+struct Probe {
+    wheel_timer t;
+    uint32 fired;
+    uint32 lastTick;
+    uint32 stopAfter;
+    wheel_timer *victim;
+};
+
+static void probeFired(void *arg) {
+    Probe *p = (Probe*)arg;
+    p->fired++;
+    p->lastTick = timer_wheel_now(&tw);
+    if (p->stopAfter && p->fired == p->stopAfter) {
+        timer_wheel_stop(&tw, &p->t);
+    }
+    if (p->victim) {
+        timer_wheel_stop(&tw, p->victim);
+    }
+}
+
+static void probeInit(Probe *p) {
+    wheel_timer_init(&p->t, probeFired, p);
+    p->fired = 0;
+    p->lastTick = 0;
+    p->stopAfter = 0;
+    p->victim = NULL;
+}
+
+HOST_TEST(wheel_one_shot_exact_tick) {
+    static const uint32 delays[] = {
+        1, 2, 63, 64, 65, 127, 4095, 4096, 4097, 70000, 262143, 262144,
+        TIMER_WHEEL_MAX_DELAY, TIMER_WHEEL_MAX_DELAY + 1000,
+    };
+    const uint32 n = sizeof(delays) / sizeof(delays[0]);
+    static Probe probes[sizeof(delays) / sizeof(delays[0])];
+
+    /* Start off a level boundary so the cascades are not aligned */
+    timer_wheel_init(&tw, 0xFFFF0123);
+    for (uint32 i = 0; i < n; i++) {
+        probeInit(&probes[i]);
+        timer_wheel_start(&tw, &probes[i].t, delays[i], 0);
+    }
+    CHECK(tw.count == n);
+    timer_wheel_advance(&tw, TIMER_WHEEL_MAX_DELAY + 2000);
+    for (uint32 i = 0; i < n; i++) {
+        CHECK(probes[i].fired == 1);
+        CHECK(probes[i].lastTick == 0xFFFF0123 + delays[i]);
+        CHECK(!wheel_timer_active(&probes[i].t));
+    }
+    CHECK(tw.count == 0);
+}
+
+HOST_TEST(wheel_periodic_and_stop) {
+    Probe a, b;
+
+    timer_wheel_init(&tw, 0);
+    probeInit(&a);
+    probeInit(&b);
+    a.stopAfter = 5;
+    timer_wheel_start(&tw, &a.t, 10, 100);
+    timer_wheel_start(&tw, &b.t, 50, 0);
+    timer_wheel_stop(&tw, &b.t);
+    timer_wheel_stop(&tw, &b.t);
+    timer_wheel_advance(&tw, 1000);
+    CHECK(a.fired == 5);
+    CHECK(a.lastTick == 410);
+    CHECK(b.fired == 0);
+    CHECK(tw.count == 0);
+}
+
+HOST_TEST(wheel_callback_stops_slot_mate) {
+    Probe a, b;
+
+    timer_wheel_init(&tw, 0);
+    probeInit(&a);
+    probeInit(&b);
+    timer_wheel_start(&tw, &a.t, 20, 0);
+    timer_wheel_start(&tw, &b.t, 20, 0);
+    /* b was linked last, so it runs first; let it stop a */
+    b.victim = &a.t;
+    timer_wheel_advance(&tw, 20);
+    CHECK(b.fired == 1);
+    CHECK(a.fired == 0);
+    CHECK(tw.count == 0);
+}
+
+HOST_TEST(wheel_restart_moves_expiry) {
+    Probe a;
+
+    timer_wheel_init(&tw, 0);
+    probeInit(&a);
+    timer_wheel_start(&tw, &a.t, 5000, 0);
+    timer_wheel_advance(&tw, 10);
+    timer_wheel_start(&tw, &a.t, 3, 0);
+    CHECK(tw.count == 1);
+    timer_wheel_advance(&tw, 3);
+    CHECK(a.fired == 1);
+    CHECK(a.lastTick == 13);
+    timer_wheel_advance(&tw, 6000);
+    CHECK(a.fired == 1);
+}
+
+HOST_TEST(wheel_next_expiry_never_late) {
+    Probe a;
+
+    timer_wheel_init(&tw, 7);
+    CHECK(timer_wheel_next_expiry(&tw) == TIMER_WHEEL_IDLE);
+    probeInit(&a);
+    timer_wheel_start(&tw, &a.t, 30, 0);
+    CHECK(timer_wheel_next_expiry(&tw) == 30);
+
+    /* Sleep as the tickless owner would; never past the expiry */
+    timer_wheel_start(&tw, &a.t, 100000, 0);
+    uint32 wakeups = 0;
+    while (!a.fired) {
+        uint32 sleep = timer_wheel_next_expiry(&tw);
+        CHECK(sleep >= 1);
+        CHECK(sleep <= TIMER_WHEEL_SLOTS * TIMER_WHEEL_SLOTS);
+        timer_wheel_advance(&tw, sleep);
+        wakeups++;
+    }
+    CHECK(a.lastTick == 7 + 100000);
+    CHECK(timer_wheel_now(&tw) == a.lastTick);
+    CHECK(wakeups < 100);
+}
+
+HOST_TEST(wheel_next_expiry_across_wrap) {
+    Probe a, b;
+    uint32 delay;
+
+    /* Level 0 timers past its wrap, and at the wrap itself */
+    timer_wheel_init(&tw, 60);
+    probeInit(&a);
+    probeInit(&b);
+    timer_wheel_start(&tw, &a.t, 10, 0);
+    CHECK(timer_wheel_next_expiry(&tw) == 10);
+    timer_wheel_start(&tw, &b.t, 4, 0);
+    CHECK(timer_wheel_next_expiry(&tw) == 4);
+    timer_wheel_stop(&tw, &a.t);
+    timer_wheel_stop(&tw, &b.t);
+
+    for (delay = 1; delay < 3 * TIMER_WHEEL_SLOTS; delay++) {
+        timer_wheel_init(&tw, 60);
+        probeInit(&a);
+        timer_wheel_start(&tw, &a.t, delay, 0);
+        while (!a.fired) {
+            timer_wheel_advance(&tw, timer_wheel_next_expiry(&tw));
+        }
+        CHECK(a.lastTick == 60 + delay);
+        CHECK(timer_wheel_now(&tw) == a.lastTick);
+    }
+}
+
+/*
+ * Insert and expire cost: NR_TIMERS timers run at once, one of them is
+ * restarted with a pseudo-random delay and time advances a tick per
+ * iteration.  The reference is a list kept sorted by expiry, the
+ * usual single-timer-interrupt design: O(1) expiry, O(n) insertion.
+ */
+
+#define NR_TIMERS 1024
+#define MAX_DELAY 8192
+
+static wheel_timer benchTimers[NR_TIMERS];
+static uint32 benchSeed;
+
+static void benchExpired(void *arg) {
+    host_sink++;
+}
+
+static uint32 benchDelay(void) {
+    benchSeed = benchSeed * 1664525 + 1013904223;
+    return 1 + (benchSeed >> 8) % MAX_DELAY;
+}
+
+HOST_BENCH(wheel_restart_tick_1k, 2000000) {
+    if (iter == 0) {
+        benchSeed = 1;
+        timer_wheel_init(&tw, 0);
+        for (uint32 i = 0; i < NR_TIMERS; i++) {
+            wheel_timer_init(&benchTimers[i], benchExpired, NULL);
+            timer_wheel_start(&tw, &benchTimers[i], benchDelay(), 0);
+        }
+    }
+    timer_wheel_start(&tw, &benchTimers[iter % NR_TIMERS], benchDelay(), 0);
+    timer_wheel_advance(&tw, 1);
+}
+
+struct ListTimer {
+    ListTimer *next;
+    ListTimer *prev;
+    uint32 expires;
+    bool active;
+};
+
+static ListTimer listTimers[NR_TIMERS];
+static ListTimer listHead;
+static uint32 listNow;
+
+static void listStop(ListTimer *t) {
+    if (t->active) {
+        t->prev->next = t->next;
+        t->next->prev = t->prev;
+        t->active = false;
+    }
+}
+
+static void listStart(ListTimer *t, uint32 delay) {
+    listStop(t);
+    t->expires = listNow + delay;
+    ListTimer *pos = listHead.next;
+    while (pos != &listHead && (int32)(pos->expires - t->expires) <= 0) {
+        pos = pos->next;
+    }
+    t->next = pos;
+    t->prev = pos->prev;
+    pos->prev->next = t;
+    pos->prev = t;
+    t->active = true;
+}
+
+static void listTick(void) {
+    listNow++;
+    while (listHead.next != &listHead && listHead.next->expires == listNow) {
+        listStop(listHead.next);
+        host_sink++;
+    }
+}
+
+HOST_BENCH(sorted_list_restart_tick_1k, 2000000) {
+    if (iter == 0) {
+        benchSeed = 1;
+        listNow = 0;
+        listHead.next = listHead.prev = &listHead;
+        for (uint32 i = 0; i < NR_TIMERS; i++) {
+            listTimers[i].active = false;
+            listStart(&listTimers[i], benchDelay());
+        }
+    }
+    listStart(&listTimers[iter % NR_TIMERS], benchDelay());
+    listTick();
+}
@@ -189,6 +189,35 @@ uint16 adc_read(const adc_dev *dev, uint8 channel) {
     return (uint16)(regs->DR & ADC_DR_DATA);
 }
 
+#ifndef STM32L1
+/**
+ * @brief Set the regular conversion sequence.
+ *
+ * Fills in SQR3, SQR2 and SQR1 with the channels in conversion order
+ * and sets the sequence length.  Use adc_set_scan() to convert more
+ * than the first one per trigger.  Don't call this during conversion.
+ *
+ * @param dev ADC device
+ * @param channels Channels to convert, in order; a channel may appear
+ *                 more than once.
+ * @param length Number of channels, from 1 to 16.
+ */
+void adc_set_reg_sequence(const adc_dev *dev, const uint8 *channels,
+                          uint8 length) {
+    adc_reg_map *regs = dev->regs;
+    uint32 sqr[3] = {0, 0, 0};  /* SQR3, SQR2, SQR1 */
+    uint8 i;
+
+    ASSERT(length >= 1 && length <= 16);
+    for (i = 0; i < length; i++) {
+        sqr[i / 6] |= (uint32)(channels[i] & 0x1F) << (5 * (i % 6));
+    }
+    regs->SQR3 = sqr[0];
+    regs->SQR2 = sqr[1];
+    regs->SQR1 = sqr[2] | ((uint32)(length - 1) << 20);
+}
+#endif
+
 void setupADC_F2() {
 #ifdef STM32F2
 		  uint32 tmpreg1 = 0;
@@ -156,6 +156,11 @@ extern const adc_dev *ADC3;
 #define ADC_SR_RCNR                     BIT(ADC_SR_RCNR_BIT)
 #define ADC_SR_JCNR                     BIT(ADC_SR_JCNR_BIT)
 #endif
+#ifdef STM32F2
+#define ADC_SR_OVR_BIT                  5
+
+#define ADC_SR_OVR                      BIT(ADC_SR_OVR_BIT)
+#endif
 
 /* Control register 1 */
 
@@ -218,6 +223,12 @@ extern const adc_dev *ADC3;
 #define ADC_CR1_DISCNUM                 (0xE000)
 #define ADC_CR1_JAWDEN                  BIT(ADC_CR1_JAWDEN_BIT)
 #define ADC_CR1_AWDEN                   BIT(ADC_CR1_AWDEN_BIT)
+#ifdef STM32F2
+#define ADC_CR1_OVRIE_BIT               26
+
+#define ADC_CR1_RES                     (0x3 << 24)
+#define ADC_CR1_OVRIE                   BIT(ADC_CR1_OVRIE_BIT)
+#endif
 #endif
 
 /* Control register 2 */
@@ -261,10 +272,17 @@ extern const adc_dev *ADC3;
 #define ADC_CR2_EXTTRIG_BIT             20
 #define ADC_CR2_TSEREFE_BIT             23
 #ifdef STM32F2
+	#define ADC_CR2_DDS_BIT                 9
+	#define ADC_CR2_EOCS_BIT                10
 	#define ADC_CR2_JSWSTART_BIT            22
 	#define ADC_CR2_SWSTART_BIT             30
 	#define ADC_CR2_EXTSEL                  (0x0F000000)
 	#define ADC_CR2_JEXTSEL                 (0x000F0000)
+	#define ADC_CR2_EXTEN                   (0x30000000)
+	#define ADC_CR2_EXTEN_RISING            (0x10000000)
+	#define ADC_CR2_JEXTEN                  (0x00300000)
+	#define ADC_CR2_DDS                     BIT(ADC_CR2_DDS_BIT)
+	#define ADC_CR2_EOCS                    BIT(ADC_CR2_EOCS_BIT)
 #else
 	#define ADC_CR2_JSWSTART_BIT            21
 	#define ADC_CR2_SWSTART_BIT             22
@@ -500,7 +518,30 @@ typedef enum adc_extsel_event {
     ADC_ADC12_EXTI11    = (0xF << 24), /**< ADC: EXTI 11 event */
 } adc_extsel_event;
 
-#else	// STM32F*
+#elif defined(STM32F2)
+/* All three ADCs share one list of regular triggers. */
+typedef enum adc_extsel_event {
+    ADC_EXT_TIM1_CC1    = (0x0 << 24), /**< Timer 1 CC1 event */
+    ADC_EXT_TIM1_CC2    = (0x1 << 24), /**< Timer 1 CC2 event */
+    ADC_EXT_TIM1_CC3    = (0x2 << 24), /**< Timer 1 CC3 event */
+    ADC_EXT_TIM2_CC2    = (0x3 << 24), /**< Timer 2 CC2 event */
+    ADC_EXT_TIM2_CC3    = (0x4 << 24), /**< Timer 2 CC3 event */
+    ADC_EXT_TIM2_CC4    = (0x5 << 24), /**< Timer 2 CC4 event */
+    ADC_EXT_TIM2_TRGO   = (0x6 << 24), /**< Timer 2 TRGO event */
+    ADC_EXT_TIM3_CC1    = (0x7 << 24), /**< Timer 3 CC1 event */
+    ADC_EXT_TIM3_TRGO   = (0x8 << 24), /**< Timer 3 TRGO event */
+    ADC_EXT_TIM4_CC4    = (0x9 << 24), /**< Timer 4 CC4 event */
+    ADC_EXT_TIM5_CC1    = (0xA << 24), /**< Timer 5 CC1 event */
+    ADC_EXT_TIM5_CC2    = (0xB << 24), /**< Timer 5 CC2 event */
+    ADC_EXT_TIM5_CC3    = (0xC << 24), /**< Timer 5 CC3 event */
+    ADC_EXT_TIM8_CC1    = (0xD << 24), /**< Timer 8 CC1 event */
+    ADC_EXT_TIM8_TRGO   = (0xE << 24), /**< Timer 8 TRGO event */
+    ADC_EXT_EXTI11      = (0xF << 24), /**< EXTI line 11 event */
+    ADC_SWSTART         = (0x0 << 24)  /**< Software start only; the
+                                            trigger is not enabled */
+} adc_extsel_event;
+
+#else	// STM32F1
 typedef enum adc_extsel_event {
     ADC_ADC12_TIM1_CC1  = (0 << 17), /**< ADC1 and ADC2: Timer 1 CC1 event */
     ADC_ADC12_TIM1_CC2  = (1 << 17), /**< ADC1 and ADC2: Timer 1 CC2 event */
@@ -552,12 +593,27 @@ typedef enum {
     ADC_SMPR_41_5,              /**< 41.5 ADC cycles */
     ADC_SMPR_55_5,              /**< 55.5 ADC cycles */
     ADC_SMPR_71_5,              /**< 71.5 ADC cycles */
-    ADC_SMPR_239_5              /**< 239.5 ADC cycles */
+    ADC_SMPR_239_5,             /**< 239.5 ADC cycles */
+#ifdef STM32F2
+    /* The same settings give these sample times on the STM32F2/F4 */
+    ADC_SMPR_3   = ADC_SMPR_1_5,   /**< 3 ADC cycles */
+    ADC_SMPR_15  = ADC_SMPR_7_5,   /**< 15 ADC cycles */
+    ADC_SMPR_28  = ADC_SMPR_13_5,  /**< 28 ADC cycles */
+    ADC_SMPR_56  = ADC_SMPR_28_5,  /**< 56 ADC cycles */
+    ADC_SMPR_84  = ADC_SMPR_41_5,  /**< 84 ADC cycles */
+    ADC_SMPR_112 = ADC_SMPR_55_5,  /**< 112 ADC cycles */
+    ADC_SMPR_144 = ADC_SMPR_71_5,  /**< 144 ADC cycles */
+    ADC_SMPR_480 = ADC_SMPR_239_5, /**< 480 ADC cycles */
+#endif
 } adc_smp_rate;
 
 void adc_set_sample_rate(const adc_dev *dev, adc_smp_rate smp_rate);
 void adc_calibrate(const adc_dev *dev);
 uint16 adc_read(const adc_dev *dev, uint8 channel);
+#ifndef STM32L1
+void adc_set_reg_sequence(const adc_dev *dev, const uint8 *channels,
+                          uint8 length);
+#endif
 
 /**
  * @brief Set the regular channel sequence length.
@@ -582,7 +638,44 @@ static inline void adc_set_reg_seqlen(const adc_dev *dev, uint8 length) {
  *               disabled.
  */
 static inline void adc_set_exttrig(const adc_dev *dev, uint8 enable) {
+#ifdef STM32F2
+    /* EXTEN: rising edge, or disabled */
+    uint32 cr2 = dev->regs->CR2 & ~ADC_CR2_EXTEN;
+    dev->regs->CR2 = cr2 | (enable ? ADC_CR2_EXTEN_RISING : 0);
+#else
     *bb_perip(&dev->regs->CR2, ADC_CR2_EXTTRIG_BIT) = !!enable;
+#endif
+}
+
+/**
+ * @brief Enable or disable scan mode.
+ *
+ * In scan mode a trigger converts the whole regular sequence rather
+ * than just its first channel.
+ *
+ * @param dev    ADC device
+ * @param enable If 1, scan mode is enabled; if 0, disabled.
+ */
+static inline void adc_set_scan(const adc_dev *dev, uint8 enable) {
+    *bb_perip(&dev->regs->CR1, ADC_CR1_SCAN_BIT) = !!enable;
+}
+
+/**
+ * @brief Enable or disable DMA requests for regular conversions.
+ *
+ * On the STM32F2/F4 this also sets DDS, so that requests continue
+ * after the DMA stream's first pass, as a circular transfer needs.
+ *
+ * @param dev    ADC device
+ * @param enable If 1, a DMA request follows each regular conversion.
+ */
+static inline void adc_set_dma(const adc_dev *dev, uint8 enable) {
+#ifdef STM32F2
+    uint32 cr2 = dev->regs->CR2 & ~(ADC_CR2_DMA | ADC_CR2_DDS);
+    dev->regs->CR2 = cr2 | (enable ? ADC_CR2_DMA | ADC_CR2_DDS : 0);
+#else
+    *bb_perip(&dev->regs->CR2, ADC_CR2_DMA_BIT) = !!enable;
+#endif
 }
 
 /**
@@ -610,6 +703,177 @@ static inline void adc_disable_all(void) {
 
 void setupADC_F2();
 
+#ifdef STM32F2
+/*
+ * Multi-ADC modes (STM32F2/F4)
+ */
+
+/* Common status register: each ADC's SR flags, 8 bits apart */
+
+#define ADC_CSR_OVR1_BIT                5
+#define ADC_CSR_OVR2_BIT                13
+#define ADC_CSR_OVR3_BIT                21
+
+#define ADC_CSR_OVR1                    BIT(ADC_CSR_OVR1_BIT)
+#define ADC_CSR_OVR2                    BIT(ADC_CSR_OVR2_BIT)
+#define ADC_CSR_OVR3                    BIT(ADC_CSR_OVR3_BIT)
+
+/* Common control register */
+
+#define ADC_CCR_TSVREFE_BIT             23
+#define ADC_CCR_VBATE_BIT               22
+#define ADC_CCR_DDS_BIT                 13
+
+#define ADC_CCR_TSVREFE                 BIT(ADC_CCR_TSVREFE_BIT)
+#define ADC_CCR_VBATE                   BIT(ADC_CCR_VBATE_BIT)
+#define ADC_CCR_ADCPRE                  (0x3 << 16)
+#define ADC_CCR_DMA                     (0x3 << 14)
+#define ADC_CCR_DDS                     BIT(ADC_CCR_DDS_BIT)
+#define ADC_CCR_DELAY                   (0xF << 8)
+#define ADC_CCR_MULTI                   0x1F
+
+/** Common regular data register address, for multi-ADC DMA. */
+#define ADC_CDR_ADDRESS                 (&ADC_COMMON->CDR)
+
+/** How the ADCs work together. */
+typedef enum adc_multi_mode {
+    ADC_MULTI_INDEPENDENT        = 0x00, /**< Each ADC on its own */
+    ADC_MULTI_DUAL_SIMULTANEOUS  = 0x06, /**< ADC1 and ADC2 convert their
+                                              sequences in lockstep */
+    ADC_MULTI_DUAL_INTERLEAVED   = 0x07, /**< ADC1 and ADC2 take turns */
+    ADC_MULTI_TRIPLE_SIMULTANEOUS = 0x16, /**< All three in lockstep */
+    ADC_MULTI_TRIPLE_INTERLEAVED = 0x17, /**< All three take turns */
+} adc_multi_mode;
+
+/**
+ * @brief How multi-mode results are read from the common data register.
+ *
+ * Read as consecutive half-words, the results come out in ADC order
+ * for modes 1 and 2: ADC1, ADC2[, ADC3], ADC1, ...  Mode 3 does the
+ * same with bytes.
+ */
+typedef enum adc_multi_dma {
+    ADC_MULTI_DMA_NONE  = (0x0 << 14), /**< No DMA */
+    ADC_MULTI_DMA_MODE1 = (0x1 << 14), /**< A half-word per request;
+                                            triple modes only */
+    ADC_MULTI_DMA_MODE2 = (0x2 << 14), /**< Two half-words per request */
+    ADC_MULTI_DMA_MODE3 = (0x3 << 14), /**< Two bytes per request; 8-
+                                            and 6-bit resolution only */
+} adc_multi_dma;
+
+/** ADC clock prescaler, from PCLK2. */
+typedef enum adc_prescaler {
+    ADC_PRE_PCLK2_DIV_2 = (0x0 << 16), /**< PCLK2 / 2 */
+    ADC_PRE_PCLK2_DIV_4 = (0x1 << 16), /**< PCLK2 / 4 */
+    ADC_PRE_PCLK2_DIV_6 = (0x2 << 16), /**< PCLK2 / 6 */
+    ADC_PRE_PCLK2_DIV_8 = (0x3 << 16), /**< PCLK2 / 8 */
+} adc_prescaler;
+
+/** Conversion resolution. */
+typedef enum adc_resolution {
+    ADC_RES_12BIT = (0x0 << 24), /**< 12 bits, 12 ADC clocks */
+    ADC_RES_10BIT = (0x1 << 24), /**< 10 bits, 10 ADC clocks */
+    ADC_RES_8BIT  = (0x2 << 24), /**< 8 bits, 8 ADC clocks */
+    ADC_RES_6BIT  = (0x3 << 24), /**< 6 bits, 6 ADC clocks */
+} adc_resolution;
+
+/** A multi-ADC setup. */
+typedef struct adc_multi_config {
+    adc_multi_mode mode;        /**< Mode */
+    adc_multi_dma dma;          /**< DMA mode */
+    adc_prescaler prescaler;    /**< ADC clock prescaler */
+    adc_resolution resolution;  /**< Resolution, for all ADCs */
+    adc_smp_rate smp;           /**< Sample time, for all channels */
+    uint8 delay;                /**< Interleaved modes: ADC clocks
+                                     between the ADCs' conversions,
+                                     5 to 20 */
+    uint8 continuous;           /**< Convert continuously rather than
+                                     once per trigger */
+    uint8 length;               /**< Sequence length, 1 to 16 */
+    const uint8 *channels[3];   /**< Sequence of ADC1, ADC2 and ADC3 */
+} adc_multi_config;
+
+/** Problems adc_multi_check() finds. */
+typedef enum adc_multi_error {
+    ADC_MULTI_OK = 0,           /**< Usable */
+    ADC_MULTI_BAD_LENGTH,       /**< No channels, or more than 16 */
+    ADC_MULTI_BAD_DELAY,        /**< Interleave delay out of range, or
+                                     not longer than the sample time */
+    ADC_MULTI_BAD_DMA,          /**< DMA mode doesn't suit the mode or
+                                     resolution */
+    ADC_MULTI_CHANNEL_CLASH,    /**< Simultaneous: two ADCs would
+                                     sample one channel at once */
+    ADC_MULTI_CHANNEL_MISMATCH, /**< Interleaved: the ADCs' sequences
+                                     differ */
+} adc_multi_error;
+
+uint8 adc_multi_nr_adcs(adc_multi_mode mode);
+uint32 adc_smp_cycles(adc_smp_rate smp);
+adc_multi_error adc_multi_check(const adc_multi_config *cfg);
+uint32 adc_multi_ccr(const adc_multi_config *cfg, uint32 ccr);
+uint32 adc_multi_rate(const adc_multi_config *cfg, uint32 adc_clk);
+adc_multi_error adc_multi_setup(const adc_multi_config *cfg);
+void adc_multi_stop(void);
+
+/*
+ * Injected conversions (STM32F2/F4)
+ */
+
+/** Injected group trigger, for adc_set_inj_trigger(). */
+typedef enum adc_jextsel_event {
+    ADC_JEXT_TIM1_CC4   = (0x0 << 16), /**< Timer 1 CC4 event */
+    ADC_JEXT_TIM1_TRGO  = (0x1 << 16), /**< Timer 1 TRGO event */
+    ADC_JEXT_TIM2_CC1   = (0x2 << 16), /**< Timer 2 CC1 event */
+    ADC_JEXT_TIM2_TRGO  = (0x3 << 16), /**< Timer 2 TRGO event */
+    ADC_JEXT_TIM3_CC2   = (0x4 << 16), /**< Timer 3 CC2 event */
+    ADC_JEXT_TIM3_CC4   = (0x5 << 16), /**< Timer 3 CC4 event */
+    ADC_JEXT_TIM4_CC1   = (0x6 << 16), /**< Timer 4 CC1 event */
+    ADC_JEXT_TIM4_CC2   = (0x7 << 16), /**< Timer 4 CC2 event */
+    ADC_JEXT_TIM4_CC3   = (0x8 << 16), /**< Timer 4 CC3 event */
+    ADC_JEXT_TIM4_TRGO  = (0x9 << 16), /**< Timer 4 TRGO event */
+    ADC_JEXT_TIM5_CC4   = (0xA << 16), /**< Timer 5 CC4 event */
+    ADC_JEXT_TIM5_TRGO  = (0xB << 16), /**< Timer 5 TRGO event */
+    ADC_JEXT_TIM8_CC2   = (0xC << 16), /**< Timer 8 CC2 event */
+    ADC_JEXT_TIM8_CC3   = (0xD << 16), /**< Timer 8 CC3 event */
+    ADC_JEXT_TIM8_CC4   = (0xE << 16), /**< Timer 8 CC4 event */
+    ADC_JEXT_EXTI15     = (0xF << 16), /**< EXTI line 15 event */
+} adc_jextsel_event;
+
+/** Trigger edge for the injected group. */
+typedef enum adc_jexten {
+    ADC_JEXTEN_NONE    = (0x0 << 20), /**< Software start only */
+    ADC_JEXTEN_RISING  = (0x1 << 20), /**< Rising edge */
+    ADC_JEXTEN_FALLING = (0x2 << 20), /**< Falling edge */
+    ADC_JEXTEN_BOTH    = (0x3 << 20), /**< Both edges */
+} adc_jexten;
+
+/**
+ * @brief Injected conversion handler.
+ * @param results JDR1 onwards: one result per channel of the injected
+ *                sequence, in order, less its offset.
+ * @param count Length of the sequence, 1 to 4.
+ */
+typedef void (*adc_inj_handler)(const int16 *results, uint8 count);
+
+uint32 adc_inj_jsqr(const uint8 *channels, uint8 length);
+void adc_set_inj_sequence(const adc_dev *dev, const uint8 *channels,
+                          uint8 length);
+void adc_set_inj_offset(const adc_dev *dev, uint8 rank, uint16 offset);
+void adc_set_inj_trigger(const adc_dev *dev, adc_jextsel_event event,
+                         adc_jexten edge);
+uint8 adc_inj_read(const adc_dev *dev, int16 *results);
+void adc_inj_attach_interrupt(const adc_dev *dev, adc_inj_handler handler);
+void adc_inj_detach_interrupt(const adc_dev *dev);
+
+/**
+ * @brief Start the injected sequence from software.
+ * @param dev ADC device
+ */
+static inline void adc_inj_start(const adc_dev *dev) {
+    dev->regs->CR2 |= ADC_CR2_JSWSTART;
+}
+#endif
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
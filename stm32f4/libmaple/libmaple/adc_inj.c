@@ -0,0 +1,201 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file adc_inj.c
+ * @brief Injected conversions (STM32F2/F4).
+ *
+ * The injected group converts up to four channels on its own trigger,
+ * interrupting any regular conversion, and keeps each result in its
+ * own data register less a per-rank offset.  A timer compare or TRGO
+ * starts it at a fixed point of the PWM period, and the shared ADC
+ * interrupt hands all its results to one handler per ADC.
+ */
+
+#include "adc.h"
+#include "nvic.h"
+
+#ifdef STM32F2
+
+static adc_inj_handler inj_handlers[3];
+
+static int adc_index(const adc_dev *dev) {
+    if (dev == ADC1) {
+        return 0;
+    } else if (dev == ADC2) {
+        return 1;
+    }
+    return 2;
+}
+
+/**
+ * @brief JSQR value for an injected sequence.
+ *
+ * A sequence shorter than four is right-aligned: it starts at
+ * JSQ(5 - length) and ends at JSQ4.
+ *
+ * @param channels Channels to convert, in order.
+ * @param length Number of channels, from 1 to 4.
+ */
+uint32 adc_inj_jsqr(const uint8 *channels, uint8 length) {
+    uint32 jsqr = (uint32)(length - 1) << 20;
+    uint8 first = 4 - length;
+    uint8 i;
+
+    for (i = 0; i < length; i++) {
+        jsqr |= (uint32)(channels[i] & 0x1F) << (5 * (first + i));
+    }
+    return jsqr;
+}
+
+/**
+ * @brief Set the injected sequence.
+ *
+ * Sequences longer than one need scan mode, which is turned on; it
+ * does not affect a regular sequence of one.
+ *
+ * @param dev ADC device
+ * @param channels Channels to convert, in order.
+ * @param length Number of channels, from 1 to 4.
+ */
+void adc_set_inj_sequence(const adc_dev *dev, const uint8 *channels,
+                          uint8 length) {
+    ASSERT(length >= 1 && length <= 4);
+    dev->regs->JSQR = adc_inj_jsqr(channels, length);
+    if (length > 1) {
+        dev->regs->CR1 |= ADC_CR1_SCAN;
+    }
+}
+
+/**
+ * @brief Set the offset subtracted from an injected result.
+ *
+ * The difference is sign-extended, so the result may be negative: an
+ * offset at the zero-current level of a current sensor gives signed
+ * currents directly.
+ *
+ * @param dev ADC device
+ * @param rank Position in the injected sequence, from 1 to 4.
+ * @param offset Offset, 0 to 4095.
+ */
+void adc_set_inj_offset(const adc_dev *dev, uint8 rank, uint16 offset) {
+    __io uint32 *jofr = &dev->regs->JOFR1;
+
+    ASSERT(rank >= 1 && rank <= 4);
+    jofr[rank - 1] = offset & 0xFFF;
+}
+
+/**
+ * @brief Select the injected group's trigger.
+ * @param dev ADC device
+ * @param event Trigger event.
+ * @param edge Edge to trigger on; ADC_JEXTEN_NONE for software start
+ *             only.
+ */
+void adc_set_inj_trigger(const adc_dev *dev, adc_jextsel_event event,
+                         adc_jexten edge) {
+    uint32 cr2 = dev->regs->CR2 & ~(ADC_CR2_JEXTSEL | ADC_CR2_JEXTEN);
+    dev->regs->CR2 = cr2 | event | edge;
+}
+
+/**
+ * @brief Read the injected results.
+ * @param dev ADC device
+ * @param results Filled with up to 4 results, in sequence order.
+ * @return Length of the injected sequence.
+ */
+uint8 adc_inj_read(const adc_dev *dev, int16 *results) {
+    adc_reg_map *regs = dev->regs;
+    uint8 count = ((regs->JSQR & ADC_JSQR_JL) >> 20) + 1;
+
+    /* Unrolled: the handler is waiting, and the loads are cheap */
+    switch (count) {
+    case 4:
+        results[3] = (int16)regs->JDR4;
+        /* fall through */
+    case 3:
+        results[2] = (int16)regs->JDR3;
+        /* fall through */
+    case 2:
+        results[1] = (int16)regs->JDR2;
+        /* fall through */
+    default:
+        results[0] = (int16)regs->JDR1;
+    }
+    return count;
+}
+
+/**
+ * @brief Call a handler when the injected sequence completes.
+ *
+ * Enables the ADC interrupt, which all ADCs share.
+ *
+ * @param dev ADC device
+ * @param handler Called from the interrupt with the results.
+ */
+void adc_inj_attach_interrupt(const adc_dev *dev, adc_inj_handler handler) {
+    inj_handlers[adc_index(dev)] = handler;
+    dev->regs->SR = ~(uint32)ADC_SR_JEOC;
+    dev->regs->CR1 |= ADC_CR1_JEOCIE;
+    nvic_irq_enable(NVIC_ADC_1_2);
+}
+
+/**
+ * @brief Stop calling the injected conversion handler.
+ *
+ * The ADC interrupt stays enabled while another ADC has a handler.
+ *
+ * @param dev ADC device
+ */
+void adc_inj_detach_interrupt(const adc_dev *dev) {
+    dev->regs->CR1 &= ~ADC_CR1_JEOCIE;
+    inj_handlers[adc_index(dev)] = NULL;
+    if (!inj_handlers[0] && !inj_handlers[1] && !inj_handlers[2]) {
+        nvic_irq_disable(NVIC_ADC_1_2);
+    }
+}
+
+static void adc_inj_irq(const adc_dev *dev, adc_inj_handler handler) {
+    adc_reg_map *regs = dev->regs;
+    int16 results[4];
+    uint8 count;
+
+    if (!handler || !(regs->SR & ADC_SR_JEOC)) {
+        return;
+    }
+    count = adc_inj_read(dev, results);
+    /* rc_w0: writing ones leaves the other flags alone */
+    regs->SR = ~(uint32)(ADC_SR_JEOC | ADC_SR_JSTRT);
+    handler(results, count);
+}
+
+void __irq_adc(void) {
+    adc_inj_irq(ADC1, inj_handlers[0]);
+    adc_inj_irq(ADC2, inj_handlers[1]);
+    adc_inj_irq(ADC3, inj_handlers[2]);
+}
+
+#endif
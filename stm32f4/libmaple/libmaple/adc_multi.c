@@ -0,0 +1,237 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file adc_multi.c
+ * @brief Dual and triple ADC modes (STM32F2/F4).
+ *
+ * The checks and register arithmetic are kept apart from the register
+ * writes, so that they can be tested on the host.
+ */
+
+#include "adc.h"
+
+#ifdef STM32F2
+
+/* Sample times in ADC clocks, by adc_smp_rate */
+static const uint16 smp_cycles[8] = {3, 15, 28, 56, 84, 112, 144, 480};
+
+/**
+ * @brief Number of ADCs a mode uses.
+ */
+uint8 adc_multi_nr_adcs(adc_multi_mode mode) {
+    if (mode == ADC_MULTI_INDEPENDENT) {
+        return 1;
+    }
+    return (mode & 0x10) ? 3 : 2;
+}
+
+/**
+ * @brief Sample time in ADC clocks.
+ */
+uint32 adc_smp_cycles(adc_smp_rate smp) {
+    return smp_cycles[smp & 0x7];
+}
+
+static int is_interleaved(adc_multi_mode mode) {
+    return mode == ADC_MULTI_DUAL_INTERLEAVED ||
+        mode == ADC_MULTI_TRIPLE_INTERLEAVED;
+}
+
+/* ADC clocks per conversion: sampling plus one per bit */
+static uint32 conversion_cycles(const adc_multi_config *cfg) {
+    static const uint8 res_cycles[4] = {12, 10, 8, 6};
+    return adc_smp_cycles(cfg->smp) + res_cycles[cfg->resolution >> 24];
+}
+
+/**
+ * @brief Check a multi-ADC configuration against the rules of the
+ *        reference manual.
+ * @return ADC_MULTI_OK, or the first problem found.
+ */
+adc_multi_error adc_multi_check(const adc_multi_config *cfg) {
+    uint8 n = adc_multi_nr_adcs(cfg->mode);
+    uint8 a, b, i;
+
+    if (cfg->length == 0 || cfg->length > 16) {
+        return ADC_MULTI_BAD_LENGTH;
+    }
+
+    switch (cfg->dma) {
+    case ADC_MULTI_DMA_NONE:
+        break;
+    case ADC_MULTI_DMA_MODE1:
+        if (n != 3) {
+            return ADC_MULTI_BAD_DMA;
+        }
+        break;
+    case ADC_MULTI_DMA_MODE2:
+        if (n == 1) {
+            return ADC_MULTI_BAD_DMA;
+        }
+        break;
+    case ADC_MULTI_DMA_MODE3:
+        if (n == 1 || cfg->resolution == ADC_RES_12BIT ||
+            cfg->resolution == ADC_RES_10BIT) {
+            return ADC_MULTI_BAD_DMA;
+        }
+        break;
+    default:
+        return ADC_MULTI_BAD_DMA;
+    }
+
+    if (is_interleaved(cfg->mode)) {
+        /* The ADCs share the inputs: one must be done sampling before
+         * the next starts */
+        if (cfg->delay < 5 || cfg->delay > 20 ||
+            adc_smp_cycles(cfg->smp) >= cfg->delay) {
+            return ADC_MULTI_BAD_DELAY;
+        }
+        for (a = 1; a < n; a++) {
+            for (i = 0; i < cfg->length; i++) {
+                if (cfg->channels[a][i] != cfg->channels[0][i]) {
+                    return ADC_MULTI_CHANNEL_MISMATCH;
+                }
+            }
+        }
+    } else if (n > 1) {
+        for (i = 0; i < cfg->length; i++) {
+            for (a = 0; a < n; a++) {
+                for (b = a + 1; b < n; b++) {
+                    if (cfg->channels[a][i] == cfg->channels[b][i]) {
+                        return ADC_MULTI_CHANNEL_CLASH;
+                    }
+                }
+            }
+        }
+    }
+    return ADC_MULTI_OK;
+}
+
+/**
+ * @brief Compute ADC_COMMON->CCR for a configuration.
+ * @param cfg Configuration, which adc_multi_check() accepts.
+ * @param ccr Current CCR; the temperature sensor and VBAT bits are kept.
+ */
+uint32 adc_multi_ccr(const adc_multi_config *cfg, uint32 ccr) {
+    ccr &= ~(ADC_CCR_MULTI | ADC_CCR_DELAY | ADC_CCR_DDS | ADC_CCR_DMA |
+             ADC_CCR_ADCPRE);
+    ccr |= cfg->mode | cfg->dma | cfg->prescaler;
+    if (is_interleaved(cfg->mode)) {
+        ccr |= (uint32)(cfg->delay - 5) << 8;
+    }
+    if (cfg->dma != ADC_MULTI_DMA_NONE) {
+        ccr |= ADC_CCR_DDS;
+    }
+    return ccr;
+}
+
+/**
+ * @brief Samples per second, from all the ADCs together, when
+ *        converting continuously.
+ *
+ * Interleaved, each ADC starts delay clocks after the previous one,
+ * and can only start again once its own conversion is done.
+ * Simultaneous, the ADCs go at the pace of one.
+ *
+ * @param cfg Configuration
+ * @param adc_clk ADC clock, Hz
+ */
+uint32 adc_multi_rate(const adc_multi_config *cfg, uint32 adc_clk) {
+    uint32 n = adc_multi_nr_adcs(cfg->mode);
+    uint32 cycles = conversion_cycles(cfg);
+
+    if (is_interleaved(cfg->mode) && n * cfg->delay > cycles) {
+        cycles = n * cfg->delay;
+    }
+    return (uint32)((uint64)adc_clk * n / cycles);
+}
+
+/**
+ * @brief Configure the ADCs and the common registers for a mode.
+ *
+ * The ADCs must be initialized and on.  Conversions start on ADC1's
+ * trigger (adc_set_extsel() and adc_set_exttrig() on ADC1) or its
+ * SWSTART; the slaves follow.  With DMA, stream ADC_CDR_ADDRESS on
+ * ADC1's DMA request, in half-words for DMA mode 1 and words for
+ * modes 2 and 3.
+ *
+ * @return The result of adc_multi_check(); nothing is changed unless
+ *         it is ADC_MULTI_OK.
+ */
+adc_multi_error adc_multi_setup(const adc_multi_config *cfg) {
+    static const adc_dev * const *devs[3] = {&ADC1, &ADC2, &ADC3};
+    adc_multi_error err = adc_multi_check(cfg);
+    uint8 n = adc_multi_nr_adcs(cfg->mode);
+    uint8 i;
+
+    if (err != ADC_MULTI_OK) {
+        return err;
+    }
+
+    /* Back to independent while the ADCs are reconfigured */
+    adc_multi_stop();
+    for (i = 0; i < n; i++) {
+        const adc_dev *dev = *devs[i];
+        adc_reg_map *regs = dev->regs;
+        uint32 cr1 = regs->CR1 & ~(ADC_CR1_RES | ADC_CR1_SCAN);
+        uint32 cr2 = regs->CR2 & ~(ADC_CR2_CONT | ADC_CR2_DMA | ADC_CR2_DDS |
+                                   ADC_CR2_EXTEN | ADC_CR2_EXTSEL);
+
+        regs->CR1 = cr1 | cfg->resolution |
+            (cfg->length > 1 ? ADC_CR1_SCAN : 0);
+        regs->CR2 = cr2 | (cfg->continuous ? ADC_CR2_CONT : 0);
+        adc_set_reg_sequence(dev, cfg->channels[i], cfg->length);
+        adc_set_sample_rate(dev, cfg->smp);
+        regs->SR = 0;
+    }
+    ADC_COMMON->CCR = adc_multi_ccr(cfg, ADC_COMMON->CCR);
+    return ADC_MULTI_OK;
+}
+
+/**
+ * @brief Return to independent mode.
+ *
+ * Stops continuous conversion and DMA on all ADCs and leaves them
+ * ready for adc_read().
+ */
+void adc_multi_stop(void) {
+    static const adc_dev * const *devs[3] = {&ADC1, &ADC2, &ADC3};
+    uint8 i;
+
+    ADC_COMMON->CCR &= ~(ADC_CCR_MULTI | ADC_CCR_DELAY | ADC_CCR_DDS |
+                         ADC_CCR_DMA);
+    for (i = 0; i < 3; i++) {
+        adc_reg_map *regs = (*devs[i])->regs;
+        regs->CR2 &= ~(ADC_CR2_CONT | ADC_CR2_EXTEN | ADC_CR2_EXTSEL);
+        regs->CR1 &= ~(ADC_CR1_RES | ADC_CR1_SCAN);
+        regs->SQR1 &= ~ADC_SQR1_L;
+        (void)regs->DR;
+        regs->SR = 0;
+    }
+}
+
+#endif
@@ -113,8 +113,9 @@ static inline volatile uint32* __bb_addr(volatile void *address,
                                          uint32 bit,
                                          uint32 bb_base,
                                          uint32 bb_ref) {
-    return (volatile uint32*)(bb_base + ((uint32)address - bb_ref) * 32 +
-                              bit * 4);
+    /* via unsigned long, which is pointer sized on the host build too */
+    return (volatile uint32*)(unsigned long)
+        (bb_base + ((uint32)(unsigned long)address - bb_ref) * 32 + bit * 4);
 }
 
 #endif  /* _BITBAND_H_ */
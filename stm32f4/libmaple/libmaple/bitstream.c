@@ -0,0 +1,180 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file bitstream.c
+ * @brief Pulse-width coding of serial bit streams for timer bursts.
+ */
+
+#include "bitstream.h"
+
+/**
+ * @brief Work out the timer settings for a bit rate.
+ *
+ * The prescaler is taken to be 1.  High times are rounded to the
+ * nearest tick.
+ *
+ * @param t Set to the reload and compare values.
+ * @param clk_hz Timer clock, e.g. from rcc_dev_timer_clk_speed().
+ * @param bit_hz Bits per second.
+ * @param zero_permille High time of a 0, in thousandths of a bit.
+ * @param one_permille High time of a 1, in thousandths of a bit.
+ * @return 0 on success, -1 if a bit would not fit the 16-bit counter,
+ *         or the clock is too slow to tell a 0 from a 1.
+ */
+int bitstream_timing_calc(bitstream_timing *t, uint32 clk_hz, uint32 bit_hz,
+                          uint16 zero_permille, uint16 one_permille) {
+    uint32 ticks, zero, one;
+
+    if (bit_hz == 0 || zero_permille >= one_permille || one_permille >= 1000) {
+        return -1;
+    }
+    ticks = (clk_hz + bit_hz / 2) / bit_hz;
+    if (ticks < 2 || ticks > 0x10000) {
+        return -1;
+    }
+    zero = (ticks * zero_permille + 500) / 1000;
+    one = (ticks * one_permille + 500) / 1000;
+    if (zero == 0 || zero == one || one >= ticks) {
+        return -1;
+    }
+    t->reload = (uint16)(ticks - 1);
+    t->zero = (uint16)zero;
+    t->one = (uint16)one;
+    return 0;
+}
+
+/**
+ * @brief Timer settings for WS2812 LEDs.
+ *
+ * 800 kbit/s, with a 0 high for 0.4 us and a 1 for 0.8 us, well
+ * inside the +/-150 ns the data sheet allows.
+ */
+int bitstream_ws2812_timing(bitstream_timing *t, uint32 clk_hz) {
+    return bitstream_timing_calc(t, clk_hz, BITSTREAM_WS2812_RATE, 320, 640);
+}
+
+/**
+ * @brief Timer settings for DShot.
+ *
+ * A 0 is high for 37.5% of the bit and a 1 for 75%.
+ */
+int bitstream_dshot_timing(bitstream_timing *t, uint32 clk_hz,
+                           bitstream_dshot_speed speed) {
+    return bitstream_timing_calc(t, clk_hz, speed, 375, 750);
+}
+
+/**
+ * @brief Make a DShot frame.
+ *
+ * 11 bits of value, the telemetry request bit and a 4-bit checksum
+ * XORing the nibbles of the other 12.
+ *
+ * @param value Throttle, BITSTREAM_DSHOT_MIN_THROTTLE to
+ *              BITSTREAM_DSHOT_MAX_THROTTLE; 0 to disarm, or a command
+ *              below BITSTREAM_DSHOT_MIN_THROTTLE.  Larger values are
+ *              clamped.
+ * @param telemetry Non-zero to ask the ESC for telemetry.
+ * @return The 16 bits to send.
+ */
+uint16 bitstream_dshot_frame(uint16 value, uint8 telemetry) {
+    uint16 data, crc;
+
+    if (value > BITSTREAM_DSHOT_MAX_THROTTLE) {
+        value = BITSTREAM_DSHOT_MAX_THROTTLE;
+    }
+    data = (uint16)(value << 1 | (telemetry ? 1 : 0));
+    crc = (data ^ data >> 4 ^ data >> 8) & 0xF;
+    return (uint16)(data << 4 | crc);
+}
+
+/**
+ * @brief Encode the low bits of a word, most significant first.
+ * @param t Timing, from bitstream_timing_calc() or a protocol's.
+ * @param word Bits to send.
+ * @param bits How many, from 1 to 32.
+ * @param slots Set to one compare value per bit.
+ * @param stride Slots from one bit's value to the next.
+ */
+void bitstream_encode_word(const bitstream_timing *t, uint32 word,
+                           uint8 bits, uint16 *slots, uint32 stride) {
+    uint32 mask = 1UL << (bits - 1);
+
+    for (; mask; mask >>= 1) {
+        *slots = (word & mask) ? t->one : t->zero;
+        slots += stride;
+    }
+}
+
+/**
+ * @brief Encode part of a byte buffer, padding with idle slots.
+ *
+ * Meant for refilling half of a double buffer: each call carries on
+ * from where the last left off, and once the data runs out the rest
+ * of the slots are zero, which holds the line low.
+ *
+ * @param t Timing, from bitstream_timing_calc() or a protocol's.
+ * @param data Bytes to send, each most significant bit first.
+ * @param first_bit Bit of data to start from.
+ * @param bits Bits in data.
+ * @param slots Set to one compare value per bit.
+ * @param count Slots to fill.
+ * @param stride Slots from one bit's value to the next.
+ * @return Bits of data encoded, at most count.
+ */
+uint32 bitstream_encode(const bitstream_timing *t, const uint8 *data,
+                        uint32 first_bit, uint32 bits, uint16 *slots,
+                        uint32 count, uint32 stride) {
+    uint32 n = 0;
+    uint32 start = first_bit < bits ? first_bit : bits;
+    uint32 bit = start;
+
+    /* A byte at a time once aligned */
+    while (n < count && bit < bits && (bit & 7)) {
+        *slots = (data[bit >> 3] & (0x80 >> (bit & 7))) ? t->one : t->zero;
+        slots += stride;
+        bit++;
+        n++;
+    }
+    while (count - n >= 8 && bits - bit >= 8) {
+        bitstream_encode_word(t, data[bit >> 3], 8, slots, stride);
+        slots += 8 * stride;
+        bit += 8;
+        n += 8;
+    }
+    while (n < count && bit < bits) {
+        *slots = (data[bit >> 3] & (0x80 >> (bit & 7))) ? t->one : t->zero;
+        slots += stride;
+        bit++;
+        n++;
+    }
+
+    for (; n < count; n++) {
+        *slots = 0;
+        slots += stride;
+    }
+    return bit - start;
+}
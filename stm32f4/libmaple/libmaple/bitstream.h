@@ -0,0 +1,103 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file bitstream.h
+ * @brief Pulse-width coding of serial bit streams for timer bursts.
+ *
+ * Single-wire protocols such as WS2812 LED strings and DShot ESC
+ * frames send each bit as one fixed-length period whose high time
+ * says whether it is a 0 or a 1.  With the timer period set to one
+ * bit time, these routines turn bits into the compare values a timer
+ * burst (timer_burst.h) plays, one per period:
+ *
+ *     bitstream_timing t;
+ *     uint16 slots[17];
+ *
+ *     bitstream_dshot_timing(&t, 168000000, BITSTREAM_DSHOT600);
+ *     timer_set_reload(TIMER8, t.reload);
+ *     bitstream_encode_word(&t, bitstream_dshot_frame(1046, 0), 16,
+ *                           slots, 1);
+ *     slots[16] = 0;                  // idle low after the frame
+ *
+ * Bits go out most significant first.  A stride other than 1 leaves
+ * room between slots for other channels of the same burst.
+ *
+ * None of this touches the hardware.
+ */
+
+#ifndef _BITSTREAM_H_
+#define _BITSTREAM_H_
+
+#include "libmaple_types.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** Timer settings for one bit period. */
+typedef struct bitstream_timing {
+    uint16 reload;              /**< Timer reload: ticks per bit - 1 */
+    uint16 zero;                /**< Compare value, high ticks, of a 0 */
+    uint16 one;                 /**< Compare value of a 1 */
+} bitstream_timing;
+
+/** WS2812 bit rate, bits per second. */
+#define BITSTREAM_WS2812_RATE           800000
+/** Idle time latching a WS2812 string's colours, in microseconds. */
+#define BITSTREAM_WS2812_RESET_US       300
+
+/** DShot bit rates, bits per second. */
+typedef enum bitstream_dshot_speed {
+    BITSTREAM_DSHOT150 = 150000, /**< DShot150 */
+    BITSTREAM_DSHOT300 = 300000, /**< DShot300 */
+    BITSTREAM_DSHOT600 = 600000  /**< DShot600 */
+} bitstream_dshot_speed;
+
+/** Bits in a DShot frame. */
+#define BITSTREAM_DSHOT_BITS            16
+/** DShot values below this are commands, not throttle. */
+#define BITSTREAM_DSHOT_MIN_THROTTLE    48
+/** Largest DShot throttle value. */
+#define BITSTREAM_DSHOT_MAX_THROTTLE    2047
+
+int bitstream_timing_calc(bitstream_timing *t, uint32 clk_hz, uint32 bit_hz,
+                          uint16 zero_permille, uint16 one_permille);
+int bitstream_ws2812_timing(bitstream_timing *t, uint32 clk_hz);
+int bitstream_dshot_timing(bitstream_timing *t, uint32 clk_hz,
+                           bitstream_dshot_speed speed);
+uint16 bitstream_dshot_frame(uint16 value, uint8 telemetry);
+void bitstream_encode_word(const bitstream_timing *t, uint32 word,
+                           uint8 bits, uint16 *slots, uint32 stride);
+uint32 bitstream_encode(const bitstream_timing *t, const uint8 *data,
+                        uint32 first_bit, uint32 bits, uint16 *slots,
+                        uint32 count, uint32 stride);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
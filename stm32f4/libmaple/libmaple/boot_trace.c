@@ -0,0 +1,109 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file boot_trace.c
+ * @brief Startup timestamps and bootloader handoff
+ */
+
+#include "boot_trace.h"
+#include "dwt.h"
+
+/* Without a bootloader (VECT_TAB_BASE) the program owns all of RAM,
+ * so the trace is kept in an ordinary variable instead. */
+#ifdef VECT_TAB_BASE
+static boot_handoff boot_block;
+#define BOOT_HANDOFF (&boot_block)
+#else
+#define BOOT_HANDOFF ((boot_handoff*)BOOT_HANDOFF_ADDR)
+#endif
+
+/**
+ * @brief Take over the bootloader's trace, or start a new one.
+ *
+ * Called first thing from init(). If the bootloader left a valid
+ * block its stamps are kept and the cycle counter, which it started,
+ * keeps running; otherwise the counter is started here.
+ */
+void boot_trace_init(void) {
+    boot_handoff *h = BOOT_HANDOFF;
+
+    if (h->magic != BOOT_HANDOFF_MAGIC || h->count > BOOT_TRACE_MAX ||
+        !dwt_cyccnt_enabled()) {
+        h->magic = BOOT_HANDOFF_MAGIC;
+        h->count = 0;
+        dwt_cyccnt_enable();
+    }
+    h->dfu_request = 0;
+}
+
+/**
+ * @brief Record the current cycle count for a startup stage.
+ *
+ * Stamps past BOOT_TRACE_MAX are dropped.
+ *
+ * @param tag Stage name, see BOOT_TAG().
+ */
+void boot_trace_mark(uint32 tag) {
+    boot_handoff *h = BOOT_HANDOFF;
+    uint32 cycles = dwt_cycles();
+
+    if (h->count < BOOT_TRACE_MAX) {
+        h->stamp[h->count].tag = tag;
+        h->stamp[h->count].cycles = cycles;
+        h->count++;
+    }
+}
+
+/**
+ * @brief Number of stamps recorded since reset.
+ */
+uint32 boot_trace_count(void) {
+    return BOOT_HANDOFF->count;
+}
+
+/**
+ * @brief Get a recorded stamp.
+ * @param i Stamp index, 0 is the earliest.
+ * @return The stamp, or NULL if i is out of range.
+ */
+const boot_stamp* boot_trace_get(uint32 i) {
+    boot_handoff *h = BOOT_HANDOFF;
+    return i < h->count ? &h->stamp[i] : NULL;
+}
+
+/**
+ * @brief Ask the bootloader to stay in DFU mode after the next reset.
+ *
+ * A bootloader built with FAST_BOOT otherwise starts the program again
+ * immediately.
+ */
+void boot_request_dfu(void) {
+    boot_handoff *h = BOOT_HANDOFF;
+
+    h->magic = BOOT_HANDOFF_MAGIC;
+    h->dfu_request = BOOT_DFU_REQUEST;
+}
@@ -0,0 +1,89 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file boot_trace.h
+ *
+ * @brief Startup timestamps and the RAM handoff block shared with the
+ * bootloader.
+ *
+ * The bootloader and libmaple stamp each startup stage with the DWT
+ * cycle count into a small block at BOOT_HANDOFF_ADDR, which lies in
+ * the RAM reserved for the bootloader and is neither initialized nor
+ * used by the program. The same block carries a DFU request from the
+ * program to the bootloader across a reset, so a bootloader built with
+ * FAST_BOOT knows to stay in DFU mode. The layout must match
+ * maple-bootloader/boot.h.
+ */
+
+#ifndef _BOOT_TRACE_H_
+#define _BOOT_TRACE_H_
+
+#include "libmaple_types.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** Address of the handoff block, below USER_ADDR_RAM */
+#define BOOT_HANDOFF_ADDR               0x20000000
+/** boot_handoff.magic when the block is valid */
+#define BOOT_HANDOFF_MAGIC              0xB0071ACE
+/** boot_handoff.dfu_request asking the bootloader to stay in DFU mode */
+#define BOOT_DFU_REQUEST                0x1EAF1EAF
+
+/** Number of stamps the block holds */
+#define BOOT_TRACE_MAX                  15
+
+/** Build a stamp tag from four characters, e.g. BOOT_TAG('a','d','c',' ') */
+#define BOOT_TAG(a, b, c, d)                                            \
+    ((uint32)(a) | ((uint32)(b) << 8) | ((uint32)(c) << 16) | ((uint32)(d) << 24))
+
+/** One startup stage: a four character tag and the cycle count */
+typedef struct boot_stamp {
+    uint32 tag;
+    uint32 cycles;
+} boot_stamp;
+
+/** Handoff block layout */
+typedef struct boot_handoff {
+    uint32 magic;
+    uint32 dfu_request;
+    uint32 count;
+    boot_stamp stamp[BOOT_TRACE_MAX];
+} boot_handoff;
+
+void boot_trace_init(void);
+void boot_trace_mark(uint32 tag);
+uint32 boot_trace_count(void);
+const boot_stamp* boot_trace_get(uint32 i);
+void boot_request_dfu(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
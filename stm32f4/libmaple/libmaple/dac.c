@@ -123,4 +123,87 @@ void dac_disable_channel(const dac_dev *dev, uint8 channel) {
     }
 }
 
+/* Channel 2's control bits are channel 1's, 16 bits up */
+static inline uint32 dac_cr_shift(uint8 channel) {
+    return channel == 2 ? 16 : 0;
+}
+
+/**
+ * @brief Convert on a trigger instead of on each write.
+ *
+ * Each trigger moves the data holding register to the output, and
+ * requests the next value from DMA if that is enabled.
+ *
+ * @param dev DAC device
+ * @param channel 1 or 2
+ * @param trig Trigger source
+ */
+void dac_set_trigger(const dac_dev *dev, uint8 channel, dac_trigger trig) {
+    uint32 shift = dac_cr_shift(channel);
+    uint32 cr = dev->regs->CR & ~((DAC_CR_TSEL1 | DAC_CR_TEN1) << shift);
+
+    dev->regs->CR = cr | (((uint32)trig << 3 | DAC_CR_TEN1) << shift);
+}
+
+/**
+ * @brief Convert on each write again.
+ * @param dev DAC device
+ * @param channel 1 or 2
+ */
+void dac_disable_trigger(const dac_dev *dev, uint8 channel) {
+    dev->regs->CR &= ~((DAC_CR_TSEL1 | DAC_CR_TEN1) << dac_cr_shift(channel));
+}
+
+/**
+ * @brief Generate noise or a triangle on top of the written value.
+ *
+ * Both advance on each trigger, so a trigger must be set.  The noise
+ * is the low `bits' bits of an LFSR; the triangle counts from 0 up to
+ * 2^bits - 1 and back.  Either is added to the data holding register,
+ * which sets the base level.
+ *
+ * @param dev DAC device
+ * @param channel 1 or 2
+ * @param wave Waveform
+ * @param bits Amplitude, 1 to 12 bits.
+ */
+void dac_set_wave(const dac_dev *dev, uint8 channel, dac_wave wave,
+                  uint8 bits) {
+    uint32 shift = dac_cr_shift(channel);
+    uint32 cr = dev->regs->CR & ~((DAC_CR_WAVE1 | DAC_CR_MAMP1) << shift);
+    uint32 mamp = bits > 12 ? 11 : bits ? bits - 1 : 0;
+
+    dev->regs->CR = cr | (((uint32)wave << 6 | mamp << 8) << shift);
+}
+
+/**
+ * @brief Enable or disable DMA requests on each trigger.
+ *
+ * For both channels through DHR12RD, enable DMA on channel 1 only and
+ * trigger both from the same source.
+ *
+ * @param dev DAC device
+ * @param channel 1 or 2
+ * @param enable Nonzero to enable
+ */
+void dac_set_dma(const dac_dev *dev, uint8 channel, uint8 enable) {
+    uint32 bit = DAC_CR_DMAEN1 << dac_cr_shift(channel);
+
+    if (enable) {
+        dev->regs->CR |= bit;
+    } else {
+        dev->regs->CR &= ~bit;
+    }
+}
+
+/**
+ * @brief A channel's 12-bit right-aligned data holding register, for
+ *        DMA.
+ * @param dev DAC device
+ * @param channel 1 or 2
+ */
+__io uint32* dac_dhr12r(const dac_dev *dev, uint8 channel) {
+    return channel == 2 ? &dev->regs->DHR12R2 : &dev->regs->DHR12R1;
+}
+
 #endif  /* STM32_HIGH_DENSITY */
@@ -68,6 +68,9 @@ typedef struct dac_reg_map {
                               register */
     __io uint32 DOR1;    /**< Channel 1 data output register */
     __io uint32 DOR2;    /**< Channel 2 data output register */
+#if defined(STM32F2) || defined(STM32L1)
+    __io uint32 SR;      /**< Status register */
+#endif
 } dac_reg_map;
 
 /** DAC register map base address */
@@ -97,7 +100,7 @@ extern const dac_dev *DAC;
 #define DAC_CR_WAVE1             (0x3 << 6) /* Noise/triangle wave enable */
 #define DAC_CR_MAMP1             (0xF << 8) /* Mask/amplitude selector */
 #define DAC_CR_DMAEN1               BIT(12) /* DMA enable */
-#ifdef STM32L1
+#if defined(STM32F2) || defined(STM32L1)
 #define DAC_CR_DMAUDRIE1			BIT(13) /* DMA underrun interrupt enable */
 #endif
 /* Channel 2 control */
@@ -108,7 +111,7 @@ extern const dac_dev *DAC;
 #define DAC_CR_WAVE2            (0x3 << 22) /* Noise/triangle wave generation*/
 #define DAC_CR_MAMP2            (0xF << 24) /* Mask/amplitude selector */
 #define DAC_CR_DMAEN2               BIT(28) /* DMA enable */
-#ifdef STM32L1
+#if defined(STM32F2) || defined(STM32L1)
 #define DAC_CR_DMAUDRIE2			BIT(29) /* DMA underrun interrupt enable */
 #endif
 
@@ -152,6 +155,12 @@ extern const dac_dev *DAC;
 /* Channel 1 data output register */
 #define DAC_DOR2_DACC2DOR        0x00000FFF
 
+#if defined(STM32F2) || defined(STM32L1)
+/* Status register */
+#define DAC_SR_DMAUDR1              BIT(13) /* Channel 1 DMA underrun */
+#define DAC_SR_DMAUDR2              BIT(29) /* Channel 2 DMA underrun */
+#endif
+
 /*
  * Convenience functions
  */
@@ -161,11 +170,64 @@ extern const dac_dev *DAC;
 
 #define DAC_CH1                         0x1
 #define DAC_CH2                         0x2
+
+/** Conversion triggers (TSELx). */
+typedef enum dac_trigger {
+    DAC_TRIG_TIMER6  = 0,       /**< Timer 6 TRGO */
+    DAC_TRIG_TIMER8  = 1,       /**< Timer 8 TRGO */
+    DAC_TRIG_TIMER7  = 2,       /**< Timer 7 TRGO */
+    DAC_TRIG_TIMER5  = 3,       /**< Timer 5 TRGO */
+    DAC_TRIG_TIMER2  = 4,       /**< Timer 2 TRGO */
+    DAC_TRIG_TIMER4  = 5,       /**< Timer 4 TRGO */
+    DAC_TRIG_EXTI9   = 6,       /**< EXTI line 9 */
+    DAC_TRIG_SOFTWARE = 7,      /**< SWTRIGR */
+} dac_trigger;
+
+/** Waveform generation (WAVEx). */
+typedef enum dac_wave {
+    DAC_WAVE_NONE     = 0,      /**< Data holding register only */
+    DAC_WAVE_NOISE    = 1,      /**< LFSR noise added */
+    DAC_WAVE_TRIANGLE = 2,      /**< Triangle added */
+} dac_wave;
+
+/** Dual 12-bit right-aligned data holding register, for DMA. */
+#define DAC_DHR12RD_ADDRESS             (&DAC->regs->DHR12RD)
+
 void dac_init(const dac_dev *dev, uint32 flags);
 
 void dac_write_channel(const dac_dev *dev, uint8 channel, uint16 val);
 void dac_enable_channel(const dac_dev *dev, uint8 channel);
 void dac_disable_channel(const dac_dev *dev, uint8 channel);
+void dac_set_trigger(const dac_dev *dev, uint8 channel, dac_trigger trig);
+void dac_disable_trigger(const dac_dev *dev, uint8 channel);
+void dac_set_wave(const dac_dev *dev, uint8 channel, dac_wave wave,
+                  uint8 bits);
+void dac_set_dma(const dac_dev *dev, uint8 channel, uint8 enable);
+__io uint32* dac_dhr12r(const dac_dev *dev, uint8 channel);
+
+/**
+ * @brief Pack two 12-bit values as DHR12RD takes them.
+ * @param ch1 Channel 1 value
+ * @param ch2 Channel 2 value
+ */
+static inline uint32 dac_pack_dual(uint16 ch1, uint16 ch2) {
+    return ((uint32)(ch2 & 0xFFF) << 16) | (ch1 & 0xFFF);
+}
+
+/**
+ * @brief Write both channels at once.
+ *
+ * With both triggered by the same event, or neither triggered, the
+ * outputs change together.
+ *
+ * @param dev DAC device
+ * @param ch1 Channel 1 value
+ * @param ch2 Channel 2 value
+ */
+static inline void dac_write_dual(const dac_dev *dev, uint16 ch1,
+                                  uint16 ch2) {
+    dev->regs->DHR12RD = dac_pack_dual(ch1, ch2);
+}
 
 #ifdef __cplusplus
 } // extern "C"
@@ -0,0 +1,435 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file decimate.c
+ * @brief Oversampling and decimation filters for ADC sample streams.
+ */
+
+#include <string.h>
+#include "decimate.h"
+
+/*
+ * SIMD helpers: the instructions with the DSP extension, the same
+ * arithmetic in C elsewhere, so that the paired loops below can be
+ * checked against the plain ones on any machine.
+ */
+
+/* Two halfword additions, each modulo 2^16 */
+static inline uint32 sadd16(uint32 a, uint32 b) {
+#ifdef __ARM_FEATURE_DSP
+    uint32 r;
+    asm("sadd16 %0, %1, %2" : "=r" (r) : "r" (a), "r" (b));
+    return r;
+#else
+    return ((a + b) & 0xFFFF) | ((((a >> 16) + (b >> 16)) & 0xFFFF) << 16);
+#endif
+}
+
+/* acc + x.lo * y.lo + x.hi * y.hi, signed halfwords */
+static inline int32 smlad(uint32 x, uint32 y, int32 acc) {
+#ifdef __ARM_FEATURE_DSP
+    asm("smlad %0, %1, %2, %0" : "+r" (acc) : "r" (x), "r" (y));
+    return acc;
+#else
+    return acc + (int16)x * (int16)y + (int16)(x >> 16) * (int16)(y >> 16);
+#endif
+}
+
+/* Two halfwords at any even address; a single LDR on the M3/M4 */
+static inline uint32 load_pair(const void *p) {
+    uint32 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32 decim_sum_c(const uint16 *in, uint32 n) {
+    uint32 sum = 0;
+
+    while (n >= 4) {
+        sum += in[0] + in[1] + in[2] + in[3];
+        in += 4;
+        n -= 4;
+    }
+    while (n--) {
+        sum += *in++;
+    }
+    return sum;
+}
+
+/*
+ * Each lane of a SADD16 accumulator adds up 16 samples of at most 12
+ * bits (16 * 4095 < 2^16) before the lanes are folded into the total.
+ */
+uint32 decim_sum_simd(const uint16 *in, uint32 n) {
+    uint32 sum = 0;
+    uint32 lanes;
+    uint32 pairs;
+
+    while (n >= 2) {
+        pairs = n / 2 > 16 ? 16 : n / 2;
+        n -= 2 * pairs;
+        lanes = 0;
+        while (pairs >= 2) {
+            lanes = sadd16(lanes, load_pair(in));
+            lanes = sadd16(lanes, load_pair(in + 2));
+            in += 4;
+            pairs -= 2;
+        }
+        if (pairs) {
+            lanes = sadd16(lanes, load_pair(in));
+            in += 2;
+        }
+        sum += (lanes & 0xFFFF) + (lanes >> 16);
+    }
+    if (n) {
+        sum += *in;
+    }
+    return sum;
+}
+
+int32 decim_dot_c(const int16 *x, const int16 *c, uint32 n) {
+    int32 acc = 0;
+    uint32 i;
+
+    for (i = 0; i < n; i++) {
+        acc += x[i] * c[i];
+    }
+    return acc;
+}
+
+int32 decim_dot_simd(const int16 *x, const int16 *c, uint32 n) {
+    int32 acc = 0;
+    uint32 i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        acc = smlad(load_pair(x + i), load_pair(c + i), acc);
+        acc = smlad(load_pair(x + i + 2), load_pair(c + i + 2), acc);
+    }
+    for (; i < n; i++) {
+        acc += x[i] * c[i];
+    }
+    return acc;
+}
+
+static uint8 log2_ceil(uint32 x) {
+    uint8 bits = 0;
+
+    while (bits < 32 && ((uint64)1 << bits) < x) {
+        bits++;
+    }
+    return bits;
+}
+
+/**
+ * @brief Set up oversampling: each output is the sum of `ratio'
+ *        inputs shifted right by `shift'.
+ *
+ * Oversampling by 4^n and shifting by n adds n bits of resolution,
+ * given enough noise on the input to dither it.
+ *
+ * @return 0, or -1 if the outputs could exceed 16 bits.
+ */
+int decim_avg_init(decim_avg *st, uint32 ratio, uint8 shift) {
+    uint64 max = (uint64)((1 << DECIM_INPUT_BITS) - 1) * ratio;
+
+    if (ratio == 0 || shift > 31 || max > 0xFFFFFFFF ||
+        (max >> shift) > 0xFFFF) {
+        return -1;
+    }
+    st->ratio = ratio;
+    st->count = 0;
+    st->acc = 0;
+    st->shift = shift;
+    st->divide = 0;
+    return 0;
+}
+
+/**
+ * @brief Set up a moving average: each output is the rounded mean of
+ *        `ratio' inputs.
+ * @return 0, or -1 if ratio is 0 or the sum could overflow.
+ */
+int decim_mean_init(decim_avg *st, uint32 ratio) {
+    if (ratio == 0 || ratio > (0xFFFFFFFF >> DECIM_INPUT_BITS)) {
+        return -1;
+    }
+    st->ratio = ratio;
+    st->count = 0;
+    st->acc = 0;
+    st->shift = 0;
+    st->divide = 1;
+    return 0;
+}
+
+/**
+ * @brief Average a block of samples.
+ * @param st State
+ * @param in Samples
+ * @param n Number of samples
+ * @param out Outputs; room for n / ratio + 1.
+ * @return Number of outputs written.
+ */
+uint32 decim_avg_process(decim_avg *st, const uint16 *in, uint32 n,
+                         uint16 *out) {
+    uint32 produced = 0;
+    uint32 take;
+
+    while (n) {
+        take = st->ratio - st->count;
+        if (take > n) {
+            take = n;
+        }
+        st->acc += decim_sum(in, take);
+        st->count += take;
+        in += take;
+        n -= take;
+        if (st->count == st->ratio) {
+            if (st->divide) {
+                out[produced++] =
+                    (uint16)((st->acc + st->ratio / 2) / st->ratio);
+            } else {
+                out[produced++] = (uint16)(st->acc >> st->shift);
+            }
+            st->acc = 0;
+            st->count = 0;
+        }
+    }
+    return produced;
+}
+
+/**
+ * @brief Set up a CIC decimator.
+ *
+ * Its DC gain is ratio^order; the output is shifted right by `shift'
+ * to fit 16 bits.  The integrators wrap, which the combs undo, as
+ * long as the full gain fits 32 bits.
+ *
+ * @param st State
+ * @param order 1 to 4.  Order 1 is the same as decim_avg.
+ * @param ratio Inputs per output.
+ * @param shift Right shift of the output.
+ * @return 0, or -1 if the gain exceeds 32 bits or the outputs could
+ *         exceed 16.
+ */
+int decim_cic_init(decim_cic *st, uint8 order, uint32 ratio, uint8 shift) {
+    uint64 max;
+    uint8 i;
+
+    if (order < 1 || order > 4 || ratio == 0 || shift > 31 ||
+        DECIM_INPUT_BITS + order * log2_ceil(ratio) > 32) {
+        return -1;
+    }
+    max = (1 << DECIM_INPUT_BITS) - 1;
+    for (i = 0; i < order; i++) {
+        max *= ratio;
+    }
+    if ((max >> shift) > 0xFFFF) {
+        return -1;
+    }
+    st->order = order;
+    st->shift = shift;
+    st->ratio = ratio;
+    st->count = 0;
+    for (i = 0; i < 4; i++) {
+        st->integ[i] = 0;
+        st->comb[i] = 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief Filter and decimate a block of samples.
+ * @param st State
+ * @param in Samples
+ * @param n Number of samples
+ * @param out Outputs; room for n / ratio + 1.
+ * @return Number of outputs written.
+ */
+uint32 decim_cic_process(decim_cic *st, const uint16 *in, uint32 n,
+                         uint16 *out) {
+    /* All four integrators run whatever the order: four adds cost
+     * less than a branch per sample, and the unused ones are never
+     * read */
+    uint32 i0 = st->integ[0], i1 = st->integ[1];
+    uint32 i2 = st->integ[2], i3 = st->integ[3];
+    uint32 count = st->count;
+    uint32 produced = 0;
+    uint32 v, prev;
+    uint8 k;
+
+    while (n--) {
+        i0 += *in++;
+        i1 += i0;
+        i2 += i1;
+        i3 += i2;
+        if (++count < st->ratio) {
+            continue;
+        }
+        count = 0;
+        switch (st->order) {
+        case 1:
+            v = i0;
+            break;
+        case 2:
+            v = i1;
+            break;
+        case 3:
+            v = i2;
+            break;
+        default:
+            v = i3;
+            break;
+        }
+        for (k = 0; k < st->order; k++) {
+            prev = st->comb[k];
+            st->comb[k] = v;
+            v -= prev;
+        }
+        out[produced++] = (uint16)(v >> st->shift);
+    }
+    st->integ[0] = i0;
+    st->integ[1] = i1;
+    st->integ[2] = i2;
+    st->integ[3] = i3;
+    st->count = count;
+    return produced;
+}
+
+/**
+ * @brief Set up a decimating FIR filter.
+ *
+ * Output n is the sum of coeffs[k] * input[n - k], divided by 32768
+ * with rounding and clamped to 0..65535.  Inputs must be below 32768.
+ *
+ * @param st State
+ * @param coeffs Q15 coefficients; kept by reference.
+ * @param taps Number of coefficients, up to DECIM_FIR_MAX_TAPS.
+ * @param ratio Inputs per output.
+ * @return 0, or -1 if the sizes are out of range or the coefficients'
+ *         absolute sum exceeds 65535, which could overflow the
+ *         accumulator.
+ */
+int decim_fir_init(decim_fir *st, const int16 *coeffs, uint16 taps,
+                   uint32 ratio) {
+    uint32 total = 0;
+    uint16 i;
+
+    if (taps == 0 || taps > DECIM_FIR_MAX_TAPS || ratio == 0) {
+        return -1;
+    }
+    for (i = 0; i < taps; i++) {
+        total += coeffs[i] < 0 ? -coeffs[i] : coeffs[i];
+    }
+    if (total > 0xFFFF) {
+        return -1;
+    }
+    st->coeffs = coeffs;
+    st->taps = taps;
+    st->pos = 0;
+    st->ratio = ratio;
+    st->phase = 0;
+    memset(st->history, 0, sizeof(st->history));
+    return 0;
+}
+
+/**
+ * @brief Filter and decimate a block of samples.
+ * @param st State
+ * @param in Samples, below 32768.
+ * @param n Number of samples
+ * @param out Outputs; room for n / ratio + 1.
+ * @return Number of outputs written.
+ */
+uint32 decim_fir_process(decim_fir *st, const uint16 *in, uint32 n,
+                         uint16 *out) {
+    uint32 produced = 0;
+    uint16 taps = st->taps;
+    int32 acc;
+
+    while (n--) {
+        st->pos = (st->pos ? st->pos : taps) - 1;
+        st->history[st->pos] = st->history[st->pos + taps] = (int16)*in++;
+        if (++st->phase < st->ratio) {
+            continue;
+        }
+        st->phase = 0;
+        acc = decim_dot(&st->history[st->pos], st->coeffs, taps);
+        acc = (acc + (1 << 14)) >> 15;
+        if (acc < 0) {
+            acc = 0;
+        } else if (acc > 0xFFFF) {
+            acc = 0xFFFF;
+        }
+        out[produced++] = (uint16)acc;
+    }
+    return produced;
+}
+
+static uint32 first_process(decim_pipeline *p, const uint16 *in, uint32 n,
+                            uint16 *out) {
+    if (p->stage == DECIM_STAGE_CIC) {
+        return decim_cic_process(&p->first.cic, in, n, out);
+    }
+    return decim_avg_process(&p->first.avg, in, n, out);
+}
+
+/**
+ * @brief Inputs per output of a whole pipeline.
+ */
+uint32 decim_pipeline_ratio(const decim_pipeline *p) {
+    uint32 ratio = p->stage == DECIM_STAGE_CIC ? p->first.cic.ratio
+                                               : p->first.avg.ratio;
+    return p->fir ? ratio * p->fir->ratio : ratio;
+}
+
+/**
+ * @brief Run a block of samples through a pipeline.
+ * @param p Pipeline, its stages set up
+ * @param in Samples
+ * @param n Number of samples
+ * @param out Outputs; room for n / decim_pipeline_ratio() + 1.
+ * @return Number of outputs written.
+ */
+uint32 decim_pipeline_process(decim_pipeline *p, const uint16 *in,
+                              uint32 n, uint16 *out) {
+    uint16 tmp[DECIM_CHUNK];
+    uint32 produced = 0;
+    uint32 take;
+
+    if (!p->fir) {
+        return first_process(p, in, n, out);
+    }
+    while (n) {
+        take = n > DECIM_CHUNK ? DECIM_CHUNK : n;
+        produced += decim_fir_process(p->fir, tmp,
+                                      first_process(p, in, take, tmp),
+                                      out + produced);
+        in += take;
+        n -= take;
+    }
+    return produced;
+}
@@ -0,0 +1,192 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file decimate.h
+ * @brief Oversampling and decimation filters for ADC sample streams.
+ *
+ * Each stage takes a block of samples, such as the half buffer an
+ * AdcScan handler receives, keeps whatever it has not finished with
+ * for the next block, and writes one output per `ratio' inputs:
+ *
+ * - decim_avg sums `ratio' samples and shifts the sum: oversampling
+ *   by 4^n with a shift of n gives n extra bits.  Or, set up with
+ *   decim_mean_init(), divides it, for a plain moving average.
+ * - decim_cic is a cascaded integrator-comb filter of order 1 to 4:
+ *   a steeper anti-alias response than one average, still with no
+ *   multiplications.
+ * - decim_fir is an FIR filter with Q15 coefficients, evaluated only
+ *   for the samples it keeps.  It usually follows one of the others
+ *   to flatten their droop and cut what they let alias.
+ *
+ * decim_pipeline chains a first stage and an optional FIR:
+ *
+ *     static decim_pipeline pipe;
+ *     static decim_fir fir;
+ *     static const int16 taps[16] = {...};     // Q15, sum 32768
+ *
+ *     // Gain 8^3: 12 + 9 bits, less 6, leaves 15 for the FIR
+ *     decim_cic_init(&pipe.first.cic, 3, 8, 6);
+ *     decim_fir_init(&fir, taps, 16, 2);
+ *     pipe.stage = DECIM_STAGE_CIC;
+ *     pipe.fir = &fir;
+ *
+ *     void gotSamples(const uint16 *samples, uint32 count) {
+ *         uint16 out[64];                     // count / 16
+ *         uint32 n = decim_pipeline_process(&pipe, samples, count, out);
+ *         ...
+ *     }
+ *
+ * The FIR takes samples of at most 15 bits.
+ *
+ * Inputs are unsigned samples of at most DECIM_INPUT_BITS bits.  The
+ * summing and FIR inner loops use the Cortex-M4 SADD16 and SMLAD
+ * instructions when the DSP extension is available (DECIM_SIMD), and
+ * plain C otherwise; both give identical results.
+ */
+
+#ifndef _DECIMATE_H_
+#define _DECIMATE_H_
+
+#include "libmaple_types.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** Bits per input sample. */
+#define DECIM_INPUT_BITS                12
+/** Most FIR taps. */
+#define DECIM_FIR_MAX_TAPS              64
+/** Samples a pipeline's first stage handles at a time. */
+#define DECIM_CHUNK                     64
+
+/** Whether to use the SADD16/SMLAD inner loops. */
+#ifndef DECIM_SIMD
+#ifdef __ARM_FEATURE_DSP
+#define DECIM_SIMD                      1
+#else
+#define DECIM_SIMD                      0
+#endif
+#endif
+
+/** Sum-and-dump average. */
+typedef struct decim_avg {
+    uint32 ratio;               /**< Inputs per output */
+    uint32 count;               /**< Inputs summed so far */
+    uint32 acc;                 /**< Their sum */
+    uint8 shift;                /**< Right shift of the sum */
+    uint8 divide;               /**< Divide the sum by ratio instead */
+} decim_avg;
+
+/** Cascaded integrator-comb decimator. */
+typedef struct decim_cic {
+    uint8 order;                /**< Number of integrators and combs */
+    uint8 shift;                /**< Right shift of the output */
+    uint32 ratio;               /**< Inputs per output */
+    uint32 count;               /**< Inputs since the last output */
+    uint32 integ[4];            /**< Integrators, modulo 2^32 */
+    uint32 comb[4];             /**< Comb delay lines */
+} decim_cic;
+
+/** Decimating FIR filter. */
+typedef struct decim_fir {
+    const int16 *coeffs;        /**< Q15 coefficients, newest sample first */
+    uint16 taps;                /**< Number of coefficients */
+    uint16 pos;                 /**< Newest sample's index in history */
+    uint32 ratio;               /**< Inputs per output */
+    uint32 phase;               /**< Inputs since the last output */
+    /* Each sample is stored twice, taps apart, so that the newest
+     * `taps' are always contiguous from history[pos] */
+    int16 history[2 * DECIM_FIR_MAX_TAPS];
+} decim_fir;
+
+/** Kinds of first stage for decim_pipeline. */
+typedef enum decim_stage {
+    DECIM_STAGE_AVG,            /**< decim_avg */
+    DECIM_STAGE_CIC             /**< decim_cic */
+} decim_stage;
+
+/** A first stage and an optional FIR. */
+typedef struct decim_pipeline {
+    decim_stage stage;          /**< Which of first is used */
+    union {
+        decim_avg avg;
+        decim_cic cic;
+    } first;                    /**< First stage, set up by its init */
+    decim_fir *fir;             /**< Second stage, or NULL */
+} decim_pipeline;
+
+int decim_avg_init(decim_avg *st, uint32 ratio, uint8 shift);
+int decim_mean_init(decim_avg *st, uint32 ratio);
+uint32 decim_avg_process(decim_avg *st, const uint16 *in, uint32 n,
+                         uint16 *out);
+
+int decim_cic_init(decim_cic *st, uint8 order, uint32 ratio, uint8 shift);
+uint32 decim_cic_process(decim_cic *st, const uint16 *in, uint32 n,
+                         uint16 *out);
+
+int decim_fir_init(decim_fir *st, const int16 *coeffs, uint16 taps,
+                   uint32 ratio);
+uint32 decim_fir_process(decim_fir *st, const uint16 *in, uint32 n,
+                         uint16 *out);
+
+uint32 decim_pipeline_ratio(const decim_pipeline *p);
+uint32 decim_pipeline_process(decim_pipeline *p, const uint16 *in,
+                              uint32 n, uint16 *out);
+
+uint32 decim_sum_c(const uint16 *in, uint32 n);
+uint32 decim_sum_simd(const uint16 *in, uint32 n);
+int32 decim_dot_c(const int16 *x, const int16 *c, uint32 n);
+int32 decim_dot_simd(const int16 *x, const int16 *c, uint32 n);
+
+/**
+ * @brief Sum of samples of at most DECIM_INPUT_BITS bits.
+ */
+static inline uint32 decim_sum(const uint16 *in, uint32 n) {
+#if DECIM_SIMD
+    return decim_sum_simd(in, n);
+#else
+    return decim_sum_c(in, n);
+#endif
+}
+
+/**
+ * @brief Dot product; the caller keeps it within an int32.
+ */
+static inline int32 decim_dot(const int16 *x, const int16 *c, uint32 n) {
+#if DECIM_SIMD
+    return decim_dot_simd(x, c, n);
+#else
+    return decim_dot_c(x, c, n);
+#endif
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -5,6 +5,7 @@
 
 #include "libmaple_types.h"
 #include "stm32.h"
+#include "dwt.h"
 
 #ifndef _DELAY_H_
 #define _DELAY_H_
@@ -12,9 +13,23 @@
 /**
  * @brief Delay the given number of microseconds.
  *
+ * Counts core cycles on the DWT cycle counter once it runs (init()
+ * starts it); before that, falls back to a calibrated busy loop whose
+ * accuracy depends on flash wait states.
+ *
  * @param us Number of microseconds to delay.
  */
 static inline void delay_us(uint32 us) {
+    if (dwt_cyccnt_enabled()) {
+        /* keep each wait below 2^32 cycles */
+        while (us > 1000000) {
+            dwt_delay_cycles(1000000 * STM32_TICKS_PER_US);
+            us -= 1000000;
+        }
+        dwt_delay_cycles(us * STM32_TICKS_PER_US);
+        return;
+    }
+
     us *= STM32_DELAY_US_MULT;
 
     /* fudge for function call overhead  */
@@ -0,0 +1,438 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file dmaF2.c
+ * @brief Direct Memory Access peripheral support, STM32F2/F4 streams.
+ */
+
+#include "dma.h"
+#include "bitband.h"
+#include "util.h"
+
+/*
+ * Devices
+ */
+
+static dma_dev dma1 = {
+    .regs     = DMA1_BASE,
+    .clk_id   = RCC_DMA1,
+    .handlers = {{ .handler = NULL, .irq_line = NVIC_DMA1_STREAM0 },
+                 { .handler = NULL, .irq_line = NVIC_DMA1_STREAM1 },
+                 { .handler = NULL, .irq_line = NVIC_DMA1_STREAM2 },
+                 { .handler = NULL, .irq_line = NVIC_DMA1_STREAM3 },
+                 { .handler = NULL, .irq_line = NVIC_DMA1_STREAM4 },
+                 { .handler = NULL, .irq_line = NVIC_DMA1_STREAM5 },
+                 { .handler = NULL, .irq_line = NVIC_DMA1_STREAM6 },
+                 { .handler = NULL, .irq_line = NVIC_DMA1_STREAM7 }}
+};
+/** DMA1 device */
+dma_dev* const DMA1 = &dma1;
+
+static dma_dev dma2 = {
+    .regs     = DMA2_BASE,
+    .clk_id   = RCC_DMA2,
+    .handlers = {{ .handler = NULL, .irq_line = NVIC_DMA2_STREAM0 },
+                 { .handler = NULL, .irq_line = NVIC_DMA2_STREAM1 },
+                 { .handler = NULL, .irq_line = NVIC_DMA2_STREAM2 },
+                 { .handler = NULL, .irq_line = NVIC_DMA2_STREAM3 },
+                 { .handler = NULL, .irq_line = NVIC_DMA2_STREAM4 },
+                 { .handler = NULL, .irq_line = NVIC_DMA2_STREAM5 },
+                 { .handler = NULL, .irq_line = NVIC_DMA2_STREAM6 },
+                 { .handler = NULL, .irq_line = NVIC_DMA2_STREAM7 }}
+};
+/** DMA2 device */
+dma_dev* const DMA2 = &dma2;
+
+static void dma2_stream4_handler(void);
+static void dma2_stream5_handler(void);
+static void dma2_stream6_handler(void);
+static void dma2_stream7_handler(void);
+
+/*
+ * Convenience routines
+ */
+
+/**
+ * @brief Initialize a DMA device.
+ * @param dev Device to initialize.
+ */
+void dma_init(dma_dev *dev) {
+    rcc_clk_enable(dev->clk_id);
+}
+
+/**
+ * @brief Set up a DMA transfer.
+ *
+ * The stream will be disabled before being reconfigured.  The
+ * transfer will have low priority and use direct mode (no FIFO) by
+ * default.  You may choose another priority using dma_set_priority()
+ * or set up the FIFO using dma_set_fifo() before the transfer
+ * begins.  When the stream is configured to your liking, enable it
+ * using dma_enable().
+ *
+ * @param dev DMA device.
+ * @param stream DMA stream.
+ * @param channel Request channel the stream serves.
+ * @param peripheral_address Base address of peripheral data register
+ *                           involved in the transfer.
+ * @param peripheral_size Peripheral data transfer size.
+ * @param memory_address Base memory address involved in the transfer.
+ *                       In double buffer mode, the first buffer.
+ * @param memory_size Memory data transfer size.
+ * @param mode Logical OR of dma_mode_flags
+ * @sideeffect Disables the given DMA stream.
+ * @see dma_xfer_size
+ * @see dma_mode_flags
+ * @see dma_set_num_transfers()
+ * @see dma_set_mem1_addr()
+ * @see dma_attach_interrupt()
+ * @see dma_enable()
+ */
+void dma_setup_transfer(dma_dev       *dev,
+                        dma_stream     stream,
+                        dma_channel    channel,
+                        __io void     *peripheral_address,
+                        dma_xfer_size  peripheral_size,
+                        __io void     *memory_address,
+                        dma_xfer_size  memory_size,
+                        uint32         mode) {
+    dma_stream_reg_map *stream_regs = dma_stream_regs(dev, stream);
+
+    dma_disable(dev, stream);   /* can't write to M0AR/PAR otherwise */
+    dma_clear_isr_bits(dev, stream, DMA_ISR_ALL);
+    stream_regs->CR = ((uint32)channel << 25) | (memory_size << 13) |
+        (peripheral_size << 11) | mode;
+    stream_regs->FCR = DMA_SFCR_FTH_1_2;
+    stream_regs->M0AR = (uint32)(unsigned long)memory_address;
+    stream_regs->PAR = (uint32)(unsigned long)peripheral_address;
+}
+
+/**
+ * @brief Set the number of data to be transferred on a DMA stream.
+ *
+ * You may not call this function while the stream is enabled.
+ *
+ * @param dev DMA device
+ * @param stream Stream through which the transfer occurs.
+ * @param num_transfers
+ */
+void dma_set_num_transfers(dma_dev *dev,
+                           dma_stream stream,
+                           uint16 num_transfers) {
+    ASSERT_FAULT(!dma_is_stream_enabled(dev, stream));
+
+    dma_stream_regs(dev, stream)->NDTR = num_transfers;
+}
+
+/**
+ * @brief Set the priority of a DMA transfer.
+ *
+ * You may not call this function while the stream is enabled.
+ *
+ * @param dev DMA device
+ * @param stream DMA stream
+ * @param priority priority to set.
+ */
+void dma_set_priority(dma_dev *dev,
+                      dma_stream stream,
+                      dma_priority priority) {
+    dma_stream_reg_map *stream_regs;
+    uint32 cr;
+
+    ASSERT_FAULT(!dma_is_stream_enabled(dev, stream));
+
+    stream_regs = dma_stream_regs(dev, stream);
+    cr = stream_regs->CR;
+    cr &= ~DMA_SCR_PL;
+    cr |= priority;
+    stream_regs->CR = cr;
+}
+
+/**
+ * @brief Configure a stream's FIFO.
+ *
+ * You may not call this function while the stream is enabled.
+ *
+ * @param dev DMA device
+ * @param stream DMA stream
+ * @param fcr DMA_SFCR_DMDIS to use the FIFO, ORed with a
+ *            DMA_SFCR_FTH_* threshold and optionally DMA_SFCR_FEIE.
+ *            0 selects direct mode.
+ */
+void dma_set_fifo(dma_dev *dev, dma_stream stream, uint32 fcr) {
+    ASSERT_FAULT(!dma_is_stream_enabled(dev, stream));
+
+    dma_stream_regs(dev, stream)->FCR = fcr;
+}
+
+/**
+ * @brief Attach an interrupt to a DMA transfer.
+ *
+ * Interrupts are enabled using appropriate mode flags in
+ * dma_setup_transfer().
+ *
+ * DMA2 streams 4 to 7 have no slot in the STM32F1-layout vector
+ * table, so their handlers are installed with nvic_install_handler(),
+ * which moves the vector table to RAM.  DMA1 stream 7 is served from
+ * the __irq_adc3 vector, which is where the F1 has ADC3.
+ *
+ * @param dev DMA device
+ * @param stream Stream to attach handler to
+ * @param handler Interrupt handler to call when stream interrupt fires.
+ * @see dma_setup_transfer()
+ * @see dma_get_irq_cause()
+ * @see dma_detach_interrupt()
+ */
+void dma_attach_interrupt(dma_dev *dev,
+                          dma_stream stream,
+                          void (*handler)(void)) {
+    static void (* const dma2_high[4])(void) = {
+        dma2_stream4_handler, dma2_stream5_handler,
+        dma2_stream6_handler, dma2_stream7_handler,
+    };
+    nvic_irq_num irq_line = dev->handlers[stream].irq_line;
+
+    dev->handlers[stream].handler = handler;
+    if (dev == DMA2 && stream >= DMA_STREAM4) {
+        nvic_install_handler(irq_line, dma2_high[stream - DMA_STREAM4]);
+    }
+    nvic_irq_enable(irq_line);
+}
+
+/**
+ * @brief Detach a DMA transfer interrupt handler.
+ *
+ * After calling this function, the given stream's interrupts will be
+ * disabled.
+ *
+ * @param dev DMA device
+ * @param stream Stream whose handler to detach
+ * @sideeffect Clears interrupt enable bits in the stream's CR and FCR.
+ * @see dma_attach_interrupt()
+ */
+void dma_detach_interrupt(dma_dev *dev, dma_stream stream) {
+    dma_stream_reg_map *stream_regs = dma_stream_regs(dev, stream);
+
+    stream_regs->CR &= ~(DMA_SCR_TCIE | DMA_SCR_HTIE | DMA_SCR_TEIE |
+                         DMA_SCR_DMEIE);
+    stream_regs->FCR &= ~DMA_SFCR_FEIE;
+    nvic_irq_disable(dev->handlers[stream].irq_line);
+    dev->handlers[stream].handler = NULL;
+}
+
+/**
+ * @brief Discover the reason why a DMA interrupt was called.
+ *
+ * You may only call this function within an attached interrupt
+ * handler for the given stream.
+ *
+ * This function clears the stream's status flags; consequently, it
+ * can only be called once per interrupt handler invocation.  In
+ * circular mode a transfer complete that follows a half transfer
+ * closely enough may be reported together with it; use
+ * dma_get_isr_bits() if both matter.
+ *
+ * @param dev DMA device
+ * @param stream Stream whose interrupt is being handled.
+ * @return Reason why the interrupt fired.
+ * @sideeffect Clears the stream's status flags.
+ * @see dma_attach_interrupt()
+ * @see dma_irq_cause
+ */
+dma_irq_cause dma_get_irq_cause(dma_dev *dev, dma_stream stream) {
+    uint8 status_bits = dma_get_isr_bits(dev, stream);
+
+    dma_clear_isr_bits(dev, stream, status_bits);
+
+    /* Don't change the order of these if statements. */
+    if (status_bits & DMA_ISR_TEIF) {
+        return DMA_TRANSFER_ERROR;
+    } else if (status_bits & DMA_ISR_DMEIF) {
+        return DMA_TRANSFER_DME_ERROR;
+    } else if (status_bits & DMA_ISR_FEIF) {
+        return DMA_TRANSFER_FIFO_ERROR;
+    } else if (status_bits & DMA_ISR_TCIF) {
+        return DMA_TRANSFER_COMPLETE;
+    } else if (status_bits & DMA_ISR_HTIF) {
+        return DMA_TRANSFER_HALF_COMPLETE;
+    }
+    return DMA_TRANSFER_ERROR;
+}
+
+/**
+ * @brief Enable a DMA stream.
+ * @param dev DMA device
+ * @param stream Stream to enable
+ */
+void dma_enable(dma_dev *dev, dma_stream stream) {
+    dma_stream_reg_map *stream_regs = dma_stream_regs(dev, stream);
+    bb_peri_set_bit(&stream_regs->CR, DMA_SCR_EN_BIT, 1);
+}
+
+/**
+ * @brief Disable a DMA stream.
+ *
+ * A stream finishes its current data beat before it stops, so this
+ * waits until the EN bit reads back as zero.
+ *
+ * @param dev DMA device
+ * @param stream Stream to disable
+ */
+void dma_disable(dma_dev *dev, dma_stream stream) {
+    dma_stream_reg_map *stream_regs = dma_stream_regs(dev, stream);
+    bb_peri_set_bit(&stream_regs->CR, DMA_SCR_EN_BIT, 0);
+    while (stream_regs->CR & DMA_SCR_EN)
+        ;
+}
+
+/**
+ * @brief Set the base memory address where data will be read from or
+ *        written to.
+ *
+ * You must not call this function while the stream is enabled.
+ *
+ * @param dev DMA Device
+ * @param stream Stream whose base memory address to set.
+ * @param addr Memory base address to use.
+ */
+void dma_set_mem_addr(dma_dev *dev, dma_stream stream, __io void *addr) {
+    ASSERT_FAULT(!dma_is_stream_enabled(dev, stream));
+
+    dma_stream_regs(dev, stream)->M0AR = (uint32)(unsigned long)addr;
+}
+
+/**
+ * @brief Set the second memory buffer for double buffer mode.
+ *
+ * Unlike M0AR, the buffer the stream is not currently using may be
+ * changed while the stream is enabled, which is how a double
+ * buffered transfer is kept fed.
+ *
+ * @param dev DMA Device
+ * @param stream Stream whose second memory address to set.
+ * @param addr Memory base address to use.
+ * @see dma_get_current_target()
+ */
+void dma_set_mem1_addr(dma_dev *dev, dma_stream stream, __io void *addr) {
+    dma_stream_regs(dev, stream)->M1AR = (uint32)(unsigned long)addr;
+}
+
+/**
+ * @brief Set the base peripheral address where data will be read from
+ *        or written to.
+ *
+ * You must not call this function while the stream is enabled.
+ *
+ * @param dev DMA Device
+ * @param stream Stream whose peripheral data register base address to set.
+ * @param addr Peripheral memory base address to use.
+ */
+void dma_set_per_addr(dma_dev *dev, dma_stream stream, __io void *addr) {
+    ASSERT_FAULT(!dma_is_stream_enabled(dev, stream));
+
+    dma_stream_regs(dev, stream)->PAR = (uint32)(unsigned long)addr;
+}
+
+/*
+ * IRQ handlers
+ *
+ * The vector table has the STM32F1 layout, whose DMA1 channel 1..7
+ * and DMA2 channel 1..4_5 slots are DMA1 streams 0..6 and DMA2
+ * streams 0..3 on the F2/F4.  DMA1 stream 7 is where the F1 has ADC3.
+ */
+
+static inline void dispatch_handler(dma_dev *dev, dma_stream stream) {
+    void (*handler)(void) = dev->handlers[stream].handler;
+    if (handler) {
+        handler();
+    }
+    dma_clear_isr_bits(dev, stream, DMA_ISR_ALL); /* in case handler doesn't */
+}
+
+void __irq_dma1_channel1(void) {
+    dispatch_handler(DMA1, DMA_STREAM0);
+}
+
+void __irq_dma1_channel2(void) {
+    dispatch_handler(DMA1, DMA_STREAM1);
+}
+
+void __irq_dma1_channel3(void) {
+    dispatch_handler(DMA1, DMA_STREAM2);
+}
+
+void __irq_dma1_channel4(void) {
+    dispatch_handler(DMA1, DMA_STREAM3);
+}
+
+void __irq_dma1_channel5(void) {
+    dispatch_handler(DMA1, DMA_STREAM4);
+}
+
+void __irq_dma1_channel6(void) {
+    dispatch_handler(DMA1, DMA_STREAM5);
+}
+
+void __irq_dma1_channel7(void) {
+    dispatch_handler(DMA1, DMA_STREAM6);
+}
+
+void __irq_adc3(void) {
+    dispatch_handler(DMA1, DMA_STREAM7);
+}
+
+void __irq_dma2_channel1(void) {
+    dispatch_handler(DMA2, DMA_STREAM0);
+}
+
+void __irq_dma2_channel2(void) {
+    dispatch_handler(DMA2, DMA_STREAM1);
+}
+
+void __irq_dma2_channel3(void) {
+    dispatch_handler(DMA2, DMA_STREAM2);
+}
+
+void __irq_dma2_channel4_5(void) {
+    dispatch_handler(DMA2, DMA_STREAM3);
+}
+
+static void dma2_stream4_handler(void) {
+    dispatch_handler(DMA2, DMA_STREAM4);
+}
+
+static void dma2_stream5_handler(void) {
+    dispatch_handler(DMA2, DMA_STREAM5);
+}
+
+static void dma2_stream6_handler(void) {
+    dispatch_handler(DMA2, DMA_STREAM6);
+}
+
+static void dma2_stream7_handler(void) {
+    dispatch_handler(DMA2, DMA_STREAM7);
+}
@@ -0,0 +1,350 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file dmaF2.h
+ * @brief Direct Memory Access peripheral support, STM32F2/F4 streams.
+ *
+ * The F2/F4 DMA controllers have eight streams each instead of the
+ * F1's channels.  Each stream picks one of eight request channels,
+ * has a FIFO, and can alternate between two memory buffers (double
+ * buffer mode).  The functions mirror dmaF1.h's, with the stream
+ * taking the place of the channel, plus the request channel in
+ * dma_setup_transfer().
+ */
+
+#ifndef _DMA_H_
+#define _DMA_H_
+
+#include "libmaple_types.h"
+#include "rcc.h"
+#include "nvic.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*
+ * Register maps
+ */
+
+/** DMA stream register map type. */
+typedef struct dma_stream_reg_map {
+    __io uint32 CR;             /**< Stream configuration register */
+    __io uint32 NDTR;           /**< Stream number of data register */
+    __io uint32 PAR;            /**< Stream peripheral address register */
+    __io uint32 M0AR;           /**< Stream memory 0 address register */
+    __io uint32 M1AR;           /**< Stream memory 1 address register */
+    __io uint32 FCR;            /**< Stream FIFO control register */
+} dma_stream_reg_map;
+
+/** DMA register map type. */
+typedef struct dma_reg_map {
+    __io uint32 LISR;           /**< Low interrupt status register */
+    __io uint32 HISR;           /**< High interrupt status register */
+    __io uint32 LIFCR;          /**< Low interrupt flag clear register */
+    __io uint32 HIFCR;          /**< High interrupt flag clear register */
+    dma_stream_reg_map STREAM[8]; /**< Streams 0 to 7 */
+} dma_reg_map;
+
+/** DMA controller 1 register map base pointer */
+#define DMA1_BASE                       ((struct dma_reg_map*)0x40026000)
+/** DMA controller 2 register map base pointer */
+#define DMA2_BASE                       ((struct dma_reg_map*)0x40026400)
+
+/*
+ * Register bit definitions
+ */
+
+/* Interrupt status registers, per stream, right aligned */
+
+#define DMA_ISR_TCIF_BIT                5
+#define DMA_ISR_HTIF_BIT                4
+#define DMA_ISR_TEIF_BIT                3
+#define DMA_ISR_DMEIF_BIT               2
+#define DMA_ISR_FEIF_BIT                0
+
+#define DMA_ISR_TCIF                    BIT(DMA_ISR_TCIF_BIT)
+#define DMA_ISR_HTIF                    BIT(DMA_ISR_HTIF_BIT)
+#define DMA_ISR_TEIF                    BIT(DMA_ISR_TEIF_BIT)
+#define DMA_ISR_DMEIF                   BIT(DMA_ISR_DMEIF_BIT)
+#define DMA_ISR_FEIF                    BIT(DMA_ISR_FEIF_BIT)
+#define DMA_ISR_ALL                     0x3D
+
+/* Stream configuration register */
+
+#define DMA_SCR_CT_BIT                  19
+#define DMA_SCR_DBM_BIT                 18
+#define DMA_SCR_PINCOS_BIT              15
+#define DMA_SCR_MINC_BIT                10
+#define DMA_SCR_PINC_BIT                9
+#define DMA_SCR_CIRC_BIT                8
+#define DMA_SCR_PFCTRL_BIT              5
+#define DMA_SCR_TCIE_BIT                4
+#define DMA_SCR_HTIE_BIT                3
+#define DMA_SCR_TEIE_BIT                2
+#define DMA_SCR_DMEIE_BIT               1
+#define DMA_SCR_EN_BIT                  0
+
+#define DMA_SCR_CHSEL                   (0x7 << 25)
+#define DMA_SCR_MBURST                  (0x3 << 23)
+#define DMA_SCR_PBURST                  (0x3 << 21)
+#define DMA_SCR_CT                      BIT(DMA_SCR_CT_BIT)
+#define DMA_SCR_DBM                     BIT(DMA_SCR_DBM_BIT)
+#define DMA_SCR_PL                      (0x3 << 16)
+#define DMA_SCR_PL_LOW                  (0x0 << 16)
+#define DMA_SCR_PL_MEDIUM               (0x1 << 16)
+#define DMA_SCR_PL_HIGH                 (0x2 << 16)
+#define DMA_SCR_PL_VERY_HIGH            (0x3 << 16)
+#define DMA_SCR_PINCOS                  BIT(DMA_SCR_PINCOS_BIT)
+#define DMA_SCR_MSIZE                   (0x3 << 13)
+#define DMA_SCR_PSIZE                   (0x3 << 11)
+#define DMA_SCR_MINC                    BIT(DMA_SCR_MINC_BIT)
+#define DMA_SCR_PINC                    BIT(DMA_SCR_PINC_BIT)
+#define DMA_SCR_CIRC                    BIT(DMA_SCR_CIRC_BIT)
+#define DMA_SCR_DIR                     (0x3 << 6)
+#define DMA_SCR_DIR_PER_TO_MEM          (0x0 << 6)
+#define DMA_SCR_DIR_MEM_TO_PER          (0x1 << 6)
+#define DMA_SCR_DIR_MEM_TO_MEM          (0x2 << 6)
+#define DMA_SCR_PFCTRL                  BIT(DMA_SCR_PFCTRL_BIT)
+#define DMA_SCR_TCIE                    BIT(DMA_SCR_TCIE_BIT)
+#define DMA_SCR_HTIE                    BIT(DMA_SCR_HTIE_BIT)
+#define DMA_SCR_TEIE                    BIT(DMA_SCR_TEIE_BIT)
+#define DMA_SCR_DMEIE                   BIT(DMA_SCR_DMEIE_BIT)
+#define DMA_SCR_EN                      BIT(DMA_SCR_EN_BIT)
+
+/* Stream FIFO control register */
+
+#define DMA_SFCR_FEIE_BIT               7
+#define DMA_SFCR_DMDIS_BIT              2
+
+#define DMA_SFCR_FEIE                   BIT(DMA_SFCR_FEIE_BIT)
+#define DMA_SFCR_FS                     (0x7 << 3)
+#define DMA_SFCR_DMDIS                  BIT(DMA_SFCR_DMDIS_BIT)
+#define DMA_SFCR_FTH                    0x3
+#define DMA_SFCR_FTH_1_4                0x0
+#define DMA_SFCR_FTH_1_2                0x1
+#define DMA_SFCR_FTH_3_4                0x2
+#define DMA_SFCR_FTH_FULL               0x3
+
+/*
+ * Devices
+ */
+
+/** Encapsulates state related to a DMA stream interrupt. */
+typedef struct dma_handler_config {
+    void (*handler)(void);      /**< User-specified stream interrupt
+                                     handler */
+    nvic_irq_num irq_line;      /**< Stream's NVIC interrupt number */
+} dma_handler_config;
+
+/** DMA device type */
+typedef struct dma_dev {
+    dma_reg_map *regs;             /**< Register map */
+    rcc_clk_id clk_id;             /**< Clock ID */
+    dma_handler_config handlers[8]; /**< IRQ handlers and NVIC numbers,
+                                         by stream */
+} dma_dev;
+
+extern dma_dev* const DMA1;
+extern dma_dev* const DMA2;
+
+/*
+ * Convenience functions
+ */
+
+void dma_init(dma_dev *dev);
+
+/** Flags for DMA transfer configuration. */
+typedef enum dma_mode_flags {
+    DMA_DBL_BUF_MODE = DMA_SCR_DBM,   /**< Alternate between M0AR and M1AR */
+    DMA_MINC_MODE  = DMA_SCR_MINC,    /**< Auto-increment memory address */
+    DMA_PINC_MODE  = DMA_SCR_PINC,    /**< Auto-increment peripheral address */
+    DMA_CIRC_MODE  = DMA_SCR_CIRC,    /**< Circular mode */
+    DMA_MEM_2_MEM  = DMA_SCR_DIR_MEM_TO_MEM, /**< Memory to memory mode */
+    DMA_FROM_MEM   = DMA_SCR_DIR_MEM_TO_PER, /**< Read from memory to
+                                                  peripheral */
+    DMA_TRNS_CMPLT = DMA_SCR_TCIE,    /**< Interrupt on transfer completion */
+    DMA_HALF_TRNS  = DMA_SCR_HTIE,    /**< Interrupt on half-transfer */
+    DMA_TRNS_ERR   = DMA_SCR_TEIE,    /**< Interrupt on transfer error */
+} dma_mode_flags;
+
+/** Source and destination transfer sizes. */
+typedef enum dma_xfer_size {
+    DMA_SIZE_8BITS  = 0,        /**< 8-bit transfers */
+    DMA_SIZE_16BITS = 1,        /**< 16-bit transfers */
+    DMA_SIZE_32BITS = 2         /**< 32-bit transfers */
+} dma_xfer_size;
+
+/** DMA stream */
+typedef enum dma_stream {
+    DMA_STREAM0 = 0,            /**< Stream 0 */
+    DMA_STREAM1 = 1,            /**< Stream 1 */
+    DMA_STREAM2 = 2,            /**< Stream 2 */
+    DMA_STREAM3 = 3,            /**< Stream 3 */
+    DMA_STREAM4 = 4,            /**< Stream 4 */
+    DMA_STREAM5 = 5,            /**< Stream 5 */
+    DMA_STREAM6 = 6,            /**< Stream 6 */
+    DMA_STREAM7 = 7,            /**< Stream 7 */
+} dma_stream;
+
+/** DMA request channel a stream serves, see the reference manual's
+ * request mapping tables. */
+typedef enum dma_channel {
+    DMA_CH0 = 0,                /**< Channel 0 */
+    DMA_CH1 = 1,                /**< Channel 1 */
+    DMA_CH2 = 2,                /**< Channel 2 */
+    DMA_CH3 = 3,                /**< Channel 3 */
+    DMA_CH4 = 4,                /**< Channel 4 */
+    DMA_CH5 = 5,                /**< Channel 5 */
+    DMA_CH6 = 6,                /**< Channel 6 */
+    DMA_CH7 = 7,                /**< Channel 7 */
+} dma_channel;
+
+void dma_setup_transfer(dma_dev       *dev,
+                        dma_stream     stream,
+                        dma_channel    channel,
+                        __io void     *peripheral_address,
+                        dma_xfer_size  peripheral_size,
+                        __io void     *memory_address,
+                        dma_xfer_size  memory_size,
+                        uint32         mode);
+
+void dma_set_num_transfers(dma_dev *dev,
+                           dma_stream stream,
+                           uint16 num_transfers);
+
+/** DMA transfer priority. */
+typedef enum dma_priority {
+    DMA_PRIORITY_LOW       = DMA_SCR_PL_LOW,      /**< Low priority */
+    DMA_PRIORITY_MEDIUM    = DMA_SCR_PL_MEDIUM,   /**< Medium priority */
+    DMA_PRIORITY_HIGH      = DMA_SCR_PL_HIGH,     /**< High priority */
+    DMA_PRIORITY_VERY_HIGH = DMA_SCR_PL_VERY_HIGH /**< Very high priority */
+} dma_priority;
+
+void dma_set_priority(dma_dev *dev,
+                      dma_stream stream,
+                      dma_priority priority);
+
+void dma_set_fifo(dma_dev *dev, dma_stream stream, uint32 fcr);
+
+void dma_attach_interrupt(dma_dev *dev,
+                          dma_stream stream,
+                          void (*handler)(void));
+void dma_detach_interrupt(dma_dev *dev, dma_stream stream);
+
+/**
+ * Encodes the reason why a DMA interrupt was called.
+ * @see dma_get_irq_cause()
+ */
+typedef enum dma_irq_cause {
+    DMA_TRANSFER_COMPLETE,      /**< Transfer is complete. */
+    DMA_TRANSFER_HALF_COMPLETE, /**< Transfer is half complete. */
+    DMA_TRANSFER_ERROR,         /**< Error occurred during transfer. */
+    DMA_TRANSFER_DME_ERROR,     /**< Direct mode error. */
+    DMA_TRANSFER_FIFO_ERROR,    /**< FIFO error. */
+} dma_irq_cause;
+
+dma_irq_cause dma_get_irq_cause(dma_dev *dev, dma_stream stream);
+
+void dma_enable(dma_dev *dev, dma_stream stream);
+void dma_disable(dma_dev *dev, dma_stream stream);
+
+void dma_set_mem_addr(dma_dev *dev, dma_stream stream, __io void *address);
+void dma_set_mem1_addr(dma_dev *dev, dma_stream stream, __io void *address);
+void dma_set_per_addr(dma_dev *dev, dma_stream stream, __io void *address);
+
+/**
+ * @brief Obtain a pointer to an individual DMA stream's registers.
+ * @param dev DMA device
+ * @param stream DMA stream whose register map to obtain.
+ */
+static inline dma_stream_reg_map* dma_stream_regs(dma_dev *dev,
+                                                  dma_stream stream) {
+    return &dev->regs->STREAM[stream];
+}
+
+/**
+ * @brief Check if a DMA stream is enabled
+ * @param dev DMA device
+ * @param stream Stream whose enabled bit to check.
+ */
+static inline uint8 dma_is_stream_enabled(dma_dev *dev, dma_stream stream) {
+    return (uint8)(dma_stream_regs(dev, stream)->CR & DMA_SCR_EN);
+}
+
+/* Offset of a stream's flags within LISR/HISR and LIFCR/HIFCR */
+static inline uint32 dma_isr_shift(dma_stream stream) {
+    return 16 * ((stream >> 1) & 1) + 6 * (stream & 1);
+}
+
+/**
+ * @brief Get the ISR status bits for a DMA stream.
+ *
+ * The bits are returned right-aligned: DMA_ISR_TCIF, DMA_ISR_HTIF,
+ * DMA_ISR_TEIF, DMA_ISR_DMEIF and DMA_ISR_FEIF.
+ *
+ * @param dev DMA device
+ * @param stream Stream whose ISR bits to return.
+ * @see dma_get_irq_cause().
+ */
+static inline uint8 dma_get_isr_bits(dma_dev *dev, dma_stream stream) {
+    __io uint32 *isr = stream < 4 ? &dev->regs->LISR : &dev->regs->HISR;
+    return (*isr >> dma_isr_shift(stream)) & DMA_ISR_ALL;
+}
+
+/**
+ * @brief Clear the ISR status bits for a given DMA stream.
+ * @param dev DMA device
+ * @param stream Stream whose ISR bits to clear.
+ * @param bits Bits to clear, as returned by dma_get_isr_bits().
+ */
+static inline void dma_clear_isr_bits(dma_dev *dev, dma_stream stream,
+                                      uint8 bits) {
+    __io uint32 *ifcr = stream < 4 ? &dev->regs->LIFCR : &dev->regs->HIFCR;
+    *ifcr = (uint32)bits << dma_isr_shift(stream);
+}
+
+/**
+ * @brief Transfers left before the stream's current buffer is done.
+ */
+static inline uint16 dma_get_count(dma_dev *dev, dma_stream stream) {
+    return (uint16)dma_stream_regs(dev, stream)->NDTR;
+}
+
+/**
+ * @brief In double buffer mode, the buffer the stream is filling.
+ * @return 0 for M0AR, 1 for M1AR.
+ */
+static inline uint8 dma_get_current_target(dma_dev *dev, dma_stream stream) {
+    return (dma_stream_regs(dev, stream)->CR & DMA_SCR_CT) ? 1 : 0;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
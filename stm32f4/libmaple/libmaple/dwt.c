@@ -0,0 +1,66 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file dwt.c
+ * @brief 64-bit cycle count on top of the 32-bit DWT counter
+ */
+
+#include "dwt.h"
+
+#ifndef LIBMAPLE_QEMU
+
+static volatile uint32 dwt_high;
+static volatile uint32 dwt_last;
+
+/**
+ * @brief Core clock cycles as a 64-bit count.
+ *
+ * The high word is advanced whenever the counter is seen to have
+ * wrapped since the previous call, so this must run at least once per
+ * 2^32 cycles (25 s at 168 MHz); the SysTick handler takes care of
+ * that. Safe to call from interrupt handlers.
+ */
+uint64 dwt_cycles64(void) {
+    uint32 primask;
+    uint32 now;
+    uint32 high;
+
+    asm volatile("mrs %0, primask \n\t"
+                 "cpsid i"
+                 : "=r" (primask) : : "memory");
+    now = DWT_BASE->CYCCNT;
+    if (now < dwt_last) {
+        dwt_high++;
+    }
+    dwt_last = now;
+    high = dwt_high;
+    asm volatile("msr primask, %0" : : "r" (primask) : "memory");
+
+    return ((uint64)high << 32) | now;
+}
+
+#endif
@@ -0,0 +1,180 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file dwt.h
+ *
+ * @brief Data watchpoint and trace unit: the free running core cycle
+ * counter (CYCCNT), extended to 64 bits in software.
+ */
+
+#ifndef _DWT_H_
+#define _DWT_H_
+
+#include "libmaple_types.h"
+#include "util.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** DWT register map type (cycle counter part) */
+typedef struct dwt_reg_map {
+    __io uint32 CTRL;           /**< Control register */
+    __io uint32 CYCCNT;         /**< Cycle count register */
+    __io uint32 CPICNT;         /**< CPI count register */
+    __io uint32 EXCCNT;         /**< Exception overhead count register */
+    __io uint32 SLEEPCNT;       /**< Sleep count register */
+    __io uint32 LSUCNT;         /**< LSU count register */
+    __io uint32 FOLDCNT;        /**< Folded instruction count register */
+    __io uint32 PCSR;           /**< Program counter sample register */
+} dwt_reg_map;
+
+/** DWT register map base pointer */
+#define DWT_BASE                        ((struct dwt_reg_map*)0xE0001000)
+
+/** Debug exception and monitor control register */
+#define DWT_DEMCR                       (*(__io uint32*)0xE000EDFC)
+
+/*
+ * Register bit definitions.
+ */
+
+#define DWT_CTRL_CYCCNTENA              BIT(0)
+#define DWT_DEMCR_TRCENA                BIT(24)
+
+#ifdef LIBMAPLE_QEMU
+
+/*
+ * QEMU models no DWT.  QEMU builds count core cycles with SysTick
+ * instead, which the emulator clocks at the core clock; with -icount
+ * that makes the counts a fixed multiple of instructions executed.
+ */
+
+#include "systick.h"
+#include "scb.h"
+
+static inline void dwt_cyccnt_enable(void) {
+}
+
+static inline int dwt_cyccnt_enabled(void) {
+    return SYSTICK_BASE->CSR & SYSTICK_CSR_ENABLE;
+}
+
+static inline uint64 dwt_cycles64(void) {
+    uint32 ms, cnt, reload = SYSTICK_BASE->RVR;
+    do {
+        ms = systick_uptime();
+        cnt = SYSTICK_BASE->CNT;
+    } while (ms != systick_uptime());
+    /* wrapped, but the tick handler has not run yet */
+    if ((SCB_BASE->ICSR & SCB_ICSR_PENDSTSET) && cnt > reload / 2) {
+        ms++;
+    }
+    return (uint64)ms * (reload + 1) + (reload - cnt);
+}
+
+static inline uint32 dwt_cycles(void) {
+    return (uint32)dwt_cycles64();
+}
+
+static inline void dwt_delay_cycles(uint32 cycles) {
+    uint32 start = dwt_cycles();
+    while (dwt_cycles() - start < cycles)
+        ;
+}
+
+#else
+
+/**
+ * @brief Start the cycle counter, leaving its value alone if it is
+ *        already running (e.g. started by the bootloader).
+ */
+static inline void dwt_cyccnt_enable(void) {
+    DWT_DEMCR |= DWT_DEMCR_TRCENA;
+    DWT_BASE->CTRL |= DWT_CTRL_CYCCNTENA;
+}
+
+/**
+ * @brief Check whether the cycle counter is counting.
+ */
+static inline int dwt_cyccnt_enabled(void) {
+    return (DWT_DEMCR & DWT_DEMCR_TRCENA) &&
+        (DWT_BASE->CTRL & DWT_CTRL_CYCCNTENA);
+}
+
+/**
+ * @brief Core clock cycles counted so far; wraps every 2^32 cycles.
+ */
+static inline uint32 dwt_cycles(void) {
+    return DWT_BASE->CYCCNT;
+}
+
+uint64 dwt_cycles64(void);
+
+/**
+ * @brief Busy-wait for at least the given number of core cycles.
+ *
+ * Exact to within a few cycles regardless of flash wait states;
+ * interrupts can only make it longer. The cycle counter must be
+ * running (init() starts it).
+ *
+ * @param cycles Cycles to wait, less than 2^32.
+ */
+static inline void dwt_delay_cycles(uint32 cycles) {
+    uint32 start = DWT_BASE->CYCCNT;
+    while (DWT_BASE->CYCCNT - start < cycles)
+        ;
+}
+
+#endif
+
+/**
+ * @brief Divide a 64-bit cycle count by a small divisor without a
+ *        64-bit library division.
+ *
+ * Three hardware 32-bit divides, for turning cycles into
+ * microseconds or nanoseconds.
+ *
+ * @param n Dividend.
+ * @param d Divisor, less than 65536 (e.g. cycles per microsecond).
+ */
+static inline uint64 dwt_div_small(uint64 n, uint32 d) {
+    uint32 hi = (uint32)(n >> 32);
+    uint32 lo = (uint32)n;
+    uint32 qh = hi / d;
+    uint32 t = ((hi % d) << 16) | (lo >> 16);
+    uint32 q1 = t / d;
+
+    t = ((t % d) << 16) | (lo & 0xFFFF);
+    return ((uint64)qh << 32) | (q1 << 16) | (t / d);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
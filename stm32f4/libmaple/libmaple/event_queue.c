@@ -0,0 +1,129 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file event_queue.c
+ * @brief Lock-free event queue from interrupt handlers to the main loop.
+ */
+
+#include "event_queue.h"
+
+#if (EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) != 0
+#error "EVENT_QUEUE_SIZE must be a power of two"
+#endif
+
+#define MASK (EVENT_QUEUE_SIZE - 1)
+
+/**
+ * @brief Empty a queue.
+ *
+ * Nothing may post to or take from the queue while it is being
+ * initialised.
+ */
+void event_queue_init(event_queue *q) {
+    uint32 i;
+
+    for (i = 0; i < EVENT_QUEUE_SIZE; i++) {
+        q->cells[i].seq = i;
+    }
+    q->head = 0;
+    q->tail = 0;
+    q->dropped = 0;
+    q->high_water = 0;
+}
+
+/**
+ * @brief Post an event.
+ *
+ * Safe from any interrupt handler and from thread mode, concurrently.
+ *
+ * @param q       Queue to post to
+ * @param handler Function the consumer will call
+ * @param arg     First argument for handler
+ * @param data    Second argument for handler
+ * @param stamp   Time of posting, handed back by event_queue_take()
+ * @return 0 on success, -1 if the queue was full.
+ */
+int event_queue_post(event_queue *q, event_handler handler, void *arg,
+                     uint32 data, uint32 stamp) {
+    event_queue_cell *cell;
+    uint32 pos = q->head;
+    uint32 depth;
+
+    for (;;) {
+        int32 diff;
+
+        cell = &q->cells[pos & MASK];
+        diff = (int32)(cell->seq - pos);
+        if (diff == 0) {
+            if (__sync_bool_compare_and_swap(&q->head, pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* The cell still holds last lap's event */
+            __sync_fetch_and_add(&q->dropped, 1);
+            return -1;
+        }
+        pos = q->head;
+    }
+
+    cell->ev.handler = handler;
+    cell->ev.arg = arg;
+    cell->ev.data = data;
+    cell->ev.stamp = stamp;
+    __sync_synchronize();
+    cell->seq = pos + 1;
+
+    /* Statistics only; a racing post may leave it one short. */
+    depth = pos + 1 - q->tail;
+    if (depth > q->high_water) {
+        q->high_water = depth;
+    }
+    return 0;
+}
+
+/**
+ * @brief Take the oldest ready event.
+ *
+ * Only one context may take from a queue.
+ *
+ * @param q  Queue to take from
+ * @param ev Filled in with the event
+ * @return 1 if an event was taken, 0 if none was ready.
+ */
+int event_queue_take(event_queue *q, event *ev) {
+    uint32 pos = q->tail;
+    event_queue_cell *cell = &q->cells[pos & MASK];
+
+    if (cell->seq != pos + 1) {
+        return 0;
+    }
+    *ev = cell->ev;
+    __sync_synchronize();
+    cell->seq = pos + EVENT_QUEUE_SIZE;
+    q->tail = pos + 1;
+    return 1;
+}
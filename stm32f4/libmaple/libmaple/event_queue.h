@@ -0,0 +1,116 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file event_queue.h
+ * @brief Lock-free event queue from interrupt handlers to the main loop.
+ *
+ * A bounded multi-producer, single-consumer queue of (handler, arg,
+ * data) events.  Any interrupt handler, at any priority, may post;
+ * only one context (normally the main loop, through wirish's
+ * EventLoop) takes events out and calls their handlers.  Posting
+ * claims a cell with a compare-and-swap (LDREX/STREX) on the write
+ * index, so a higher-priority handler that interrupts a post in
+ * progress simply claims the next cell; nothing disables interrupts.
+ *
+ * Each cell carries a sequence number saying whether it is free for
+ * the producer of a given lap, or full for the consumer, after
+ * Dmitry Vyukov's bounded MPMC queue with the consumer side
+ * simplified.  A post that finds the queue full fails and is
+ * counted in the queue's dropped counter.
+ *
+ * The queue does not read any clock.  The stamp passed to
+ * event_queue_post() is handed back with the event, for the consumer
+ * to measure posting-to-dispatch latency with.
+ */
+
+#ifndef _EVENT_QUEUE_H_
+#define _EVENT_QUEUE_H_
+
+#include "libmaple_types.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** Cells per queue; must be a power of two. */
+#ifndef EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE                32
+#endif
+
+/** Event handler; arg and data are as passed to event_queue_post(). */
+typedef void (*event_handler)(void *arg, uint32 data);
+
+/** An event taken from the queue. */
+typedef struct event {
+    event_handler handler;      /**< Function to call */
+    void *arg;                  /**< Its first argument */
+    uint32 data;                /**< Its second argument */
+    uint32 stamp;               /**< Time of posting, caller's units */
+} event;
+
+/** One queue cell. */
+typedef struct event_queue_cell {
+    volatile uint32 seq;        /**< Lap/state sequence number */
+    event ev;                   /**< Event stored in the cell */
+} event_queue_cell;
+
+/** Event queue. */
+typedef struct event_queue {
+    volatile uint32 head;       /**< Next cell to post into */
+    volatile uint32 tail;       /**< Next cell to take from */
+    volatile uint32 dropped;    /**< Posts refused, queue full */
+    volatile uint32 high_water; /**< Most events ever queued at once */
+    event_queue_cell cells[EVENT_QUEUE_SIZE];
+} event_queue;
+
+void event_queue_init(event_queue *q);
+int event_queue_post(event_queue *q, event_handler handler, void *arg,
+                     uint32 data, uint32 stamp);
+int event_queue_take(event_queue *q, event *ev);
+
+/**
+ * @brief Whether an event is ready to be taken.
+ *
+ * Only meaningful to the consumer.  An event whose post is still in
+ * progress, in an interrupt handler the consumer interrupted, is not
+ * ready yet.
+ */
+static inline int event_queue_ready(const event_queue *q) {
+    uint32 pos = q->tail;
+    return q->cells[pos & (EVENT_QUEUE_SIZE - 1)].seq == pos + 1;
+}
+
+/** @brief Number of events posted and not yet taken. */
+static inline uint32 event_queue_depth(const event_queue *q) {
+    return q->head - q->tail;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -170,6 +170,7 @@ void gpio_set_af_mode(gpio_dev *dev, uint8 pin, int mode) {
 void afio_init(void) {
     //rcc_clk_enable(RCC_AFIO);
     //rcc_reset_dev(RCC_AFIO);
+    rcc_clk_enable(RCC_SYSCFG);
 }
 
 #define AFIO_EXTI_SEL_MASK 0xF
@@ -183,7 +184,7 @@ void afio_init(void) {
  * @see afio_exti_port
  */
 void afio_exti_select(afio_exti_num exti, afio_exti_port gpio_port) {
-    __io uint32 *exti_cr = &AFIO_BASE->EXTICR1 + exti / 4;
+    __io uint32 *exti_cr = &SYSCFG_BASE->EXTICR[exti / 4];
     uint32 shift = 4 * (exti % 4);
     uint32 cr = *exti_cr;
 
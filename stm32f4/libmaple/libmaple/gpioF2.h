@@ -207,6 +207,33 @@ static inline afio_exti_port gpio_exti_port(gpio_dev *dev) {
     return dev->exti_port;
 }
 
+/*
+ * Register-level variants of the three functions below.  With a
+ * constant register map (GPIOA_BASE, ...) each is a single access to
+ * a fixed address.
+ */
+
+/** @brief gpio_write_bit(), given the port's register map. */
+static inline void gpio_regs_write_bit(gpio_reg_map *regs,
+                                       uint8 pin,
+                                       uint8 val) {
+    if (val) {
+        regs->BSRRL = BIT(pin);
+    } else {
+        regs->BSRRH = BIT(pin);
+    }
+}
+
+/** @brief gpio_read_bit(), given the port's register map. */
+static inline uint32 gpio_regs_read_bit(gpio_reg_map *regs, uint8 pin) {
+    return regs->IDR & BIT(pin);
+}
+
+/** @brief gpio_toggle_bit(), given the port's register map. */
+static inline void gpio_regs_toggle_bit(gpio_reg_map *regs, uint8 pin) {
+    regs->ODR = regs->ODR ^ BIT(pin);
+}
+
 /**
  * Set or reset a GPIO pin.
  *
@@ -217,11 +244,7 @@ static inline afio_exti_port gpio_exti_port(gpio_dev *dev) {
  * @param val If true, set the pin.  If false, reset the pin.
  */
 static inline void gpio_write_bit(gpio_dev *dev, uint8 pin, uint8 val) {
-    if (val) {
-        dev->regs->BSRRL = BIT(pin);
-    } else {
-        dev->regs->BSRRH = BIT(pin);
-    }
+    gpio_regs_write_bit(dev->regs, pin, val);
 }
 
 /**
@@ -234,7 +257,7 @@ static inline void gpio_write_bit(gpio_dev *dev, uint8 pin, uint8 val) {
  * @return True if the pin is set, false otherwise.
  */
 static inline uint32 gpio_read_bit(gpio_dev *dev, uint8 pin) {
-    return dev->regs->IDR & BIT(pin);
+    return gpio_regs_read_bit(dev->regs, pin);
 }
 
 /**
@@ -243,7 +266,7 @@ static inline uint32 gpio_read_bit(gpio_dev *dev, uint8 pin) {
  * @param pin Pin on dev to toggle.
  */
 static inline void gpio_toggle_bit(gpio_dev *dev, uint8 pin) {
-    dev->regs->ODR = dev->regs->ODR ^ BIT(pin);
+    gpio_regs_toggle_bit(dev->regs, pin);
 }
 
 /*
@@ -270,6 +293,23 @@ typedef struct afio_reg_map {
 /** AFIO register map base pointer. */
 #define AFIO_BASE                       ((struct afio_reg_map *)0x40010000)
 
+/**
+ * SYSCFG register map.  On the F2/F4 this, not AFIO, selects the GPIO
+ * port of each external interrupt line.
+ */
+typedef struct syscfg_reg_map {
+    __io uint32 MEMRMP;         /**< Memory remap register. */
+    __io uint32 PMC;            /**< Peripheral mode configuration
+                                   register. */
+    __io uint32 EXTICR[4];      /**< External interrupt configuration
+                                   registers 1 to 4. */
+    const uint32 RESERVED[2];   /**< Reserved */
+    __io uint32 CMPCR;          /**< Compensation cell control register. */
+} syscfg_reg_map;
+
+/** SYSCFG register map base pointer. */
+#define SYSCFG_BASE                     ((struct syscfg_reg_map *)0x40013800)
+
 /*
  * AFIO register bit definitions
  */
@@ -309,6 +309,33 @@ void gpio_init(gpio_dev *dev);
 void gpio_init_all(void);
 void gpio_set_mode(gpio_dev *dev, uint8 pin, gpio_pin_mode mode);
 
+/*
+ * Register-level variants of the three functions below.  With a
+ * constant register map (GPIOA_BASE, ...) each is a single access to
+ * a fixed address.
+ */
+
+/** @brief gpio_write_bit(), given the port's register map. */
+static inline void gpio_regs_write_bit(gpio_reg_map *regs,
+                                       uint8 pin,
+                                       uint8 val) {
+    if (val) {
+        regs->BSRR = BIT(pin);
+    } else {
+        regs->BSRR = BIT(pin) << 16;
+    }
+}
+
+/** @brief gpio_read_bit(), given the port's register map. */
+static inline uint32 gpio_regs_read_bit(gpio_reg_map *regs, uint8 pin) {
+    return regs->IDR & BIT(pin);
+}
+
+/** @brief gpio_toggle_bit(), given the port's register map. */
+static inline void gpio_regs_toggle_bit(gpio_reg_map *regs, uint8 pin) {
+    regs->ODR = regs->ODR ^ BIT(pin);
+}
+
 /**
  * Set or reset a GPIO pin.
  *
@@ -319,11 +346,7 @@ void gpio_set_mode(gpio_dev *dev, uint8 pin, gpio_pin_mode mode);
  * @param val If true, set the pin.  If false, reset the pin.
  */
 static inline void gpio_write_bit(gpio_dev *dev, uint8 pin, uint8 val) {
-    if (val) {
-        dev->regs->BSRR = BIT(pin);
-    } else {
-        dev->regs->BSRR = pin << (16+pin);
-    }
+    gpio_regs_write_bit(dev->regs, pin, val);
 }
 
 /**
@@ -336,7 +359,7 @@ static inline void gpio_write_bit(gpio_dev *dev, uint8 pin, uint8 val) {
  * @return True if the pin is set, false otherwise.
  */
 static inline uint32 gpio_read_bit(gpio_dev *dev, uint8 pin) {
-    return dev->regs->IDR & BIT(pin);
+    return gpio_regs_read_bit(dev->regs, pin);
 }
 
 /**
@@ -345,7 +368,7 @@ static inline uint32 gpio_read_bit(gpio_dev *dev, uint8 pin) {
  * @param pin Pin on dev to toggle.
  */
 static inline void gpio_toggle_bit(gpio_dev *dev, uint8 pin) {
-    dev->regs->ODR = dev->regs->ODR ^ BIT(pin);
+    gpio_regs_toggle_bit(dev->regs, pin);
 }
 
 #ifdef __cplusplus
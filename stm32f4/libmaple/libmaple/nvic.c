@@ -83,3 +83,116 @@ void nvic_init(uint32 vector_table_address, uint32 offset) {
 void nvic_set_vector_table(uint32 addr, uint32 offset) {
     SCB_BASE->VTOR = addr | (offset & 0x1FFFFF80);
 }
+
+/*
+ * RAM vector table.  VTOR needs the table aligned to the next power
+ * of two above its size; 512 bytes covers every supported part.
+ */
+
+static nvic_handler nvic_ram_vectors[NVIC_NR_VECTORS]
+    __attribute__((aligned(512)));
+static const nvic_handler *nvic_rom_vectors;
+static uint32 nvic_rom_nr_vectors;
+
+/*
+ * The linked table, from libcs3/libcs4 via common.inc.  libcs3's stops
+ * at the F1's last interrupt, short of NVIC_NR_VECTORS on the F2.
+ */
+extern const nvic_handler __cs3_stm32_vector_table[];
+extern const char __stm32_vector_table_end[];
+extern void __default_handler(void);
+
+static uint32 nvic_linked_nr_vectors(void) {
+    uint32 nr = ((uint32)__stm32_vector_table_end -
+                 (uint32)__cs3_stm32_vector_table) / sizeof(nvic_handler);
+    return nr < NVIC_NR_VECTORS ? nr : NVIC_NR_VECTORS;
+}
+
+/**
+ * @brief Move the vector table into RAM.
+ *
+ * Copies the active table (wherever VTOR points) into RAM and points
+ * VTOR at the copy.  Only as many vectors as the linked table has are
+ * copied; the slots past it get __default_handler.  Calling it again
+ * does nothing.
+ * nvic_install_handler() calls it for you.
+ */
+void nvic_vector_table_to_ram(void) {
+    const nvic_handler *active = (const nvic_handler*)SCB_BASE->VTOR;
+    uint32 nr = nvic_linked_nr_vectors();
+    uint32 primask;
+    uint32 i;
+
+    if (active == nvic_ram_vectors) {
+        return;
+    }
+
+    asm volatile("mrs %0, primask \n\t"
+                 "cpsid i"
+                 : "=r" (primask) : : "memory");
+    for (i = 0; i < nr; i++) {
+        nvic_ram_vectors[i] = active[i];
+    }
+    for (; i < NVIC_NR_VECTORS; i++) {
+        nvic_ram_vectors[i] = __default_handler;
+    }
+    nvic_rom_vectors = active;
+    nvic_rom_nr_vectors = nr;
+    SCB_BASE->VTOR = (uint32)nvic_ram_vectors;
+    asm volatile("dsb \n\t"
+                 "msr primask, %0" : : "r" (primask) : "memory");
+}
+
+/**
+ * @brief Point an interrupt or exception straight at a handler.
+ *
+ * handler replaces libmaple's own handler for irqn (its __irq_* or
+ * __exc_* function) in the vector table, so it is entered directly
+ * by the hardware, skipping the dispatch through exti_attach_interrupt(),
+ * timer_attach_interrupt(), dma_attach_interrupt() and friends and
+ * their handler tables.  That also means it must do what the
+ * dispatcher would have: clear the peripheral's interrupt flags, for
+ * a start.
+ *
+ * The vector table is moved to RAM on first use.  Any other handling
+ * already attached for irqn is bypassed until nvic_remove_handler().
+ *
+ * @param irqn Interrupt or exception to handle.
+ * @param handler Function to call for it.
+ * @see nvic_remove_handler()
+ */
+void nvic_install_handler(nvic_irq_num irqn, nvic_handler handler) {
+    nvic_vector_table_to_ram();
+    nvic_ram_vectors[16 + irqn] = handler;
+    asm volatile("dsb" : : : "memory");
+}
+
+/**
+ * @brief Give an interrupt or exception back to libmaple's handler.
+ * @param irqn Interrupt or exception previously passed to
+ *             nvic_install_handler().
+ */
+void nvic_remove_handler(nvic_irq_num irqn) {
+    if (nvic_rom_vectors == 0) {
+        return;
+    }
+    if ((uint32)(16 + irqn) < nvic_rom_nr_vectors) {
+        nvic_ram_vectors[16 + irqn] = nvic_rom_vectors[16 + irqn];
+    } else {
+        nvic_ram_vectors[16 + irqn] = __default_handler;
+    }
+    asm volatile("dsb" : : : "memory");
+}
+
+/**
+ * @brief Handler the hardware will call for an interrupt or exception.
+ */
+nvic_handler nvic_get_handler(nvic_irq_num irqn) {
+    const nvic_handler *active = (const nvic_handler*)SCB_BASE->VTOR;
+
+    if (active != nvic_ram_vectors &&
+        (uint32)(16 + irqn) >= nvic_linked_nr_vectors()) {
+        return __default_handler;
+    }
+    return active[16 + irqn];
+}
@@ -48,6 +48,7 @@
 
 #include "libmaple_types.h"
 #include "util.h"
+#include "stm32.h"
 
 #ifdef __cplusplus
 extern "C"{
@@ -159,6 +160,26 @@ typedef enum nvic_irq_num {
     NVIC_DMA2_CH3       = 58,   /**< DMA2 channel 3 */
     NVIC_DMA2_CH_4_5    = 59,   /**< DMA2 channels 4 and 5 */
 #endif
+#ifdef STM32F2
+    /* STM32F2/F4 DMA streams.  Streams that share a number with an
+     * F1 channel above also share its vector. */
+    NVIC_DMA1_STREAM0   = 11,   /**< DMA1 stream 0 */
+    NVIC_DMA1_STREAM1   = 12,   /**< DMA1 stream 1 */
+    NVIC_DMA1_STREAM2   = 13,   /**< DMA1 stream 2 */
+    NVIC_DMA1_STREAM3   = 14,   /**< DMA1 stream 3 */
+    NVIC_DMA1_STREAM4   = 15,   /**< DMA1 stream 4 */
+    NVIC_DMA1_STREAM5   = 16,   /**< DMA1 stream 5 */
+    NVIC_DMA1_STREAM6   = 17,   /**< DMA1 stream 6 */
+    NVIC_DMA1_STREAM7   = 47,   /**< DMA1 stream 7 */
+    NVIC_DMA2_STREAM0   = 56,   /**< DMA2 stream 0 */
+    NVIC_DMA2_STREAM1   = 57,   /**< DMA2 stream 1 */
+    NVIC_DMA2_STREAM2   = 58,   /**< DMA2 stream 2 */
+    NVIC_DMA2_STREAM3   = 59,   /**< DMA2 stream 3 */
+    NVIC_DMA2_STREAM4   = 60,   /**< DMA2 stream 4 */
+    NVIC_DMA2_STREAM5   = 68,   /**< DMA2 stream 5 */
+    NVIC_DMA2_STREAM6   = 69,   /**< DMA2 stream 6 */
+    NVIC_DMA2_STREAM7   = 70,   /**< DMA2 stream 7 */
+#endif
 } nvic_irq_num;
 
 #else	// STM32L1
@@ -242,6 +263,25 @@ void nvic_set_vector_table(uint32 address, uint32 offset);
 
 void nvic_irq_set_priority(nvic_irq_num irqn, uint8 priority);
 
+/*
+ * Direct handler installation
+ */
+
+/** Number of entries in the vector table, including the 16 for the core. */
+#ifdef STM32F2
+#define NVIC_NR_VECTORS                 (16 + 82)
+#else
+#define NVIC_NR_VECTORS                 (16 + STM32_NR_INTERRUPTS)
+#endif
+
+/** An interrupt or exception handler, as stored in the vector table. */
+typedef void (*nvic_handler)(void);
+
+void nvic_vector_table_to_ram(void);
+void nvic_install_handler(nvic_irq_num irqn, nvic_handler handler);
+void nvic_remove_handler(nvic_irq_num irqn);
+nvic_handler nvic_get_handler(nvic_irq_num irqn);
+
 /**
  * Enables interrupts and configurable fault handlers (clear PRIMASK).
  */
@@ -98,6 +98,7 @@ static const struct rcc_dev_info rcc_dev_table[] = {
     [RCC_TIMER12] = { .clk_domain = APB1, .line_num =  6 }, //unchanged
     [RCC_TIMER13] = { .clk_domain = APB1, .line_num =  7 }, //unchanged
     [RCC_TIMER14] = { .clk_domain = APB1, .line_num =  8 }, //unchanged
+    [RCC_SYSCFG]  = { .clk_domain = APB2, .line_num = 14 },
 };
 
 /**
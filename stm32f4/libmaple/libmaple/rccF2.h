@@ -498,6 +498,7 @@ typedef enum rcc_clk_id {
     RCC_TIMER12,
     RCC_TIMER13,
     RCC_TIMER14,
+    RCC_SYSCFG,
 } rcc_clk_id;
 
 void rcc_clk_init(rcc_sysclk_src sysclk_src,
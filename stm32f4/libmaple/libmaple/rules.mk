@@ -15,8 +15,15 @@ CFLAGS_$(d) = -I$(d) $(LIBMAPLE_INCLUDES) -Wall -Werror
 #              bkp.c                    
 
 cSRCS_$(d) := adc.c                    \
+              adc_inj.c                \
+              adc_multi.c              \
+              bitstream.c              \
+              boot_trace.c             \
               dac.c                    \
+              decimate.c               \
               dma.c                    \
+              dwt.c                    \
+              event_queue.c            \
               exti.c                   \
               flash.c                  \
               fsmc.c                   \
@@ -26,10 +33,15 @@ cSRCS_$(d) := adc.c                    \
               pwr.c		       \
               i2c.c                    \
               rcc.c                    \
+              semihost.c               \
               spi.c                    \
               syscalls.c               \
               systick.c                \
               timer.c                  \
+              timer_burst.c            \
+              timer_capture.c          \
+              timer_encoder.c          \
+              timer_wheel.c            \
               usart.c                  \
               util.c                   \
               usb/descriptors.c        \
@@ -61,5 +61,13 @@ typedef struct scb_reg_map {
 /** System control block register map base pointer */
 #define SCB_BASE                        ((struct scb_reg_map*)0xE000ED00)
 
+/*
+ * Register bit definitions
+ */
+
+/* Interrupt control state register */
+
+#define SCB_ICSR_PENDSTSET              (1U << 26)
+
 #endif
 
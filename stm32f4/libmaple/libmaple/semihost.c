@@ -0,0 +1,73 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file semihost.c
+ * @brief ARM semihosting: console and exit through a debugger or QEMU.
+ */
+
+#include "semihost.h"
+
+#define SYS_OPEN                0x01
+#define SYS_WRITE               0x05
+#define SYS_READC               0x07
+#define SYS_EXIT                0x18
+
+#define ADP_STOPPED_APPLICATION_EXIT  0x20026
+#define ADP_STOPPED_RUNTIME_ERROR     0x20023
+
+static int semihost_call(int op, void *arg) {
+    register int r0 asm("r0") = op;
+    register void *r1 asm("r1") = arg;
+    asm volatile("bkpt 0xAB"
+                 : "+r" (r0)
+                 : "r" (r1)
+                 : "memory");
+    return r0;
+}
+
+/* Handle of ":tt" opened for writing, or -1 until first use */
+static int semihost_stdout = -1;
+
+void semihost_write(const void *buf, uint32 len) {
+    if (semihost_stdout < 0) {
+        uint32 args[3] = { (uint32)":tt", 4 /* "w" */, 3 };
+        semihost_stdout = semihost_call(SYS_OPEN, args);
+    }
+    uint32 args[3] = { (uint32)semihost_stdout, (uint32)buf, len };
+    semihost_call(SYS_WRITE, args);
+}
+
+int semihost_readc(void) {
+    return semihost_call(SYS_READC, NULL);
+}
+
+void semihost_exit(int status) {
+    semihost_call(SYS_EXIT, (void*)(status ? ADP_STOPPED_RUNTIME_ERROR :
+                                    ADP_STOPPED_APPLICATION_EXIT));
+    while (1)
+        ;
+}
@@ -0,0 +1,62 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file semihost.h
+ * @brief ARM semihosting: console and exit through a debugger or QEMU.
+ *
+ * Each call traps with BKPT 0xAB for the debugger or emulator to
+ * service.  Without one attached the BKPT escalates to a hard fault,
+ * so only use these in builds meant for QEMU (LIBMAPLE_QEMU) or a
+ * semihosting-enabled debug session.
+ */
+
+#ifndef _SEMIHOST_H_
+#define _SEMIHOST_H_
+
+#include "libmaple_types.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** Write len bytes to the host's standard output. */
+void semihost_write(const void *buf, uint32 len);
+
+/** Read one character from the host's standard input; blocks. */
+int semihost_readc(void);
+
+/**
+ * Stop the program; QEMU exits with status 0 if status is 0 and 1
+ * otherwise.
+ */
+void semihost_exit(int status) __attribute__((noreturn));
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
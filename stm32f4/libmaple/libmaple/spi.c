@@ -46,7 +46,7 @@ static spi_dev spi1 = {
     .irq_num  = NVIC_SPI1,
 };
 /** SPI device 1 */
-spi_dev *SPI1 = &spi1;
+spi_dev* const SPI1 = &spi1;
 
 static spi_dev spi2 = {
     .regs     = SPI2_BASE,
@@ -54,7 +54,7 @@ static spi_dev spi2 = {
     .irq_num  = NVIC_SPI2,
 };
 /** SPI device 2 */
-spi_dev *SPI2 = &spi2;
+spi_dev* const SPI2 = &spi2;
 
 #ifdef STM32_HIGH_DENSITY
 static spi_dev spi3 = {
@@ -63,7 +63,7 @@ static spi_dev spi3 = {
     .irq_num  = NVIC_SPI3,
 };
 /** SPI device 3 */
-spi_dev *SPI3 = &spi3;
+spi_dev* const SPI3 = &spi3;
 #endif
 
 /*
@@ -152,16 +152,7 @@ void spi_slave_enable(spi_dev *dev, spi_mode mode, uint32 flags) {
  * @return Number of elements transmitted.
  */
 uint32 spi_tx(spi_dev *dev, const void *buf, uint32 len) {
-    uint32 txed = 0;
-    uint8 byte_frame = spi_dff(dev) == SPI_DFF_8_BIT;
-    while (spi_is_tx_empty(dev) && (txed < len)) {
-        if (byte_frame) {
-            dev->regs->DR = ((const uint8*)buf)[txed++];
-        } else {
-            dev->regs->DR = ((const uint16*)buf)[txed++];
-        }
-    }
-    return txed;
+    return spi_regs_tx(dev->regs, buf, len);
 }
 
 /**
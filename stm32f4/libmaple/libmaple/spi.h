@@ -209,10 +209,10 @@ typedef struct spi_dev {
     nvic_irq_num irq_num;       /**< NVIC interrupt number */
 } spi_dev;
 
-extern spi_dev *SPI1;
-extern spi_dev *SPI2;
+extern spi_dev* const SPI1;
+extern spi_dev* const SPI2;
 #ifdef STM32_HIGH_DENSITY
-extern spi_dev *SPI3;
+extern spi_dev* const SPI3;
 #endif
 
 /*
@@ -445,6 +445,47 @@ static inline uint8 spi_is_busy(spi_dev *dev) {
     return dev->regs->SR & SPI_SR_BSY;
 }
 
+/*
+ * Register-level functions, for callers that know their port at
+ * compile time: spi_regs_tx(SPI1_BASE, ...) needs no spi_dev and
+ * inlines to direct register accesses.
+ */
+
+/**
+ * @brief Nonblocking transmit on the SPI port at regs.
+ * @see spi_tx()
+ */
+static inline uint32 spi_regs_tx(spi_reg_map *regs,
+                                 const void *buf,
+                                 uint32 len) {
+    uint32 txed = 0;
+    uint8 byte_frame = (regs->CR1 & SPI_CR1_DFF) == SPI_CR1_DFF_8_BIT;
+    while ((regs->SR & SPI_SR_TXE) && (txed < len)) {
+        if (byte_frame) {
+            regs->DR = ((const uint8*)buf)[txed++];
+        } else {
+            regs->DR = ((const uint16*)buf)[txed++];
+        }
+    }
+    return txed;
+}
+
+/**
+ * @brief Send one frame on the SPI port at regs and return the frame
+ *        received in exchange.
+ *
+ * Blocks until the transmit register is free and then until the
+ * reply has arrived.
+ */
+static inline uint16 spi_regs_transfer(spi_reg_map *regs, uint16 val) {
+    while (!(regs->SR & SPI_SR_TXE))
+        ;
+    regs->DR = val;
+    while (!(regs->SR & SPI_SR_RXNE))
+        ;
+    return (uint16)regs->DR;
+}
+
 /*
  * I2S convenience functions (TODO)
  */
@@ -133,6 +133,14 @@
      */
     #define STM32_DELAY_US_MULT
 
+    /**
+     * @brief Core clock cycles per microsecond, used by delay_us()
+     *        when the DWT cycle counter is running.
+     *
+     * @see delay_us()
+     */
+    #define STM32_TICKS_PER_US
+
     /**
      * @brief Pointer to end of built-in SRAM.
      *
@@ -151,6 +159,7 @@
 #if defined(MCU_STM32F103RB)
     /* e.g., LeafLabs Maple */
 
+    #define STM32_TICKS_PER_US          72
     #define STM32_NR_GPIO_PORTS          4
     #define STM32_DELAY_US_MULT         12
     #define STM32_SRAM_END              ((void*)0x20005000)
@@ -161,6 +170,7 @@
 #elif defined(MCU_STM32F103ZE)
     /* e.g., LeafLabs Maple Native */
 
+    #define STM32_TICKS_PER_US          72
     #define STM32_NR_GPIO_PORTS          7
     #define STM32_DELAY_US_MULT         12
     #define STM32_SRAM_END              ((void*)0x20010000)
@@ -174,6 +184,7 @@
     /* This STM32_NR_GPIO_PORTS value is not, strictly speaking, true.
      * But only pins 0 and 1 exist, and they're used for OSC on the
      * Mini, so we'll live with this for now. */
+    #define STM32_TICKS_PER_US          72
     #define STM32_NR_GPIO_PORTS          3
     #define STM32_DELAY_US_MULT         12
     #define STM32_SRAM_END              ((void*)0x20005000)
@@ -184,6 +195,7 @@
 #elif defined(MCU_STM32F103RE)
     /* e.g., LeafLabs Maple RET6 edition */
 
+    #define STM32_TICKS_PER_US          72
     #define STM32_NR_GPIO_PORTS          4
     #define STM32_DELAY_US_MULT         12
     #define STM32_SRAM_END              ((void*)0x20010000)
@@ -194,6 +206,7 @@
 #elif defined(MCU_STM32F103VE)
     /* e.g., LeafLabs Maple Native */
 
+    #define STM32_TICKS_PER_US          72
     #define STM32_NR_GPIO_PORTS          5
     #define STM32_DELAY_US_MULT         12
     #define STM32_SRAM_END              ((void*)0x20010000)
@@ -230,9 +243,6 @@
 	#define DELAY_US_MULT               STM32_DELAY_US_MULT
 #else
 
-
-#else
-
 #error "No MCU type specified. Add something like -DMCU_STM32F103RB "   \
        "to your compiler arguments (probably in a Makefile)."
 
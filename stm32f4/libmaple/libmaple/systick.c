@@ -30,9 +30,11 @@
  */
 
 #include "systick.h"
+#include "dwt.h"
 
 volatile uint32 systick_uptime_millis;
 static void (*systick_user_callback)(void);
+static void (* volatile systick_subscribers[SYSTICK_NR_SUBSCRIBERS])(void);
 
 /**
  * @brief Initialize and enable SysTick.
@@ -75,13 +77,68 @@ void systick_attach_callback(void (*callback)(void)) {
     systick_user_callback = callback;
 }
 
+/**
+ * @brief Add a callback to be called from the SysTick exception handler.
+ *
+ * Unlike systick_attach_callback(), which FreeRTOS takes for its
+ * tick, any number of subscribers up to SYSTICK_NR_SUBSCRIBERS can be
+ * registered side by side.  They are called after the attached
+ * callback, in the order of their slots.
+ *
+ * @param callback Function to call every millisecond.
+ * @return 0 on success, -1 if every slot is taken.
+ * @see systick_unsubscribe()
+ */
+int systick_subscribe(void (*callback)(void)) {
+    uint32 primask;
+    int ret = -1;
+    int i;
+
+    asm volatile("mrs %0, primask \n\t"
+                 "cpsid i"
+                 : "=r" (primask) : : "memory");
+    for (i = 0; i < SYSTICK_NR_SUBSCRIBERS; i++) {
+        if (!systick_subscribers[i]) {
+            systick_subscribers[i] = callback;
+            ret = 0;
+            break;
+        }
+    }
+    asm volatile("msr primask, %0" : : "r" (primask) : "memory");
+    return ret;
+}
+
+/**
+ * @brief Remove a callback added with systick_subscribe().
+ *
+ * Once this returns, the handler will not call it again.
+ */
+void systick_unsubscribe(void (*callback)(void)) {
+    int i;
+
+    for (i = 0; i < SYSTICK_NR_SUBSCRIBERS; i++) {
+        if (systick_subscribers[i] == callback) {
+            systick_subscribers[i] = 0;
+        }
+    }
+}
+
 /*
  * SysTick ISR
  */
 
 void __exc_systick(void) {
+    int i;
+
     systick_uptime_millis++;
+    dwt_cycles64();             /* keep the 64-bit cycle count's high word */
     if (systick_user_callback) {
         systick_user_callback();
     }
+    for (i = 0; i < SYSTICK_NR_SUBSCRIBERS; i++) {
+        void (*callback)(void) = systick_subscribers[i];
+        if (callback) {
+            callback();
+        }
+    }
 }
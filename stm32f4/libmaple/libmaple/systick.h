@@ -74,6 +74,14 @@ typedef struct systick_reg_map {
 #define SYSTICK_CVR_SKEW                BIT(30)
 #define SYSTICK_CVR_TENMS               0xFFFFFF
 
+/**
+ * Number of callbacks systick_subscribe() can register, besides the
+ * one from systick_attach_callback().
+ */
+#ifndef SYSTICK_NR_SUBSCRIBERS
+#define SYSTICK_NR_SUBSCRIBERS          8
+#endif
+
 /** System elapsed time, in milliseconds */
 extern volatile uint32 systick_uptime_millis;
 
@@ -88,6 +96,9 @@ static inline uint32 systick_uptime(void) {
 void systick_init(uint32 reload_val);
 void systick_disable();
 void systick_enable();
+void systick_attach_callback(void (*callback)(void));
+int systick_subscribe(void (*callback)(void));
+void systick_unsubscribe(void (*callback)(void));
 
 /**
  * @brief Returns the current value of the SysTick counter.
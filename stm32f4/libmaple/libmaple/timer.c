@@ -51,7 +51,7 @@ static timer_dev timer1 = {
     .handlers     = { [NR_ADV_HANDLERS - 1] = 0 },
 };
 /** Timer 1 device (advanced) */
-timer_dev *TIMER1 = &timer1;
+timer_dev* const TIMER1 = &timer1;
 
 static timer_dev timer2 = {
     .regs         = { .gen = TIMER2_BASE },
@@ -60,7 +60,7 @@ static timer_dev timer2 = {
     .handlers     = { [NR_GEN_HANDLERS - 1] = 0 },
 };
 /** Timer 2 device (general-purpose) */
-timer_dev *TIMER2 = &timer2;
+timer_dev* const TIMER2 = &timer2;
 
 static timer_dev timer3 = {
     .regs         = { .gen = TIMER3_BASE },
@@ -69,7 +69,7 @@ static timer_dev timer3 = {
     .handlers     = { [NR_GEN_HANDLERS - 1] = 0 },
 };
 /** Timer 3 device (general-purpose) */
-timer_dev *TIMER3 = &timer3;
+timer_dev* const TIMER3 = &timer3;
 
 static timer_dev timer4 = {
     .regs         = { .gen = TIMER4_BASE },
@@ -78,7 +78,7 @@ static timer_dev timer4 = {
     .handlers     = { [NR_GEN_HANDLERS - 1] = 0 },
 };
 /** Timer 4 device (general-purpose) */
-timer_dev *TIMER4 = &timer4;
+timer_dev* const TIMER4 = &timer4;
 
 #ifdef STM32_HIGH_DENSITY
 static timer_dev timer5 = {
@@ -88,7 +88,7 @@ static timer_dev timer5 = {
     .handlers     = { [NR_GEN_HANDLERS - 1] = 0 },
 };
 /** Timer 5 device (general-purpose) */
-timer_dev *TIMER5 = &timer5;
+timer_dev* const TIMER5 = &timer5;
 
 static timer_dev timer6 = {
     .regs         = { .bas = TIMER6_BASE },
@@ -97,7 +97,7 @@ static timer_dev timer6 = {
     .handlers     = { [NR_BAS_HANDLERS - 1] = 0 },
 };
 /** Timer 6 device (basic) */
-timer_dev *TIMER6 = &timer6;
+timer_dev* const TIMER6 = &timer6;
 
 static timer_dev timer7 = {
     .regs         = { .bas = TIMER7_BASE },
@@ -106,7 +106,7 @@ static timer_dev timer7 = {
     .handlers     = { [NR_BAS_HANDLERS - 1] = 0 },
 };
 /** Timer 7 device (basic) */
-timer_dev *TIMER7 = &timer7;
+timer_dev* const TIMER7 = &timer7;
 
 static timer_dev timer8 = {
     .regs         = { .adv = TIMER8_BASE },
@@ -115,7 +115,7 @@ static timer_dev timer8 = {
     .handlers     = { [NR_ADV_HANDLERS - 1] = 0 },
 };
 /** Timer 8 device (advanced) */
-timer_dev *TIMER8 = &timer8;
+timer_dev* const TIMER8 = &timer8;
 #endif
 
 /*
@@ -124,9 +124,11 @@ timer_dev *TIMER8 = &timer8;
 
 static void disable_channel(timer_dev *dev, uint8 channel);
 static void pwm_mode(timer_dev *dev, uint8 channel);
+static void pwm_complementary_mode(timer_dev *dev, uint8 channel);
 static void output_compare_mode(timer_dev *dev, uint8 channel);
+static void input_capture_mode(timer_dev *dev, uint8 channel);
 
-static inline void enable_irq(timer_dev *dev, uint8 interrupt);
+static inline void enable_irq(timer_dev *dev, timer_interrupt_id iid);
 
 /**
  * Initialize a timer, and reset its register map.
@@ -184,10 +186,87 @@ void timer_set_mode(timer_dev *dev, uint8 channel, timer_mode mode) {
     case TIMER_PWM:
         pwm_mode(dev, channel);
         break;
+    case TIMER_PWM_COMPLEMENTARY:
+        pwm_complementary_mode(dev, channel);
+        break;
     case TIMER_OUTPUT_COMPARE:
         output_compare_mode(dev, channel);
         break;
+    case TIMER_INPUT_CAPTURE:
+        input_capture_mode(dev, channel);
+        break;
+    }
+}
+
+/**
+ * @brief Configure and enable a channel's input capture.
+ *
+ * The channel captures its own input TIn.  Capture is disabled while
+ * the mode changes, since CCMR's input bits are only writable then.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL.
+ * @param channel Channel to capture on, from 1 to 4.
+ * @param edge Edge to capture on.
+ * @param psc Capture prescaler.
+ * @param filter Digital input filter, from 0 (off) to 15.
+ * @see timer_ic_set_mode()
+ */
+void timer_ic_setup(timer_dev *dev, uint8 channel, timer_ic_edge edge,
+                    timer_ic_prescaler psc, uint8 filter) {
+    ASSERT_FAULT(channel > 0 && channel <= 4);
+    timer_cc_disable(dev, channel);
+    timer_ic_set_mode(dev, channel, TIMER_IC_INPUT_DIRECT, psc, filter);
+    timer_ic_set_edge(dev, channel, edge);
+    timer_cc_enable(dev, channel);
+}
+
+/**
+ * @brief Put a channel pair in PWM input mode.
+ *
+ * The given channel captures its input on the given edge, which also
+ * resets the counter through the slave mode controller; its pair
+ * (1 <-> 2) captures the same input on the opposite edge.  After each
+ * period the channel's compare register holds the period and the
+ * pair's holds the pulse width, both in timer ticks, with no
+ * interrupt or DMA involved.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL.
+ * @param channel 1 or 2; only TI1 and TI2 can reset the counter.
+ * @param edge TIMER_IC_RISING or TIMER_IC_FALLING, the edge a period
+ *             starts on.
+ * @param filter Digital input filter, from 0 (off) to 15.
+ * @return 0 on success, -1 if the channel or edge is not supported.
+ */
+int timer_ic_set_pwm_input(timer_dev *dev, uint8 channel, timer_ic_edge edge,
+                           uint8 filter) {
+    uint8 pair = channel == 1 ? 2 : 1;
+    timer_ic_edge opposite =
+        edge == TIMER_IC_RISING ? TIMER_IC_FALLING : TIMER_IC_RISING;
+    uint32 smcr;
+
+    if (dev->type == TIMER_BASIC || (channel != 1 && channel != 2) ||
+        (edge != TIMER_IC_RISING && edge != TIMER_IC_FALLING)) {
+        return -1;
     }
+
+    timer_cc_disable(dev, channel);
+    timer_cc_disable(dev, pair);
+    timer_ic_set_mode(dev, channel, TIMER_IC_INPUT_DIRECT, TIMER_IC_DIV1,
+                      filter);
+    timer_ic_set_mode(dev, pair, TIMER_IC_INPUT_INDIRECT, TIMER_IC_DIV1,
+                      filter);
+    timer_ic_set_edge(dev, channel, edge);
+    timer_ic_set_edge(dev, pair, opposite);
+
+    smcr = (dev->regs).gen->SMCR;
+    smcr &= ~(TIMER_SMCR_TS | TIMER_SMCR_SMS);
+    smcr |= (channel == 1 ? TIMER_SMCR_TS_TI1FP1 : TIMER_SMCR_TS_TI2FP2) |
+        TIMER_SMCR_SMS_RESET;
+    (dev->regs).gen->SMCR = smcr;
+
+    timer_cc_enable(dev, channel);
+    timer_cc_enable(dev, pair);
+    return 0;
 }
 
 /**
@@ -207,6 +286,133 @@ void timer_foreach(void (*fn)(timer_dev*)) {
 #endif
 }
 
+/**
+ * @brief Count a quadrature encoder on a timer's channels 1 and 2.
+ *
+ * Both channels capture their own input through the given filter, and
+ * the slave mode controller counts up or down on their edges.  The
+ * counter runs over the timer's whole range, with no prescaler;
+ * channels 3 and 4 stay free.  Start the timer with timer_resume().
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL.
+ * @param mode Which inputs' edges count.
+ * @param filter Digital input filter for both inputs, from 0 (off)
+ *               to 15.
+ * @param reverse Nonzero to count the other way, by inverting TI1.
+ * @return 0 on success, -1 for a basic timer.
+ */
+int timer_encoder_setup(timer_dev *dev, timer_encoder_mode mode,
+                        uint8 filter, uint8 reverse) {
+    uint32 smcr;
+
+    if (dev->type == TIMER_BASIC) {
+        return -1;
+    }
+
+    timer_cc_disable(dev, 1);
+    timer_cc_disable(dev, 2);
+    timer_ic_set_mode(dev, 1, TIMER_IC_INPUT_DIRECT, TIMER_IC_DIV1, filter);
+    timer_ic_set_mode(dev, 2, TIMER_IC_INPUT_DIRECT, TIMER_IC_DIV1, filter);
+    timer_ic_set_edge(dev, 1, reverse ? TIMER_IC_FALLING : TIMER_IC_RISING);
+    timer_ic_set_edge(dev, 2, TIMER_IC_RISING);
+
+    smcr = (dev->regs).gen->SMCR;
+    smcr &= ~TIMER_SMCR_SMS;
+    smcr |= mode;
+    (dev->regs).gen->SMCR = smcr;
+
+    timer_set_prescaler(dev, 0);
+    timer_set_reload(dev, timer_max_reload(dev));
+    timer_generate_update(dev);
+    return 0;
+}
+
+/**
+ * @brief Choose a prescaler and reload value for a timer period.
+ *
+ * Picks the smallest prescale factor whose reload value still fits
+ * in max_reload, which gives the finest counter resolution, then
+ * rounds the reload to the nearest tick.  The resulting period is
+ * factor * (reload + 1) timer clock cycles.  With a 32-bit timer the
+ * factor stays at 1 for periods up to 2^32 cycles.
+ *
+ * @param clk_hz Timer input clock in Hz, from rcc_dev_timer_clk_speed().
+ * @param microseconds Desired period.
+ * @param max_reload Largest usable reload value; see timer_max_reload().
+ * @param factor Set to the prescale factor, from 1 to 65,536 (PSC + 1).
+ * @param reload Set to the reload (ARR) value.
+ * @return 0 on success, -1 if the period was out of range and was
+ *         clamped to the nearest one the timer can produce.
+ */
+int timer_calc_period(uint32 clk_hz, uint32 microseconds, uint32 max_reload,
+                      uint32 *factor, uint32 *reload) {
+    uint64 ticks = ((uint64)clk_hz * microseconds + 500000) / 1000000;
+    uint64 span = (uint64)max_reload + 1;
+    uint64 psc;
+    uint64 arr;
+    int ret = 0;
+
+    if (ticks < 2) {
+        *factor = 1;
+        *reload = 1;
+        return -1;
+    }
+
+    psc = (ticks + span - 1) / span;
+    if (psc > 65536) {
+        psc = 65536;
+        ret = -1;
+    }
+    arr = (ticks + psc / 2) / psc;
+    if (arr > span) {
+        arr = span;
+    }
+
+    *factor = (uint32)psc;
+    *reload = (uint32)(arr - 1);
+    return ret;
+}
+
+/**
+ * @brief Encode a dead time as BDTR's DTG field.
+ *
+ * DTG has four ranges: 0 to 127 ticks in steps of 1, 128 to 254 in
+ * steps of 2, 256 to 504 in steps of 8 and 512 to 1008 in steps of
+ * 16.  Ticks are of the timer clock, with CR1's CKD at its default.
+ *
+ * @param ticks Dead time, rounded up to the next step and clamped to
+ *              1008.
+ * @return DTG value.
+ * @see timer_set_dead_time()
+ */
+uint8 timer_dead_time_dtg(uint32 ticks) {
+    if (ticks <= 127) {
+        return (uint8)ticks;
+    } else if (ticks <= 254) {
+        return (uint8)(0x80 | ((ticks + 1) / 2 - 64));
+    } else if (ticks <= 504) {
+        return (uint8)(0xC0 | ((ticks + 7) / 8 - 32));
+    } else if (ticks <= 1008) {
+        return (uint8)(0xE0 | ((ticks + 15) / 16 - 32));
+    }
+    return 0xFF;
+}
+
+/**
+ * @brief Dead time a DTG value gives, in timer clock ticks.
+ * @see timer_dead_time_dtg()
+ */
+uint32 timer_dead_time_ticks(uint8 dtg) {
+    if (!(dtg & 0x80)) {
+        return dtg;
+    } else if ((dtg & 0xC0) == 0x80) {
+        return (64 + (dtg & 0x3F)) * 2;
+    } else if ((dtg & 0xE0) == 0xC0) {
+        return (32 + (dtg & 0x1F)) * 8;
+    }
+    return (32 + (dtg & 0x1F)) * 16;
+}
+
 /**
  * @brief Attach a timer interrupt.
  * @param dev Timer device
@@ -404,6 +610,9 @@ static inline void dispatch_basic(timer_dev *dev) {
 static void disable_channel(timer_dev *dev, uint8 channel) {
     timer_detach_interrupt(dev, channel);
     timer_cc_disable(dev, channel);
+    if (dev->type == TIMER_ADVANCED && channel <= 3) {
+        timer_ccn_disable(dev, channel);
+    }
 }
 
 static void pwm_mode(timer_dev *dev, uint8 channel) {
@@ -412,11 +621,24 @@ static void pwm_mode(timer_dev *dev, uint8 channel) {
     timer_cc_enable(dev, channel);
 }
 
+static void pwm_complementary_mode(timer_dev *dev, uint8 channel) {
+    if (dev->type != TIMER_ADVANCED || channel > 3) {
+        return;
+    }
+    pwm_mode(dev, channel);
+    timer_ccn_enable(dev, channel);
+}
+
 static void output_compare_mode(timer_dev *dev, uint8 channel) {
     timer_oc_set_mode(dev, channel, TIMER_OC_MODE_ACTIVE_ON_MATCH, 0);
     timer_cc_enable(dev, channel);
 }
 
+static void input_capture_mode(timer_dev *dev, uint8 channel) {
+    timer_disable_irq(dev, channel);
+    timer_ic_setup(dev, channel, TIMER_IC_RISING, TIMER_IC_DIV1, 0);
+}
+
 static void enable_advanced_irq(timer_dev *dev, timer_interrupt_id id);
 static void enable_nonmuxed_irq(timer_dev *dev);
 
@@ -180,15 +180,15 @@ typedef struct timer_dev {
     voidFuncPtr handlers[];     /**< User IRQ handlers */
 } timer_dev;
 
-extern timer_dev *TIMER1;
-extern timer_dev *TIMER2;
-extern timer_dev *TIMER3;
-extern timer_dev *TIMER4;
+extern timer_dev* const TIMER1;
+extern timer_dev* const TIMER2;
+extern timer_dev* const TIMER3;
+extern timer_dev* const TIMER4;
 #ifdef STM32_HIGH_DENSITY
-extern timer_dev *TIMER5;
-extern timer_dev *TIMER6;
-extern timer_dev *TIMER7;
-extern timer_dev *TIMER8;
+extern timer_dev* const TIMER5;
+extern timer_dev* const TIMER6;
+extern timer_dev* const TIMER7;
+extern timer_dev* const TIMER8;
 #endif
 
 /*
@@ -279,7 +279,7 @@ extern timer_dev *TIMER8;
 #define TIMER_SMCR_TS_TI1FP1            (0x5 << 4)
 #define TIMER_SMCR_TS_TI2FP2            (0x6 << 4)
 #define TIMER_SMCR_TS_ETRF              (0x7 << 4)
-#define TIMER_SMCR_SMS                  0x3
+#define TIMER_SMCR_SMS                  0x7
 #define TIMER_SMCR_SMS_DISABLED         0x0
 #define TIMER_SMCR_SMS_ENCODER1         0x1
 #define TIMER_SMCR_SMS_ENCODER2         0x2
@@ -292,12 +292,15 @@ extern timer_dev *TIMER8;
 /* DMA/Interrupt enable register (DIER) */
 
 #define TIMER_DIER_TDE_BIT              14
+#define TIMER_DIER_COMDE_BIT            13
 #define TIMER_DIER_CC4DE_BIT            12
 #define TIMER_DIER_CC3DE_BIT            11
 #define TIMER_DIER_CC2DE_BIT            10
 #define TIMER_DIER_CC1DE_BIT            9
 #define TIMER_DIER_UDE_BIT              8
+#define TIMER_DIER_BIE_BIT              7
 #define TIMER_DIER_TIE_BIT              6
+#define TIMER_DIER_COMIE_BIT            5
 #define TIMER_DIER_CC4IE_BIT            4
 #define TIMER_DIER_CC3IE_BIT            3
 #define TIMER_DIER_CC2IE_BIT            2
@@ -305,12 +308,15 @@ extern timer_dev *TIMER8;
 #define TIMER_DIER_UIE_BIT              0
 
 #define TIMER_DIER_TDE                  BIT(TIMER_DIER_TDE_BIT)
+#define TIMER_DIER_COMDE                BIT(TIMER_DIER_COMDE_BIT)
 #define TIMER_DIER_CC4DE                BIT(TIMER_DIER_CC4DE_BIT)
 #define TIMER_DIER_CC3DE                BIT(TIMER_DIER_CC3DE_BIT)
 #define TIMER_DIER_CC2DE                BIT(TIMER_DIER_CC2DE_BIT)
 #define TIMER_DIER_CC1DE                BIT(TIMER_DIER_CC1DE_BIT)
 #define TIMER_DIER_UDE                  BIT(TIMER_DIER_UDE_BIT)
+#define TIMER_DIER_BIE                  BIT(TIMER_DIER_BIE_BIT)
 #define TIMER_DIER_TIE                  BIT(TIMER_DIER_TIE_BIT)
+#define TIMER_DIER_COMIE                BIT(TIMER_DIER_COMIE_BIT)
 #define TIMER_DIER_CC4IE                BIT(TIMER_DIER_CC4IE_BIT)
 #define TIMER_DIER_CC3IE                BIT(TIMER_DIER_CC3IE_BIT)
 #define TIMER_DIER_CC2IE                BIT(TIMER_DIER_CC2IE_BIT)
@@ -347,14 +353,18 @@ extern timer_dev *TIMER8;
 
 /* Event generation register (EGR) */
 
+#define TIMER_EGR_BG_BIT                7
 #define TIMER_EGR_TG_BIT                6
+#define TIMER_EGR_COMG_BIT              5
 #define TIMER_EGR_CC4G_BIT              4
 #define TIMER_EGR_CC3G_BIT              3
 #define TIMER_EGR_CC2G_BIT              2
 #define TIMER_EGR_CC1G_BIT              1
 #define TIMER_EGR_UG_BIT                0
 
+#define TIMER_EGR_BG                    BIT(TIMER_EGR_BG_BIT)
 #define TIMER_EGR_TG                    BIT(TIMER_EGR_TG_BIT)
+#define TIMER_EGR_COMG                  BIT(TIMER_EGR_COMG_BIT)
 #define TIMER_EGR_CC4G                  BIT(TIMER_EGR_CC4G_BIT)
 #define TIMER_EGR_CC3G                  BIT(TIMER_EGR_CC3G_BIT)
 #define TIMER_EGR_CC2G                  BIT(TIMER_EGR_CC2G_BIT)
@@ -434,21 +444,35 @@ extern timer_dev *TIMER8;
 
 /* Capture/compare enable register (CCER) */
 
+#define TIMER_CCER_CC4NP_BIT            15
 #define TIMER_CCER_CC4P_BIT             13
 #define TIMER_CCER_CC4E_BIT             12
+#define TIMER_CCER_CC3NP_BIT            11
+#define TIMER_CCER_CC3NE_BIT            10
 #define TIMER_CCER_CC3P_BIT             9
 #define TIMER_CCER_CC3E_BIT             8
+#define TIMER_CCER_CC2NP_BIT            7
+#define TIMER_CCER_CC2NE_BIT            6
 #define TIMER_CCER_CC2P_BIT             5
 #define TIMER_CCER_CC2E_BIT             4
+#define TIMER_CCER_CC1NP_BIT            3
+#define TIMER_CCER_CC1NE_BIT            2
 #define TIMER_CCER_CC1P_BIT             1
 #define TIMER_CCER_CC1E_BIT             0
 
+#define TIMER_CCER_CC4NP                BIT(TIMER_CCER_CC4NP_BIT)
 #define TIMER_CCER_CC4P                 BIT(TIMER_CCER_CC4P_BIT)
 #define TIMER_CCER_CC4E                 BIT(TIMER_CCER_CC4E_BIT)
+#define TIMER_CCER_CC3NP                BIT(TIMER_CCER_CC3NP_BIT)
+#define TIMER_CCER_CC3NE                BIT(TIMER_CCER_CC3NE_BIT)
 #define TIMER_CCER_CC3P                 BIT(TIMER_CCER_CC3P_BIT)
 #define TIMER_CCER_CC3E                 BIT(TIMER_CCER_CC3E_BIT)
+#define TIMER_CCER_CC2NP                BIT(TIMER_CCER_CC2NP_BIT)
+#define TIMER_CCER_CC2NE                BIT(TIMER_CCER_CC2NE_BIT)
 #define TIMER_CCER_CC2P                 BIT(TIMER_CCER_CC2P_BIT)
 #define TIMER_CCER_CC2E                 BIT(TIMER_CCER_CC2E_BIT)
+#define TIMER_CCER_CC1NP                BIT(TIMER_CCER_CC1NP_BIT)
+#define TIMER_CCER_CC1NE                BIT(TIMER_CCER_CC1NE_BIT)
 #define TIMER_CCER_CC1P                 BIT(TIMER_CCER_CC1P_BIT)
 #define TIMER_CCER_CC1E                 BIT(TIMER_CCER_CC1E_BIT)
 
@@ -525,21 +549,29 @@ extern timer_dev *TIMER8;
  * Used to configure the behavior of a timer channel.  Note that not
  * all timers can be configured in every mode.
  */
-/* TODO TIMER_PWM_CENTER_ALIGNED, TIMER_INPUT_CAPTURE, TIMER_ONE_PULSE */
+/* TODO TIMER_PWM_CENTER_ALIGNED, TIMER_ONE_PULSE */
 typedef enum timer_mode {
     TIMER_DISABLED, /**< In this mode, the timer stops counting,
                          channel interrupts are detached, and no state
                          changes are output. */
     TIMER_PWM, /**< PWM output mode. This is the default mode for pins
                     after initialization. */
+    TIMER_PWM_COMPLEMENTARY, /**< PWM output mode on both the channel's
+                                  output and its complementary output
+                                  CHxN, with the dead time set by
+                                  timer_set_dead_time().  Channels 1 to
+                                  3 of advanced timers only. */
     /* TIMER_PWM_CENTER_ALIGNED, /\**< Center-aligned PWM output mode. *\/ */
     TIMER_OUTPUT_COMPARE, /**< In this mode, the timer counts from 0
                                to its reload value repeatedly; every
                                time the counter value reaches one of
                                the channel compare values, the
                                corresponding interrupt is fired. */
-    /* TIMER_INPUT_CAPTURE, /\**< In this mode, the timer can measure the */
-    /*                           pulse lengths of input signals. *\/ */
+    TIMER_INPUT_CAPTURE, /**< In this mode, the channel latches the
+                              counter on each rising edge of its
+                              input; the compare value reads back
+                              the last capture.  See timer_ic_set_mode()
+                              for filters, prescalers and edges. */
     /* TIMER_ONE_PULSE /\**< In this mode, the timer can generate a single */
     /*                      pulse on a GPIO pin for a specified amount of */
     /*                      time. *\/ */
@@ -567,6 +599,8 @@ void timer_init(timer_dev *dev);
 void timer_disable(timer_dev *dev);
 void timer_set_mode(timer_dev *dev, uint8 channel, timer_mode mode);
 void timer_foreach(void (*fn)(timer_dev*));
+int timer_calc_period(uint32 clk_hz, uint32 microseconds, uint32 max_reload,
+                      uint32 *factor, uint32 *reload);
 
 /**
  * @brief Timer interrupt number.
@@ -631,24 +665,56 @@ static inline void timer_resume(timer_dev *dev) {
     *bb_perip(&(dev->regs).bas->CR1, TIMER_CR1_CEN_BIT) = 1;
 }
 
+/**
+ * @brief Check whether a timer has a 32-bit counter.
+ *
+ * On STM32F2, TIMER2 and TIMER5 have 32-bit CNT, ARR and CCRx
+ * registers.  Every other timer, and every timer on STM32F1, is
+ * 16 bits wide.
+ *
+ * @param dev Timer to check
+ * @return Nonzero if the timer's counter is 32 bits wide.
+ */
+static inline int timer_is_32bit(timer_dev *dev) {
+#if defined(STM32F2) && defined(STM32_HIGH_DENSITY)
+    return dev == TIMER2 || dev == TIMER5;
+#elif defined(STM32F2)
+    return dev == TIMER2;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Largest reload value a timer supports.
+ * @param dev Timer to check
+ * @return 0xFFFFFFFF for 32-bit timers, 0xFFFF otherwise.
+ * @see timer_is_32bit()
+ */
+static inline uint32 timer_max_reload(timer_dev *dev) {
+    return timer_is_32bit(dev) ? 0xFFFFFFFFUL : 0xFFFFUL;
+}
+
 /**
  * @brief Returns the timer's counter value.
  *
  * This value is likely to be inaccurate if the counter is running
- * with a low prescaler.
+ * with a low prescaler.  It is 32 bits wide on 32-bit timers.
  *
  * @param dev Timer whose counter to return
+ * @see timer_is_32bit()
  */
-static inline uint16 timer_get_count(timer_dev *dev) {
-    return (uint16)(dev->regs).bas->CNT;
+static inline uint32 timer_get_count(timer_dev *dev) {
+    return (dev->regs).bas->CNT;
 }
 
 /**
  * @brief Sets the counter value for the given timer.
  * @param dev Timer whose counter to set
- * @param value New counter value
+ * @param value New counter value.  Only the low 16 bits are used on
+ *              16-bit timers.
  */
-static inline void timer_set_count(timer_dev *dev, uint16 value) {
+static inline void timer_set_count(timer_dev *dev, uint32 value) {
     (dev->regs).bas->CNT = value;
 }
 
@@ -686,17 +752,18 @@ static inline void timer_set_prescaler(timer_dev *dev, uint16 psc) {
  * @brief Returns a timer's reload value.
  * @param dev Timer whose reload value to return
  */
-static inline uint16 timer_get_reload(timer_dev *dev) {
-    return (uint16)(dev->regs).bas->ARR;
+static inline uint32 timer_get_reload(timer_dev *dev) {
+    return (dev->regs).bas->ARR;
 }
 
 /**
  * @brief Set a timer's reload value.
  * @param dev Timer whose reload value to set
  * @param arr New reload value to use.  Takes effect at next update event.
+ *            Must not exceed timer_max_reload(dev).
  * @see timer_generate_update()
  */
-static inline void timer_set_reload(timer_dev *dev, uint16 arr) {
+static inline void timer_set_reload(timer_dev *dev, uint32 arr) {
     (dev->regs).bas->ARR = arr;
 }
 
@@ -705,7 +772,7 @@ static inline void timer_set_reload(timer_dev *dev, uint16 arr) {
  * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL.
  * @param channel Channel whose compare value to get.
  */
-static inline uint16 timer_get_compare(timer_dev *dev, uint8 channel) {
+static inline uint32 timer_get_compare(timer_dev *dev, uint8 channel) {
     __io uint32 *ccr = &(dev->regs).gen->CCR1 + (channel - 1);
     return *ccr;
 }
@@ -718,7 +785,7 @@ static inline uint16 timer_get_compare(timer_dev *dev, uint8 channel) {
  */
 static inline void timer_set_compare(timer_dev *dev,
                                      uint8 channel,
-                                     uint16 value) {
+                                     uint32 value) {
     __io uint32 *ccr = &(dev->regs).gen->CCR1 + (channel - 1);
     *ccr = value;
 }
@@ -737,6 +804,45 @@ static inline void timer_generate_update(timer_dev *dev) {
     *bb_perip(&(dev->regs).bas->EGR, TIMER_EGR_UG_BIT) = 1;
 }
 
+/**
+ * @brief Generate a commutation (COM) event.
+ *
+ * With capture/compare preload on (see timer_set_ccx_preload()), this
+ * makes the preloaded CCxE, CCxNE and OCxM bits of every channel take
+ * effect at once.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED.
+ */
+static inline void timer_generate_com(timer_dev *dev) {
+    *bb_perip(&(dev->regs).adv->EGR, TIMER_EGR_COMG_BIT) = 1;
+}
+
+/**
+ * @brief Generate a break event.
+ *
+ * Turns the outputs off just as the break input would.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED.
+ */
+static inline void timer_generate_break(timer_dev *dev) {
+    *bb_perip(&(dev->regs).adv->EGR, TIMER_EGR_BG_BIT) = 1;
+}
+
+/**
+ * @brief Select what a timer signals on its trigger output (TRGO).
+ *
+ * TRGO can start ADC and DAC conversions and clock other timers.
+ *
+ * @param dev Timer device.  Basic timers only support
+ *            TIMER_CR2_MMS_RESET, TIMER_CR2_MMS_ENABLE and
+ *            TIMER_CR2_MMS_UPDATE.
+ * @param mms One of the TIMER_CR2_MMS_* values.
+ */
+static inline void timer_set_master_mode(timer_dev *dev, uint32 mms) {
+    uint32 cr2 = (dev->regs).bas->CR2 & ~TIMER_CR2_MMS;
+    (dev->regs).bas->CR2 = cr2 | (mms & TIMER_CR2_MMS);
+}
+
 /**
  * @brief Enable a timer's trigger DMA request
  * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL
@@ -753,6 +859,28 @@ static inline void timer_dma_disable_trg_req(timer_dev *dev) {
     *bb_perip(&(dev->regs).gen->DIER, TIMER_DIER_TDE_BIT) = 0;
 }
 
+/**
+ * @brief Enable a timer's update DMA request
+ *
+ * With a DMA burst set up in DCR, each update event then makes the
+ * timer request one transfer per burst register through DMAR.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL
+ * @see timer_dma_set_burst_len()
+ * @see timer_dma_set_base_addr()
+ */
+static inline void timer_dma_enable_upd_req(timer_dev *dev) {
+    *bb_perip(&(dev->regs).gen->DIER, TIMER_DIER_UDE_BIT) = 1;
+}
+
+/**
+ * @brief Disable a timer's update DMA request
+ * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL
+ */
+static inline void timer_dma_disable_upd_req(timer_dev *dev) {
+    *bb_perip(&(dev->regs).gen->DIER, TIMER_DIER_UDE_BIT) = 0;
+}
+
 /**
  * @brief Enable a timer channel's DMA request.
  * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL
@@ -852,6 +980,191 @@ static inline void timer_cc_set_pol(timer_dev *dev, uint8 channel, uint8 pol) {
     *bb_perip(&(dev->regs).gen->CCER, 4 * (channel - 1) + 1) = pol;
 }
 
+/**
+ * @brief Enable a channel's complementary output CHxN.
+ * @param dev Timer device, must have type TIMER_ADVANCED.
+ * @param channel Channel, from 1 to 3.
+ */
+static inline void timer_ccn_enable(timer_dev *dev, uint8 channel) {
+    *bb_perip(&(dev->regs).adv->CCER, 4 * (channel - 1) + 2) = 1;
+}
+
+/**
+ * @brief Disable a channel's complementary output CHxN.
+ * @param dev Timer device, must have type TIMER_ADVANCED.
+ * @param channel Channel, from 1 to 3.
+ */
+static inline void timer_ccn_disable(timer_dev *dev, uint8 channel) {
+    *bb_perip(&(dev->regs).adv->CCER, 4 * (channel - 1) + 2) = 0;
+}
+
+/**
+ * @brief Set a complementary output's polarity.
+ * @param dev Timer device, must have type TIMER_ADVANCED.
+ * @param channel Channel, from 1 to 3.
+ * @param pol 0 for active high, 1 for active low.
+ */
+static inline void timer_ccn_set_pol(timer_dev *dev, uint8 channel,
+                                     uint8 pol) {
+    *bb_perip(&(dev->regs).adv->CCER, 4 * (channel - 1) + 3) = pol;
+}
+
+/**
+ * Timer counting modes.
+ * @see timer_set_count_mode()
+ */
+typedef enum timer_count_mode {
+    TIMER_COUNT_EDGE = TIMER_CR1_CKD_CMS_EDGE, /**< Count up or down, as
+                                                  CR1's DIR bit says */
+    TIMER_COUNT_CENTER_DOWN = TIMER_CR1_CKD_CMS_CENTER1, /**< Count up and
+                                                            down; output
+                                                            compare flags
+                                                            set counting
+                                                            down */
+    TIMER_COUNT_CENTER_UP = TIMER_CR1_CKD_CMS_CENTER2, /**< Count up and
+                                                          down; flags set
+                                                          counting up */
+    TIMER_COUNT_CENTER_BOTH = TIMER_CR1_CKD_CMS_CENTER3 /**< Count up and
+                                                           down; flags set
+                                                           both ways */
+} timer_count_mode;
+
+/**
+ * @brief Set a timer's counting mode.
+ *
+ * Center-aligned counting runs from 0 up to the reload value and back
+ * down, so a PWM period is twice the reload value and pulses on
+ * different channels are centred on each other.  Update events come
+ * at both ends unless the repetition counter thins them out; see
+ * timer_set_repetition().
+ *
+ * Change the mode only while the timer is paused.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL.
+ * @param mode New counting mode.
+ */
+static inline void timer_set_count_mode(timer_dev *dev,
+                                        timer_count_mode mode) {
+    uint32 cr1 = (dev->regs).gen->CR1 & ~(TIMER_CR1_CKD_CMS | TIMER_CR1_DIR);
+    (dev->regs).gen->CR1 = cr1 | mode;
+}
+
+/**
+ * @brief Set how many counter overflows or underflows an update
+ *        event takes.
+ *
+ * An update event comes after every rep + 1 of them.  In
+ * center-aligned mode, 1 gives one update per PWM period.  The new
+ * value takes effect at the next update event.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED.
+ * @param rep Repetitions, from 0 to 255.
+ */
+static inline void timer_set_repetition(timer_dev *dev, uint8 rep) {
+    (dev->regs).adv->RCR = rep;
+}
+
+/**
+ * @brief Set the capture/compare control preload.
+ *
+ * With preload on, writes to the channels' CCxE, CCxNE and OCxM bits
+ * wait for a commutation event, so a whole new output pattern can be
+ * set up channel by channel and switched in at once: six-step motor
+ * commutation, for example.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED.
+ * @param preload Non-zero to preload the control bits.
+ * @param on_trigger Non-zero to also take a rising edge on the trigger
+ *                   input (TRGI) as a commutation event, besides
+ *                   timer_generate_com().
+ */
+static inline void timer_set_ccx_preload(timer_dev *dev, uint8 preload,
+                                         uint8 on_trigger) {
+    uint32 cr2 = (dev->regs).adv->CR2 & ~(TIMER_CR2_CCPC | TIMER_CR2_CCUS);
+    if (preload) {
+        cr2 |= TIMER_CR2_CCPC | (on_trigger ? TIMER_CR2_CCUS : 0);
+    }
+    (dev->regs).adv->CR2 = cr2;
+}
+
+uint8 timer_dead_time_dtg(uint32 ticks);
+uint32 timer_dead_time_ticks(uint8 dtg);
+
+/**
+ * @brief Set the dead time between complementary outputs.
+ *
+ * Each output's rising edge is delayed by the dead time, so the high
+ * and low side switches of a bridge are never on together.  The
+ * hardware has 1-tick steps up to 127 ticks, then coarser ones up to
+ * 1008; the time is rounded up to the next step.
+ *
+ * BDTR cannot be written once locked; see TIMER_BDTR_LOCK.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED.
+ * @param ticks Dead time in timer clock ticks, before the prescaler.
+ * @return The dead time set, in ticks.
+ */
+static inline uint32 timer_set_dead_time(timer_dev *dev, uint32 ticks) {
+    uint8 dtg = timer_dead_time_dtg(ticks);
+    uint32 bdtr = (dev->regs).adv->BDTR & ~TIMER_BDTR_DTG;
+    (dev->regs).adv->BDTR = bdtr | dtg;
+    return timer_dead_time_ticks(dtg);
+}
+
+/**
+ * @brief Configure the break input.
+ *
+ * A break, from the BKIN pin or timer_generate_break(), clears the
+ * main output enable at once, without waiting for the clock: every
+ * output goes to its idle state (OISx, low by default).  It stays
+ * off until timer_set_main_output() turns it back on, or with
+ * auto_restart until the next update event after the break input
+ * goes inactive.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED.
+ * @param enable Non-zero to act on the BKIN pin.
+ * @param active_high Non-zero if BKIN is active high, else active low.
+ * @param auto_restart Non-zero to turn the outputs back on
+ *                     automatically.
+ */
+static inline void timer_break_setup(timer_dev *dev, uint8 enable,
+                                     uint8 active_high,
+                                     uint8 auto_restart) {
+    uint32 bdtr = (dev->regs).adv->BDTR &
+        ~(TIMER_BDTR_BKE | TIMER_BDTR_BKP | TIMER_BDTR_AOE);
+    if (enable) {
+        bdtr |= TIMER_BDTR_BKE;
+    }
+    if (active_high) {
+        bdtr |= TIMER_BDTR_BKP;
+    }
+    if (auto_restart) {
+        bdtr |= TIMER_BDTR_AOE;
+    }
+    (dev->regs).adv->BDTR = bdtr;
+}
+
+/**
+ * @brief Turn an advanced timer's outputs on or off.
+ *
+ * No advanced timer output, complementary or not, drives its pin
+ * until the main output enable (MOE) is set.  A break clears it.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED.
+ * @param enable Non-zero to enable the outputs.
+ */
+static inline void timer_set_main_output(timer_dev *dev, uint8 enable) {
+    *bb_perip(&(dev->regs).adv->BDTR, TIMER_BDTR_MOE_BIT) = enable ? 1 : 0;
+}
+
+/**
+ * @brief Whether an advanced timer's outputs are on.
+ * @param dev Timer device, must have type TIMER_ADVANCED.
+ */
+static inline uint8 timer_get_main_output(timer_dev *dev) {
+    return ((dev->regs).adv->BDTR & TIMER_BDTR_MOE) != 0;
+}
+
 /**
  * @brief Get a timer's DMA burst length.
  * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL.
@@ -1020,6 +1333,126 @@ static inline void timer_oc_set_mode(timer_dev *dev,
     *ccmr = tmp;
 }
 
+/**
+ * Timer input capture signal selection.
+ * @see timer_ic_set_mode()
+ */
+typedef enum timer_ic_input {
+    TIMER_IC_INPUT_DIRECT = TIMER_CCMR_CCS_INPUT_TI1, /**< Channel n captures
+                                                         its own input TIn */
+    TIMER_IC_INPUT_INDIRECT = TIMER_CCMR_CCS_INPUT_TI2, /**< Channel captures
+                                                           its pair's input:
+                                                           1 <-> 2, 3 <-> 4 */
+    TIMER_IC_INPUT_TRC = TIMER_CCMR_CCS_INPUT_TRC /**< Channel captures the
+                                                     trigger input TRC */
+} timer_ic_input;
+
+/**
+ * Timer input capture prescaler: capture once every N edges.
+ * @see timer_ic_set_mode()
+ */
+typedef enum timer_ic_prescaler {
+    TIMER_IC_DIV1 = 0 << 2,     /**< Capture every edge */
+    TIMER_IC_DIV2 = 1 << 2,     /**< Capture every 2nd edge */
+    TIMER_IC_DIV4 = 2 << 2,     /**< Capture every 4th edge */
+    TIMER_IC_DIV8 = 3 << 2      /**< Capture every 8th edge */
+} timer_ic_prescaler;
+
+/**
+ * Timer input capture edge, as CCxNP:CCxP bits for channel 1.
+ * @see timer_ic_set_edge()
+ */
+typedef enum timer_ic_edge {
+    TIMER_IC_RISING = 0,                /**< Capture on rising edges */
+    TIMER_IC_FALLING = TIMER_CCER_CC1P, /**< Capture on falling edges */
+#ifdef STM32F2
+    TIMER_IC_BOTH = TIMER_CCER_CC1P | TIMER_CCER_CC1NP /**< Capture on
+                                                          both edges */
+#endif
+} timer_ic_edge;
+
+/**
+ * @brief Configure a channel's input capture mode.
+ *
+ * Leaves the channel's capture disabled if it was; enable it with
+ * timer_cc_enable() once the mode and edge are set.
+ *
+ * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL.
+ * @param channel Channel to configure in input capture mode, from 1 to 4.
+ * @param input Signal the channel captures on.
+ * @param psc Capture prescaler.
+ * @param filter Digital input filter ICxF, from 0 (off) to 15.  Higher
+ *               values need more consecutive equal samples, taken at
+ *               a lower rate, before an edge is seen; see the
+ *               reference manual for the sampling table.
+ * @see timer_ic_input
+ * @see timer_ic_prescaler
+ */
+static inline void timer_ic_set_mode(timer_dev *dev,
+                                     uint8 channel,
+                                     timer_ic_input input,
+                                     timer_ic_prescaler psc,
+                                     uint8 filter) {
+    __io uint32 *ccmr = &(dev->regs).gen->CCMR1 + (((channel - 1) >> 1) & 1);
+    uint8 shift = 8 * (1 - (channel & 1));
+
+    uint32 tmp = *ccmr;
+    tmp &= ~(0xFF << shift);
+    tmp |= (input | psc | (filter & 0xF) << 4) << shift;
+    *ccmr = tmp;
+}
+
+/**
+ * @brief Set the edge a channel captures on.
+ * @param dev Timer device, must have type TIMER_ADVANCED or TIMER_GENERAL.
+ * @param channel Channel, from 1 to 4.
+ * @param edge Edge to capture on.
+ * @see timer_ic_edge
+ */
+static inline void timer_ic_set_edge(timer_dev *dev,
+                                     uint8 channel,
+                                     timer_ic_edge edge) {
+    uint8 shift = 4 * (channel - 1);
+    uint32 tmp = (dev->regs).gen->CCER;
+    tmp &= ~((uint32)(TIMER_CCER_CC1P | TIMER_CCER_CC1NP) << shift);
+    tmp |= (uint32)edge << shift;
+    (dev->regs).gen->CCER = tmp;
+}
+
+void timer_ic_setup(timer_dev *dev, uint8 channel, timer_ic_edge edge,
+                    timer_ic_prescaler psc, uint8 filter);
+int timer_ic_set_pwm_input(timer_dev *dev, uint8 channel, timer_ic_edge edge,
+                           uint8 filter);
+
+/**
+ * Quadrature encoder counting modes: which inputs' edges count.  The
+ * other input's level gives the direction.
+ * @see timer_encoder_setup()
+ */
+typedef enum timer_encoder_mode {
+    TIMER_ENCODER_TI1 = TIMER_SMCR_SMS_ENCODER1, /**< Count TI1 edges:
+                                                    2 counts per cycle */
+    TIMER_ENCODER_TI2 = TIMER_SMCR_SMS_ENCODER2, /**< Count TI2 edges:
+                                                    2 counts per cycle */
+    TIMER_ENCODER_TI12 = TIMER_SMCR_SMS_ENCODER3 /**< Count both: 4 counts
+                                                    per cycle */
+} timer_encoder_mode;
+
+int timer_encoder_setup(timer_dev *dev, timer_encoder_mode mode,
+                        uint8 filter, uint8 reverse);
+
+/**
+ * @brief Get a timer's counting direction.
+ *
+ * In encoder mode this is the direction of the last count.
+ *
+ * @param dev Timer device.
+ * @return 0 when counting up, 1 when counting down.
+ */
+static inline uint8 timer_get_direction(timer_dev *dev) {
+    return *bb_perip(&(dev->regs).bas->CR1, TIMER_CR1_DIR_BIT);
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
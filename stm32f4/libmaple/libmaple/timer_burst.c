@@ -0,0 +1,258 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file timer_burst.c
+ * @brief Compare value streams written by timer DMA bursts.
+ */
+
+#include "timer_burst.h"
+
+#ifdef STM32F2
+
+/* Update DMA stream and request channel of a bursting timer */
+typedef struct burst_dma {
+    uint8 controller;           /* 1 or 2 */
+    dma_stream stream;
+    dma_channel request;
+} burst_dma;
+
+static const burst_dma tim1_dma = {2, DMA_STREAM5, DMA_CH6};
+static const burst_dma tim3_dma = {1, DMA_STREAM2, DMA_CH5};
+static const burst_dma tim4_dma = {1, DMA_STREAM6, DMA_CH2};
+static const burst_dma tim8_dma = {2, DMA_STREAM1, DMA_CH7};
+
+/**
+ * @brief Find the DMA stream serving a timer's update requests.
+ *
+ * From the reference manual's request mapping tables.  TIMER3's
+ * stream is shared with its channel 4 capture requests, and TIMER4's
+ * with the I2C1 transmitter.
+ *
+ * @param dev Timer device.
+ * @param dma Set to the DMA controller.
+ * @param stream Set to the stream.
+ * @param request Set to the stream's request channel.
+ * @return 0 on success, -1 if the timer cannot burst 16-bit slots.
+ */
+int timer_burst_dma_request(timer_dev *dev, dma_dev **dma,
+                            dma_stream *stream, dma_channel *request) {
+    const burst_dma *map;
+
+    if (dev == TIMER1) {
+        map = &tim1_dma;
+    } else if (dev == TIMER3) {
+        map = &tim3_dma;
+    } else if (dev == TIMER4) {
+        map = &tim4_dma;
+    } else if (dev == TIMER8) {
+        map = &tim8_dma;
+    } else {
+        return -1;
+    }
+    *dma = map->controller == 1 ? DMA1 : DMA2;
+    *stream = map->stream;
+    *request = map->request;
+    return 0;
+}
+
+/**
+ * @brief Set up a burst engine.
+ *
+ * Puts the channels in PWM mode 1 with preload and sets their compare
+ * values to zero, so their outputs are low.  On TIMER1 and TIMER8 the
+ * main output enable is set too.  The timer should be running with
+ * its period set to one bit time.
+ *
+ * @param burst Engine state to initialise.
+ * @param dev TIMER1, TIMER3, TIMER4 or TIMER8.
+ * @param first First channel to write, from 1 to 4.
+ * @param channels Consecutive channels written per update, from 1 to
+ *                 5 - first.
+ * @return 0 on success, -1 if the timer or channels cannot be used.
+ */
+int timer_burst_init(timer_burst *burst, timer_dev *dev, uint8 first,
+                     uint8 channels) {
+    uint8 ch;
+
+    if (first < 1 || channels < 1 || first + channels > 5 ||
+        timer_burst_dma_request(dev, &burst->dma, &burst->stream,
+                                &burst->request) < 0) {
+        return -1;
+    }
+    burst->timer = dev;
+    burst->first = first;
+    burst->channels = channels;
+    burst->buffers[0] = NULL;
+    burst->buffers[1] = NULL;
+    burst->finished = 0;
+
+    timer_dma_disable_upd_req(dev);
+    for (ch = first; ch < first + channels; ch++) {
+        timer_set_compare(dev, ch, 0);
+        timer_oc_set_mode(dev, ch, TIMER_OC_MODE_PWM_1, TIMER_OC_PE);
+        timer_cc_enable(dev, ch);
+    }
+    if (dev->type == TIMER_ADVANCED) {
+        (dev->regs).adv->BDTR |= TIMER_BDTR_MOE;
+    }
+    return 0;
+}
+
+static int start(timer_burst *burst, uint16 *slots0, uint16 *slots1,
+                 uint16 updates, void (*handler)(void)) {
+    timer_dev *dev = burst->timer;
+    uint32 transfers = (uint32)updates * burst->channels;
+    uint32 mode = DMA_MINC_MODE | DMA_FROM_MEM | DMA_TRNS_CMPLT |
+        DMA_TRNS_ERR;
+
+    if (!slots0 || updates == 0 || transfers > 0xFFFF ||
+        timer_burst_busy(burst)) {
+        return -1;
+    }
+    if (slots1) {
+        mode |= DMA_DBL_BUF_MODE | DMA_CIRC_MODE;
+    }
+    burst->buffers[0] = slots0;
+    burst->buffers[1] = slots1;
+    burst->finished = 0;
+
+    timer_dma_set_base_addr(dev, (timer_dma_base_addr)
+                            (TIMER_DMA_BASE_CCR1 + burst->first - 1));
+    timer_dma_set_burst_len(dev, burst->channels);
+
+    dma_init(burst->dma);
+    dma_setup_transfer(burst->dma, burst->stream, burst->request,
+                       &(dev->regs).gen->DMAR, DMA_SIZE_16BITS,
+                       slots0,                 DMA_SIZE_16BITS,
+                       mode);
+    if (slots1) {
+        dma_set_mem1_addr(burst->dma, burst->stream, slots1);
+    }
+    dma_set_num_transfers(burst->dma, burst->stream, (uint16)transfers);
+    dma_set_priority(burst->dma, burst->stream, DMA_PRIORITY_VERY_HIGH);
+    dma_attach_interrupt(burst->dma, burst->stream, handler);
+    dma_enable(burst->dma, burst->stream);
+
+    /* The first row is written at the next update and plays after it */
+    timer_dma_enable_upd_req(dev);
+    return 0;
+}
+
+/**
+ * @brief Play a buffer once.
+ *
+ * The handler is called when the last row has been written, one
+ * period before it has played; it must call timer_burst_finish(),
+ * which stops the burst.
+ *
+ * @param burst Engine state, from timer_burst_init().
+ * @param slots Rows to play, channels slots each.
+ * @param updates Number of rows.  updates * channels is at most 65535.
+ * @param handler DMA interrupt handler.
+ * @return 0 on success, -1 if the buffer is unusable or a burst is
+ *         still playing.
+ */
+int timer_burst_send(timer_burst *burst, uint16 *slots, uint16 updates,
+                     void (*handler)(void)) {
+    return start(burst, slots, NULL, updates, handler);
+}
+
+/**
+ * @brief Play two buffers alternately until stopped.
+ *
+ * The handler is called each time a buffer has been written out and
+ * the other one started; it must call timer_burst_finish() and may
+ * then refill timer_burst_idle_buffer(), or call timer_burst_stop()
+ * once a buffer ending in a row of zeros has been finished.
+ *
+ * @param burst Engine state, from timer_burst_init().
+ * @param slots0 First buffer to play.
+ * @param slots1 Second buffer, the same size.
+ * @param updates Rows in each buffer.  updates * channels is at most
+ *                65535.
+ * @param handler DMA interrupt handler.
+ * @return 0 on success, -1 if the buffers are unusable or a burst is
+ *         still playing.
+ */
+int timer_burst_stream(timer_burst *burst, uint16 *slots0, uint16 *slots1,
+                       uint16 updates, void (*handler)(void)) {
+    if (!slots1) {
+        return -1;
+    }
+    return start(burst, slots0, slots1, updates, handler);
+}
+
+/**
+ * @brief Stop playing.
+ *
+ * The channels' compare values are set to zero, so the outputs go low
+ * at the next update if they were stopped mid-frame.
+ *
+ * @param burst Engine state.
+ */
+void timer_burst_stop(timer_burst *burst) {
+    uint8 ch;
+
+    timer_dma_disable_upd_req(burst->timer);
+    dma_disable(burst->dma, burst->stream);
+    dma_detach_interrupt(burst->dma, burst->stream);
+    for (ch = burst->first; ch < burst->first + burst->channels; ch++) {
+        timer_set_compare(burst->timer, ch, 0);
+    }
+}
+
+/**
+ * @brief Acknowledge the DMA interrupt.
+ *
+ * Call this first from the handler passed to timer_burst_send() or
+ * timer_burst_stream().  A buffer sent once is stopped here, as is
+ * any burst whose transfer failed.
+ *
+ * @param burst Engine state.
+ * @return 1 if a buffer was finished, 0 otherwise.
+ */
+uint8 timer_burst_finish(timer_burst *burst) {
+    uint8 bits = dma_get_isr_bits(burst->dma, burst->stream);
+
+    dma_clear_isr_bits(burst->dma, burst->stream, bits);
+    if (bits & DMA_ISR_TEIF) {
+        timer_burst_stop(burst);
+        return 0;
+    }
+    if (!(bits & DMA_ISR_TCIF)) {
+        return 0;
+    }
+    burst->finished++;
+    if (!burst->buffers[1]) {
+        timer_dma_disable_upd_req(burst->timer);
+        dma_disable(burst->dma, burst->stream);
+        dma_detach_interrupt(burst->dma, burst->stream);
+    }
+    return 1;
+}
+
+#endif
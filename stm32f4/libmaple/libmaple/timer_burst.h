@@ -0,0 +1,130 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file timer_burst.h
+ * @brief Compare value streams written by timer DMA bursts.
+ *
+ * Each update event makes the timer issue a DMA burst through its
+ * DMAR register, which writes the next slot of a buffer into one or
+ * more consecutive CCRx registers.  The channels run in PWM mode 1
+ * with preload, so a value takes effect at the following update: one
+ * buffer row per timer period sets that period's pulse width on every
+ * channel, with no CPU involvement.  That is enough to produce
+ * pulse-width coded serial protocols such as WS2812 or DShot, where
+ * the timer period is one bit time.
+ *
+ * The buffer holds `updates' rows of `channels' slots:
+ *
+ *     slots[update * channels + (channel - first)]
+ *
+ * timer_burst_send() plays one buffer once.  timer_burst_stream()
+ * alternates between two buffers using the DMA's double buffer mode;
+ * the transfer complete interrupt comes each time one is finished,
+ * and timer_burst_idle_buffer() says which one to refill while the
+ * other plays:
+ *
+ *     static uint16 bufs[2][64];
+ *     static timer_burst burst;
+ *
+ *     static void done(void) {
+ *         uint16 *next = timer_burst_idle_buffer(&burst);
+ *         // refill next, or timer_burst_stop() at the end
+ *     }
+ *
+ *     timer_burst_init(&burst, TIMER3, 1, 1);
+ *     timer_burst_stream(&burst, bufs[0], bufs[1], 64, done);
+ *
+ * End every frame with a row of zeros: its channels then stay low
+ * once the DMA stops.  The timer's prescaler and reload, which set the
+ * bit time, are left to the caller.
+ *
+ * STM32F2/F4 only.  Slots are 16 bits, so TIMER2 and TIMER5, whose
+ * 32-bit compare registers cannot take halfword bursts, are not
+ * supported.
+ */
+
+#ifndef _TIMER_BURST_H_
+#define _TIMER_BURST_H_
+
+#include "libmaple_types.h"
+#include "timer.h"
+#include "dma.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifdef STM32F2
+
+/** Burst engine state. */
+typedef struct timer_burst {
+    timer_dev *timer;           /**< Bursting timer */
+    uint8 first;                /**< First channel written, 1 to 4 */
+    uint8 channels;             /**< Channels written per update */
+    dma_dev *dma;               /**< DMA controller serving updates */
+    dma_stream stream;          /**< Stream serving updates */
+    dma_channel request;        /**< Request channel of that stream */
+    uint16 *buffers[2];         /**< Buffers played, second if streaming */
+    volatile uint32 finished;   /**< Buffers played out */
+} timer_burst;
+
+int timer_burst_dma_request(timer_dev *dev, dma_dev **dma,
+                            dma_stream *stream, dma_channel *request);
+int timer_burst_init(timer_burst *burst, timer_dev *dev, uint8 first,
+                     uint8 channels);
+int timer_burst_send(timer_burst *burst, uint16 *slots, uint16 updates,
+                     void (*handler)(void));
+int timer_burst_stream(timer_burst *burst, uint16 *slots0, uint16 *slots1,
+                       uint16 updates, void (*handler)(void));
+void timer_burst_stop(timer_burst *burst);
+uint8 timer_burst_finish(timer_burst *burst);
+
+/**
+ * @brief Whether a burst is still playing.
+ */
+static inline uint8 timer_burst_busy(timer_burst *burst) {
+    return dma_is_stream_enabled(burst->dma, burst->stream) != 0;
+}
+
+/**
+ * @brief While streaming, the buffer DMA is not reading.
+ *
+ * From the transfer complete handler, that is the buffer just played,
+ * which may be refilled until the other one is finished.
+ */
+static inline uint16* timer_burst_idle_buffer(timer_burst *burst) {
+    return burst->buffers[!dma_get_current_target(burst->dma,
+                                                  burst->stream)];
+}
+
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
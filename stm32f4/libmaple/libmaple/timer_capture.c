@@ -0,0 +1,266 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file timer_capture.c
+ * @brief Input capture timestamps streamed into a ring by DMA.
+ */
+
+#include "timer_capture.h"
+
+#ifdef STM32F2
+
+/* CC1..CC4 DMA streams and request channel of each capture timer */
+typedef struct capture_dma {
+    uint8 controller;           /* 1 or 2 */
+    dma_channel request;
+    int8 streams[4];            /* -1: channel has no request */
+} capture_dma;
+
+static const capture_dma tim1_dma = {2, DMA_CH6, {1, 2, 6, 4}};
+static const capture_dma tim2_dma = {1, DMA_CH3, {5, 6, 1, 7}};
+static const capture_dma tim3_dma = {1, DMA_CH5, {4, 5, 7, 2}};
+static const capture_dma tim4_dma = {1, DMA_CH2, {0, 3, 7, -1}};
+static const capture_dma tim5_dma = {1, DMA_CH6, {2, 4, 0, 1}};
+static const capture_dma tim8_dma = {2, DMA_CH7, {2, 3, 4, 7}};
+
+/**
+ * @brief Find the DMA stream serving a timer channel's requests.
+ *
+ * From the reference manual's request mapping tables.  TIMER4's
+ * channel 4 and the basic timers have no capture request.  Several
+ * other peripherals share these streams: TIMER2 channels 1 and 2 use
+ * the DAC's, for instance.
+ *
+ * @param dev Timer device.
+ * @param channel Channel, from 1 to 4.
+ * @param dma Set to the DMA controller.
+ * @param stream Set to the stream.
+ * @param request Set to the stream's request channel.
+ * @return 0 on success, -1 if the channel has no DMA request.
+ */
+int timer_capture_dma_request(timer_dev *dev, uint8 channel, dma_dev **dma,
+                              dma_stream *stream, dma_channel *request) {
+    const capture_dma *map;
+
+    if (dev == TIMER1) {
+        map = &tim1_dma;
+    } else if (dev == TIMER2) {
+        map = &tim2_dma;
+    } else if (dev == TIMER3) {
+        map = &tim3_dma;
+    } else if (dev == TIMER4) {
+        map = &tim4_dma;
+    } else if (dev == TIMER5) {
+        map = &tim5_dma;
+    } else if (dev == TIMER8) {
+        map = &tim8_dma;
+    } else {
+        return -1;
+    }
+    if (channel < 1 || channel > 4 || map->streams[channel - 1] < 0) {
+        return -1;
+    }
+    *dma = map->controller == 1 ? DMA1 : DMA2;
+    *stream = (dma_stream)map->streams[channel - 1];
+    *request = map->request;
+    return 0;
+}
+
+/**
+ * @brief Set up a capture ring.
+ *
+ * Does not touch the hardware; configure the channel with
+ * timer_ic_setup() and then call timer_capture_start().
+ *
+ * @param cap Ring state to initialise.
+ * @param dev Timer device.
+ * @param channel Channel, from 1 to 4.
+ * @param ring Timestamp buffer, 4-byte aligned.
+ * @param length Slots in ring, at least 3.
+ * @return 0 on success, -1 if the channel has no DMA request or the
+ *         ring is too small.
+ */
+int timer_capture_init(timer_capture *cap, timer_dev *dev, uint8 channel,
+                       uint32 *ring, uint16 length) {
+    if (!ring || length < 3 ||
+        timer_capture_dma_request(dev, channel, &cap->dma, &cap->stream,
+                                  &cap->request) < 0) {
+        return -1;
+    }
+    cap->timer = dev;
+    cap->channel = channel;
+    cap->ring = ring;
+    cap->length = length;
+    cap->mask = timer_max_reload(dev);
+    cap->laps = 0;
+    cap->tail = 0;
+    cap->overruns = 0;
+    return 0;
+}
+
+/**
+ * @brief Start streaming captures into the ring.
+ * @param cap Ring state, from timer_capture_init().
+ * @param handler DMA interrupt handler; it must call timer_capture_lap().
+ */
+void timer_capture_start(timer_capture *cap, void (*handler)(void)) {
+    __io uint32 *ccr = &(cap->timer->regs).gen->CCR1 + (cap->channel - 1);
+
+    cap->laps = 0;
+    cap->tail = 0;
+    cap->overruns = 0;
+
+    dma_init(cap->dma);
+    dma_disable(cap->dma, cap->stream);
+    dma_setup_transfer(cap->dma, cap->stream, cap->request,
+                       ccr,       DMA_SIZE_32BITS,
+                       cap->ring, DMA_SIZE_32BITS,
+                       DMA_MINC_MODE | DMA_CIRC_MODE | DMA_TRNS_CMPLT);
+    dma_set_num_transfers(cap->dma, cap->stream, cap->length);
+    dma_set_priority(cap->dma, cap->stream, DMA_PRIORITY_HIGH);
+    dma_attach_interrupt(cap->dma, cap->stream, handler);
+    dma_enable(cap->dma, cap->stream);
+    timer_dma_enable_req(cap->timer, cap->channel);
+}
+
+/**
+ * @brief Stop streaming captures; the ring keeps its contents.
+ * @param cap Ring state.
+ */
+void timer_capture_stop(timer_capture *cap) {
+    timer_dma_disable_req(cap->timer, cap->channel);
+    dma_disable(cap->dma, cap->stream);
+    dma_detach_interrupt(cap->dma, cap->stream);
+}
+
+/* Captures so far, and the slot the next one goes in */
+static uint32 snapshot(timer_capture *cap, uint32 *pos) {
+    dma_stream_reg_map *regs = dma_stream_regs(cap->dma, cap->stream);
+    uint32 laps;
+    uint8 before, after;
+    uint32 left;
+
+    /* A wrap whose interrupt has not run yet shows only as TCIF */
+    do {
+        laps = cap->laps;
+        before = dma_get_isr_bits(cap->dma, cap->stream) & DMA_ISR_TCIF;
+        left = regs->NDTR;
+        after = dma_get_isr_bits(cap->dma, cap->stream) & DMA_ISR_TCIF;
+    } while (laps != cap->laps || before != after);
+
+    if (left == 0 || left > cap->length) {
+        left = cap->length;
+    }
+    *pos = cap->length - left;
+    if (before) {
+        laps++;
+    }
+    return laps * cap->length + *pos;
+}
+
+/**
+ * @brief Number of captures since timer_capture_start().
+ *
+ * Wraps modulo 2^32.  Safe to call from thread mode or from interrupts
+ * of higher priority than the DMA interrupt.
+ */
+uint32 timer_capture_count(timer_capture *cap) {
+    uint32 pos;
+    return snapshot(cap, &pos);
+}
+
+/* Drop captures that have been, or are about to be, overwritten */
+static uint32 catch_up(timer_capture *cap, uint32 count) {
+    uint32 behind = count - cap->tail;
+    if (behind > (uint32)cap->length - 1) {
+        cap->overruns += behind - (cap->length - 1);
+        cap->tail = count - (cap->length - 1);
+        behind = cap->length - 1;
+    }
+    return behind;
+}
+
+/**
+ * @brief Number of captures timer_capture_read() can return.
+ *
+ * At most length - 1: the oldest slot is the one DMA fills next.
+ */
+uint32 timer_capture_available(timer_capture *cap) {
+    uint32 pos;
+    return catch_up(cap, snapshot(cap, &pos));
+}
+
+/**
+ * @brief Read the oldest unread timestamp.
+ *
+ * If the reader fell more than a ring behind, the lost captures are
+ * added to cap->overruns and reading resumes with the oldest one
+ * still in the ring.
+ *
+ * @param cap Ring state.
+ * @param stamp Set to the captured counter value.
+ * @return 0 on success, -1 if there is no new capture.
+ */
+int timer_capture_read(timer_capture *cap, uint32 *stamp) {
+    uint32 pos;
+    uint32 behind = catch_up(cap, snapshot(cap, &pos));
+
+    if (!behind) {
+        return -1;
+    }
+    *stamp = cap->ring[(pos + cap->length - behind) % cap->length];
+    cap->tail++;
+    return 0;
+}
+
+/**
+ * @brief Timer ticks spanned by the newest captures.
+ *
+ * Takes the interval between the newest capture and the one
+ * `intervals' captures before it, modulo the counter range.  Dividing
+ * by intervals gives the average period; only the two endpoints are
+ * read, however fast the edges come.  Does not consume captures.
+ *
+ * @param cap Ring state.
+ * @param intervals Captures to span, from 1 to length - 2.
+ * @return Ticks, or 0 if fewer than intervals + 1 captures were made.
+ */
+uint32 timer_capture_span(timer_capture *cap, uint32 intervals) {
+    uint32 pos;
+    uint32 count = snapshot(cap, &pos);
+    uint32 newest, oldest;
+
+    if (intervals < 1 || intervals > (uint32)cap->length - 2 ||
+        (cap->laps == 0 && count < intervals + 1)) {
+        return 0;
+    }
+    newest = cap->ring[(pos + cap->length - 1) % cap->length];
+    oldest = cap->ring[(pos + cap->length - 1 - intervals) % cap->length];
+    return (newest - oldest) & cap->mask;
+}
+
+#endif
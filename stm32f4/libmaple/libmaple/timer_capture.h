@@ -0,0 +1,115 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file timer_capture.h
+ * @brief Input capture timestamps streamed into a ring by DMA.
+ *
+ * Each capture on a timer channel raises the channel's DMA request,
+ * which copies CCRx into the next slot of a circular buffer.  The
+ * CPU is involved only once per trip round the ring, when the
+ * transfer complete interrupt counts a lap; timer_capture_count()
+ * combines that with the stream's remaining transfer count to number
+ * every capture, so readers can tell new timestamps from old and
+ * notice when they fell more than a ring behind.
+ *
+ *     static uint32 ring[64];
+ *     static timer_capture cap;
+ *
+ *     static void lap(void) {
+ *         timer_capture_lap(&cap);
+ *     }
+ *
+ *     timer_capture_init(&cap, TIMER2, 1, ring, 64);
+ *     timer_ic_setup(TIMER2, 1, TIMER_IC_RISING, TIMER_IC_DIV1, 0);
+ *     timer_capture_start(&cap, lap);
+ *     ...
+ *     uint32 ticks = timer_capture_span(&cap, 32);   // 32 periods
+ *
+ * Timestamps are raw counter values; intervals between them are taken
+ * modulo the timer's reload range, so the timer should count freely
+ * up to timer_max_reload() and an interval must not exceed it.
+ *
+ * STM32F2/F4 only.  Each timer's four channels use one DMA request
+ * channel on fixed streams; see timer_capture_dma_request().
+ */
+
+#ifndef _TIMER_CAPTURE_H_
+#define _TIMER_CAPTURE_H_
+
+#include "libmaple_types.h"
+#include "timer.h"
+#include "dma.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#ifdef STM32F2
+
+/** Capture ring state. */
+typedef struct timer_capture {
+    timer_dev *timer;           /**< Capturing timer */
+    uint8 channel;              /**< Capturing channel, 1 to 4 */
+    dma_dev *dma;               /**< DMA controller serving the channel */
+    dma_stream stream;          /**< Stream serving the channel */
+    dma_channel request;        /**< Request channel of that stream */
+    uint32 *ring;               /**< Timestamps */
+    uint16 length;              /**< Slots in ring */
+    uint32 mask;                /**< Counter range, timer_max_reload() */
+    volatile uint32 laps;       /**< Trips round the ring */
+    uint32 tail;                /**< Captures consumed by reads */
+    uint32 overruns;            /**< Captures lost by falling behind */
+} timer_capture;
+
+int timer_capture_dma_request(timer_dev *dev, uint8 channel, dma_dev **dma,
+                              dma_stream *stream, dma_channel *request);
+int timer_capture_init(timer_capture *cap, timer_dev *dev, uint8 channel,
+                       uint32 *ring, uint16 length);
+void timer_capture_start(timer_capture *cap, void (*handler)(void));
+void timer_capture_stop(timer_capture *cap);
+uint32 timer_capture_count(timer_capture *cap);
+uint32 timer_capture_available(timer_capture *cap);
+int timer_capture_read(timer_capture *cap, uint32 *stamp);
+uint32 timer_capture_span(timer_capture *cap, uint32 intervals);
+
+/**
+ * @brief Count one trip round the ring.
+ *
+ * Call this, and nothing else, from the DMA handler passed to
+ * timer_capture_start().
+ */
+static inline void timer_capture_lap(timer_capture *cap) {
+    cap->laps++;
+}
+
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
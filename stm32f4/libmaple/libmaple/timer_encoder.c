@@ -0,0 +1,157 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file timer_encoder.c
+ * @brief 32-bit quadrature encoder positions from a timer in encoder
+ *        mode, with lock-free reads.
+ */
+
+#include "timer_encoder.h"
+
+/* Counts moved from last to raw */
+static inline int32 travel(timer_encoder *enc, uint32 raw, uint32 last) {
+    if (enc->wide) {
+        return (int32)(raw - last);
+    }
+    return (int16)(raw - last);
+}
+
+/**
+ * @brief Set up position state for an encoder timer.
+ *
+ * The current count becomes position 0.  Call after
+ * timer_encoder_setup().
+ *
+ * @param enc State to initialise.
+ * @param dev Timer in encoder mode.
+ */
+void timer_encoder_init(timer_encoder *enc, timer_dev *dev) {
+    enc->timer = dev;
+    enc->wide = timer_is_32bit(dev);
+    enc->state[0].base = 0;
+    enc->state[0].last = timer_get_count(dev);
+    enc->state[1] = enc->state[0];
+    enc->gen = 0;
+    enc->zero = 0;
+}
+
+/* Compare 3 and 4 fire after TIMER_ENCODER_SYNC_SPAN counts either way */
+static void set_sync_points(timer_encoder *enc, uint32 raw) {
+    timer_set_compare(enc->timer, 3, (raw + TIMER_ENCODER_SYNC_SPAN) & 0xFFFF);
+    timer_set_compare(enc->timer, 4, (raw - TIMER_ENCODER_SYNC_SPAN) & 0xFFFF);
+}
+
+/**
+ * @brief Start the sync interrupts a 16-bit timer needs.
+ *
+ * Puts channels 3 and 4 in frozen output compare mode and attaches
+ * the handler to both.  Does nothing for a 32-bit timer.
+ *
+ * @param enc State, from timer_encoder_init().
+ * @param handler Interrupt handler; it must call timer_encoder_sync().
+ */
+void timer_encoder_start(timer_encoder *enc, voidFuncPtr handler) {
+    if (enc->wide) {
+        return;
+    }
+    timer_oc_set_mode(enc->timer, 3, TIMER_OC_MODE_FROZEN, 0);
+    timer_oc_set_mode(enc->timer, 4, TIMER_OC_MODE_FROZEN, 0);
+    timer_encoder_sync(enc);
+    timer_attach_interrupt(enc->timer, TIMER_CC3_INTERRUPT, handler);
+    timer_attach_interrupt(enc->timer, TIMER_CC4_INTERRUPT, handler);
+}
+
+/**
+ * @brief Stop the sync interrupts.
+ *
+ * Positions read afterwards are only right while the counter stays
+ * within 32767 counts of where it was.
+ */
+void timer_encoder_stop(timer_encoder *enc) {
+    if (enc->wide) {
+        return;
+    }
+    timer_detach_interrupt(enc->timer, TIMER_CC3_INTERRUPT);
+    timer_detach_interrupt(enc->timer, TIMER_CC4_INTERRUPT);
+}
+
+/**
+ * @brief Fold the counter's movement into the base position.
+ *
+ * Call from the sync interrupt handler only; it is the one writer.
+ */
+void timer_encoder_sync(timer_encoder *enc) {
+    uint32 gen = enc->gen;
+    volatile timer_encoder_state *cur = &enc->state[gen & 1];
+    volatile timer_encoder_state *next = &enc->state[(gen + 1) & 1];
+    uint32 raw = timer_get_count(enc->timer);
+
+    next->base = cur->base + travel(enc, raw, cur->last);
+    next->last = raw;
+    enc->gen = gen + 1;
+    if (!enc->wide) {
+        set_sync_points(enc, raw);
+    }
+}
+
+/**
+ * @brief Read the encoder position.
+ *
+ * Lock-free and safe from any context, including interrupts that
+ * preempt the sync handler.
+ *
+ * @param enc Encoder state.
+ * @return Position in counts, wrapping modulo 2^32.
+ */
+int32 timer_encoder_read(timer_encoder *enc) {
+    uint32 gen;
+    int32 base;
+    uint32 last;
+    uint32 raw;
+
+    do {
+        gen = enc->gen;
+        base = enc->state[gen & 1].base;
+        last = enc->state[gen & 1].last;
+        raw = timer_get_count(enc->timer);
+    } while (gen != enc->gen);
+
+    return base + travel(enc, raw, last) - enc->zero;
+}
+
+/**
+ * @brief Set the current position.
+ *
+ * The counter is left alone; later reads are offset to match.  An
+ * index pulse handler can call this with 0.
+ *
+ * @param enc Encoder state.
+ * @param position New position for the current count.
+ */
+void timer_encoder_write(timer_encoder *enc, int32 position) {
+    enc->zero += timer_encoder_read(enc) - position;
+}
@@ -0,0 +1,106 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file timer_encoder.h
+ * @brief 32-bit quadrature encoder positions from a timer in encoder
+ *        mode, with lock-free reads.
+ *
+ * timer_encoder_setup() has the timer count the encoder by itself.
+ * On TIMER2 and TIMER5 of the STM32F2 the counter is already 32 bits
+ * wide; the 16-bit timers need the counts they wrap past added up.
+ *
+ * Instead of counting overflows, whose direction is ambiguous when
+ * the encoder dithers around the wrap point, timer_encoder_sync()
+ * folds the counter's movement since the previous sync into a 32-bit
+ * base position.  Channels 3 and 4 compare at 0x4000 counts either
+ * side of the last sync, so a sync interrupt comes every 16384 counts
+ * of travel at most, however the encoder moves; a reader can tell
+ * the movement since the last sync from the 16-bit counter alone as
+ * long as it is under 32768 counts, so a sync can be late by another
+ * 16383 counts without harm.
+ *
+ * The sync writes the next base into the one of two slots readers
+ * are not using, then publishes it by bumping a generation count.
+ * timer_encoder_read() never waits for the writer: if it interrupts
+ * a sync half way, the slot it reads is still whole.  It only retries
+ * if a sync completed while it was reading.
+ *
+ *     static timer_encoder enc;
+ *
+ *     static void sync(void) {
+ *         timer_encoder_sync(&enc);
+ *     }
+ *
+ *     timer_encoder_setup(TIMER3, TIMER_ENCODER_TI12, 6, 0);
+ *     timer_encoder_init(&enc, TIMER3);
+ *     timer_encoder_start(&enc, sync);
+ *     timer_resume(TIMER3);
+ *     ...
+ *     int32 pos = timer_encoder_read(&enc);
+ */
+
+#ifndef _TIMER_ENCODER_H_
+#define _TIMER_ENCODER_H_
+
+#include "libmaple_types.h"
+#include "timer.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** Largest travel in counts between sync interrupts. */
+#define TIMER_ENCODER_SYNC_SPAN 0x4000
+
+/** Position at one sync. */
+typedef struct timer_encoder_state {
+    int32 base;                 /**< Position at the sync */
+    uint32 last;                /**< Counter at the sync */
+} timer_encoder_state;
+
+/** Encoder position state. */
+typedef struct timer_encoder {
+    timer_dev *timer;           /**< Counting timer */
+    uint8 wide;                 /**< Nonzero for a 32-bit counter */
+    volatile timer_encoder_state state[2]; /**< Current and next sync */
+    volatile uint32 gen;        /**< Syncs published; state[gen & 1]
+                                     is current */
+    volatile int32 zero;        /**< Position reported as 0 */
+} timer_encoder;
+
+void timer_encoder_init(timer_encoder *enc, timer_dev *dev);
+void timer_encoder_start(timer_encoder *enc, voidFuncPtr handler);
+void timer_encoder_stop(timer_encoder *enc);
+void timer_encoder_sync(timer_encoder *enc);
+int32 timer_encoder_read(timer_encoder *enc);
+void timer_encoder_write(timer_encoder *enc, int32 position);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
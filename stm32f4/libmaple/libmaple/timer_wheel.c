@@ -0,0 +1,226 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file timer_wheel.c
+ * @brief Hierarchical timer wheel for large numbers of software timers.
+ */
+
+#include "timer_wheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+/* Slot index of tick at level */
+#define INDEX(tick, level) \
+    (((tick) >> ((level) * TIMER_WHEEL_BITS)) & SLOT_MASK)
+
+static void link(wheel_timer **head, wheel_timer *t) {
+    t->next = *head;
+    if (t->next) {
+        t->next->pprev = &t->next;
+    }
+    t->pprev = head;
+    *head = t;
+}
+
+static void unlink(wheel_timer *t) {
+    *t->pprev = t->next;
+    if (t->next) {
+        t->next->pprev = t->pprev;
+    }
+    t->next = NULL;
+    t->pprev = NULL;
+}
+
+/*
+ * File t by how far away it expires.  A timer due now (from a cascade
+ * at its own tick) goes in the level 0 slot about to be run.
+ */
+static void file(timer_wheel *tw, wheel_timer *t) {
+    uint32 delta = t->expires - tw->now;
+    uint32 expires = t->expires;
+    uint32 level;
+
+    if ((int32)delta < 0) {
+        delta = 0;
+        expires = tw->now;
+    } else if (delta > TIMER_WHEEL_MAX_DELAY) {
+        delta = TIMER_WHEEL_MAX_DELAY;
+        expires = tw->now + TIMER_WHEEL_MAX_DELAY;
+    }
+    for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+        if (delta < 1U << ((level + 1) * TIMER_WHEEL_BITS)) {
+            break;
+        }
+    }
+    link(&tw->slots[level][INDEX(expires, level)], t);
+}
+
+/* Move a slot's timers down to the levels below. */
+static void cascade(timer_wheel *tw, uint32 level, uint32 index) {
+    wheel_timer *t = tw->slots[level][index];
+
+    tw->slots[level][index] = NULL;
+    while (t) {
+        wheel_timer *next = t->next;
+        t->next = NULL;
+        file(tw, t);
+        t = next;
+    }
+}
+
+/**
+ * @brief Initialise a timer wheel with no timers.
+ * @param tw  Wheel to initialise
+ * @param now Tick to start counting from
+ */
+void timer_wheel_init(timer_wheel *tw, uint32 now) {
+    uint32 level;
+    uint32 i;
+
+    tw->now = now;
+    tw->count = 0;
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+            tw->slots[level][i] = NULL;
+        }
+    }
+}
+
+/**
+ * @brief Start a timer, or restart it if it is running.
+ * @param tw     Wheel to run the timer on
+ * @param t      Timer, initialised with wheel_timer_init()
+ * @param delay  Ticks until the first expiry; 0 counts as 1
+ * @param period Ticks between later expiries, or 0 for a one-shot
+ */
+void timer_wheel_start(timer_wheel *tw, wheel_timer *t,
+                       uint32 delay, uint32 period) {
+    if (wheel_timer_active(t)) {
+        unlink(t);
+        tw->count--;
+    }
+    t->expires = tw->now + (delay ? delay : 1);
+    t->period = period;
+    file(tw, t);
+    tw->count++;
+}
+
+/**
+ * @brief Stop a timer.  Stopping a stopped timer does nothing.
+ */
+void timer_wheel_stop(timer_wheel *tw, wheel_timer *t) {
+    if (wheel_timer_active(t)) {
+        unlink(t);
+        tw->count--;
+    }
+}
+
+/**
+ * @brief Move time forward, running the callbacks of expired timers.
+ *
+ * Periodic timers are refiled before their callback runs, so the
+ * callback can stop them; one-shot timers are stopped before theirs,
+ * so it can restart them.
+ *
+ * @param tw    Wheel to advance
+ * @param ticks Number of ticks elapsed
+ */
+void timer_wheel_advance(timer_wheel *tw, uint32 ticks) {
+    while (ticks--) {
+        uint32 index;
+        uint32 level;
+        wheel_timer *work;
+
+        tw->now++;
+        index = tw->now & SLOT_MASK;
+        for (level = 1; index == 0 && level < TIMER_WHEEL_LEVELS; level++) {
+            index = INDEX(tw->now, level);
+            cascade(tw, level, index);
+        }
+
+        /* Detach the slot first: callbacks may start timers into it */
+        index = tw->now & SLOT_MASK;
+        work = tw->slots[0][index];
+        if (!work) {
+            continue;
+        }
+        tw->slots[0][index] = NULL;
+        work->pprev = &work;
+        while (work) {
+            wheel_timer *t = work;
+            unlink(t);
+            if (t->period) {
+                t->expires += t->period;
+                file(tw, t);
+            } else {
+                tw->count--;
+            }
+            t->callback(t->arg);
+        }
+    }
+}
+
+/**
+ * @brief Ticks until the wheel next has work to do.
+ *
+ * timer_wheel_advance() by fewer ticks than this runs no callback,
+ * so a tickless owner can sleep that long.  The result is exact for
+ * timers due in the next TIMER_WHEEL_SLOTS ticks, unless a cascade
+ * that might bring a timer closer comes first.  Past that it is the
+ * next such cascade, so it can be early, and it is never more than
+ * TIMER_WHEEL_SLOTS^2 ticks.
+ *
+ * @return Ticks, at least 1, or TIMER_WHEEL_IDLE if no timer runs.
+ */
+uint32 timer_wheel_next_expiry(timer_wheel *tw) {
+    uint32 now = tw->now;
+    uint32 tick;
+
+    if (!tw->count) {
+        return TIMER_WHEEL_IDLE;
+    }
+
+    /* All of level 0, across its wrap.  A cascade at the wrap may
+     * bring down timers due before those already on level 0. */
+    for (tick = now + 1; tick != now + TIMER_WHEEL_SLOTS; tick++) {
+        if ((tick & SLOT_MASK) == 0 &&
+            (INDEX(tick, 1) == 0 || tw->slots[1][INDEX(tick, 1)])) {
+            return tick - now;
+        }
+        if (tw->slots[0][tick & SLOT_MASK]) {
+            return tick - now;
+        }
+    }
+
+    /* The level 1 slot each later wrap cascades, up to the wrap of
+     * level 1, where the levels above start cascading too */
+    tick = (tick + SLOT_MASK) & ~SLOT_MASK;
+    while (INDEX(tick, 1) != 0 && !tw->slots[1][INDEX(tick, 1)]) {
+        tick += TIMER_WHEEL_SLOTS;
+    }
+    return tick - now;
+}
@@ -0,0 +1,131 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file timer_wheel.h
+ * @brief Hierarchical timer wheel for large numbers of software timers.
+ *
+ * Each level of the wheel is an array of TIMER_WHEEL_SLOTS lists.
+ * Level 0 holds the timers due within the next TIMER_WHEEL_SLOTS
+ * ticks, one slot per tick; each further level covers
+ * TIMER_WHEEL_SLOTS times the span of the one below with the same
+ * number of slots, and is moved ("cascaded") down a slot at a time
+ * as the lower level wraps.  Starting and stopping a timer is O(1);
+ * a tick costs one slot's worth of expiries plus, amortized, a
+ * fraction of a cascade.  Four levels of 64 slots reach 2^24 ticks;
+ * longer timers are parked at the far end and re-filed on the way.
+ *
+ * The wheel knows nothing about where ticks come from: the owner
+ * calls timer_wheel_advance() from the SysTick handler, from a
+ * hardware timer programmed with timer_wheel_next_expiry(), or from
+ * anywhere else.  None of these functions is re-entrant; the owner
+ * must keep them from interrupting each other.  Callbacks run from
+ * inside timer_wheel_advance() and may start or stop any timer.
+ *
+ * wirish's SoftTimer is a ready-made owner driven by SysTick.
+ */
+
+#ifndef _TIMER_WHEEL_H_
+#define _TIMER_WHEEL_H_
+
+#include "libmaple_types.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/** log2 of the number of slots per level. */
+#define TIMER_WHEEL_BITS                6
+/** Slots per level. */
+#define TIMER_WHEEL_SLOTS               (1U << TIMER_WHEEL_BITS)
+/** Number of levels. */
+#define TIMER_WHEEL_LEVELS              4
+/** Longest delay filed directly, in ticks. */
+#define TIMER_WHEEL_MAX_DELAY \
+    ((1U << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+/** timer_wheel_next_expiry() result when no timer is running. */
+#define TIMER_WHEEL_IDLE                0xFFFFFFFF
+
+/** A software timer. Allocated by the user, linked into the wheel. */
+typedef struct wheel_timer {
+    struct wheel_timer *next;   /**< Next timer in the same slot */
+    struct wheel_timer **pprev; /**< Link pointing to us, NULL if stopped */
+    uint32 expires;             /**< Absolute tick to expire at */
+    uint32 period;              /**< Reload in ticks, 0 for one-shot */
+    void (*callback)(void *arg);/**< Called on expiry */
+    void *arg;                  /**< Argument for callback */
+} wheel_timer;
+
+/** Timer wheel. */
+typedef struct timer_wheel {
+    uint32 now;                 /**< Ticks advanced so far */
+    uint32 count;               /**< Timers running */
+    wheel_timer *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+} timer_wheel;
+
+void timer_wheel_init(timer_wheel *tw, uint32 now);
+void timer_wheel_start(timer_wheel *tw, wheel_timer *t,
+                       uint32 delay, uint32 period);
+void timer_wheel_stop(timer_wheel *tw, wheel_timer *t);
+void timer_wheel_advance(timer_wheel *tw, uint32 ticks);
+uint32 timer_wheel_next_expiry(timer_wheel *tw);
+
+/**
+ * @brief Set up a timer before its first start.
+ * @param t        Timer to initialise
+ * @param callback Function called when the timer expires
+ * @param arg      Argument passed to callback
+ */
+static inline void wheel_timer_init(wheel_timer *t,
+                                    void (*callback)(void *arg),
+                                    void *arg) {
+    t->next = NULL;
+    t->pprev = NULL;
+    t->expires = 0;
+    t->period = 0;
+    t->callback = callback;
+    t->arg = arg;
+}
+
+/**
+ * @brief Whether a timer is running.
+ *
+ * A one-shot timer stops just before its callback runs.
+ */
+static inline int wheel_timer_active(const wheel_timer *t) {
+    return t->pprev != NULL;
+}
+
+/** @brief The wheel's current tick. */
+static inline uint32 timer_wheel_now(const timer_wheel *tw) {
+    return tw->now;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
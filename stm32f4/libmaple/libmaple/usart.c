@@ -46,7 +46,7 @@ static usart_dev usart1 = {
     .irq_num  = NVIC_USART1
 };
 /** USART1 device */
-usart_dev *USART1 = &usart1;
+usart_dev* const USART1 = &usart1;
 
 static ring_buffer usart2_rb;
 static usart_dev usart2 = {
@@ -57,7 +57,7 @@ static usart_dev usart2 = {
     .irq_num  = NVIC_USART2
 };
 /** USART2 device */
-usart_dev *USART2 = &usart2;
+usart_dev* const USART2 = &usart2;
 
 static ring_buffer usart3_rb;
 static usart_dev usart3 = {
@@ -68,7 +68,7 @@ static usart_dev usart3 = {
     .irq_num  = NVIC_USART3
 };
 /** USART3 device */
-usart_dev *USART3 = &usart3;
+usart_dev* const USART3 = &usart3;
 
 #ifdef STM32_HIGH_DENSITY
 static ring_buffer uart4_rb;
@@ -80,7 +80,7 @@ static usart_dev uart4 = {
     .irq_num  = NVIC_UART4
 };
 /** UART4 device */
-usart_dev *UART4 = &uart4;
+usart_dev* const UART4 = &uart4;
 
 static ring_buffer uart5_rb;
 static usart_dev uart5 = {
@@ -91,7 +91,7 @@ static usart_dev uart5 = {
     .irq_num  = NVIC_UART5
 };
 /** UART5 device */
-usart_dev *UART5 = &uart5;
+usart_dev* const UART5 = &uart5;
 #endif
 
 /**
@@ -185,12 +185,7 @@ void usart_foreach(void (*fn)(usart_dev*)) {
  * @return Number of bytes transmitted
  */
 uint32 usart_tx(usart_dev *dev, const uint8 *buf, uint32 len) {
-    usart_reg_map *regs = dev->regs;
-    uint32 txed = 0;
-    while ((regs->SR & USART_SR_TXE) && (txed < len)) {
-        regs->DR = buf[txed++];
-    }
-    return txed;
+    return usart_regs_tx(dev->regs, buf, len);
 }
 
 /**
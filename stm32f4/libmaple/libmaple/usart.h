@@ -249,12 +249,12 @@ typedef struct usart_dev {
     nvic_irq_num irq_num;            /**< USART NVIC interrupt */
 } usart_dev;
 
-extern usart_dev *USART1;
-extern usart_dev *USART2;
-extern usart_dev *USART3;
+extern usart_dev* const USART1;
+extern usart_dev* const USART2;
+extern usart_dev* const USART3;
 #ifdef STM32_HIGH_DENSITY
-extern usart_dev *UART4;
-extern usart_dev *UART5;
+extern usart_dev* const UART4;
+extern usart_dev* const UART5;
 #endif
 
 void usart_init(usart_dev *dev);
@@ -265,6 +265,37 @@ void usart_foreach(void (*fn)(usart_dev *dev));
 uint32 usart_tx(usart_dev *dev, const uint8 *buf, uint32 len);
 void usart_putudec(usart_dev *dev, uint32 val);
 
+/*
+ * Register-level access.  These take a register map instead of a
+ * usart_dev; given a constant one (USART1_BASE, ...), they inline to
+ * plain loads and stores at fixed addresses.
+ */
+
+/**
+ * @brief Nonblocking transmit on the USART at regs.
+ * @see usart_tx()
+ */
+static inline uint32 usart_regs_tx(usart_reg_map *regs,
+                                   const uint8 *buf,
+                                   uint32 len) {
+    uint32 txed = 0;
+    while ((regs->SR & USART_SR_TXE) && (txed < len)) {
+        regs->DR = buf[txed++];
+    }
+    return txed;
+}
+
+/**
+ * @brief Transmit one character on the USART at regs, waiting for
+ *        room in the transmit register first.
+ * @see usart_putc()
+ */
+static inline void usart_regs_putc(usart_reg_map *regs, uint8 byte) {
+    while (!(regs->SR & USART_SR_TXE))
+        ;
+    regs->DR = byte;
+}
+
 /**
  * @brief Disable all serial ports.
  */
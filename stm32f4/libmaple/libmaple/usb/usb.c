@@ -36,6 +36,7 @@
 #include "gpio.h"
 #include "usb_hardware.h"
 #include "delay.h"
+#include "boot_trace.h"
 
 #include "usb_config.h"
 #include "usb_callbacks.h"
@@ -350,6 +351,7 @@ if (wIstr & ISTR_CTR & wInterrupt_Mask) {
 
 void usbWaitReset(void) {
   delay_us(RESET_DELAY);
+  boot_request_dfu();
   systemHardReset();
 }
 
@@ -83,6 +83,11 @@ uint8 usbIsConnected(void);
 uint8 usbIsConfigured(void);
 uint16 usbGetPending(void);
 
+/* hooks called from the USB ISR once an IN (tx) transfer has completed
+   or an OUT (rx) packet has been queued; pass NULL to detach */
+void usbAttachTxCallback(voidFuncPtr fn);
+void usbAttachRxCallback(voidFuncPtr fn);
+
 void usbSendHello(void);
 
 #ifdef __cplusplus
@@ -41,6 +41,17 @@ volatile uint32 newBytes = 0;
 RESET_STATE reset_state = DTR_UNSET;
 uint8       line_dtr_rts = 0;
 
+static volatile voidFuncPtr vcomTxHook = NULL;
+static volatile voidFuncPtr vcomRxHook = NULL;
+
+void usbAttachTxCallback(voidFuncPtr fn) {
+    vcomTxHook = fn;
+}
+
+void usbAttachRxCallback(voidFuncPtr fn) {
+    vcomRxHook = fn;
+}
+
 void vcomDataTxCb(void) {
     /* do whatever after data has been sent to host */
 
@@ -48,6 +59,10 @@ void vcomDataTxCb(void) {
 
     /* assumes tx transactions are atomic 64 bytes (nearly certain they are) */
     countTx = 0;
+
+    if (vcomTxHook) {
+        vcomTxHook();
+    }
 }
 
 /* we could get arbitrarily complicated here for speed purposes
@@ -115,6 +130,10 @@ void vcomDataRxCb(void) {
   }
 
   PMAToUserBufferCopy(&vcomBufferRx[0],VCOM_RX_ADDR,newBytes);
+
+  if (vcomRxHook) {
+      vcomRxHook();
+  }
 }
 
 void vcomManagementCb(void) {
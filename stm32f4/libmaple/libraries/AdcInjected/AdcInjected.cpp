@@ -0,0 +1,279 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file AdcInjected.cpp
+ * @brief Injected ADC conversions synchronised to an advanced timer's
+ *        PWM.
+ */
+
+#include "AdcInjected.h"
+
+#ifdef STM32F2
+
+#include "boards.h"
+#include "io.h"
+#include "rcc.h"
+
+/* One per ADC: ADC1, ADC2, ADC3 */
+static AdcInjected *activeInjected[3];
+
+static void inj1Isr(const int16 *results, uint8 count) {
+    activeInjected[0]->handle(results, count);
+}
+
+static void inj2Isr(const int16 *results, uint8 count) {
+    activeInjected[1]->handle(results, count);
+}
+
+static void inj3Isr(const int16 *results, uint8 count) {
+    activeInjected[2]->handle(results, count);
+}
+
+static const adc_inj_handler injIsrs[3] = {inj1Isr, inj2Isr, inj3Isr};
+
+static int adcIndex(const adc_dev *dev) {
+    if (dev == ADC1) {
+        return 0;
+    } else if (dev == ADC2) {
+        return 1;
+    }
+    return 2;
+}
+
+AdcInjected::AdcInjected(const adc_dev *dev) {
+    this->dev = dev;
+    this->timer = NULL;
+    this->trigger = ADC_INJ_CC4;
+    this->handler = NULL;
+    this->nrChannels = 0;
+    this->smpSet = false;
+    this->smp = ADC_SMPR_15;
+    this->cyclesPerTickQ8 = 256;
+    for (uint8 i = 0; i < 4; i++) {
+        this->offsets[i] = 0;
+    }
+    this->resetStats();
+}
+
+bool AdcInjected::setPins(const uint8 *pins, uint8 count) {
+    uint8 channels[4];
+    uint8 i;
+
+    if (count > 4) {
+        return false;
+    }
+    for (i = 0; i < count; i++) {
+        if (pins[i] >= BOARD_NR_GPIO_PINS ||
+            PIN_MAP[pins[i]].adc_device != dev) {
+            return false;
+        }
+        channels[i] = PIN_MAP[pins[i]].adc_channel;
+    }
+    for (i = 0; i < count; i++) {
+        pinMode(pins[i], INPUT_ANALOG);
+    }
+    return this->setChannels(channels, count);
+}
+
+bool AdcInjected::setChannels(const uint8 *channels, uint8 count) {
+    if (count == 0 || count > 4) {
+        return false;
+    }
+    for (uint8 i = 0; i < count; i++) {
+        this->channels[i] = channels[i];
+    }
+    nrChannels = count;
+    return true;
+}
+
+void AdcInjected::setOffset(uint8 rank, uint16 offset) {
+    if (rank < 1 || rank > 4) {
+        return;
+    }
+    offsets[rank - 1] = offset;
+    if (timer) {
+        adc_set_inj_offset(dev, rank, offset);
+    }
+}
+
+void AdcInjected::setSampleTime(adc_smp_rate smp) {
+    this->smp = smp;
+    this->smpSet = true;
+    if (timer) {
+        adc_set_sample_rate(dev, smp);
+    }
+}
+
+bool AdcInjected::begin(timer_dev *timer, AdcInjectedTrigger trigger) {
+    adc_jextsel_event event;
+    int index = adcIndex(dev);
+
+    if (timer == TIMER1) {
+        event = trigger == ADC_INJ_CC4 ? ADC_JEXT_TIM1_CC4
+                                       : ADC_JEXT_TIM1_TRGO;
+    } else if (timer == TIMER8 && trigger == ADC_INJ_CC4) {
+        event = ADC_JEXT_TIM8_CC4;
+    } else {
+        return false;
+    }
+    if (!nrChannels) {
+        return false;
+    }
+    if (activeInjected[index] && activeInjected[index] != this) {
+        activeInjected[index]->end();
+    }
+    this->end();
+    this->timer = timer;
+    this->trigger = trigger;
+    activeInjected[index] = this;
+    boardEnsureADC(dev);
+
+    adc_set_inj_trigger(dev, event, ADC_JEXTEN_NONE);
+    if (smpSet) {
+        adc_set_sample_rate(dev, smp);
+    }
+    adc_set_inj_sequence(dev, channels, nrChannels);
+    for (uint8 i = 0; i < 4; i++) {
+        adc_set_inj_offset(dev, i + 1, offsets[i]);
+    }
+    adc_inj_attach_interrupt(dev, injIsrs[index]);
+
+    cyclesPerTickQ8 = (uint32)((uint64)CYCLES_PER_MICROSECOND * 1000000 * 256 /
+                               rcc_dev_timer_clk_speed(timer->clk_id));
+    if (trigger == ADC_INJ_CC4) {
+        timer_oc_set_mode(timer, 4, TIMER_OC_MODE_PWM_2, TIMER_OC_PE);
+        timer_cc_enable(timer, 4);
+    } else {
+        timer_set_master_mode(timer, TIMER_CR2_MMS_UPDATE);
+    }
+    this->resetStats();
+    adc_set_inj_trigger(dev, event, ADC_JEXTEN_RISING);
+    return true;
+}
+
+void AdcInjected::setSamplePoint(uint16 compare) {
+    if (timer) {
+        timer_set_compare(timer, 4, compare);
+    }
+}
+
+void AdcInjected::end(void) {
+    int index = adcIndex(dev);
+
+    if (activeInjected[index] != this) {
+        return;
+    }
+    adc_set_inj_trigger(dev, ADC_JEXT_TIM1_CC4, ADC_JEXTEN_NONE);
+    adc_inj_detach_interrupt(dev);
+    if (trigger == ADC_INJ_CC4) {
+        timer_cc_disable(timer, 4);
+    } else {
+        timer_set_master_mode(timer, TIMER_CR2_MMS_RESET);
+    }
+    activeInjected[index] = NULL;
+    timer = NULL;
+}
+
+/*
+ * Timer ticks since the trigger edge.  The ADC triggers on the rising
+ * edge of OC4REF, which PWM mode 2 raises at the compare match while
+ * counting up, or on the TRGO pulse at each update: the overflow when
+ * edge-aligned, or both the overflow and the underflow when
+ * center-aligned.
+ */
+uint32 AdcInjected::ticksSinceTrigger(void) const {
+    timer_adv_reg_map *regs = timer->regs.adv;
+    uint32 cr1 = regs->CR1;
+    uint32 cnt = regs->CNT;
+    uint32 arr = regs->ARR;
+    bool down = cr1 & TIMER_CR1_DIR;
+
+    if (trigger == ADC_INJ_TRGO) {
+        return down ? arr - cnt : cnt;
+    }
+    uint32 ccr = regs->CCR4;
+    if (!(cr1 & TIMER_CR1_CKD_CMS)) {
+        return cnt >= ccr ? cnt - ccr : cnt + arr + 1 - ccr;
+    }
+    if (down) {
+        return 2 * arr - ccr - cnt;
+    }
+    return cnt >= ccr ? cnt - ccr : 2 * arr - ccr + cnt;
+}
+
+void AdcInjected::handle(const int16 *results, uint8 count) {
+    uint32 ticks = this->ticksSinceTrigger() * (timer->regs.adv->PSC + 1);
+    uint32 cycles = (uint32)(((uint64)ticks * cyclesPerTickQ8) >> 8);
+
+    lastCycles = cycles;
+    if (cycles < minCycles) {
+        minCycles = cycles;
+    }
+    if (cycles > maxCycles) {
+        maxCycles = cycles;
+    }
+    sumCycles += cycles;
+    conversions++;
+    if (handler) {
+        handler(results, count);
+    }
+}
+
+uint32 AdcInjected::toNanos(uint32 cycles) {
+    return (uint32)((uint64)cycles * 1000 / CYCLES_PER_MICROSECOND);
+}
+
+uint32 AdcInjected::getMeanLatency(void) const {
+    if (conversions == 0) {
+        return 0;
+    }
+    return toNanos((uint32)(sumCycles / conversions));
+}
+
+void AdcInjected::resetStats(void) {
+    conversions = 0;
+    lastCycles = 0;
+    minCycles = 0xFFFFFFFF;
+    maxCycles = 0;
+    sumCycles = 0;
+}
+
+void AdcInjected::printStats(Print &out) const {
+    out.print("adcinj conversions=");
+    out.print(conversions);
+    out.print(" latency_ns=");
+    out.print(conversions ? this->getMinLatency() : 0);
+    out.print('/');
+    out.print(this->getMeanLatency());
+    out.print('/');
+    out.print(this->getMaxLatency());
+    out.print(" last=");
+    out.print(this->getLastLatency());
+    out.println();
+}
+
+#endif
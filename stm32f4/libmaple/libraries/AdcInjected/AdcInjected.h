@@ -0,0 +1,202 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file AdcInjected.h
+ * @brief Injected ADC conversions synchronised to an advanced timer's
+ *        PWM, for current sensing.
+ *
+ * TIMER1 or TIMER8 starts the ADC's injected sequence at a fixed
+ * point of every PWM period: channel 4's compare (CC4), or the update
+ * event (TRGO, TIMER1 only).  The hardware subtracts a per-channel
+ * offset, and the ADC interrupt hands all up to four signed results to
+ * the handler at once.  No analogRead() in the PWM interrupt, and the
+ * sampling point is set in timer ticks, e.g. at the centre of a
+ * center-aligned period where the phase currents are steady.
+ *
+ *     AdcInjected currents(ADC1);
+ *
+ *     void gotCurrents(const int16 *i, uint8 count) {
+ *         // i[0], i[1]: phase A and B, zero at 2048
+ *     }
+ *
+ *     void setup() {
+ *         static const uint8 pins[] = {1, 2};
+ *         // ... TIMER1 PWM set up and running ...
+ *         currents.setPins(pins, 2);
+ *         currents.setOffset(1, 2048);
+ *         currents.setOffset(2, 2048);
+ *         currents.attachInterrupt(gotCurrents);
+ *         currents.begin(TIMER1, ADC_INJ_CC4);
+ *         currents.setSamplePoint(timer_get_reload(TIMER1) - 1);
+ *     }
+ *
+ * Injected conversions interrupt regular ones, so AdcScan or
+ * analogRead() can use the same ADC meanwhile.
+ *
+ * Every conversion's latency, from the trigger edge to the handler
+ * call, is measured from the timer's own count and kept as statistics.
+ *
+ * STM32F2/F4 only.
+ */
+
+#ifndef _ADC_INJECTED_H_
+#define _ADC_INJECTED_H_
+
+#include "libmaple_types.h"
+#include "adc.h"
+#include "timer.h"
+#include "Print.h"
+
+#ifdef MAPLE_IDE
+#include "wirish.h"             /* hack for IDE compile */
+#endif
+
+/**
+ * @brief Results handler.
+ * @param results One per channel, in sequence order, less the
+ *                channel's offset.
+ * @param count Number of channels, 1 to 4.
+ */
+typedef void (*AdcInjectedHandler)(const int16 *results, uint8 count);
+
+/** Where in the PWM period the sequence starts. */
+enum AdcInjectedTrigger {
+    ADC_INJ_CC4,                /**< Channel 4 compare, counting up */
+    ADC_INJ_TRGO                /**< Update event; TIMER1 only */
+};
+
+class AdcInjected {
+public:
+    AdcInjected(const adc_dev *dev);
+
+    /**
+     * @brief Convert these pins, in this order.
+     *
+     * Sets them to INPUT_ANALOG.
+     *
+     * @return false if a pin has no channel on this ADC, or more than
+     *         4 were given.
+     */
+    bool setPins(const uint8 *pins, uint8 count);
+
+    /** Convert these ADC channels, in this order. */
+    bool setChannels(const uint8 *channels, uint8 count);
+
+    /**
+     * @brief Offset the hardware subtracts from a channel's results.
+     * @param rank Position in the sequence, from 1 to 4.
+     * @param offset 0 to 4095.
+     */
+    void setOffset(uint8 rank, uint16 offset);
+
+    /**
+     * @brief Sample time, for all the ADC's channels.
+     *
+     * Left as it is unless set, since it applies to regular
+     * conversions too.
+     */
+    void setSampleTime(adc_smp_rate smp);
+
+    /** Set the function called with each sequence's results. */
+    void attachInterrupt(AdcInjectedHandler handler) {
+        this->handler = handler;
+    }
+
+    /**
+     * @brief Start converting on the timer's trigger.
+     *
+     * The timer keeps its period and PWM outputs; with ADC_INJ_CC4,
+     * channel 4 is set to PWM mode 2, whose rising edge is the
+     * compare match while counting up, and with ADC_INJ_TRGO the
+     * timer's master mode is set to update.
+     *
+     * @param timer TIMER1 or TIMER8.
+     * @param trigger Trigger point.
+     * @return false if the timer cannot trigger injected conversions
+     *         that way, or no channels were set.
+     */
+    bool begin(timer_dev *timer, AdcInjectedTrigger trigger);
+
+    /**
+     * @brief Set the CC4 sampling point.
+     * @param compare Timer count at which to sample.
+     */
+    void setSamplePoint(uint16 compare);
+
+    /** Stop converting; the timer is left running. */
+    void end(void);
+
+    /** Sequences converted since begin() or resetStats(). */
+    uint32 getConversions(void) const { return conversions; }
+
+    /** Latency of the last sequence, trigger edge to handler, in ns. */
+    uint32 getLastLatency(void) const { return toNanos(lastCycles); }
+
+    /** Shortest latency seen, in ns. */
+    uint32 getMinLatency(void) const { return toNanos(minCycles); }
+
+    /** Longest latency seen, in ns. */
+    uint32 getMaxLatency(void) const { return toNanos(maxCycles); }
+
+    /** Mean latency, in ns. */
+    uint32 getMeanLatency(void) const;
+
+    void resetStats(void);
+
+    /**
+     * @brief Print the statistics on one line:
+     *
+     *     adcinj conversions=N latency_ns=min/mean/max last=N
+     */
+    void printStats(Print &out) const;
+
+    /** Call from the ADC interrupt; public only for the ISR. */
+    void handle(const int16 *results, uint8 count);
+
+private:
+    const adc_dev *dev;
+    timer_dev *timer;
+    AdcInjectedTrigger trigger;
+    AdcInjectedHandler handler;
+    uint8 channels[4];
+    uint16 offsets[4];
+    uint8 nrChannels;
+    bool smpSet;
+    adc_smp_rate smp;
+    uint32 cyclesPerTickQ8;     /* CPU cycles per timer clock, << 8 */
+
+    volatile uint32 conversions;
+    volatile uint32 lastCycles;
+    volatile uint32 minCycles;
+    volatile uint32 maxCycles;
+    volatile uint64 sumCycles;
+
+    uint32 ticksSinceTrigger(void) const;
+    static uint32 toNanos(uint32 cycles);
+};
+
+#endif
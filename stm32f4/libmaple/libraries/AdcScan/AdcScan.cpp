@@ -0,0 +1,401 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file AdcScan.cpp
+ * @brief Continuous, timer-triggered ADC acquisition through DMA.
+ */
+
+#include "AdcScan.h"
+
+#ifdef STM32F2
+
+#include "boards.h"
+#include "io.h"
+#include "dma.h"
+#include "dwt.h"
+#include "rcc.h"
+#include "systick.h"
+
+/* One scan per ADC, indexed like the tables below */
+static AdcScan *activeScans[3];
+
+/* DMA2 stream and request channel for ADC1, ADC2 and ADC3 */
+static const dma_stream scanStreams[3] = {
+    DMA_STREAM0, DMA_STREAM2, DMA_STREAM1
+};
+static const dma_channel scanRequests[3] = {
+    DMA_CH0, DMA_CH1, DMA_CH2
+};
+
+static void scan1Isr(void) {
+    activeScans[0]->handle();
+}
+
+static void scan2Isr(void) {
+    activeScans[1]->handle();
+}
+
+static void scan3Isr(void) {
+    activeScans[2]->handle();
+}
+
+static void (* const scanIsrs[3])(void) = {scan1Isr, scan2Isr, scan3Isr};
+
+/* The ADC trigger for a timer's TRGO, or false if it has none */
+static bool timerTrigger(timer_dev *timer, adc_extsel_event *trigger) {
+    if (timer == TIMER2) {
+        *trigger = ADC_EXT_TIM2_TRGO;
+    } else if (timer == TIMER3) {
+        *trigger = ADC_EXT_TIM3_TRGO;
+    } else if (timer == TIMER8) {
+        *trigger = ADC_EXT_TIM8_TRGO;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static int adcIndex(const adc_dev *dev) {
+    if (dev == ADC1) {
+        return 0;
+    } else if (dev == ADC2) {
+        return 1;
+    }
+    return 2;
+}
+
+AdcScan::AdcScan(const adc_dev *dev) {
+    this->dev = dev;
+    this->timer = NULL;
+    this->handler = NULL;
+    this->buffer = NULL;
+    this->length = 0;
+    this->scanRate = 0;
+    this->smp = ADC_SMPR_15;
+    this->nrChannels = 0;
+    this->stream = scanStreams[adcIndex(dev)];
+    this->request = scanRequests[adcIndex(dev)];
+    this->multi = false;
+    this->unit = 1;
+    this->packing = 1;
+    this->scanSamples = 0;
+    this->resetStats();
+}
+
+bool AdcScan::setPins(const uint8 *pins, uint8 count) {
+    uint8 channels[16];
+    uint8 i;
+
+    if (count > 16) {
+        return false;
+    }
+    for (i = 0; i < count; i++) {
+        if (pins[i] >= BOARD_NR_GPIO_PINS ||
+            PIN_MAP[pins[i]].adc_device != dev) {
+            return false;
+        }
+        channels[i] = PIN_MAP[pins[i]].adc_channel;
+    }
+    for (i = 0; i < count; i++) {
+        pinMode(pins[i], INPUT_ANALOG);
+    }
+    return this->setChannels(channels, count);
+}
+
+bool AdcScan::setChannels(const uint8 *channels, uint8 count) {
+    if (count == 0 || count > 16) {
+        return false;
+    }
+    for (uint8 i = 0; i < count; i++) {
+        this->channels[i] = channels[i];
+    }
+    nrChannels = count;
+    return true;
+}
+
+void AdcScan::setBuffer(uint16 *buffer, uint32 length) {
+    this->buffer = buffer;
+    this->length = length;
+}
+
+bool AdcScan::begin(timer_dev *timer, uint32 scanRate) {
+    adc_extsel_event trigger;
+    int index = adcIndex(dev);
+
+    if (!timerTrigger(timer, &trigger)) {
+        return false;
+    }
+    if (!nrChannels || !buffer || !scanRate || length > 0xFFFF ||
+        length == 0 || length % (2 * nrChannels)) {
+        return false;
+    }
+    if (activeScans[index] && activeScans[index] != this) {
+        activeScans[index]->end();
+    }
+    this->end();
+    this->timer = timer;
+    this->multi = false;
+    this->unit = 1;
+    this->packing = 1;
+    this->scanSamples = nrChannels;
+    activeScans[index] = this;
+    boardEnsureADC(dev);
+
+    /* The stream first, so that it is ready for the first request */
+    this->startDma(&dev->regs->DR, DMA_SIZE_16BITS);
+
+    adc_set_reg_sequence(dev, channels, nrChannels);
+    adc_set_sample_rate(dev, smp);
+    adc_set_scan(dev, 1);
+    dev->regs->SR = 0;
+    adc_set_dma(dev, 1);
+    adc_set_extsel(dev, trigger);
+    adc_set_exttrig(dev, 1);
+
+    this->startTimer(timer, scanRate);
+    return true;
+}
+
+bool AdcScan::beginMulti(const adc_multi_config *cfg, timer_dev *timer,
+                         uint32 scanRate) {
+    adc_extsel_event trigger = ADC_SWSTART;
+    uint8 n = adc_multi_nr_adcs(cfg->mode);
+    uint8 unit = cfg->dma == ADC_MULTI_DMA_MODE2 ? 2 : 1;
+    uint8 packing = cfg->dma == ADC_MULTI_DMA_MODE3 ? 2 : 1;
+    uint32 round = n * cfg->length;
+
+    if (dev != ADC1 || n < 2 || cfg->dma == ADC_MULTI_DMA_NONE ||
+        adc_multi_check(cfg) != ADC_MULTI_OK) {
+        return false;
+    }
+    if (timer ? (cfg->continuous || !scanRate ||
+                 !timerTrigger(timer, &trigger))
+              : !cfg->continuous) {
+        return false;
+    }
+    /* Each half holds whole rounds and whole DMA transfers */
+    if (!buffer || length == 0 || length > 0xFFFF ||
+        length % (2 * unit) || (length * packing) % (2 * round) ||
+        ((uint32)buffer & (2 * unit - 1))) {
+        return false;
+    }
+    if (activeScans[0] && activeScans[0] != this) {
+        activeScans[0]->end();
+    }
+    this->end();
+    this->timer = timer;
+    this->multi = true;
+    this->unit = unit;
+    this->packing = packing;
+    this->scanSamples = (uint8)round;
+    activeScans[0] = this;
+    boardEnsureADC(ADC1);
+    boardEnsureADC(ADC2);
+    if (n == 3) {
+        boardEnsureADC(ADC3);
+    }
+
+    this->startDma(ADC_CDR_ADDRESS,
+                   unit == 2 ? DMA_SIZE_32BITS : DMA_SIZE_16BITS);
+    adc_multi_setup(cfg);
+
+    /* The slaves follow ADC1's trigger */
+    if (timer) {
+        adc_set_extsel(ADC1, trigger);
+        adc_set_exttrig(ADC1, 1);
+        this->startTimer(timer, scanRate);
+    } else {
+        uint32 adcClock = STM32_PCLK2 / (2 + 2 * (cfg->prescaler >> 16));
+        this->scanRate = adc_multi_rate(cfg, adcClock) / round;
+        this->resetStats();
+        ADC1->regs->CR2 |= ADC_CR2_SWSTART;
+    }
+    return true;
+}
+
+void AdcScan::startDma(volatile void *src, dma_xfer_size size) {
+    dma_init(DMA2);
+    dma_setup_transfer(DMA2, (dma_stream)stream, (dma_channel)request,
+                       src,    size,
+                       buffer, size,
+                       (DMA_MINC_MODE | DMA_CIRC_MODE | DMA_HALF_TRNS |
+                        DMA_TRNS_CMPLT | DMA_TRNS_ERR));
+    dma_set_num_transfers(DMA2, (dma_stream)stream, (uint16)(length / unit));
+    dma_set_priority(DMA2, (dma_stream)stream, DMA_PRIORITY_HIGH);
+    dma_attach_interrupt(DMA2, (dma_stream)stream,
+                         scanIsrs[adcIndex(dev)]);
+    dma_enable(DMA2, (dma_stream)stream);
+}
+
+void AdcScan::startTimer(timer_dev *timer, uint32 scanRate) {
+    /* Period as close to the rate as prescaler and reload allow */
+    uint32 ticks = rcc_dev_timer_clk_speed(timer->clk_id) / scanRate;
+    uint32 prescaler = ticks / 0x10000 + 1;
+    uint32 reload = (ticks + prescaler / 2) / prescaler;
+    if (reload < 2) {
+        reload = 2;
+    }
+    this->scanRate =
+        rcc_dev_timer_clk_speed(timer->clk_id) / (prescaler * reload);
+
+    timer_pause(timer);
+    timer_set_prescaler(timer, (uint16)(prescaler - 1));
+    timer_set_reload(timer, (uint16)(reload - 1));
+    timer_set_master_mode(timer, TIMER_CR2_MMS_UPDATE);
+    timer_generate_update(timer);
+    this->resetStats();
+    timer_resume(timer);
+}
+
+void AdcScan::end(void) {
+    if (activeScans[adcIndex(dev)] != this) {
+        return;
+    }
+    if (timer) {
+        timer_pause(timer);
+        timer_set_master_mode(timer, TIMER_CR2_MMS_RESET);
+    }
+
+    if (multi) {
+        adc_multi_stop();
+    } else {
+        adc_set_exttrig(dev, 0);
+        adc_set_extsel(dev, ADC_SWSTART);
+        adc_set_dma(dev, 0);
+        adc_set_scan(dev, 0);
+        adc_set_reg_seqlen(dev, 1);
+    }
+
+    dma_disable(DMA2, (dma_stream)stream);
+    dma_detach_interrupt(DMA2, (dma_stream)stream);
+
+    /* A conversion may have finished since; analogRead() waits for
+     * EOC, so don't leave it set */
+    (void)dev->regs->DR;
+    dev->regs->SR = 0;
+
+    activeScans[adcIndex(dev)] = NULL;
+    timer = NULL;
+}
+
+void AdcScan::handle(void) {
+    uint32 start = dwt_cycles();
+    uint8 bits = dma_get_isr_bits(DMA2, (dma_stream)stream);
+    uint32 half = length / 2;
+
+    dma_clear_isr_bits(DMA2, (dma_stream)stream, bits);
+    if (!(bits & (DMA_ISR_HTIF | DMA_ISR_TCIF))) {
+        return;
+    }
+    if ((bits & DMA_ISR_HTIF) && (bits & DMA_ISR_TCIF)) {
+        /* Both halves finished since the last interrupt */
+        dropped++;
+    }
+
+    /* The half the DMA is not writing is the one just completed */
+    uint32 pos = length - dma_get_count(DMA2, (dma_stream)stream) * unit;
+    uint16 *done = pos >= half ? buffer : buffer + half;
+    if (handler) {
+        handler(done, half);
+    }
+    buffers++;
+
+    /* Did the DMA come round into the completed half meanwhile? */
+    uint32 now = length - dma_get_count(DMA2, (dma_stream)stream) * unit;
+    if ((now >= half) != (pos >= half)) {
+        dropped++;
+    }
+    isrCycles += dwt_cycles() - start;
+}
+
+uint32 AdcScan::getMeasuredRate(void) const {
+    uint32 ms = systick_uptime() - statsMillis;
+    if (ms == 0 || scanSamples == 0) {
+        return 0;
+    }
+    uint64 scans = (uint64)buffers * (length / 2) * packing / scanSamples;
+    return (uint32)(scans * 1000 / ms);
+}
+
+uint32 AdcScan::getCyclesPerSample(void) const {
+    uint64 samples = (uint64)buffers * (length / 2) * packing;
+    if (samples == 0) {
+        return 0;
+    }
+    return (uint32)(isrCycles / samples);
+}
+
+uint32 AdcScan::getLoad(void) const {
+    uint32 ms = systick_uptime() - statsMillis;
+    if (ms == 0) {
+        return 0;
+    }
+    return (uint32)(isrCycles * 1000 / ((uint64)ms * CYCLES_PER_MICROSECOND
+                                        * 1000));
+}
+
+bool AdcScan::overran(void) const {
+    if (activeScans[adcIndex(dev)] != this) {
+        return false;
+    }
+    return (dev->regs->SR & ADC_SR_OVR) ||
+        (multi && (ADC_COMMON->CSR & (ADC_CSR_OVR1 | ADC_CSR_OVR2 |
+                                      ADC_CSR_OVR3)));
+}
+
+void AdcScan::resetStats(void) {
+    buffers = 0;
+    dropped = 0;
+    isrCycles = 0;
+    statsMillis = systick_uptime();
+}
+
+void AdcScan::printStats(Print &out) const {
+    uint32 load = this->getLoad();
+
+    out.print("adcscan rate=");
+    out.print(this->getMeasuredRate());
+    out.print('/');
+    out.print(scanRate);
+    out.print(" buffers=");
+    out.print(buffers);
+    out.print(" dropped=");
+    out.print(dropped);
+    out.print(" cycles_per_sample=");
+    out.print(this->getCyclesPerSample());
+    out.print(" load=");
+    out.print(load / 10);
+    out.print('.');
+    out.print(load % 10);
+    out.print('%');
+    if (this->overran()) {
+        out.print(" OVERRUN");
+    }
+    out.println();
+}
+
+#endif
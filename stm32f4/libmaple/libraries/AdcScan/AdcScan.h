@@ -0,0 +1,234 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file AdcScan.h
+ * @brief Continuous, timer-triggered ADC acquisition through DMA.
+ *
+ * A timer's update event (TRGO) starts a scan of the regular channel
+ * sequence at a fixed rate; DMA moves each result into one circular
+ * buffer, and its half transfer and transfer complete interrupts hand
+ * the half just filled to a handler while the other half fills.  The
+ * CPU does nothing per sample, and the sampling instants are as
+ * steady as the timer.
+ *
+ *     uint16 buf[2 * 64 * 2];             // two halves, 64 scans of 2
+ *     AdcScan scan(ADC1);
+ *
+ *     void gotSamples(const uint16 *samples, uint32 count) {
+ *         // samples[0], [2], ... from pin 1; [1], [3], ... from pin 2
+ *     }
+ *
+ *     void setup() {
+ *         static const uint8 pins[] = {1, 2};
+ *         scan.setPins(pins, 2);
+ *         scan.setBuffer(buf, sizeof(buf) / sizeof(buf[0]));
+ *         scan.attachInterrupt(gotSamples);
+ *         scan.begin(TIMER3, 10000);      // 10000 scans per second
+ *     }
+ *
+ * The handler runs in the DMA interrupt and has until the other half
+ * fills to finish; one that is late, or an interrupt delayed that
+ * long, is counted as a dropped buffer.  Posting to the EventLoop
+ * from the handler moves the work to loop().
+ *
+ * beginMulti() runs two or three ADCs together in one of the dual or
+ * triple modes (see adc_multi_config), for an ADC1 scan: interleaved
+ * to multiply the sample rate of one channel, or simultaneous to
+ * sample several at the same instant.  The common data register
+ * interleaves their results in the buffer.
+ *
+ * STM32F2/F4 only.  ADC1, ADC2 and ADC3 use DMA2 streams 0, 2 and 1.
+ * Timers 2, 3 and 8 can trigger.
+ */
+
+#ifndef _ADC_SCAN_H_
+#define _ADC_SCAN_H_
+
+#include "libmaple_types.h"
+#include "adc.h"
+#include "dma.h"
+#include "timer.h"
+#include "Print.h"
+
+#ifdef MAPLE_IDE
+#include "wirish.h"             /* hack for IDE compile */
+#endif
+
+/**
+ * @brief Buffer handler.
+ * @param samples The half of the buffer just filled, whole scans in
+ *                sequence order.
+ * @param count Number of samples, half the buffer length.
+ */
+typedef void (*AdcScanHandler)(const uint16 *samples, uint32 count);
+
+class AdcScan {
+public:
+    AdcScan(const adc_dev *dev);
+
+    /**
+     * @brief Scan these pins, in this order.
+     *
+     * Sets them to INPUT_ANALOG.
+     *
+     * @return false if a pin has no channel on this ADC, or more than
+     *         16 were given.
+     */
+    bool setPins(const uint8 *pins, uint8 count);
+
+    /**
+     * @brief Scan these ADC channels, in this order.
+     *
+     * For channels with no pin, such as the temperature sensor.
+     */
+    bool setChannels(const uint8 *channels, uint8 count);
+
+    /** Sample time for all channels; ADC_SMPR_15 by default. */
+    void setSampleTime(adc_smp_rate smp) { this->smp = smp; }
+
+    /**
+     * @brief Set the buffer to fill.
+     * @param length Samples the buffer holds; a multiple of twice the
+     *               number of channels, at most 65535.
+     */
+    void setBuffer(uint16 *buffer, uint32 length);
+
+    /** Set the function called with each half of the buffer. */
+    void attachInterrupt(AdcScanHandler handler) { this->handler = handler; }
+
+    /**
+     * @brief Start acquiring.
+     *
+     * The timer is taken over until end() and set as close to
+     * scanRate as its clock allows.
+     *
+     * @param timer TIMER2, TIMER3 or TIMER8.
+     * @param scanRate Scans of the whole sequence per second.
+     * @return false if the timer cannot trigger the ADC, or the
+     *         channels or buffer are missing.
+     */
+    bool begin(timer_dev *timer, uint32 scanRate);
+
+    /**
+     * @brief Start acquiring with ADCs working together.
+     *
+     * Only for ADC1, which leads; the configuration's own channels
+     * are used rather than setPins().  Each half of the buffer holds
+     * whole rounds, the ADCs' results in turn: ADC1, ADC2[, ADC3],
+     * ADC1, ...  With DMA mode 3 two 8- or 6-bit results share each
+     * uint16, ADC1's in the low byte, and count is in uint16s.
+     *
+     * @param cfg Configuration; its DMA mode must not be
+     *            ADC_MULTI_DMA_NONE.
+     * @param timer TIMER2, TIMER3 or TIMER8 to trigger each round at
+     *              scanRate; or NULL with cfg->continuous set, to
+     *              convert as fast as the configuration allows.
+     * @param scanRate Rounds per second, when triggered.
+     * @return false if the configuration fails adc_multi_check(),
+     *         the timer cannot trigger, or the buffer does not hold
+     *         a whole number of rounds per half.  DMA mode 2 also
+     *         needs the buffer 4-byte aligned.
+     */
+#ifdef STM32F2
+    bool beginMulti(const adc_multi_config *cfg, timer_dev *timer,
+                    uint32 scanRate);
+#endif
+
+    /** Stop, leaving the ADC ready for analogRead() again. */
+    void end(void);
+
+    /**
+     * @brief Scans per second the timer was actually set to, or that
+     *        a continuous beginMulti() converts at.
+     */
+    uint32 getScanRate(void) const { return scanRate; }
+
+    /** Scans per second measured since begin() or resetStats(). */
+    uint32 getMeasuredRate(void) const;
+
+    /** Halves handed to the handler. */
+    uint32 getBuffers(void) const { return buffers; }
+
+    /**
+     * @brief Halves lost: overwritten while the handler still had
+     *        them, or skipped because an interrupt came too late.
+     */
+    uint32 getDropped(void) const { return dropped; }
+
+    /** DMA interrupt cycles, handler included, per sample. */
+    uint32 getCyclesPerSample(void) const;
+
+    /** CPU load of the DMA interrupt, in tenths of a percent. */
+    uint32 getLoad(void) const;
+
+    /**
+     * @brief Whether the ADC overran, which stops acquisition.
+     *
+     * Happens when the DMA cannot keep up: scans faster than the
+     * conversions take, or a bus hogged for too long.
+     */
+    bool overran(void) const;
+
+    void resetStats(void);
+
+    /**
+     * @brief Print the statistics on one line:
+     *
+     *     adcscan rate=N/N buffers=N dropped=N cycles_per_sample=N load=N.N%
+     */
+    void printStats(Print &out) const;
+
+    /** Call from the DMA interrupt; public only for the ISR. */
+    void handle(void);
+
+private:
+    const adc_dev *dev;
+    timer_dev *timer;
+    AdcScanHandler handler;
+    uint16 *buffer;
+    uint32 length;
+    uint32 scanRate;
+    adc_smp_rate smp;
+    uint8 channels[16];
+    uint8 nrChannels;
+    uint8 stream;
+    uint8 request;
+    bool multi;
+    uint8 unit;                 /* uint16s per DMA transfer */
+    uint8 packing;              /* Samples per uint16 */
+    uint8 scanSamples;          /* Samples per scan or round */
+
+    void startDma(volatile void *src, dma_xfer_size size);
+    void startTimer(timer_dev *timer, uint32 scanRate);
+
+    volatile uint32 buffers;
+    volatile uint32 dropped;
+    volatile uint64 isrCycles;
+    uint32 statsMillis;
+};
+
+#endif
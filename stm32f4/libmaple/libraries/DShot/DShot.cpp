@@ -0,0 +1,189 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file DShot.cpp
+ * @brief DShot ESC frames sent by a timer DMA burst.
+ */
+
+#include "DShot.h"
+
+#ifdef STM32F2
+
+#include "boards.h"
+#include "rcc.h"
+
+/* One set of ESCs per bursting timer: TIMER1, 3, 4, 8 */
+static DShot *senders[4];
+
+static void sender0Isr(void) {
+    senders[0]->handle();
+}
+
+static void sender1Isr(void) {
+    senders[1]->handle();
+}
+
+static void sender2Isr(void) {
+    senders[2]->handle();
+}
+
+static void sender3Isr(void) {
+    senders[3]->handle();
+}
+
+static voidFuncPtr const senderIsrs[4] = {
+    sender0Isr, sender1Isr, sender2Isr, sender3Isr
+};
+
+static int8 timerSlot(timer_dev *timer) {
+    if (timer == TIMER1) {
+        return 0;
+    } else if (timer == TIMER3) {
+        return 1;
+    } else if (timer == TIMER4) {
+        return 2;
+    } else if (timer == TIMER8) {
+        return 3;
+    }
+    return -1;
+}
+
+DShot::DShot(timer_dev *timer, uint8 firstChannel, uint8 motors) {
+    this->timer = timer;
+    this->firstChannel = firstChannel;
+    this->motors = motors;
+    this->started = false;
+    this->done = NULL;
+    this->speed = BITSTREAM_DSHOT600;
+    this->sending = false;
+    for (uint8 m = 0; m < DSHOT_MAX_MOTORS; m++) {
+        this->frame[m] = bitstream_dshot_frame(0, 0);
+    }
+    this->resetStats();
+}
+
+bool DShot::begin(bitstream_dshot_speed speed) {
+    int8 slot = timerSlot(timer);
+    uint32 clock = rcc_dev_timer_clk_speed(timer->clk_id);
+
+    if (slot < 0 || motors < 1 || motors > DSHOT_MAX_MOTORS ||
+        bitstream_dshot_timing(&timing, clock, speed) < 0) {
+        return false;
+    }
+    if (senders[slot]) {
+        senders[slot]->end();
+    }
+    senders[slot] = this;
+    this->speed = speed;
+
+    boardEnsureTimer(timer);
+    timer_pause(timer);
+    timer_set_prescaler(timer, 0);
+    timer_set_reload(timer, timing.reload);
+    if (timer_burst_init(&burst, timer, firstChannel, motors) < 0) {
+        senders[slot] = NULL;
+        return false;
+    }
+    timer_generate_update(timer);
+    timer_resume(timer);
+    started = true;
+    sending = false;
+    return true;
+}
+
+void DShot::end(void) {
+    if (!started) {
+        return;
+    }
+    timer_burst_stop(&burst);
+    timer_pause(timer);
+    started = false;
+    sending = false;
+    senders[timerSlot(timer)] = NULL;
+}
+
+void DShot::write(uint8 motor, uint16 value, bool telemetry) {
+    if (motor < motors) {
+        frame[motor] = bitstream_dshot_frame(value, telemetry);
+    }
+}
+
+bool DShot::update(void) {
+    uint32 idle = BITSTREAM_DSHOT_BITS * motors;
+
+    if (!started) {
+        return false;
+    }
+    if (sending) {
+        skipped++;
+        return false;
+    }
+    for (uint8 m = 0; m < motors; m++) {
+        bitstream_encode_word(&timing, frame[m], BITSTREAM_DSHOT_BITS,
+                              slots + m, motors);
+        slots[idle + m] = 0;
+    }
+    sending = true;
+    if (timer_burst_send(&burst, slots, BITSTREAM_DSHOT_BITS + 1,
+                         senderIsrs[timerSlot(timer)]) < 0) {
+        sending = false;
+        return false;
+    }
+    return true;
+}
+
+void DShot::handle(void) {
+    uint8 finished = timer_burst_finish(&burst);
+
+    if (timer_burst_busy(&burst)) {
+        return;
+    }
+    sending = false;
+    if (finished) {
+        frames++;
+        if (done) {
+            done();
+        }
+    }
+}
+
+void DShot::resetStats(void) {
+    frames = 0;
+    skipped = 0;
+}
+
+void DShot::printStats(Print &out) const {
+    out.print("dshot rate=");
+    out.print((uint32)speed);
+    out.print(" frames=");
+    out.print(frames);
+    out.print(" skipped=");
+    out.print(skipped);
+    out.println();
+}
+
+#endif
@@ -0,0 +1,163 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file DShot.h
+ * @brief DShot ESC frames sent by a timer DMA burst.
+ *
+ * Up to four ESCs on consecutive channels of one timer get their
+ * 16-bit frames in the same burst, so all motors change speed
+ * together.  Each update() codes the frames into one small buffer
+ * that a DMA burst plays (see timer_burst.h); the CPU only starts it.
+ *
+ *     DShot escs(TIMER8, 1, 4);               // PC6, PC7, PC8, PC9
+ *
+ *     void setup() {
+ *         for (uint8 pin = 0; pin < 4; pin++) {
+ *             pinMode(Port2Pin('C', 6 + pin), PWM);
+ *         }
+ *         escs.begin(BITSTREAM_DSHOT600);
+ *     }
+ *
+ *     void loop() {
+ *         for (uint8 m = 0; m < 4; m++) {
+ *             escs.write(m, throttle[m]);
+ *         }
+ *         escs.update();
+ *         delayMicroseconds(500);
+ *     }
+ *
+ * A frame takes 27 us at DShot600 and 107 us at DShot150.  ESCs
+ * disarm when frames stop coming for a while, so update() should be
+ * called at a steady rate, typically 1 to 8 kHz.
+ *
+ * STM32F2/F4 only.  TIMER1, TIMER3, TIMER4 and TIMER8 can send, one
+ * set of ESCs each, and their update DMA streams (see
+ * timer_burst_dma_request()) must not be in use elsewhere.
+ */
+
+#ifndef _DSHOT_H_
+#define _DSHOT_H_
+
+#include "libmaple_types.h"
+#include "timer.h"
+#include "timer_burst.h"
+#include "bitstream.h"
+#include "Print.h"
+
+#ifdef MAPLE_IDE
+#include "wirish.h"             /* hack for IDE compile */
+#endif
+
+#ifdef STM32F2
+
+/** Most ESCs one timer drives. */
+#define DSHOT_MAX_MOTORS 4
+
+class DShot {
+public:
+    /**
+     * @param timer TIMER1, TIMER3, TIMER4 or TIMER8.
+     * @param firstChannel Channel driving the first ESC.
+     * @param motors ESCs, on consecutive channels from firstChannel.
+     */
+    DShot(timer_dev *timer, uint8 firstChannel, uint8 motors);
+
+    /**
+     * @brief Take over the timer and drive the outputs low.
+     * @return false if the timer or channels cannot be used, or its
+     *         clock is too slow for the speed.
+     */
+    bool begin(bitstream_dshot_speed speed = BITSTREAM_DSHOT600);
+
+    /** Stop sending. */
+    void end(void);
+
+    /**
+     * @brief Set the value the next update() sends to an ESC.
+     * @param motor ESC, from 0.
+     * @param value Throttle from BITSTREAM_DSHOT_MIN_THROTTLE to
+     *              BITSTREAM_DSHOT_MAX_THROTTLE, 0 to disarm, or a
+     *              command below BITSTREAM_DSHOT_MIN_THROTTLE.
+     * @param telemetry Ask the ESC for telemetry.
+     */
+    void write(uint8 motor, uint16 value, bool telemetry = false);
+
+    /**
+     * @brief Send the current values to all ESCs at once.
+     * @return false if the last frame is still being sent, in which
+     *         case this one is skipped, or begin() has not succeeded.
+     */
+    bool update(void);
+
+    /** Whether a frame is being sent. */
+    bool busy(void) const { return sending; }
+
+    /**
+     * @brief Set a function to call from the DMA interrupt when each
+     *        frame has been sent, or NULL.
+     */
+    void attachDone(voidFuncPtr done) { this->done = done; }
+
+    /** Frames sent. */
+    uint32 getFrames(void) const { return frames; }
+
+    /** update() calls skipped because a frame was still being sent. */
+    uint32 getSkipped(void) const { return skipped; }
+
+    void resetStats(void);
+
+    /**
+     * @brief Print the statistics on one line:
+     *
+     *     dshot rate=N frames=N skipped=N
+     */
+    void printStats(Print &out) const;
+
+    /** Call from the DMA interrupt; public only for the ISR. */
+    void handle(void);
+
+private:
+    timer_dev *timer;
+    uint8 firstChannel;
+    uint8 motors;
+    bool started;
+    voidFuncPtr done;
+    bitstream_dshot_speed speed;
+    timer_burst burst;
+    bitstream_timing timing;
+    uint16 frame[DSHOT_MAX_MOTORS];
+    /* One row per bit and an idle row, a slot per motor */
+    uint16 slots[(BITSTREAM_DSHOT_BITS + 1) * DSHOT_MAX_MOTORS];
+
+    volatile bool sending;
+    volatile uint32 frames;
+    uint32 skipped;
+};
+
+#endif
+
+#endif
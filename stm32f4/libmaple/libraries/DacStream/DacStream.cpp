@@ -0,0 +1,291 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file DacStream.cpp
+ * @brief Timer-triggered DAC output fed by DMA.
+ */
+
+#include "DacStream.h"
+
+#ifdef STM32F2
+
+#include "boards.h"
+#include "dma.h"
+#include "rcc.h"
+
+/* The stream driving each DAC channel; a dual stream is on both */
+static DacStream *owners[2];
+
+/* DMA1 stream for DAC channels 1 and 2, both on request channel 7 */
+static const dma_stream dacStreams[2] = {DMA_STREAM5, DMA_STREAM6};
+
+static void dac1Isr(void) {
+    owners[0]->handle();
+}
+
+static void dac2Isr(void) {
+    owners[1]->handle();
+}
+
+static bool timerTrigger(timer_dev *timer, dac_trigger *trig) {
+    if (timer == TIMER6) {
+        *trig = DAC_TRIG_TIMER6;
+    } else if (timer == TIMER7) {
+        *trig = DAC_TRIG_TIMER7;
+    } else if (timer == TIMER2) {
+        *trig = DAC_TRIG_TIMER2;
+    } else if (timer == TIMER4) {
+        *trig = DAC_TRIG_TIMER4;
+    } else if (timer == TIMER5) {
+        *trig = DAC_TRIG_TIMER5;
+    } else if (timer == TIMER8) {
+        *trig = DAC_TRIG_TIMER8;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+DacStream::DacStream(DacStreamOutput output) {
+    this->output = output;
+    this->timer = NULL;
+    this->refill = NULL;
+    this->buffer = NULL;
+    this->length = 0;
+    this->sampleRate = 0;
+    this->unit = output == DAC_STREAM_DUAL ? 2 : 1;
+    this->streaming = false;
+    this->resetStats();
+}
+
+void DacStream::setBuffer(uint16 *buffer, uint32 length) {
+    this->buffer = buffer;
+    this->length = length;
+}
+
+/* Claim the outputs, stopping whatever stream had them */
+static void claim(DacStream *stream, DacStreamOutput output) {
+    for (uint8 i = 0; i < 2; i++) {
+        if ((output & (1 << i)) && owners[i] && owners[i] != stream) {
+            owners[i]->end();
+        }
+    }
+    stream->end();
+    for (uint8 i = 0; i < 2; i++) {
+        if (output & (1 << i)) {
+            owners[i] = stream;
+        }
+    }
+}
+
+bool DacStream::begin(timer_dev *timer, uint32 sampleRate) {
+    dac_trigger trig;
+    uint8 channel = output == DAC_STREAM_CH2 ? 2 : 1;
+    dma_stream stream = dacStreams[channel - 1];
+
+    if (!timerTrigger(timer, &trig) || !sampleRate) {
+        return false;
+    }
+    if (!buffer || length == 0 || length > 0xFFFF ||
+        length % (2 * unit) || ((uint32)buffer & (2 * unit - 1))) {
+        return false;
+    }
+    claim(this, output);
+    this->timer = timer;
+    this->streaming = true;
+    if (refill) {
+        refill(buffer, length / 2);
+        refill(buffer + length / 2, length / 2);
+    }
+
+    rcc_clk_enable(RCC_DAC);
+    for (uint8 ch = 1; ch <= 2; ch++) {
+        if (output & ch) {
+            dac_set_wave(DAC, ch, DAC_WAVE_NONE, 0);
+            dac_set_trigger(DAC, ch, trig);
+            dac_enable_channel(DAC, ch);
+        }
+    }
+
+    dma_init(DMA1);
+    if (unit == 2) {
+        dma_setup_transfer(DMA1, stream, DMA_CH7,
+                           DAC_DHR12RD_ADDRESS, DMA_SIZE_32BITS,
+                           buffer,              DMA_SIZE_32BITS,
+                           (DMA_MINC_MODE | DMA_CIRC_MODE | DMA_FROM_MEM |
+                            DMA_HALF_TRNS | DMA_TRNS_CMPLT | DMA_TRNS_ERR));
+    } else {
+        dma_setup_transfer(DMA1, stream, DMA_CH7,
+                           dac_dhr12r(DAC, channel), DMA_SIZE_16BITS,
+                           buffer,                   DMA_SIZE_16BITS,
+                           (DMA_MINC_MODE | DMA_CIRC_MODE | DMA_FROM_MEM |
+                            DMA_HALF_TRNS | DMA_TRNS_CMPLT | DMA_TRNS_ERR));
+    }
+    dma_set_num_transfers(DMA1, stream, (uint16)(length / unit));
+    dma_set_priority(DMA1, stream, DMA_PRIORITY_HIGH);
+    dma_attach_interrupt(DMA1, stream, channel == 1 ? dac1Isr : dac2Isr);
+    dma_enable(DMA1, stream);
+
+    /* One request stream for a dual output: channel 1's */
+    DAC->regs->SR = 0;
+    dac_set_dma(DAC, channel, 1);
+    return this->startTimer(timer, sampleRate);
+}
+
+bool DacStream::beginWave(timer_dev *timer, uint32 stepRate, dac_wave wave,
+                          uint8 bits, uint16 base) {
+    dac_trigger trig;
+
+    if (!timerTrigger(timer, &trig) || !stepRate ||
+        wave == DAC_WAVE_NONE || bits < 1 || bits > 12) {
+        return false;
+    }
+    claim(this, output);
+    this->timer = timer;
+    this->streaming = false;
+
+    rcc_clk_enable(RCC_DAC);
+    for (uint8 ch = 1; ch <= 2; ch++) {
+        if (output & ch) {
+            dac_set_trigger(DAC, ch, trig);
+            dac_set_wave(DAC, ch, wave, bits);
+            dac_write_channel(DAC, ch, base);
+            dac_enable_channel(DAC, ch);
+        }
+    }
+    return this->startTimer(timer, stepRate);
+}
+
+bool DacStream::startTimer(timer_dev *timer, uint32 rate) {
+    /* Period as close to the rate as prescaler and reload allow */
+    uint32 ticks = rcc_dev_timer_clk_speed(timer->clk_id) / rate;
+    uint32 prescaler = ticks / 0x10000 + 1;
+    uint32 reload = (ticks + prescaler / 2) / prescaler;
+    if (reload < 2) {
+        reload = 2;
+    }
+    this->sampleRate =
+        rcc_dev_timer_clk_speed(timer->clk_id) / (prescaler * reload);
+
+    boardEnsureTimer(timer);
+    timer_pause(timer);
+    timer_set_prescaler(timer, (uint16)(prescaler - 1));
+    timer_set_reload(timer, (uint16)(reload - 1));
+    timer_set_master_mode(timer, TIMER_CR2_MMS_UPDATE);
+    timer_generate_update(timer);
+    this->resetStats();
+    timer_resume(timer);
+    return true;
+}
+
+void DacStream::end(void) {
+    uint8 channel = output == DAC_STREAM_CH2 ? 2 : 1;
+
+    if (owners[channel - 1] != this) {
+        return;
+    }
+    timer_pause(timer);
+    timer_set_master_mode(timer, TIMER_CR2_MMS_RESET);
+
+    for (uint8 ch = 1; ch <= 2; ch++) {
+        if (output & ch) {
+            dac_set_dma(DAC, ch, 0);
+            dac_set_wave(DAC, ch, DAC_WAVE_NONE, 0);
+            dac_disable_trigger(DAC, ch);
+            owners[ch - 1] = NULL;
+        }
+    }
+    if (streaming) {
+        dma_disable(DMA1, dacStreams[channel - 1]);
+        dma_detach_interrupt(DMA1, dacStreams[channel - 1]);
+    }
+    streaming = false;
+    timer = NULL;
+}
+
+void DacStream::handle(void) {
+    dma_stream stream = dacStreams[output == DAC_STREAM_CH2 ? 1 : 0];
+    uint8 bits = dma_get_isr_bits(DMA1, stream);
+    uint32 half = length / 2;
+
+    dma_clear_isr_bits(DMA1, stream, bits);
+    if (!(bits & (DMA_ISR_HTIF | DMA_ISR_TCIF))) {
+        return;
+    }
+    if ((bits & DMA_ISR_HTIF) && (bits & DMA_ISR_TCIF)) {
+        /* Both halves played since the last interrupt */
+        dropped++;
+    }
+
+    /* The half the DMA is not reading is the one just played */
+    uint32 pos = length - dma_get_count(DMA1, stream) * unit;
+    uint16 *done = pos >= half ? buffer : buffer + half;
+    if (refill) {
+        refill(done, half);
+        buffers++;
+    }
+
+    /* Did the DMA come round into the refilled half meanwhile? */
+    uint32 now = length - dma_get_count(DMA1, stream) * unit;
+    if (refill && (now >= half) != (pos >= half)) {
+        dropped++;
+    }
+}
+
+bool DacStream::underran(void) const {
+    uint32 flags = 0;
+
+    if (!streaming) {
+        return false;
+    }
+    if (output & DAC_STREAM_CH1) {
+        flags |= DAC_SR_DMAUDR1;
+    } else {
+        flags |= DAC_SR_DMAUDR2;
+    }
+    return DAC->regs->SR & flags;
+}
+
+void DacStream::resetStats(void) {
+    buffers = 0;
+    dropped = 0;
+}
+
+void DacStream::printStats(Print &out) const {
+    out.print("dacstream rate=");
+    out.print(sampleRate);
+    out.print(" buffers=");
+    out.print(buffers);
+    out.print(" dropped=");
+    out.print(dropped);
+    if (this->underran()) {
+        out.print(" UNDERRUN");
+    }
+    out.println();
+}
+
+#endif
@@ -0,0 +1,185 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file DacStream.h
+ * @brief Timer-triggered DAC output fed by DMA.
+ *
+ * A timer's update event (TRGO) moves the next sample into the DAC at
+ * a fixed rate, and DMA keeps the DAC's data holding register full
+ * from a circular buffer.  With no refill handler the buffer repeats,
+ * which suits a waveform table; with one, its half transfer and
+ * transfer complete interrupts ask for the half just played to be
+ * refilled while the other half plays:
+ *
+ *     uint16 buf[2 * 256];
+ *     DacStream out(DAC_STREAM_CH1);
+ *
+ *     void refill(uint16 *samples, uint32 count) {
+ *         // write count 12-bit samples
+ *     }
+ *
+ *     void setup() {
+ *         out.setBuffer(buf, 512);
+ *         out.attachRefill(refill);
+ *         out.begin(TIMER6, 44100);
+ *     }
+ *
+ * DAC_STREAM_DUAL drives both channels from one stream: the buffer
+ * holds pairs, channel 1 then channel 2, which one 32-bit transfer
+ * writes to DHR12RD so that both outputs change together.
+ *
+ * beginWave() needs no buffer: the DAC's own noise or triangle
+ * generator steps on each trigger.
+ *
+ * STM32F2/F4 only.  Channel 1 (PA4) uses DMA1 stream 5 and channel 2
+ * (PA5) stream 6.  Timers 2, 4, 5, 6, 7 and 8 can trigger.
+ */
+
+#ifndef _DAC_STREAM_H_
+#define _DAC_STREAM_H_
+
+#include "libmaple_types.h"
+#include "dac.h"
+#include "timer.h"
+#include "Print.h"
+
+#ifdef MAPLE_IDE
+#include "wirish.h"             /* hack for IDE compile */
+#endif
+
+/**
+ * @brief Refill handler.
+ * @param samples The half of the buffer just played.
+ * @param count Number of uint16s in it; pairs when dual.
+ */
+typedef void (*DacStreamRefill)(uint16 *samples, uint32 count);
+
+/** Which outputs a stream drives. */
+enum DacStreamOutput {
+    DAC_STREAM_CH1 = 1,         /**< PA4 */
+    DAC_STREAM_CH2 = 2,         /**< PA5 */
+    DAC_STREAM_DUAL = 3         /**< Both, in step */
+};
+
+class DacStream {
+public:
+    DacStream(DacStreamOutput output);
+
+    /**
+     * @brief Set the buffer to play.
+     * @param length uint16s the buffer holds; even, and when dual a
+     *               multiple of 4, at most 65535.  A dual buffer must
+     *               be 4-byte aligned.
+     */
+    void setBuffer(uint16 *buffer, uint32 length);
+
+    /**
+     * @brief Set the function that refills each half, or NULL to
+     *        repeat the buffer.
+     */
+    void attachRefill(DacStreamRefill refill) { this->refill = refill; }
+
+    /**
+     * @brief Start playing.
+     *
+     * With a refill handler, it is first called for both halves.  The
+     * timer is taken over until end() and set as close to
+     * sampleRate as its clock allows.
+     *
+     * @param timer TIMER2, 4, 5, 6, 7 or 8.
+     * @param sampleRate Samples, or pairs, per second.
+     * @return false if the timer cannot trigger the DAC, or the buffer
+     *         is missing or the wrong size.
+     */
+    bool begin(timer_dev *timer, uint32 sampleRate);
+
+    /**
+     * @brief Generate noise or a triangle in hardware.
+     *
+     * The DAC steps its generator on each trigger; a triangle's period
+     * is 2^(bits + 1) steps.  Dual streams generate on both channels.
+     *
+     * @param timer As for begin().
+     * @param stepRate Triggers per second.
+     * @param wave DAC_WAVE_NOISE or DAC_WAVE_TRIANGLE.
+     * @param bits Amplitude, 1 to 12 bits.
+     * @param base Level the waveform is added to.
+     */
+    bool beginWave(timer_dev *timer, uint32 stepRate, dac_wave wave,
+                   uint8 bits, uint16 base);
+
+    /** Stop; the outputs hold their last value. */
+    void end(void);
+
+    /** Samples per second the timer was actually set to. */
+    uint32 getSampleRate(void) const { return sampleRate; }
+
+    /** Halves refilled. */
+    uint32 getBuffers(void) const { return buffers; }
+
+    /**
+     * @brief Halves played again because the refill was late, or the
+     *        interrupt came too late.
+     */
+    uint32 getDropped(void) const { return dropped; }
+
+    /**
+     * @brief Whether a trigger came before DMA delivered the sample,
+     *        which stops the stream.
+     */
+    bool underran(void) const;
+
+    void resetStats(void);
+
+    /**
+     * @brief Print the statistics on one line:
+     *
+     *     dacstream rate=N buffers=N dropped=N
+     */
+    void printStats(Print &out) const;
+
+    /** Call from the DMA interrupt; public only for the ISR. */
+    void handle(void);
+
+private:
+    DacStreamOutput output;
+    timer_dev *timer;
+    DacStreamRefill refill;
+    uint16 *buffer;
+    uint32 length;
+    uint32 sampleRate;
+    uint8 unit;                 /* uint16s per DMA transfer */
+    bool streaming;
+
+    volatile uint32 buffers;
+    volatile uint32 dropped;
+
+    bool startTimer(timer_dev *timer, uint32 rate);
+    void setTriggers(dac_trigger trig);
+};
+
+#endif
@@ -25,6 +25,7 @@
  *****************************************************************************/
 
 #include "MapleFreeRTOS.h"
+#include "usb.h"
 
 extern "C" {
 
@@ -42,3 +43,63 @@ void vApplicationStackOverflowHook(xTaskHandle *pxTask,
 }
 
 }
+
+/*
+ * SerialUSB integration
+ */
+
+static xSemaphoreHandle usbSerialRxSem = NULL;
+static xSemaphoreHandle usbSerialTxSem = NULL;
+
+static void usbSerialGive(xSemaphoreHandle sem) {
+    signed portBASE_TYPE woken = pdFALSE;
+    xSemaphoreGiveFromISR(sem, &woken);
+    portEND_SWITCHING_ISR(woken);
+}
+
+static void usbSerialRxISR(void) {
+    usbSerialGive(usbSerialRxSem);
+}
+
+static void usbSerialTxISR(void) {
+    usbSerialGive(usbSerialTxSem);
+}
+
+void usbSerialWaitYield(usb_serial_dir, uint32) {
+    taskYIELD();
+}
+
+void usbSerialWaitSemaphore(usb_serial_dir dir, uint32 timeout_ms) {
+    xSemaphoreHandle sem = dir == USB_SERIAL_TX ? usbSerialTxSem :
+                                                  usbSerialRxSem;
+    portTickType ticks = portMAX_DELAY;
+
+    if (!sem) {
+        taskYIELD();
+        return;
+    }
+    if (timeout_ms != USB_SERIAL_WAIT_FOREVER) {
+        ticks = timeout_ms / portTICK_RATE_MS;
+        if (ticks == 0) {
+            ticks = 1;
+        }
+    }
+    /* A stale give just costs one extra poll of the endpoint. */
+    xSemaphoreTake(sem, ticks);
+}
+
+/**
+ * Create the SerialUSB semaphores, have the USB ISR give them, and
+ * make SerialUSB block on them.  The USB interrupt must not be
+ * raised above configMAX_SYSCALL_INTERRUPT_PRIORITY (libmaple leaves
+ * it at the lowest priority).
+ */
+void usbSerialUseSemaphore(void) {
+    if (!usbSerialRxSem) {
+        vSemaphoreCreateBinary(usbSerialRxSem);
+        vSemaphoreCreateBinary(usbSerialTxSem);
+    }
+    usbAttachRxCallback(usbSerialRxISR);
+    usbAttachTxCallback(usbSerialTxISR);
+    SerialUSB.setWaitHook(usbSerialWaitSemaphore);
+}
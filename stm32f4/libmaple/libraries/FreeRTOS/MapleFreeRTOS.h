@@ -37,4 +37,16 @@ extern "C" {
 #include "utility/semphr.h"
 }
 
+/*
+ * SerialUSB wait strategies; install with SerialUSB.setWaitHook().
+ *
+ * usbSerialWaitYield() calls taskYIELD(), which only lets tasks of
+ * equal or higher priority run.  usbSerialWaitSemaphore() blocks the
+ * calling task until the USB ISR signals endpoint activity, so lower
+ * priority tasks run too; call usbSerialUseSemaphore() to set it up.
+ */
+void usbSerialWaitYield(usb_serial_dir dir, uint32 timeout_ms);
+void usbSerialWaitSemaphore(usb_serial_dir dir, uint32 timeout_ms);
+void usbSerialUseSemaphore(void);
+
 #endif
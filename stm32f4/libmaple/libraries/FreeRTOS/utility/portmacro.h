@@ -105,6 +105,14 @@ extern void vPortYieldFromISR( void );
 
 /* Critical section management. */
 
+#ifdef LIBMAPLE_HOST
+
+/* Host build (make host): one thread and no interrupts to mask. */
+#define portSET_INTERRUPT_MASK()
+#define portCLEAR_INTERRUPT_MASK()
+
+#else
+
 /* 
  * Set basepri to portMAX_SYSCALL_INTERRUPT_PRIORITY without effecting other
  * registers.  r0 is clobbered.
@@ -129,6 +137,8 @@ extern void vPortYieldFromISR( void );
 		:::"r0"								\
 	)
 
+#endif
+
 #define portSET_INTERRUPT_MASK_FROM_ISR()		0;portSET_INTERRUPT_MASK()
 #define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)	portCLEAR_INTERRUPT_MASK();(void)x
 
@@ -0,0 +1,243 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file InputCapture.cpp
+ * @brief Frequency and pulse measurement with timer input capture.
+ */
+
+#include "InputCapture.h"
+
+#ifdef STM32F2
+
+#include "boards.h"
+#include "rcc.h"
+
+static InputCapture *activeRings[INPUT_CAPTURE_RINGS];
+
+static void ring0Isr(void) {
+    activeRings[0]->handle();
+}
+
+static void ring1Isr(void) {
+    activeRings[1]->handle();
+}
+
+static void ring2Isr(void) {
+    activeRings[2]->handle();
+}
+
+static void ring3Isr(void) {
+    activeRings[3]->handle();
+}
+
+static voidFuncPtr const ringIsrs[INPUT_CAPTURE_RINGS] = {
+    ring0Isr, ring1Isr, ring2Isr, ring3Isr,
+};
+
+InputCapture::InputCapture(timer_dev *timer, uint8 channel) {
+    this->timer = timer;
+    this->channel = channel;
+    this->edgesPerCapture = 1;
+    this->pwm = false;
+    this->running = false;
+    this->slot = -1;
+    this->ring = NULL;
+    this->length = 0;
+    this->tickRate = 0;
+}
+
+void InputCapture::setBuffer(uint32 *ring, uint16 length) {
+    this->ring = ring;
+    this->length = length;
+}
+
+bool InputCapture::begin(timer_ic_edge edge, timer_ic_prescaler psc,
+                         uint8 filter, uint32 prescaleFactor) {
+    int8 unused = -1;
+
+    this->end();
+    for (int8 i = INPUT_CAPTURE_RINGS - 1; i >= 0; i--) {
+        if (!activeRings[i]) {
+            unused = i;
+        }
+    }
+    if (unused < 0 || prescaleFactor < 1 || prescaleFactor > 0x10000 ||
+        timer_capture_init(&cap, timer, channel, ring, length) < 0) {
+        return false;
+    }
+    this->slot = unused;
+    activeRings[unused] = this;
+    this->pwm = false;
+    this->edgesPerCapture = 1 << (psc >> 2);
+
+    this->startTimer(prescaleFactor);
+    timer_ic_setup(timer, channel, edge, psc, filter);
+    timer_capture_start(&cap, ringIsrs[unused]);
+    this->running = true;
+    timer_resume(timer);
+    return true;
+}
+
+bool InputCapture::beginPwm(uint32 minFrequency, timer_ic_edge edge,
+                            uint8 filter) {
+    uint64 span = (uint64)timer_max_reload(timer) + 1;
+    uint64 slowest;
+    uint32 factor;
+
+    this->end();
+    if (!minFrequency || (channel != 1 && channel != 2) ||
+        (edge != TIMER_IC_RISING && edge != TIMER_IC_FALLING)) {
+        return false;
+    }
+    /* Smallest prescaler whose counter range holds the longest period */
+    slowest = rcc_dev_timer_clk_speed(timer->clk_id) / minFrequency + 1;
+    factor = (uint32)((slowest + span - 1) / span);
+    if (factor > 0x10000) {
+        factor = 0x10000;
+    }
+
+    this->startTimer(factor);
+    timer_ic_set_pwm_input(timer, channel, edge, filter);
+    /* Only a counter overflow, not an input reset, sets UIF */
+    (timer->regs).gen->CR1 |= TIMER_CR1_URS;
+    (timer->regs).gen->SR = 0;
+    this->pwm = true;
+    this->edgesPerCapture = 1;
+    this->running = true;
+    timer_resume(timer);
+    return true;
+}
+
+void InputCapture::startTimer(uint32 prescaleFactor) {
+    this->tickRate = rcc_dev_timer_clk_speed(timer->clk_id) / prescaleFactor;
+
+    boardEnsureTimer(timer);
+    timer_pause(timer);
+    (timer->regs).gen->SMCR &= ~TIMER_SMCR_SMS;
+    timer_set_prescaler(timer, (uint16)(prescaleFactor - 1));
+    timer_set_reload(timer, timer_max_reload(timer));
+    timer_generate_update(timer);
+}
+
+void InputCapture::end(void) {
+    if (!running) {
+        return;
+    }
+    timer_pause(timer);
+    if (pwm) {
+        (timer->regs).gen->SMCR &= ~TIMER_SMCR_SMS;
+        (timer->regs).gen->CR1 &= ~TIMER_CR1_URS;
+        timer_cc_disable(timer, 1);
+        timer_cc_disable(timer, 2);
+    } else {
+        timer_capture_stop(&cap);
+        timer_cc_disable(timer, channel);
+        activeRings[slot] = NULL;
+        slot = -1;
+    }
+    running = false;
+}
+
+uint32 InputCapture::available(void) {
+    return running && !pwm ? timer_capture_available(&cap) : 0;
+}
+
+bool InputCapture::read(uint32 *stamp) {
+    return running && !pwm && timer_capture_read(&cap, stamp) == 0;
+}
+
+uint32 InputCapture::getCaptures(void) {
+    return running && !pwm ? timer_capture_count(&cap) : 0;
+}
+
+uint32 InputCapture::getOverruns(void) const {
+    return pwm ? 0 : cap.overruns;
+}
+
+uint32 InputCapture::getSpan(uint16 captures) {
+    return running && !pwm ? timer_capture_span(&cap, captures) : 0;
+}
+
+/* PWM mode: has a period ended since the counter last overflowed? */
+bool InputCapture::signalPresent(void) {
+    uint32 sr = (timer->regs).gen->SR;
+
+    if (sr & TIMER_SR_UIF) {
+        (timer->regs).gen->SR = (uint32)~TIMER_SR_UIF;
+        /* Reading CCRx clears CCxIF, so it is set only by a new period */
+        return sr & BIT(channel);
+    }
+    return true;
+}
+
+float InputCapture::getFrequency(uint16 periods) {
+    uint32 ticks;
+
+    if (!running) {
+        return 0;
+    }
+    if (pwm) {
+        if (!this->signalPresent()) {
+            return 0;
+        }
+        ticks = timer_get_compare(timer, channel);
+        return ticks ? (float)tickRate / ticks : 0;
+    }
+    ticks = timer_capture_span(&cap, periods);
+    if (!ticks) {
+        return 0;
+    }
+    return (float)tickRate * periods * edgesPerCapture / ticks;
+}
+
+float InputCapture::getDuty(void) {
+    uint32 period, pulse;
+
+    if (!running || !pwm || !this->signalPresent()) {
+        return 0;
+    }
+    period = timer_get_compare(timer, channel);
+    pulse = timer_get_compare(timer, channel == 1 ? 2 : 1);
+    if (!period || pulse > period) {
+        return 0;
+    }
+    return (float)pulse / period;
+}
+
+void InputCapture::printStats(Print &out) {
+    out.print("inputcapture ticks=");
+    out.print(tickRate);
+    out.print(" captures=");
+    out.print(this->getCaptures());
+    out.print(" overruns=");
+    out.print(this->getOverruns());
+    out.print(" freq=");
+    out.print(this->getFrequency());
+    out.println();
+}
+
+#endif
@@ -0,0 +1,205 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file InputCapture.h
+ * @brief Frequency and pulse measurement with timer input capture.
+ *
+ * Two ways to measure, neither with an interrupt per edge:
+ *
+ * - begin() streams each capture's timestamp into a ring by DMA
+ *   (see timer_capture.h).  read() returns them in order, and
+ *   getFrequency() averages over the newest few periods by reading
+ *   just two of them.  The capture prescaler keeps the DMA rate down
+ *   at high edge rates: with TIMER_IC_DIV8 a 1 MHz input makes 125k
+ *   transfers a second.
+ *
+ * - beginPwm() uses the PWM input mode: the timer resets on each
+ *   period and two channels latch the period and the pulse width, so
+ *   getFrequency() and getDuty() read two registers.
+ *
+ *     static uint32 ring[64];
+ *     InputCapture tach(TIMER2, 1);           // PA0
+ *
+ *     void setup() {
+ *         tach.setBuffer(ring, 64);
+ *         tach.begin(TIMER_IC_RISING, TIMER_IC_DIV1, 4);
+ *     }
+ *
+ *     void loop() {
+ *         Serial2.println(tach.getFrequency(32));
+ *     }
+ *
+ * In ring mode the timer counts freely over its whole range, so the
+ * averaging window must be shorter than one counter wrap: about
+ * 0.78 ms on a 16-bit timer at 84 MHz and 51 s on TIMER2 or TIMER5.
+ * A prescale factor lengthens it at the cost of resolution.
+ *
+ * STM32F2/F4 only.  Up to INPUT_CAPTURE_RINGS rings run at once; the
+ * DMA stream each channel uses is fixed by the hardware (see
+ * timer_capture_dma_request()) and must not be in use elsewhere.
+ */
+
+#ifndef _INPUT_CAPTURE_H_
+#define _INPUT_CAPTURE_H_
+
+#include "libmaple_types.h"
+#include "timer.h"
+#include "timer_capture.h"
+#include "Print.h"
+
+#ifdef MAPLE_IDE
+#include "wirish.h"             /* hack for IDE compile */
+#endif
+
+#ifdef STM32F2
+
+/** Capture rings that can stream at the same time. */
+#define INPUT_CAPTURE_RINGS 4
+
+class InputCapture {
+public:
+    /**
+     * @param timer Timer to capture with; it is taken over until end().
+     * @param channel Channel whose input pin carries the signal.
+     */
+    InputCapture(timer_dev *timer, uint8 channel);
+
+    /**
+     * @brief Set the timestamp ring for begin().
+     * @param length Slots, at least 3 and more than the longest
+     *               averaging window plus one.
+     */
+    void setBuffer(uint32 *ring, uint16 length);
+
+    /**
+     * @brief Stream capture timestamps into the ring.
+     *
+     * @param edge Edge to capture on.  With TIMER_IC_BOTH, the
+     *             frequency measured is that of the edges, twice the
+     *             signal's.
+     * @param psc Capture every edge, or every 2nd, 4th or 8th.
+     * @param filter Digital input filter, from 0 (off) to 15.
+     * @param prescaleFactor Timer clock divider, from 1 to 65,536.
+     * @return false if the channel has no DMA request, the ring is
+     *         missing or too small, or all rings are in use.
+     */
+    bool begin(timer_ic_edge edge = TIMER_IC_RISING,
+               timer_ic_prescaler psc = TIMER_IC_DIV1,
+               uint8 filter = 0,
+               uint32 prescaleFactor = 1);
+
+    /**
+     * @brief Measure period and pulse width in PWM input mode.
+     *
+     * @param minFrequency Lowest frequency to measure, in Hz; sets the
+     *                     timer prescaler so its period fits.  Below
+     *                     it the signal counts as lost.
+     * @param edge Edge a period starts on, TIMER_IC_RISING or
+     *             TIMER_IC_FALLING; the pulse is the part after it.
+     * @param filter Digital input filter, from 0 (off) to 15.
+     * @return false unless the channel is 1 or 2 and the edge rising
+     *         or falling.
+     */
+    bool beginPwm(uint32 minFrequency,
+                  timer_ic_edge edge = TIMER_IC_RISING,
+                  uint8 filter = 0);
+
+    /** Stop capturing and release the timer. */
+    void end(void);
+
+    /** Timer ticks per second the captures are counted in. */
+    uint32 getTickRate(void) const { return tickRate; }
+
+    /** Ring mode: timestamps read() can return. */
+    uint32 available(void);
+
+    /**
+     * @brief Ring mode: read the oldest unread timestamp.
+     * @param stamp Set to the counter value at the capture.
+     * @return false if there is none.
+     */
+    bool read(uint32 *stamp);
+
+    /** Ring mode: captures since begin(), modulo 2^32. */
+    uint32 getCaptures(void);
+
+    /** Ring mode: captures read() skipped because it fell behind. */
+    uint32 getOverruns(void) const;
+
+    /**
+     * @brief Ring mode: ticks spanned by the newest captures.
+     * @param captures Intervals to span, from 1 to the ring length - 2.
+     * @return Ticks, or 0 if too few captures were made.
+     */
+    uint32 getSpan(uint16 captures);
+
+    /**
+     * @brief Signal frequency in Hz.
+     *
+     * In ring mode, averaged over the newest `periods' captures and
+     * 0 until there are that many; a signal that stopped keeps its
+     * last value, so watch getCaptures() to tell.  In PWM mode, from
+     * the last period, and 0 if none was seen for a whole counter
+     * range.
+     */
+    float getFrequency(uint16 periods = 16);
+
+    /**
+     * @brief PWM mode: fraction of the period after the starting edge,
+     *        from 0 to 1.  0 in ring mode or when the signal is lost.
+     */
+    float getDuty(void);
+
+    /**
+     * @brief Print the state on one line:
+     *
+     *     inputcapture ticks=N captures=N overruns=N freq=F
+     */
+    void printStats(Print &out);
+
+    /** Call from the DMA interrupt; public only for the ISR. */
+    void handle(void) { timer_capture_lap(&cap); }
+
+private:
+    timer_dev *timer;
+    uint8 channel;
+    uint8 edgesPerCapture;
+    bool pwm;
+    bool running;
+    int8 slot;
+    uint32 *ring;
+    uint16 length;
+    uint32 tickRate;
+    timer_capture cap;
+
+    bool signalPresent(void);
+    void startTimer(uint32 prescaleFactor);
+};
+
+#endif
+
+#endif
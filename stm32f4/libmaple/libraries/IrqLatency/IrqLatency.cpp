@@ -0,0 +1,448 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file IrqLatency.cpp
+ * @brief Interrupt latency and jitter measurement.
+ */
+
+#include "IrqLatency.h"
+#include "boards.h"
+#include "io.h"
+#include "dwt.h"
+#include "exti.h"
+#include "gpio.h"
+
+/* Bar length of the fullest bin in LatencyHistogram::dump() */
+#define BAR_WIDTH 40
+
+/* Trigger lead, see IrqLatency::measure() */
+#define LEAD_MIN 256
+#define LEAD_SPAN 2048
+
+static IrqLatency *activeLatency;
+
+static void latencyIsr(void) {
+    uint32 now = dwt_cycles();
+    activeLatency->handle(now);
+}
+
+/* exti_attach_interrupt() wants a handler; the vector bypasses it. */
+static void extiUnused(void) {
+}
+
+static inline uint32 irqSave(void) {
+    uint32 primask;
+    asm volatile("mrs %0, primask \n\t"
+                 "cpsid i"
+                 : "=r"(primask) : : "memory");
+    return primask;
+}
+
+static inline void irqRestore(uint32 primask) {
+    asm volatile("msr primask, %0" : : "r"(primask) : "memory");
+}
+
+static nvic_irq_num timerCcIrq(timer_dev *dev) {
+    if (dev == TIMER1) {
+        return NVIC_TIMER1_CC;
+    } else if (dev == TIMER2) {
+        return NVIC_TIMER2;
+    } else if (dev == TIMER3) {
+        return NVIC_TIMER3;
+    } else if (dev == TIMER4) {
+        return NVIC_TIMER4;
+#ifdef STM32_HIGH_DENSITY
+    } else if (dev == TIMER5) {
+        return NVIC_TIMER5;
+    } else if (dev == TIMER8) {
+        return NVIC_TIMER8_CC;
+#endif
+    }
+    return NVIC_NMI;
+}
+
+static nvic_irq_num extiIrq(uint8 line) {
+    if (line < 5) {
+        return (nvic_irq_num)(NVIC_EXTI0 + line);
+    }
+    return line < 10 ? NVIC_EXTI_9_5 : NVIC_EXTI_15_10;
+}
+
+static inline __io uint32 *timerCcr(timer_dev *dev, uint8 channel) {
+    return &(dev->regs).gen->CCR1 + (channel - 1);
+}
+
+/*
+ * LatencyHistogram
+ */
+
+LatencyHistogram::LatencyHistogram(uint16 binCycles) {
+    this->binCycles = binCycles ? binCycles : 1;
+    reset();
+}
+
+void LatencyHistogram::reset(void) {
+    samples = 0;
+    min = 0xFFFFFFFF;
+    max = 0;
+    total = 0;
+    for (uint8 i = 0; i < IRQ_LATENCY_BINS; i++) {
+        bins[i] = 0;
+    }
+}
+
+void LatencyHistogram::add(uint32 cycles) {
+    uint32 bin = cycles / binCycles;
+    if (bin >= IRQ_LATENCY_BINS) {
+        bin = IRQ_LATENCY_BINS - 1;
+    }
+    bins[bin]++;
+    samples++;
+    total += cycles;
+    if (cycles < min) {
+        min = cycles;
+    }
+    if (cycles > max) {
+        max = cycles;
+    }
+}
+
+uint32 LatencyHistogram::getMean(void) const {
+    return samples ? (uint32)(total / samples) : 0;
+}
+
+void LatencyHistogram::dump(Print &out, const char *label) const {
+    uint32 fullest = 1;
+    for (uint8 i = 0; i < IRQ_LATENCY_BINS; i++) {
+        if (bins[i] > fullest) {
+            fullest = bins[i];
+        }
+    }
+
+    out.print("# latency ");
+    out.print(label);
+    out.print(" samples=");
+    out.print(samples);
+    out.print(" min=");
+    out.print(getMin());
+    out.print(" mean=");
+    out.print(getMean());
+    out.print(" max=");
+    out.print(max);
+    out.print(" bin=");
+    out.println(binCycles);
+
+    for (uint8 i = 0; i < IRQ_LATENCY_BINS; i++) {
+        if (!bins[i]) {
+            continue;
+        }
+        if (i == IRQ_LATENCY_BINS - 1) {
+            out.print(">=");
+        }
+        out.print((uint32)i * binCycles);
+        out.print(' ');
+        out.print(bins[i]);
+        out.print(' ');
+        uint32 bar = (bins[i] * BAR_WIDTH + fullest - 1) / fullest;
+        while (bar--) {
+            out.print('#');
+        }
+        out.println();
+    }
+}
+
+/*
+ * IrqLatency
+ */
+
+IrqLatency::IrqLatency(void) {
+    source = SOURCE_NONE;
+    irq = NVIC_NMI;
+    timer = NULL;
+    seed = 1;
+    armed = false;
+    pended = false;
+    fired = false;
+}
+
+void IrqLatency::beginSoftware(nvic_irq_num irq) {
+    end();
+    this->irq = irq;
+    source = SOURCE_SOFTWARE;
+    activeLatency = this;
+    nvic_install_handler(irq, latencyIsr);
+    nvic_irq_enable(irq);
+}
+
+/*
+ * Common setup of the compare channel on outPin: free-running at the
+ * timer clock, output low until the next arm().  Also measures the
+ * timer tick in core cycles, since APB1 and APB2 timers differ.
+ */
+bool IrqLatency::beginTimer(uint8 outPin) {
+    end();
+    if (outPin >= BOARD_NR_GPIO_PINS || !PIN_MAP[outPin].timer_device) {
+        return false;
+    }
+    timer = PIN_MAP[outPin].timer_device;
+    outChannel = PIN_MAP[outPin].timer_channel;
+    irq = timerCcIrq(timer);
+    if (irq == NVIC_NMI) {
+        timer = NULL;
+        return false;
+    }
+    this->outPin = outPin;
+
+    pinMode(outPin, PWM);
+    timer_pause(timer);
+    timer_set_prescaler(timer, 0);
+    timer_set_reload(timer, 0xFFFF);
+    timer_oc_set_mode(timer, outChannel, TIMER_OC_MODE_FORCE_INACTIVE, 0);
+    if (timer->type == TIMER_ADVANCED) {
+        (timer->regs).adv->BDTR |= TIMER_BDTR_MOE;
+    }
+    timer_generate_update(timer);
+    timer_resume(timer);
+
+    uint32 primask = irqSave();
+    uint16 c0 = timer_get_count(timer);
+    uint32 d0 = dwt_cycles();
+    dwt_delay_cycles(16384);
+    uint16 c1 = timer_get_count(timer);
+    uint32 d1 = dwt_cycles();
+    irqRestore(primask);
+    cyclesPerTick8 = ((d1 - d0) << 8) / (uint16)(c1 - c0);
+
+    activeLatency = this;
+    return true;
+}
+
+bool IrqLatency::beginCompare(uint8 outPin) {
+    if (!beginTimer(outPin)) {
+        return false;
+    }
+    source = SOURCE_COMPARE;
+    (timer->regs).gen->SR = ~BIT(outChannel);
+    timer_enable_irq(timer, outChannel);
+    nvic_install_handler(irq, latencyIsr);
+    nvic_irq_enable(irq);
+    return true;
+}
+
+bool IrqLatency::beginExti(uint8 outPin, uint8 inPin) {
+    if (inPin >= BOARD_NR_GPIO_PINS || !beginTimer(outPin)) {
+        return false;
+    }
+    source = SOURCE_EXTI;
+    this->inPin = inPin;
+    extiLine = PIN_MAP[inPin].gpio_bit;
+    irq = extiIrq(extiLine);
+
+    pinMode(inPin, INPUT);
+    nvic_install_handler(irq, latencyIsr);
+    exti_attach_interrupt((afio_exti_num)extiLine,
+                          gpio_exti_port(PIN_MAP[inPin].gpio_device),
+                          extiUnused, EXTI_RISING);
+    return true;
+}
+
+bool IrqLatency::beginCapture(uint8 outPin, uint8 inPin) {
+    if (inPin >= BOARD_NR_GPIO_PINS || !beginTimer(outPin)) {
+        return false;
+    }
+    if (PIN_MAP[inPin].timer_device != timer ||
+        PIN_MAP[inPin].timer_channel == outChannel) {
+        end();
+        return false;
+    }
+    source = SOURCE_CAPTURE;
+    this->inPin = inPin;
+    inChannel = PIN_MAP[inPin].timer_channel;
+
+    /* pinMode() routes the pin to the timer; then make the channel an
+     * input capturing rising edges on its own pin, unfiltered. */
+    pinMode(inPin, PWM);
+    timer_cc_disable(timer, inChannel);
+    __io uint32 *ccmr = &(timer->regs).gen->CCMR1 + (inChannel - 1) / 2;
+    uint8 shift = 8 * ((inChannel - 1) & 1);
+    *ccmr = (*ccmr & ~(0xFF << shift)) | (TIMER_CCMR_CCS_INPUT_TI1 << shift);
+    timer_cc_set_pol(timer, inChannel, 0);
+    timer_cc_enable(timer, inChannel);
+
+    (timer->regs).gen->SR = ~BIT(inChannel);
+    timer_enable_irq(timer, inChannel);
+    nvic_install_handler(irq, latencyIsr);
+    nvic_irq_enable(irq);
+    return true;
+}
+
+void IrqLatency::end(void) {
+    /* No source yet still leaves the timer run by a failed begin */
+    switch (source) {
+    case SOURCE_NONE:
+        break;
+    case SOURCE_SOFTWARE:
+        nvic_irq_disable(irq);
+        break;
+    case SOURCE_COMPARE:
+    case SOURCE_CAPTURE:
+        nvic_irq_disable(irq);
+        timer_disable_irq(timer, outChannel);
+        if (source == SOURCE_CAPTURE) {
+            timer_disable_irq(timer, inChannel);
+            pinMode(inPin, INPUT);
+        }
+        break;
+    case SOURCE_EXTI:
+        exti_detach_interrupt((afio_exti_num)extiLine);
+        break;
+    }
+    if (timer) {
+        timer_pause(timer);
+        pinMode(outPin, INPUT);
+        timer = NULL;
+    }
+    if (source != SOURCE_NONE) {
+        nvic_remove_handler(irq);
+    }
+    source = SOURCE_NONE;
+    armed = false;
+    if (activeLatency == this) {
+        activeLatency = NULL;
+    }
+}
+
+void IrqLatency::setPriority(uint8 priority) {
+    nvic_irq_set_priority(irq, priority);
+}
+
+uint32 IrqLatency::ticksToCycles(uint16 ticks) const {
+    return ((uint32)ticks * cyclesPerTick8) >> 8;
+}
+
+/*
+ * Schedule the next trigger lead cycles from now.  A timer trigger is
+ * a compare match lead cycles' worth of ticks ahead; the output is
+ * forced low, then set on the match, giving the EXTI and capture
+ * inputs a rising edge.  Reading the counter and the cycle counter
+ * back to back costs a few cycles of constant offset.
+ */
+void IrqLatency::arm(uint32 lead) {
+    uint32 primask = irqSave();
+    fired = false;
+    if (source == SOURCE_SOFTWARE) {
+        due = dwt_cycles() + lead;
+        armed = true;
+        irqRestore(primask);
+        return;
+    }
+
+    uint16 ticks = (lead << 8) / cyclesPerTick8;
+    timer_oc_set_mode(timer, outChannel, TIMER_OC_MODE_FORCE_INACTIVE, 0);
+    armTicks = timer_get_count(timer);
+    armCycles = dwt_cycles();
+    *timerCcr(timer, outChannel) = (uint16)(armTicks + ticks);
+    due = armCycles + ticksToCycles(ticks);
+    (timer->regs).gen->SR = ~(BIT(outChannel) |
+                              (source == SOURCE_CAPTURE ? BIT(inChannel) : 0));
+    if (source == SOURCE_EXTI) {
+        EXTI_BASE->PR = BIT(extiLine);
+    }
+    NVIC_BASE->ICPR[irq / 32] = BIT(irq % 32);
+    timer_oc_set_mode(timer, outChannel, TIMER_OC_MODE_ACTIVE_ON_MATCH, 0);
+    armed = true;
+    irqRestore(primask);
+}
+
+void IrqLatency::poll(void) {
+    if (source != SOURCE_SOFTWARE || !armed || pended ||
+        (int32)(dwt_cycles() - due) < 0) {
+        return;
+    }
+    uint32 primask = irqSave();
+    if (armed && !pended) {
+        pended = true;
+        due = dwt_cycles();
+        NVIC_BASE->ISPR[irq / 32] = BIT(irq % 32);
+    }
+    irqRestore(primask);
+}
+
+void IrqLatency::handle(uint32 now) {
+    switch (source) {
+    case SOURCE_COMPARE:
+        (timer->regs).gen->SR = ~BIT(outChannel);
+        break;
+    case SOURCE_CAPTURE:
+        captured = *timerCcr(timer, inChannel);
+        (timer->regs).gen->SR = ~BIT(inChannel);
+        break;
+    case SOURCE_EXTI:
+        EXTI_BASE->PR = BIT(extiLine);
+        break;
+    default:
+        break;
+    }
+    if (armed) {
+        armed = false;
+        entry = now;
+        fired = true;
+    }
+}
+
+uint32 IrqLatency::measure(LatencyHistogram &hist, uint32 samples,
+                           voidFuncPtr load) {
+    if (source == SOURCE_NONE) {
+        return 0;
+    }
+
+    uint32 taken;
+    for (taken = 0; taken < samples; taken++) {
+        seed = seed * 1664525 + 1013904223;
+        pended = false;
+        arm(LEAD_MIN + (seed >> 16) % LEAD_SPAN);
+
+        uint32 start = dwt_cycles();
+        while (!fired) {
+            if (load) {
+                load();
+            }
+            poll();
+            if (dwt_cycles() - start > IRQ_LATENCY_TIMEOUT) {
+                armed = false;
+                return taken;
+            }
+        }
+
+        uint32 edge = due;
+        if (source == SOURCE_CAPTURE) {
+            edge = armCycles + ticksToCycles((uint16)(captured - armTicks));
+        }
+        hist.add(entry - edge);
+    }
+    return taken;
+}
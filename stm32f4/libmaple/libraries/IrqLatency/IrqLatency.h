@@ -0,0 +1,237 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file IrqLatency.h
+ * @brief Interrupt latency and jitter measurement.
+ *
+ * An IrqLatency produces interrupts at known times and timestamps the
+ * first statement of their handler with the DWT cycle counter; the
+ * differences go into a LatencyHistogram.  The trigger can be
+ *
+ * - software: the interrupt is pended through NVIC_ISPR.  This needs
+ *   no wiring and no peripheral, so it also runs under QEMU, but only
+ *   covers the CPU side (exception entry, masking, preemption).
+ * - a timer compare match on a PWM-capable pin's channel.
+ * - an EXTI line: the compare output pin is wired to another pin and
+ *   its rising edge raises that pin's external interrupt.
+ * - an input capture: as above, but the other pin is a channel of the
+ *   same timer, which captures the edge's arrival time in hardware.
+ *
+ * The handler is installed straight into the RAM vector table with
+ * nvic_install_handler(), so the numbers do not include libmaple's
+ * dispatch code.  Only one IrqLatency runs at a time.
+ *
+ *     IrqLatency lat;
+ *     LatencyHistogram hist;
+ *
+ *     lat.beginExti(BOARD_PWM_PIN, BOARD_EXTI_PIN);
+ *     for (uint8 p = 0; p < 16; p += 4) {
+ *         lat.setPriority(p);
+ *         hist.reset();
+ *         lat.measure(hist, 1000);
+ *         hist.dump(SerialUSB, "exti");
+ *     }
+ *     lat.end();
+ *
+ * measure() can call a load function while it waits for each
+ * interrupt, e.g. one that holds a FreeRTOS critical section, to see
+ * how code masking interrupts shows up in the tail of the histogram.
+ */
+
+#ifndef _IRQ_LATENCY_H_
+#define _IRQ_LATENCY_H_
+
+#include "libmaple_types.h"
+#include "nvic.h"
+#include "timer.h"
+#include "Print.h"
+
+#ifdef MAPLE_IDE
+#include "wirish.h"             /* hack for IDE compile */
+#endif
+
+/** Number of bins in a LatencyHistogram; the last one catches the rest. */
+#ifndef IRQ_LATENCY_BINS
+#define IRQ_LATENCY_BINS 32
+#endif
+
+/** Cycles measure() waits for an interrupt before giving up. */
+#ifndef IRQ_LATENCY_TIMEOUT
+#define IRQ_LATENCY_TIMEOUT 10000000
+#endif
+
+class LatencyHistogram {
+public:
+    /**
+     * @param binCycles Width of each bin in cycles.
+     */
+    LatencyHistogram(uint16 binCycles = 4);
+
+    /** Clear all bins and statistics. */
+    void reset(void);
+
+    /** Count one latency. */
+    void add(uint32 cycles);
+
+    /**
+     * @brief Print the statistics and the non-empty bins.
+     *
+     *     # latency exti p4 samples=1000 min=31 mean=33 max=58 bin=4
+     *     28 312 ########
+     *     32 655 ################
+     *     ...
+     *
+     * Each bin line gives the bin's lowest latency in cycles, its
+     * count and a bar scaled to the fullest bin.  A last line starting
+     * with ">=" holds everything past the end of the table.
+     */
+    void dump(Print &out, const char *label) const;
+
+    uint32 getSamples(void) const { return samples; }
+    uint32 getMin(void) const { return samples ? min : 0; }
+    uint32 getMax(void) const { return max; }
+    uint32 getMean(void) const;
+    /** Peak-to-peak jitter, max - min. */
+    uint32 getJitter(void) const { return getMax() - getMin(); }
+    uint16 getBinCycles(void) const { return binCycles; }
+    uint32 getBin(uint8 bin) const { return bins[bin]; }
+
+private:
+    uint16 binCycles;
+    uint32 samples;
+    uint32 min;
+    uint32 max;
+    uint64 total;
+    uint32 bins[IRQ_LATENCY_BINS];
+};
+
+class IrqLatency {
+public:
+    IrqLatency(void);
+
+    /**
+     * @brief Trigger irq from software.
+     * @param irq An interrupt nothing else uses; its vector is taken
+     *            over until end().
+     */
+    void beginSoftware(nvic_irq_num irq);
+
+    /**
+     * @brief Trigger on a compare match of pin's timer channel.
+     *
+     * The pin also outputs a rising edge at each match.
+     *
+     * @return false if pin has no timer channel.
+     */
+    bool beginCompare(uint8 outPin);
+
+    /**
+     * @brief Trigger on inPin's external interrupt.
+     *
+     * outPin, a timer channel, must be wired to inPin.
+     *
+     * @return false if outPin has no timer channel.
+     */
+    bool beginExti(uint8 outPin, uint8 inPin);
+
+    /**
+     * @brief Trigger on an input capture on inPin.
+     *
+     * outPin must be wired to inPin, and both must be channels of the
+     * same timer.  The latency is counted from the captured edge
+     * rather than the expected one, so it includes neither the output
+     * nor the input synchronizer delay.
+     *
+     * @return false if the pins are not channels of the same timer.
+     */
+    bool beginCapture(uint8 outPin, uint8 inPin);
+
+    /** Stop, giving back the vector and the pins. */
+    void end(void);
+
+    /** Set the NVIC priority (0-15) of the measured interrupt. */
+    void setPriority(uint8 priority);
+
+    /** The interrupt being measured, NVIC_NMI before a begin. */
+    nvic_irq_num getIrq(void) const { return irq; }
+
+    /**
+     * @brief Measure a number of interrupts into hist.
+     *
+     * Each trigger is scheduled a pseudo-random 256 to 2303 cycles
+     * ahead, so that it lands at varying points of load.
+     *
+     * @param load Called repeatedly while waiting for each interrupt.
+     *             Software triggers only fire from poll(), so a load
+     *             that spins for long should call it too.
+     * @return Samples taken; less than samples if an interrupt went
+     *         missing for IRQ_LATENCY_TIMEOUT cycles (wiring, or a
+     *         priority the load keeps masked).
+     */
+    uint32 measure(LatencyHistogram &hist, uint32 samples,
+                   voidFuncPtr load = NULL);
+
+    /** Fire a due software trigger.  Safe to call at any time. */
+    void poll(void);
+
+    /** Call from the interrupt; public only for the ISR. */
+    void handle(uint32 entry);
+
+private:
+    enum Source {
+        SOURCE_NONE,
+        SOURCE_SOFTWARE,
+        SOURCE_COMPARE,
+        SOURCE_EXTI,
+        SOURCE_CAPTURE,
+    };
+
+    Source source;
+    nvic_irq_num irq;
+    timer_dev *timer;
+    uint8 outChannel;
+    uint8 inChannel;
+    uint8 extiLine;
+    uint8 outPin;
+    uint8 inPin;
+    uint32 cyclesPerTick8;      /* core cycles per timer tick, Q8 */
+    uint32 seed;
+    volatile bool armed;
+    volatile bool pended;
+    volatile bool fired;
+    volatile uint32 due;        /* trigger time, DWT cycles */
+    volatile uint32 entry;      /* handler entry, DWT cycles */
+    volatile uint16 captured;   /* captured CCR, SOURCE_CAPTURE */
+    uint16 armTicks;            /* counter at arm(), timer ticks */
+    uint32 armCycles;           /* DWT cycles at the same time */
+
+    bool beginTimer(uint8 outPin);
+    void arm(uint32 lead);
+    uint32 ticksToCycles(uint16 ticks) const;
+};
+
+#endif
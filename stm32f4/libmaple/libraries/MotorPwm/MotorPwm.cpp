@@ -0,0 +1,362 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file MotorPwm.cpp
+ * @brief Three-phase bridge PWM on an advanced timer.
+ */
+
+#include "MotorPwm.h"
+#include "boards.h"
+#include "rcc.h"
+#include "dwt.h"
+
+#ifdef STM32_HIGH_DENSITY
+#define NR_MOTOR_TIMERS 2
+#else
+#define NR_MOTOR_TIMERS 1
+#endif
+
+/* One per advanced timer: TIMER1, TIMER8 */
+static MotorPwm *bridges[NR_MOTOR_TIMERS];
+
+static void update0Isr(void) {
+    bridges[0]->handleUpdate();
+}
+
+static void break0Isr(void) {
+    bridges[0]->handleBreak();
+}
+
+#ifdef STM32_HIGH_DENSITY
+static void update1Isr(void) {
+    bridges[1]->handleUpdate();
+}
+
+static void break1Isr(void) {
+    bridges[1]->handleBreak();
+}
+#endif
+
+static voidFuncPtr const updateIsrs[NR_MOTOR_TIMERS] = {
+    update0Isr,
+#ifdef STM32_HIGH_DENSITY
+    update1Isr,
+#endif
+};
+
+static voidFuncPtr const breakIsrs[NR_MOTOR_TIMERS] = {
+    break0Isr,
+#ifdef STM32_HIGH_DENSITY
+    break1Isr,
+#endif
+};
+
+static int8 timerSlot(timer_dev *timer) {
+    if (timer == TIMER1) {
+        return 0;
+#ifdef STM32_HIGH_DENSITY
+    } else if (timer == TIMER8) {
+        return 1;
+#endif
+    }
+    return -1;
+}
+
+MotorPwm::MotorPwm(timer_dev *timer) {
+    this->timer = timer;
+    this->slot = -1;
+    this->period = 0;
+    this->frequency = 0;
+    this->deadTimeNs = 0;
+    this->cyclesPerTick = 1;
+    this->onBreak = NULL;
+    this->latencyPending = false;
+    this->commitCycles = 0;
+    this->measuring = false;
+    this->resetStats();
+}
+
+bool MotorPwm::begin(uint32 frequency, uint32 deadTimeNs,
+                     bool centerAligned) {
+    int8 slot = timerSlot(timer);
+    uint32 clock = rcc_dev_timer_clk_speed(timer->clk_id);
+
+    if (slot < 0 || frequency == 0) {
+        return false;
+    }
+    if (bridges[slot]) {
+        bridges[slot]->end();
+    }
+    bridges[slot] = this;
+    this->slot = slot;
+
+    /* Counting up and down takes twice the reload value per period */
+    uint32 ticks = (clock + frequency / 2) / frequency;
+    if (centerAligned) {
+        ticks /= 2;
+    }
+    uint32 prescaler = ticks / 0xFFFF + 1;
+    uint32 reload = (ticks + prescaler / 2) / prescaler;
+    if (reload < 2) {
+        reload = 2;
+    }
+    this->period = (uint16)reload;
+    this->frequency = clock / (prescaler * reload * (centerAligned ? 2 : 1));
+    this->cyclesPerTick = (uint32)((uint64)CYCLES_PER_MICROSECOND * 1000000 *
+                                   prescaler / clock);
+
+    boardEnsureTimer(timer);
+    timer_pause(timer);
+    timer_detach_interrupt(timer, TIMER_UPDATE_INTERRUPT);
+    timer_set_ccx_preload(timer, 0, 0);
+
+    /* Off-state outputs held inactive, rather than floating */
+    (timer->regs).adv->BDTR = TIMER_BDTR_OSSR | TIMER_BDTR_OSSI;
+    uint64 deadTicks = ((uint64)clock * deadTimeNs + 999999999) / 1000000000;
+    deadTicks = timer_set_dead_time(timer, deadTicks > 1008 ?
+                                    1008 : (uint32)deadTicks);
+    this->deadTimeNs = (uint32)(deadTicks * 1000000000 / clock);
+
+    timer_set_count_mode(timer, centerAligned ? TIMER_COUNT_CENTER_DOWN :
+                         TIMER_COUNT_EDGE);
+    timer_set_prescaler(timer, (uint16)(prescaler - 1));
+    if (centerAligned) {
+        timer_set_reload(timer, reload);
+        timer_set_repetition(timer, 1);   /* one update per period */
+    } else {
+        timer_set_reload(timer, reload - 1);
+        timer_set_repetition(timer, 0);
+    }
+    for (uint8 ch = 1; ch <= MOTOR_PWM_PHASES; ch++) {
+        timer_set_compare(timer, ch, 0);
+        timer_set_mode(timer, ch, TIMER_PWM_COMPLEMENTARY);
+    }
+    timer_set_ccx_preload(timer, 1, 0);
+    timer_generate_update(timer);
+
+    this->resetStats();
+    latencyPending = false;
+    if (measuring) {
+        timer_attach_interrupt(timer, TIMER_UPDATE_INTERRUPT,
+                               updateIsrs[slot]);
+    }
+    timer_attach_interrupt(timer, TIMER_BREAK_INTERRUPT, breakIsrs[slot]);
+    timer_resume(timer);
+    return true;
+}
+
+void MotorPwm::end(void) {
+    if (slot < 0) {
+        return;
+    }
+    this->disableOutputs();
+    timer_detach_interrupt(timer, TIMER_UPDATE_INTERRUPT);
+    timer_detach_interrupt(timer, TIMER_BREAK_INTERRUPT);
+    timer_pause(timer);
+    timer_set_ccx_preload(timer, 0, 0);
+    for (uint8 ch = 1; ch <= MOTOR_PWM_PHASES; ch++) {
+        timer_set_mode(timer, ch, TIMER_DISABLED);
+    }
+    timer_set_count_mode(timer, TIMER_COUNT_EDGE);
+    timer_set_repetition(timer, 0);
+    bridges[slot] = NULL;
+    slot = -1;
+}
+
+void MotorPwm::commitDuties(void) {
+    if (measuring) {
+        commitCycles = dwt_cycles();
+        latencyPending = true;
+    }
+}
+
+void MotorPwm::setDuty(uint16 a, uint16 b, uint16 c) {
+    __io uint32 *udis = bb_perip(&(timer->regs).adv->CR1,
+                                 TIMER_CR1_UDIS_BIT);
+
+    /* No update may pick up some of the new duties and not others */
+    *udis = 1;
+    timer_set_compare(timer, 1, a < period ? a : period);
+    timer_set_compare(timer, 2, b < period ? b : period);
+    timer_set_compare(timer, 3, c < period ? c : period);
+    *udis = 0;
+    this->commitDuties();
+}
+
+void MotorPwm::setDuty(uint8 phase, uint16 duty) {
+    if (phase < MOTOR_PWM_PHASES) {
+        timer_set_compare(timer, phase + 1, duty < period ? duty : period);
+        this->commitDuties();
+    }
+}
+
+void MotorPwm::setPhase(uint8 phase, MotorPhaseOutput output) {
+    uint8 ch = phase + 1;
+
+    if (phase >= MOTOR_PWM_PHASES) {
+        return;
+    }
+    /* Preloaded: nothing changes until commutate() */
+    switch (output) {
+    case MOTOR_PHASE_PWM:
+        timer_oc_set_mode(timer, ch, TIMER_OC_MODE_PWM_1, TIMER_OC_PE);
+        timer_cc_enable(timer, ch);
+        timer_ccn_enable(timer, ch);
+        break;
+    case MOTOR_PHASE_LOW:
+        timer_oc_set_mode(timer, ch, TIMER_OC_MODE_FORCE_INACTIVE,
+                          TIMER_OC_PE);
+        timer_cc_enable(timer, ch);
+        timer_ccn_enable(timer, ch);
+        break;
+    case MOTOR_PHASE_OFF:
+        timer_cc_disable(timer, ch);
+        timer_ccn_disable(timer, ch);
+        break;
+    }
+}
+
+void MotorPwm::commutate(void) {
+    timer_generate_com(timer);
+}
+
+void MotorPwm::enableOutputs(void) {
+    (timer->regs).adv->SR = (uint32)~TIMER_SR_BIF;
+    timer_enable_irq(timer, TIMER_BREAK_INTERRUPT);
+    timer_set_main_output(timer, 1);
+}
+
+void MotorPwm::disableOutputs(void) {
+    timer_set_main_output(timer, 0);
+}
+
+bool MotorPwm::outputsEnabled(void) const {
+    return timer_get_main_output(timer);
+}
+
+void MotorPwm::enableBreak(bool activeHigh, bool autoRestart) {
+    timer_break_setup(timer, 1, activeHigh, autoRestart);
+}
+
+void MotorPwm::disableBreak(void) {
+    timer_break_setup(timer, 0, 0, 0);
+}
+
+void MotorPwm::emergencyStop(void) {
+    timer_generate_break(timer);
+}
+
+void MotorPwm::handleBreak(void) {
+    /* BIF stays set while the input is active; see enableOutputs() */
+    timer_disable_irq(timer, TIMER_BREAK_INTERRUPT);
+    breaks++;
+    if (onBreak) {
+        onBreak();
+    }
+}
+
+void MotorPwm::measureLatency(bool enable) {
+    measuring = enable;
+    latencyPending = false;
+    if (slot < 0) {
+        return;
+    }
+    if (enable) {
+        timer_attach_interrupt(timer, TIMER_UPDATE_INTERRUPT,
+                               updateIsrs[slot]);
+    } else {
+        timer_detach_interrupt(timer, TIMER_UPDATE_INTERRUPT);
+    }
+}
+
+void MotorPwm::handleUpdate(void) {
+    timer_adv_reg_map *regs = (timer->regs).adv;
+    uint32 now = dwt_cycles();
+    uint32 count = regs->CNT;
+    uint32 since;
+    uint32 elapsed;
+    uint32 latency;
+
+    if (!latencyPending) {
+        return;
+    }
+    /* Time since the update, from where the counter has got to */
+    if (regs->CR1 & TIMER_CR1_DIR) {
+        since = (regs->ARR - count) * cyclesPerTick;
+    } else {
+        since = count * cyclesPerTick;
+    }
+    elapsed = now - commitCycles;
+    if (elapsed < since) {
+        /* An update from before the duties were set */
+        return;
+    }
+    latency = elapsed - since;
+    latencyPending = false;
+
+    if (latency < latencyMin) {
+        latencyMin = latency;
+    }
+    if (latency > latencyMax) {
+        latencyMax = latency;
+    }
+    latencyTotal += latency;
+    latencySamples++;
+}
+
+uint32 MotorPwm::getLatencyMean(void) const {
+    if (!latencySamples) {
+        return 0;
+    }
+    return (uint32)(latencyTotal / latencySamples);
+}
+
+void MotorPwm::resetStats(void) {
+    breaks = 0;
+    latencySamples = 0;
+    latencyMin = 0xFFFFFFFF;
+    latencyMax = 0;
+    latencyTotal = 0;
+}
+
+void MotorPwm::printStats(Print &out) const {
+    out.print("motorpwm freq=");
+    out.print(frequency);
+    out.print(" deadtime=");
+    out.print(deadTimeNs);
+    out.print(" breaks=");
+    out.print(breaks);
+    out.print(" latency=");
+    out.print(this->getLatencyMin());
+    out.print("/");
+    out.print(this->getLatencyMean());
+    out.print("/");
+    out.print(latencyMax);
+    out.print(" samples=");
+    out.print(latencySamples);
+    out.println();
+}
@@ -0,0 +1,235 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file MotorPwm.h
+ * @brief Three-phase bridge PWM on an advanced timer.
+ *
+ * Channels 1 to 3 of TIMER1 or TIMER8 drive the high side switches
+ * and their complementary outputs CH1N to CH3N the low side ones,
+ * with a dead time between the two so that a phase leg never shorts.
+ * Counting is center-aligned by default, which centres the three
+ * phases' pulses on each other and halves the switching noise seen by
+ * current sensing at the middle of the period.
+ *
+ *     MotorPwm bridge(TIMER1);                // PE9/8, PE11/10, PE13/12
+ *
+ *     void setup() {
+ *         bridge.begin(20000, 500);           // 20 kHz, 500 ns
+ *         bridge.enableBreak(false);          // BKIN (PE15) active low
+ *         bridge.enableOutputs();
+ *     }
+ *
+ *     void loop() {
+ *         uint16 full = bridge.getPeriod();
+ *         bridge.setDuty(full / 2, full / 4, full * 3 / 4);
+ *     }
+ *
+ * setDuty() writes all three compare values with update events held
+ * off, so the new duties always take effect together, at the next
+ * update; one comes per PWM period.  For six-step (trapezoidal)
+ * drive, setPhase() preloads each phase's output pattern and
+ * commutate() switches all of them at once through the timer's
+ * commutation event.
+ *
+ * The break input turns every output off in hardware, asynchronously
+ * and without the CPU; so does emergencyStop().  Outputs stay off
+ * until enableOutputs(), unless the break was set up to restart
+ * automatically.
+ *
+ * measureLatency() times, in core cycles, how long each setDuty()
+ * waits for the update event that applies it: from nothing up to one
+ * PWM period, depending on where in the period it was called.
+ *
+ * The output pins are left to the caller; on the STM32F4 Discovery
+ * only the TIMER1 channel pins are set up by the board.
+ */
+
+#ifndef _MOTOR_PWM_H_
+#define _MOTOR_PWM_H_
+
+#include "libmaple_types.h"
+#include "timer.h"
+#include "Print.h"
+
+#ifdef MAPLE_IDE
+#include "wirish.h"             /* hack for IDE compile */
+#endif
+
+/** Phases a MotorPwm drives, on channels 1 to 3. */
+#define MOTOR_PWM_PHASES 3
+
+/** What a phase's outputs do; see MotorPwm::setPhase(). */
+enum MotorPhaseOutput {
+    MOTOR_PHASE_PWM,            /**< High side at the duty, low side
+                                     the rest of the period */
+    MOTOR_PHASE_LOW,            /**< Low side on */
+    MOTOR_PHASE_OFF             /**< Both off; the phase floats */
+};
+
+class MotorPwm {
+public:
+    /** @param timer TIMER1 or TIMER8. */
+    MotorPwm(timer_dev *timer);
+
+    /**
+     * @brief Take over the timer, with all outputs off.
+     *
+     * All phases are set to MOTOR_PHASE_PWM at zero duty.  Call
+     * enableOutputs() to start driving the bridge.
+     *
+     * @param frequency PWM frequency in Hz.
+     * @param deadTimeNs Dead time, rounded up to the timer's steps.
+     * @param centerAligned Count up and down rather than up.
+     * @return false if the timer is not an advanced timer.
+     */
+    bool begin(uint32 frequency, uint32 deadTimeNs,
+               bool centerAligned = true);
+
+    /** Turn the outputs off and stop the timer. */
+    void end(void);
+
+    /** The duty for a 100% high side on-time. */
+    uint16 getPeriod(void) const { return period; }
+
+    /** The PWM frequency actually set. */
+    uint32 getFrequency(void) const { return frequency; }
+
+    /** The dead time actually set, in nanoseconds. */
+    uint32 getDeadTime(void) const { return deadTimeNs; }
+
+    /**
+     * @brief Set the three duties at once.
+     *
+     * They take effect together at the next update event.  Duties
+     * above getPeriod() are clamped.
+     */
+    void setDuty(uint16 a, uint16 b, uint16 c);
+
+    /** Set one phase's duty, from 0, taking effect at the next update. */
+    void setDuty(uint8 phase, uint16 duty);
+
+    /**
+     * @brief Preload a phase's output pattern for commutate().
+     * @param phase From 0 to 2.
+     */
+    void setPhase(uint8 phase, MotorPhaseOutput output);
+
+    /** Switch in the patterns preloaded by setPhase() at once. */
+    void commutate(void);
+
+    /** Drive the bridge; also re-arms it after a break. */
+    void enableOutputs(void);
+
+    /** Turn all outputs off. */
+    void disableOutputs(void);
+
+    /** Whether the outputs are being driven. */
+    bool outputsEnabled(void) const;
+
+    /**
+     * @brief Let the break input (BKIN) turn the outputs off.
+     * @param activeHigh Break on a high level, else on a low one.
+     * @param autoRestart Turn the outputs back on at the first update
+     *                    event after the break input goes inactive.
+     */
+    void enableBreak(bool activeHigh, bool autoRestart = false);
+
+    /** Ignore the break input. */
+    void disableBreak(void);
+
+    /**
+     * @brief Set a function to call from the break interrupt, or NULL.
+     *
+     * The outputs are already off by the time it runs.
+     */
+    void attachBreak(voidFuncPtr handler) { this->onBreak = handler; }
+
+    /** Turn the outputs off through a break event. */
+    void emergencyStop(void);
+
+    /**
+     * @brief Breaks since begin(), from BKIN or emergencyStop().
+     *
+     * The break interrupt is held off from the first break until
+     * enableOutputs(), so an input held active counts once.
+     */
+    uint32 getBreaks(void) const { return breaks; }
+
+    /**
+     * @brief Measure setDuty() latency in the update interrupt.
+     *
+     * Only duties set with latency measurement on are timed.
+     */
+    void measureLatency(bool enable);
+
+    uint32 getLatencySamples(void) const { return latencySamples; }
+    uint32 getLatencyMin(void) const {
+        return latencySamples ? latencyMin : 0;
+    }
+    uint32 getLatencyMax(void) const { return latencyMax; }
+    uint32 getLatencyMean(void) const;
+
+    void resetStats(void);
+
+    /**
+     * @brief Print the settings and statistics on one line:
+     *
+     *     motorpwm freq=N deadtime=N breaks=N latency=N/N/N samples=N
+     *
+     * The dead time is in nanoseconds, and the latencies are the
+     * minimum, mean and maximum in core cycles.
+     */
+    void printStats(Print &out) const;
+
+    /** Call from the update interrupt; public only for the ISR. */
+    void handleUpdate(void);
+    /** Call from the break interrupt; public only for the ISR. */
+    void handleBreak(void);
+
+private:
+    timer_dev *timer;
+    int8 slot;
+    uint16 period;
+    uint32 frequency;
+    uint32 deadTimeNs;
+    uint32 cyclesPerTick;
+    voidFuncPtr onBreak;
+
+    volatile bool latencyPending;
+    volatile uint32 commitCycles;
+    bool measuring;
+
+    volatile uint32 breaks;
+    volatile uint32 latencySamples;
+    volatile uint32 latencyMin;
+    volatile uint32 latencyMax;
+    volatile uint64 latencyTotal;
+
+    void commitDuties(void);
+};
+
+#endif
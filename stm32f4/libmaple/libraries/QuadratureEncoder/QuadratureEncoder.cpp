@@ -0,0 +1,208 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file QuadratureEncoder.cpp
+ * @brief Quadrature encoder decoding in a timer's encoder mode.
+ */
+
+#include "QuadratureEncoder.h"
+#include "boards.h"
+#include "wirish_time.h"
+#include "nvic.h"
+
+#ifdef STM32_HIGH_DENSITY
+#define NR_ENCODER_TIMERS 6
+#else
+#define NR_ENCODER_TIMERS 4
+#endif
+
+/* One per timer that can decode: TIMER1, 2, 3, 4, 5, 8 */
+static QuadratureEncoder *activeEncoders[NR_ENCODER_TIMERS];
+
+#define ENCODER_ISRS(n)                         \
+    static void sync##n(void) {                 \
+        activeEncoders[n]->handleSync();        \
+    }                                           \
+    static void index##n(void) {                \
+        activeEncoders[n]->handleIndex();       \
+    }
+
+ENCODER_ISRS(0)
+ENCODER_ISRS(1)
+ENCODER_ISRS(2)
+ENCODER_ISRS(3)
+#ifdef STM32_HIGH_DENSITY
+ENCODER_ISRS(4)
+ENCODER_ISRS(5)
+#endif
+
+static voidFuncPtr const syncIsrs[NR_ENCODER_TIMERS] = {
+    sync0, sync1, sync2, sync3,
+#ifdef STM32_HIGH_DENSITY
+    sync4, sync5,
+#endif
+};
+
+static voidFuncPtr const indexIsrs[NR_ENCODER_TIMERS] = {
+    index0, index1, index2, index3,
+#ifdef STM32_HIGH_DENSITY
+    index4, index5,
+#endif
+};
+
+static int8 timerSlot(timer_dev *timer) {
+    if (timer == TIMER1) {
+        return 0;
+    } else if (timer == TIMER2) {
+        return 1;
+    } else if (timer == TIMER3) {
+        return 2;
+    } else if (timer == TIMER4) {
+        return 3;
+#ifdef STM32_HIGH_DENSITY
+    } else if (timer == TIMER5) {
+        return 4;
+    } else if (timer == TIMER8) {
+        return 5;
+#endif
+    }
+    return -1;
+}
+
+QuadratureEncoder::QuadratureEncoder(timer_dev *timer) {
+    this->timer = timer;
+    this->slot = -1;
+    this->indexPin = 0xFF;
+    this->indexOnce = false;
+    this->indexCount = 0;
+    this->velocityPosition = 0;
+    this->velocityMicros = 0;
+    this->velocity = 0;
+
+    /* Reads before begin() see a stopped counter at 0 */
+    this->enc.timer = timer;
+    this->enc.wide = 1;
+    this->enc.state[0].base = 0;
+    this->enc.state[0].last = 0;
+    this->enc.gen = 0;
+    this->enc.zero = 0;
+}
+
+bool QuadratureEncoder::begin(timer_encoder_mode mode, uint8 filter,
+                              bool reverse) {
+    int8 slot = timerSlot(timer);
+
+    if (slot < 0) {
+        return false;
+    }
+    if (activeEncoders[slot]) {
+        activeEncoders[slot]->end();
+    }
+    this->slot = slot;
+    activeEncoders[slot] = this;
+
+    boardEnsureTimer(timer);
+    timer_pause(timer);
+    timer_set_count(timer, 0);
+    timer_encoder_setup(timer, mode, filter, reverse);
+    timer_encoder_init(&enc, timer);
+    timer_encoder_start(&enc, syncIsrs[slot]);
+    indexCount = 0;
+    velocityPosition = 0;
+    velocityMicros = micros();
+    velocity = 0;
+    timer_resume(timer);
+    return true;
+}
+
+void QuadratureEncoder::end(void) {
+    if (slot < 0) {
+        return;
+    }
+    this->detachIndex();
+    timer_encoder_stop(&enc);
+    timer_pause(timer);
+    (timer->regs).gen->SMCR &= ~TIMER_SMCR_SMS;
+    activeEncoders[slot] = NULL;
+    slot = -1;
+}
+
+void QuadratureEncoder::attachIndex(uint8 pin, ExtIntTriggerMode edge,
+                                    bool once) {
+    if (slot < 0) {
+        return;
+    }
+    this->detachIndex();
+    indexOnce = once;
+    indexPin = pin;
+    attachInterrupt(pin, indexIsrs[slot], edge);
+}
+
+void QuadratureEncoder::detachIndex(void) {
+    if (indexPin != 0xFF) {
+        detachInterrupt(indexPin);
+        indexPin = 0xFF;
+    }
+}
+
+void QuadratureEncoder::handleIndex(void) {
+    if (!indexOnce || indexCount == 0) {
+        /* Rebase the velocity reference with the position */
+        int32 position = this->read();
+        timer_encoder_write(&enc, 0);
+        velocityPosition -= position;
+    }
+    indexCount++;
+}
+
+float QuadratureEncoder::getVelocity(uint32 minMicros) {
+    uint32 now = micros();
+    uint32 elapsed = now - velocityMicros;
+    int32 position;
+    int32 delta;
+
+    if (elapsed < minMicros || elapsed == 0) {
+        return velocity;
+    }
+    /* Keep an index pulse from landing between the two */
+    nvic_globalirq_disable();
+    position = this->read();
+    delta = position - velocityPosition;
+    velocityPosition = position;
+    nvic_globalirq_enable();
+    velocity = (float)delta * 1000000.0f / elapsed;
+    velocityMicros = now;
+    return velocity;
+}
+
+void QuadratureEncoder::printStats(Print &out) {
+    out.print("encoder pos=");
+    out.print((long)this->read());
+    out.print(" index=");
+    out.print(indexCount);
+    out.println();
+}
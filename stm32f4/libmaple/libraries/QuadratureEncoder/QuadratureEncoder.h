@@ -0,0 +1,153 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file QuadratureEncoder.h
+ * @brief Quadrature encoder decoding in a timer's encoder mode.
+ *
+ * The timer counts the encoder's A and B signals on its channel 1 and
+ * 2 inputs in hardware, so there is no interrupt per count and the
+ * count rate is limited only by the input filter.  On 16-bit timers
+ * the position is extended to 32 bits by an interrupt every 16384
+ * counts of travel (see timer_encoder.h); TIMER2 and TIMER5 of the
+ * STM32F2 need none.  read() is lock-free and may be called from any
+ * interrupt.
+ *
+ *     QuadratureEncoder motor(TIMER3);        // A on PB4, B on PB5
+ *
+ *     void setup() {
+ *         gpio_set_mode(GPIOB, 4, GPIO_AF_INPUT_PD);
+ *         gpio_set_mode(GPIOB, 5, GPIO_AF_INPUT_PD);
+ *         motor.begin(TIMER_ENCODER_TI12, 6);
+ *         motor.attachIndex(Port2Pin('B', 6), RISING);
+ *     }
+ *
+ *     void loop() {
+ *         int32 position = motor.read();
+ *         float speed = motor.getVelocity();  // counts per second
+ *     }
+ *
+ * The encoder inputs must be set to the timer's alternate function
+ * beforehand.  An index pulse goes through an external interrupt, so
+ * the position it resets is the one when its handler runs, a few
+ * hundred nanoseconds after the edge.
+ */
+
+#ifndef _QUADRATURE_ENCODER_H_
+#define _QUADRATURE_ENCODER_H_
+
+#include "libmaple_types.h"
+#include "timer.h"
+#include "timer_encoder.h"
+#include "ext_interrupts.h"
+#include "Print.h"
+
+#ifdef MAPLE_IDE
+#include "wirish.h"             /* hack for IDE compile */
+#endif
+
+class QuadratureEncoder {
+public:
+    /**
+     * @param timer TIMER1, 2, 3, 4, 5 or 8; it is taken over until
+     *              end(), channels 3 and 4 included.
+     */
+    QuadratureEncoder(timer_dev *timer);
+
+    /**
+     * @brief Start counting from position 0.
+     * @param mode TIMER_ENCODER_TI12 for 4 counts per cycle, or
+     *             TIMER_ENCODER_TI1 or TIMER_ENCODER_TI2 for 2.
+     * @param filter Digital input filter, from 0 (off) to 15.  Each
+     *               step rejects longer glitches and lowers the
+     *               highest count rate.
+     * @param reverse Count the other way.
+     * @return false if the timer cannot decode an encoder.
+     */
+    bool begin(timer_encoder_mode mode = TIMER_ENCODER_TI12,
+               uint8 filter = 0,
+               bool reverse = false);
+
+    /** Stop counting and release the timer and index pin. */
+    void end(void);
+
+    /** Position in counts; lock-free. */
+    int32 read(void) { return timer_encoder_read(&enc); }
+
+    /** Set the current position. */
+    void write(int32 position) { timer_encoder_write(&enc, position); }
+
+    /**
+     * @brief Reset the position to 0 on an index pulse.
+     * @param pin Pin the index signal is on.
+     * @param edge Edge that marks the index.
+     * @param once Reset only on the first pulse, to home the encoder;
+     *             later pulses are just counted.
+     */
+    void attachIndex(uint8 pin, ExtIntTriggerMode edge = RISING,
+                     bool once = false);
+
+    /** Stop watching the index pin. */
+    void detachIndex(void);
+
+    /** Index pulses seen since begin(). */
+    uint32 getIndexCount(void) const { return indexCount; }
+
+    /**
+     * @brief Velocity in counts per second.
+     *
+     * Measured between calls at least minMicros apart; a call sooner
+     * returns the previous value.  Meant for one caller, such as a
+     * control loop.
+     */
+    float getVelocity(uint32 minMicros = 1000);
+
+    /**
+     * @brief Print the state on one line:
+     *
+     *     encoder pos=N index=N
+     */
+    void printStats(Print &out);
+
+    /** Call from the timer interrupt; public only for the ISR. */
+    void handleSync(void) { timer_encoder_sync(&enc); }
+    /** Call from the index interrupt; public only for the ISR. */
+    void handleIndex(void);
+
+private:
+    timer_dev *timer;
+    timer_encoder enc;
+    int8 slot;
+    uint8 indexPin;
+    bool indexOnce;
+    volatile uint32 indexCount;
+
+    volatile int32 velocityPosition;
+    uint32 velocityMicros;
+    float velocity;
+};
+
+#endif
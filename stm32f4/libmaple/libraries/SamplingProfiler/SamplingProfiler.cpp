@@ -0,0 +1,232 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file SamplingProfiler.cpp
+ * @brief Statistical PC/LR sampling profiler driven by a spare timer.
+ */
+
+#include "SamplingProfiler.h"
+#include "nvic.h"
+
+/* Bounds of the code the histograms cover, from common.inc. */
+extern "C" char __text_start[];
+extern "C" char _etext[];
+
+/* Words of stack searched for the exception frame, see exceptionFrame() */
+#define FRAME_SCAN_WORDS 32
+
+/* Stacked xPSR always has the Thumb bit set */
+#define XPSR_T (1U << 24)
+
+static SamplingProfiler *activeProfiler;
+
+/*
+ * Find the registers stacked on entry to the current exception.
+ *
+ * Timer handlers are called by the libmaple dispatch code, not from
+ * the vector, so the frame is not at a fixed offset from our stack
+ * pointer.  __irq_timX calls the handler and therefore pushes its LR,
+ * which holds the EXC_RETURN value, as the top word of its own frame;
+ * the exception frame starts right above it on the main stack.  When
+ * EXC_RETURN says the interrupted code ran on the process stack (a
+ * FreeRTOS task) the frame is at PSP instead.  Bit 4 clear means the
+ * FPU registers were stacked too; they come after the eight basic
+ * words, so the PC and LR are at the same offsets either way.
+ */
+static bool isExcReturn(uint32 word) {
+    switch (word & ~0x10U) {
+    case 0xFFFFFFE1:            /* handler mode, MSP */
+    case 0xFFFFFFE9:            /* thread mode, MSP */
+    case 0xFFFFFFED:            /* thread mode, PSP */
+        return true;
+    }
+    return false;
+}
+
+static const uint32 *exceptionFrame(void) {
+    const uint32 *sp;
+    asm volatile("mov %0, sp" : "=r" (sp));
+
+    for (int i = 0; i < FRAME_SCAN_WORDS; i++) {
+        uint32 word = sp[i];
+        const uint32 *frame;
+        if (!isExcReturn(word)) {
+            continue;
+        }
+        if (word & 0x4) {
+            asm volatile("mrs %0, psp" : "=r" (frame));
+        } else {
+            frame = &sp[i + 1];
+        }
+        if (frame[7] & XPSR_T) {
+            return frame;
+        }
+    }
+    return NULL;
+}
+
+static void sampleHandler(void) {
+    SamplingProfiler *profiler = activeProfiler;
+    if (profiler == NULL) {
+        return;
+    }
+    const uint32 *frame = exceptionFrame();
+    if (frame == NULL) {
+        profiler->sampleLost();
+        return;
+    }
+    /* frame: r0, r1, r2, r3, r12, lr, pc, xpsr */
+    profiler->sample(frame[6], frame[5]);
+}
+
+static nvic_irq_num updateIrq(uint8 timerNum) {
+    switch (timerNum) {
+    case 1:
+        return NVIC_TIMER1_UP;
+    case 2:
+        return NVIC_TIMER2;
+    case 3:
+        return NVIC_TIMER3;
+    case 4:
+        return NVIC_TIMER4;
+#ifdef STM32_HIGH_DENSITY
+    case 5:
+        return NVIC_TIMER5;
+    case 6:
+        return NVIC_TIMER6;
+    case 7:
+        return NVIC_TIMER7;
+    case 8:
+        return NVIC_TIMER8_UP;
+#endif
+    }
+    return NVIC_TIMER2;
+}
+
+SamplingProfiler::SamplingProfiler(uint8 timerNum)
+    : timer(timerNum), timerNum(timerNum) {
+    uint32 size = (uint32)(_etext - __text_start);
+
+    base = (uint32)__text_start;
+    shift = 1;                  /* Thumb code is halfword aligned */
+    while ((size >> shift) >= SAMPLING_PROFILER_BUCKETS) {
+        shift++;
+    }
+    reset();
+}
+
+void SamplingProfiler::begin(uint32 periodUs, uint8 priority) {
+    if (activeProfiler != NULL) {
+        activeProfiler->end();
+    }
+
+    timer.pause();
+    timer.setPeriod(periodUs);
+    timer.setCount(0);
+    timer.refresh();
+    nvic_irq_set_priority(updateIrq(timerNum), priority);
+    activeProfiler = this;
+    timer.attachInterrupt(TIMER_UPDATE_INTERRUPT, sampleHandler);
+    timer.resume();
+}
+
+void SamplingProfiler::end(void) {
+    timer.pause();
+    timer.detachInterrupt(TIMER_UPDATE_INTERRUPT);
+    if (activeProfiler == this) {
+        activeProfiler = NULL;
+    }
+}
+
+void SamplingProfiler::reset(void) {
+    for (int i = 0; i < SAMPLING_PROFILER_BUCKETS; i++) {
+        pcHits[i] = 0;
+        lrHits[i] = 0;
+    }
+    samples = 0;
+    other = 0;
+    lost = 0;
+}
+
+void SamplingProfiler::count(uint16 *hits, uint32 addr) {
+    uint32 bucket = (addr - base) >> shift;
+    if (bucket < SAMPLING_PROFILER_BUCKETS) {
+        if (hits[bucket] != 0xFFFF) {
+            hits[bucket]++;
+        }
+    } else if (hits == pcHits) {
+        other++;
+    }
+}
+
+void SamplingProfiler::sample(uint32 pc, uint32 lr) {
+    samples++;
+    count(pcHits, pc);
+    count(lrHits, lr & ~1U);
+}
+
+void SamplingProfiler::dumpHistogram(Print &out, const char *tag,
+                                     const uint16 *hits) {
+    for (int i = 0; i < SAMPLING_PROFILER_BUCKETS; i++) {
+        if (hits[i] == 0) {
+            continue;
+        }
+        out.print(tag);
+        out.print(" 0x");
+        out.print(base + ((uint32)i << shift), HEX);
+        out.print(' ');
+        out.println((uint32)hits[i]);
+    }
+}
+
+void SamplingProfiler::dump(Print &out) {
+    /* Hold sampling so the dump is one consistent snapshot */
+    bool running = (activeProfiler == this);
+    if (running) {
+        timer.pause();
+    }
+
+    out.print("# profile base=0x");
+    out.print(base, HEX);
+    out.print(" shift=");
+    out.print(shift);
+    out.print(" buckets=");
+    out.print(SAMPLING_PROFILER_BUCKETS);
+    out.print(" samples=");
+    out.print(samples);
+    out.print(" other=");
+    out.print(other);
+    out.print(" lost=");
+    out.println(lost);
+    dumpHistogram(out, "pc", pcHits);
+    dumpHistogram(out, "lr", lrHits);
+    out.println("# end");
+
+    if (running) {
+        timer.resume();
+    }
+}
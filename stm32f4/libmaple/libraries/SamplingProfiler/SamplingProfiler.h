@@ -0,0 +1,140 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file SamplingProfiler.h
+ * @brief Statistical PC/LR sampling profiler driven by a spare timer.
+ *
+ * A timer interrupt at a fixed rate reads the program counter and
+ * link register stacked by the exception entry of whatever it
+ * interrupted, and counts them in histograms whose buckets split the
+ * .text section into equal address ranges.  The PC histogram shows
+ * where time is spent; the LR histogram shows who called the leaf
+ * functions.
+ *
+ *     SamplingProfiler profiler(4);
+ *
+ *     void setup() {
+ *         profiler.begin(250);            // sample every 250 us
+ *     }
+ *
+ *     void loop() {
+ *         work();
+ *         if (SerialUSB.available()) {
+ *             profiler.dump(SerialUSB);
+ *         }
+ *     }
+ *
+ * The dump is plain text; support/scripts/profsym.py resolves the
+ * buckets to function names against build/$(BOARD).elf or .map.
+ */
+
+#ifndef _SAMPLING_PROFILER_H_
+#define _SAMPLING_PROFILER_H_
+
+#include "libmaple_types.h"
+#include "HardwareTimer.h"
+#include "Print.h"
+
+#ifdef MAPLE_IDE
+#include "wirish.h"             /* hack for IDE compile */
+#endif
+
+/** Number of buckets in each of the PC and LR histograms. */
+#ifndef SAMPLING_PROFILER_BUCKETS
+#define SAMPLING_PROFILER_BUCKETS 256
+#endif
+
+class SamplingProfiler {
+public:
+    /**
+     * @param timerNum Timer to sample with.  It is used exclusively
+     *                 while the profiler runs.
+     */
+    SamplingProfiler(uint8 timerNum);
+
+    /**
+     * @brief Start sampling.
+     *
+     * Only one profiler samples at a time; starting one stops any
+     * other.  The histograms are not cleared, so begin()/end() pairs
+     * accumulate.
+     *
+     * @param periodUs Microseconds between samples.
+     * @param priority NVIC priority of the sampling interrupt.  The
+     *                 default 0 lets it sample inside other interrupt
+     *                 handlers.
+     */
+    void begin(uint32 periodUs = 1000, uint8 priority = 0);
+
+    /** Stop sampling. */
+    void end(void);
+
+    /** Clear the histograms and counters. */
+    void reset(void);
+
+    /**
+     * @brief Print the histograms.
+     *
+     * Output is one header line, one line per non-empty bucket and an
+     * end marker:
+     *
+     *     # profile base=0x08010000 shift=7 buckets=256 samples=N other=N lost=N
+     *     pc 0x08010480 123
+     *     lr 0x08012a00 45
+     *     # end
+     *
+     * Each bucket line gives the first address of its range, which is
+     * (1 << shift) bytes long.  "other" counts samples outside .text
+     * (code running from RAM) and "lost" samples whose exception frame
+     * could not be found.
+     */
+    void dump(Print &out);
+
+    /** Samples taken since the last reset(). */
+    uint32 getSamples(void) const { return samples; }
+
+    /** Call from the timer interrupt; public only for the ISR. */
+    void sample(uint32 pc, uint32 lr);
+    /** Count a sample whose stacked registers were not found. */
+    void sampleLost(void) { lost++; }
+
+private:
+    HardwareTimer timer;
+    uint8 timerNum;
+    uint8 shift;
+    uint32 base;
+    volatile uint32 samples;
+    volatile uint32 other;
+    volatile uint32 lost;
+    uint16 pcHits[SAMPLING_PROFILER_BUCKETS];
+    uint16 lrHits[SAMPLING_PROFILER_BUCKETS];
+
+    void count(uint16 *hits, uint32 addr);
+    void dumpHistogram(Print &out, const char *tag, const uint16 *hits);
+};
+
+#endif
@@ -0,0 +1,224 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file WS2812.cpp
+ * @brief WS2812 LED strings driven by a timer DMA burst.
+ */
+
+#include "WS2812.h"
+
+#ifdef STM32F2
+
+#include "boards.h"
+#include "rcc.h"
+#include "wirish_time.h"
+
+#define BUFFER_BITS (24 * WS2812_BUFFER_LEDS)
+
+/* One string per bursting timer: TIMER1, 3, 4, 8 */
+static WS2812 *strings[4];
+
+static void string0Isr(void) {
+    strings[0]->handle();
+}
+
+static void string1Isr(void) {
+    strings[1]->handle();
+}
+
+static void string2Isr(void) {
+    strings[2]->handle();
+}
+
+static void string3Isr(void) {
+    strings[3]->handle();
+}
+
+static voidFuncPtr const stringIsrs[4] = {
+    string0Isr, string1Isr, string2Isr, string3Isr
+};
+
+static int8 timerSlot(timer_dev *timer) {
+    if (timer == TIMER1) {
+        return 0;
+    } else if (timer == TIMER3) {
+        return 1;
+    } else if (timer == TIMER4) {
+        return 2;
+    } else if (timer == TIMER8) {
+        return 3;
+    }
+    return -1;
+}
+
+WS2812::WS2812(timer_dev *timer, uint8 channel, uint8 *pixels,
+               uint16 count) {
+    this->timer = timer;
+    this->channel = channel;
+    this->pixels = pixels;
+    this->count = count;
+    this->started = false;
+    this->done = NULL;
+    this->nextBit = 0;
+    this->buffersLeft = 0;
+    this->sending = false;
+    this->sentMicros = 0;
+    this->resetStats();
+}
+
+bool WS2812::begin(void) {
+    int8 slot = timerSlot(timer);
+    uint32 clock = rcc_dev_timer_clk_speed(timer->clk_id);
+
+    if (slot < 0 || !pixels || count == 0 ||
+        bitstream_ws2812_timing(&timing, clock) < 0) {
+        return false;
+    }
+    if (strings[slot]) {
+        strings[slot]->end();
+    }
+    strings[slot] = this;
+
+    boardEnsureTimer(timer);
+    timer_pause(timer);
+    timer_set_prescaler(timer, 0);
+    timer_set_reload(timer, timing.reload);
+    if (timer_burst_init(&burst, timer, channel, 1) < 0) {
+        strings[slot] = NULL;
+        return false;
+    }
+    timer_generate_update(timer);
+    timer_resume(timer);
+    started = true;
+    sending = false;
+    sentMicros = micros();
+    return true;
+}
+
+void WS2812::end(void) {
+    int8 slot = timerSlot(timer);
+
+    if (!started) {
+        return;
+    }
+    timer_burst_stop(&burst);
+    timer_pause(timer);
+    started = false;
+    sending = false;
+    strings[slot] = NULL;
+}
+
+void WS2812::setPixel(uint16 index, uint8 red, uint8 green, uint8 blue) {
+    if (index < count) {
+        pixels[3 * index] = green;
+        pixels[3 * index + 1] = red;
+        pixels[3 * index + 2] = blue;
+    }
+}
+
+void WS2812::clear(void) {
+    for (uint32 i = 0; i < 3 * (uint32)count; i++) {
+        pixels[i] = 0;
+    }
+}
+
+bool WS2812::show(void) {
+    uint32 bits = 24 * (uint32)count;
+
+    if (!started) {
+        return false;
+    }
+    while (this->busy())
+        ;
+
+    nextBit = bitstream_encode(&timing, pixels, 0, bits,
+                               slots[0], BUFFER_BITS, 1);
+    nextBit += bitstream_encode(&timing, pixels, nextBit, bits,
+                                slots[1], BUFFER_BITS, 1);
+    /* Enough to end on at least one idle slot */
+    buffersLeft = bits / BUFFER_BITS + 1;
+    sending = true;
+    if (timer_burst_stream(&burst, slots[0], slots[1], BUFFER_BITS,
+                           stringIsrs[timerSlot(timer)]) < 0) {
+        sending = false;
+        return false;
+    }
+    return true;
+}
+
+bool WS2812::busy(void) const {
+    return sending ||
+        micros() - sentMicros < BITSTREAM_WS2812_RESET_US;
+}
+
+void WS2812::handle(void) {
+    if (!timer_burst_finish(&burst)) {
+        if (!timer_burst_busy(&burst)) {
+            /* Transfer error; the burst has been stopped */
+            sending = false;
+            sentMicros = micros();
+        }
+        return;
+    }
+
+    if (--buffersLeft == 0) {
+        timer_burst_stop(&burst);
+        sentMicros = micros();
+        sending = false;
+        frames++;
+        if (done) {
+            done();
+        }
+        return;
+    }
+
+    uint16 *idle = timer_burst_idle_buffer(&burst);
+    nextBit += bitstream_encode(&timing, pixels, nextBit, 24 * (uint32)count,
+                                idle, BUFFER_BITS, 1);
+
+    /* Did the DMA come round to the refilled buffer meanwhile? */
+    if (idle != timer_burst_idle_buffer(&burst)) {
+        late++;
+    }
+}
+
+void WS2812::resetStats(void) {
+    frames = 0;
+    late = 0;
+}
+
+void WS2812::printStats(Print &out) const {
+    out.print("ws2812 leds=");
+    out.print(count);
+    out.print(" frames=");
+    out.print(frames);
+    out.print(" late=");
+    out.print(late);
+    out.println();
+}
+
+#endif
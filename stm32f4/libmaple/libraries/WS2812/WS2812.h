@@ -0,0 +1,170 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file WS2812.h
+ * @brief WS2812 LED strings driven by a timer DMA burst.
+ *
+ * Each bit goes out as one 1.25 us timer period whose pulse width a
+ * DMA burst sets (see timer_burst.h), so the CPU is neither busy nor
+ * interrupts disabled while a string updates.  The frame is coded a
+ * few LEDs at a time into two small buffers that the DMA alternates
+ * between, whatever the length of the string:
+ *
+ *     static uint8 pixels[3 * 60];
+ *     WS2812 strip(TIMER3, 1, pixels, 60);    // PB4
+ *
+ *     void setup() {
+ *         pinMode(Port2Pin('B', 4), PWM);
+ *         strip.begin();
+ *     }
+ *
+ *     void loop() {
+ *         strip.setPixel(0, 255, 0, 0);
+ *         strip.show();
+ *         ...
+ *     }
+ *
+ * Refilling a buffer takes an interrupt every WS2812_BUFFER_LEDS
+ * LEDs, which by default is every 120 us.  Leave the pixels alone
+ * until busy() is false, or the frame may mix old and new colours.
+ *
+ * STM32F2/F4 only.  TIMER1, TIMER3, TIMER4 and TIMER8 can drive a
+ * string, one each, and their update DMA streams (see
+ * timer_burst_dma_request()) must not be in use elsewhere.
+ */
+
+#ifndef _WS2812_H_
+#define _WS2812_H_
+
+#include "libmaple_types.h"
+#include "timer.h"
+#include "timer_burst.h"
+#include "bitstream.h"
+#include "Print.h"
+
+#ifdef MAPLE_IDE
+#include "wirish.h"             /* hack for IDE compile */
+#endif
+
+#ifdef STM32F2
+
+/** LEDs coded into each half of the double buffer. */
+#ifndef WS2812_BUFFER_LEDS
+#define WS2812_BUFFER_LEDS 4
+#endif
+
+class WS2812 {
+public:
+    /**
+     * @param timer TIMER1, TIMER3, TIMER4 or TIMER8.
+     * @param channel Channel whose output drives the string's data in.
+     * @param pixels Colours, 3 bytes per LED in the string's green,
+     *               red, blue order.
+     * @param count LEDs in the string.
+     */
+    WS2812(timer_dev *timer, uint8 channel, uint8 *pixels, uint16 count);
+
+    /**
+     * @brief Take over the timer and drive the output low.
+     * @return false if the timer or channel cannot drive a string.
+     */
+    bool begin(void);
+
+    /** Stop, abandoning any frame being sent. */
+    void end(void);
+
+    void setPixel(uint16 index, uint8 red, uint8 green, uint8 blue);
+    void clear(void);
+    uint16 numPixels(void) const { return count; }
+
+    /**
+     * @brief Start sending the pixels.
+     *
+     * Waits first for the previous frame and the reset time after it,
+     * then returns as soon as the new frame has started.
+     *
+     * @return false if begin() has not succeeded.
+     */
+    bool show(void);
+
+    /**
+     * @brief Whether a frame is being sent, or was finished too
+     *        recently for the string to have latched it.
+     */
+    bool busy(void) const;
+
+    /**
+     * @brief Set a function to call from the DMA interrupt when each
+     *        frame has been sent, or NULL.
+     */
+    void attachDone(voidFuncPtr done) { this->done = done; }
+
+    /** Frames sent. */
+    uint32 getFrames(void) const { return frames; }
+
+    /**
+     * @brief Buffers refilled too late, which garbles the frame.
+     *
+     * Interrupts of higher priority than the DMA's that run for more
+     * than one buffer's time cause this.
+     */
+    uint32 getLate(void) const { return late; }
+
+    void resetStats(void);
+
+    /**
+     * @brief Print the statistics on one line:
+     *
+     *     ws2812 leds=N frames=N late=N
+     */
+    void printStats(Print &out) const;
+
+    /** Call from the DMA interrupt; public only for the ISR. */
+    void handle(void);
+
+private:
+    timer_dev *timer;
+    uint8 channel;
+    uint8 *pixels;
+    uint16 count;
+    bool started;
+    voidFuncPtr done;
+    timer_burst burst;
+    bitstream_timing timing;
+    uint16 slots[2][24 * WS2812_BUFFER_LEDS];
+
+    uint32 nextBit;
+    uint32 buffersLeft;
+    volatile bool sending;
+    volatile uint32 sentMicros;
+    volatile uint32 frames;
+    volatile uint32 late;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+# Host simulation build: "make host" compiles the pure-software parts
+# of libmaple, wirish and the libraries for the build machine, against
+# register maps that live in ordinary memory (host/sim.c), and links
+# them with the tests and benchmarks in host/.  "make host-test" also
+# runs them; the exit status is non-zero if a test failed.
+
+HOSTCC  ?= gcc
+HOSTCXX ?= g++
+
+HOST_BUILD_PATH := $(BUILD_PATH)/host
+HOST_BIN        := $(HOST_BUILD_PATH)/hostbench
+
+HOST_FLAGS := -DLIBMAPLE_HOST -O2 -g -Wall -Wno-int-to-pointer-cast	\
+	      -ffunction-sections -fdata-sections $(GLOBAL_FLAGS)	\
+	      -I$(SRCROOT)/host -I$(LIBMAPLE_PATH)			\
+	      -I$(LIBMAPLE_PATH)/usb -I$(LIBMAPLE_PATH)/usb/usb_lib	\
+	      -I$(WIRISH_PATH) -I$(WIRISH_PATH)/comm			\
+	      -I$(WIRISH_PATH)/boards					\
+	      -I$(SRCROOT)/libraries/mapleSDfat				\
+	      -I$(SRCROOT)/libraries/FreeRTOS/utility
+HOST_CFLAGS   := $(HOST_FLAGS) -std=gnu99
+HOST_CXXFLAGS := $(HOST_FLAGS) -fno-rtti -fno-exceptions
+HOST_LDFLAGS  := -Wl,--gc-sections -lm
+
+# Library code under test.  Sd2Card.cpp, HardwareSerial.cpp and the
+# FreeRTOS port.c talk to hardware; host/ has stand-ins for them.
+HOST_CSRCS := libmaple/usart.c				\
+	      libmaple/adc.c				\
+	      libmaple/adc_inj.c			\
+	      libmaple/adc_multi.c			\
+	      libmaple/dac.c				\
+	      libmaple/bitstream.c			\
+	      libmaple/decimate.c			\
+	      libmaple/dma.c				\
+	      libmaple/gpio.c				\
+	      libmaple/timer.c			\
+	      libmaple/timer_burst.c			\
+	      libmaple/timer_capture.c			\
+	      libmaple/timer_encoder.c			\
+	      libmaple/event_queue.c			\
+	      libmaple/timer_wheel.c			\
+	      libraries/FreeRTOS/utility/list.c		\
+	      libraries/FreeRTOS/utility/queue.c	\
+	      libraries/FreeRTOS/utility/tasks.c	\
+	      libraries/FreeRTOS/utility/heap_2.c	\
+	      host/sim.c				\
+	      host/freertos_port.c
+HOST_CXXSRCS := wirish/Print.cpp			\
+		wirish/wirish_math.cpp			\
+		libraries/mapleSDfat/SdFile.cpp		\
+		libraries/mapleSDfat/SdVolume.cpp	\
+		host/sim_sd.cpp				\
+		host/host_serial.cpp			\
+		host/hostbench.cpp			\
+		host/test_print.cpp			\
+		host/test_ring_buffer.cpp		\
+		host/test_math.cpp			\
+		host/test_fat.cpp			\
+		host/test_freertos.cpp			\
+		host/test_regs.cpp			\
+		host/test_fastpin.cpp			\
+		host/test_pins_maple.cpp		\
+		host/test_pins_maple_RET6.cpp	\
+		host/test_pins_maple_mini.cpp	\
+		host/test_pins_maple_native.cpp	\
+		host/test_pins_aeroquad32mini.cpp	\
+		host/test_timer_wheel.cpp	\
+		host/test_event_queue.cpp	\
+		host/test_adc_multi.cpp		\
+		host/test_adc_inj.cpp			\
+		host/test_decimate.cpp		\
+		host/test_dac.cpp			\
+		host/test_timer.cpp			\
+		host/test_bitstream.cpp
+
+HOST_OBJS := $(HOST_CSRCS:%.c=$(HOST_BUILD_PATH)/%.o)		\
+	     $(HOST_CXXSRCS:%.cpp=$(HOST_BUILD_PATH)/%.o)
+
+$(HOST_BUILD_PATH)/%.o: $(SRCROOT)/%.c
+	@mkdir -p $(dir $@)
+	$(SILENT_CC) $(HOSTCC) $(HOST_CFLAGS) -MMD -MP -c -o $@ $<
+
+$(HOST_BUILD_PATH)/%.o: $(SRCROOT)/%.cpp
+	@mkdir -p $(dir $@)
+	$(SILENT_CXX) $(HOSTCXX) $(HOST_CXXFLAGS) -MMD -MP -c -o $@ $<
+
+$(HOST_BIN): $(HOST_OBJS)
+	$(SILENT_LD) $(HOSTCXX) -o $@ $(HOST_OBJS) $(HOST_LDFLAGS)
+
+host: $(HOST_BIN)
+
+host-test: $(HOST_BIN)
+	$(HOST_BIN)
+
+-include $(HOST_OBJS:%.o=%.d)
+
+.PHONY: host host-test
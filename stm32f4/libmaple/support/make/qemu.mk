@@ -0,0 +1,35 @@
+# QEMU build: "make qemu" links the examples in QEMU_EXAMPLES for
+# QEMU's netduinoplus2 machine, an STM32F405 close enough to
+# discovery_f4, as bare-metal (jtag) images build/qemu/<example>.elf.
+# QEMU=1 swaps SerialUSB for semihosting and counts cycles with
+# SysTick, since QEMU has neither USB nor a DWT.
+#
+# "make qemu-bench" runs them headless under -icount and records
+# instruction counts and cycle estimates per benchmark; see
+# support/scripts/qemu-bench.py.
+
+QEMU_EXAMPLES ?= qemu-bench test-print test-ring-buffer-insertion \
+		 test-session freertos-blinky test-irq-latency
+QEMU_BUILD_PATH := build/qemu
+
+ifeq ($(QEMU),1)
+
+$(BUILD_PATH)/examples/%.o: $(SRCROOT)/examples/%.cpp
+	@mkdir -p $(dir $@)
+	$(SILENT_CXX) $(CXX) $(CFLAGS) $(CXXFLAGS) -I$(SRCROOT) $(LIBMAPLE_INCLUDES) $(WIRISH_INCLUDES) -o $@ -c $<
+
+$(BUILD_PATH)/%.elf: $(BUILDDIRS) $(TGT_BIN) $(BUILD_PATH)/examples/%.o
+	$(SILENT_LD) $(CXX) $(LDFLAGS) -o $@ $(TGT_BIN) $(BUILD_PATH)/examples/$*.o -Wl,-Map,$(BUILD_PATH)/$*.map
+
+qemu-examples: $(QEMU_EXAMPLES:%=$(BUILD_PATH)/%.elf)
+
+endif
+
+qemu:
+	@$(MAKE) QEMU=1 BOARD=discovery_f4 MEMORY_TARGET=jtag \
+		BUILD_PATH=$(QEMU_BUILD_PATH) --no-print-directory qemu-examples
+
+qemu-bench: qemu
+	$(SUPPORT_PATH)/scripts/qemu-bench.py $(QEMU_BUILD_PATH) $(QEMU_EXAMPLES)
+
+.PHONY: qemu qemu-bench qemu-examples
@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+#
+# Resolve a SamplingProfiler dump to function names.
+#
+#   profsym.py build/discovery_f4.elf capture.txt
+#   profsym.py build/discovery_f4.map capture.txt
+#   profsym.py --port /dev/ttyACM0 build/discovery_f4.elf
+#
+# Symbols come from arm-none-eabi-nm when given the .elf, or from the
+# linker map the Makefile writes next to it.  A bucket that spans
+# several functions is shared between them in proportion to overlap.
+# If the capture holds several dumps, the last complete one is used.
+
+import argparse
+import bisect
+import re
+import subprocess
+import sys
+
+
+def symbols_from_elf(path, nm):
+    out = subprocess.check_output([nm, "-n", "-S", "-C", "--defined-only",
+                                   path],
+                                  universal_newlines=True)
+    syms = []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) >= 4 and parts[2] in "tTwW":
+            addr, size = int(parts[0], 16), int(parts[1], 16)
+            syms.append((addr & ~1, size, " ".join(parts[3:])))
+    return syms
+
+
+MAP_SYMBOL = re.compile(r"^\s+0x([0-9a-fA-F]{8,16})\s+([A-Za-z_.$][\w.$]*)\s*$")
+MAP_SECTION = re.compile(r"^ ?\.text\.?([\w.$]*)\s*(0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?")
+
+
+def symbols_from_map(path):
+    """Function symbols and .text.* input sections of a GNU ld map."""
+    sections, names = [], []
+    pending = None
+    with open(path) as f:
+        for line in f:
+            m = MAP_SECTION.match(line)
+            if m:
+                pending = m.group(1)
+                if m.group(2):
+                    sections.append((int(m.group(3), 16), int(m.group(4), 16),
+                                     pending))
+                    pending = None
+                continue
+            if pending is not None:
+                parts = line.split()
+                if len(parts) >= 2 and parts[0].startswith("0x"):
+                    sections.append((int(parts[0], 16), int(parts[1], 16),
+                                     pending))
+                pending = None
+                continue
+            m = MAP_SYMBOL.match(line)
+            if m:
+                names.append((int(m.group(1), 16), m.group(2)))
+
+    # A symbol runs to the next symbol or the end of its section,
+    # whichever comes first; sections without symbols keep their name.
+    sections = sorted(s for s in sections if s[1])
+    names.sort()
+    starts = [n[0] for n in names]
+    syms = []
+    for addr, size, name in sections:
+        lo = bisect.bisect_left(starts, addr)
+        hi = bisect.bisect_left(starts, addr + size)
+        inside = names[lo:hi]
+        if not inside or inside[0][0] != addr:
+            inside.insert(0, (addr, name))
+        for i, (start, sym) in enumerate(inside):
+            end = inside[i + 1][0] if i + 1 < len(inside) else addr + size
+            if end > start:
+                syms.append((start, end - start, sym))
+    return syms
+
+
+def demangle(syms, cxxfilt):
+    try:
+        out = subprocess.check_output([cxxfilt],
+                                      input="\n".join(s[2] for s in syms),
+                                      universal_newlines=True)
+    except OSError:
+        return syms
+    return [(a, s, n) for (a, s, _), n in zip(syms, out.splitlines())]
+
+
+def parse_dump(lines):
+    header, hist, result = None, None, None
+    for line in lines:
+        line = line.strip()
+        if line.startswith("# profile"):
+            header = dict(kv.split("=") for kv in line.split()[2:])
+            hist = {"pc": [], "lr": []}
+        elif line == "# end" and header is not None:
+            result = (header, hist)
+            header = None
+        elif header is not None:
+            parts = line.split()
+            if len(parts) == 3 and parts[0] in hist:
+                hist[parts[0]].append((int(parts[1], 16), int(parts[2])))
+    if result is None:
+        sys.exit("no complete '# profile' ... '# end' dump in the input")
+    return result
+
+
+def read_port(port, baud):
+    import serial
+    lines = []
+    with serial.Serial(port, baud, timeout=10) as s:
+        while True:
+            line = s.readline().decode("ascii", "replace")
+            if not line:
+                sys.exit("timed out waiting for a dump on " + port)
+            lines.append(line)
+            if line.strip() == "# end" and any(l.startswith("# profile")
+                                               for l in lines):
+                return lines
+
+
+def attribute(buckets, width, syms):
+    starts = [s[0] for s in syms]
+    totals = {}
+    for addr, count in buckets:
+        end = addr + width
+        i = max(bisect.bisect_right(starts, addr) - 1, 0)
+        shares = []
+        while i < len(syms) and syms[i][0] < end:
+            lo = max(addr, syms[i][0])
+            hi = min(end, syms[i][0] + syms[i][1])
+            if hi > lo:
+                shares.append((hi - lo, syms[i][2]))
+            i += 1
+        covered = sum(s for s, _ in shares)
+        if not covered:
+            name = "0x%08x" % addr
+            totals[name] = totals.get(name, 0) + count
+            continue
+        for span, name in shares:
+            totals[name] = totals.get(name, 0) + count * span / covered
+    return totals
+
+
+def report(title, totals, samples, limit):
+    print(title)
+    rows = sorted(totals.items(), key=lambda kv: -kv[1])[:limit]
+    for name, count in rows:
+        pct = 100.0 * count / samples if samples else 0.0
+        print("  %6.2f%% %8.1f  %s" % (pct, count, name))
+    print()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("symbols", help="build/$(BOARD).elf or build/$(BOARD).map")
+    ap.add_argument("capture", nargs="?", help="dump text (default stdin)")
+    ap.add_argument("--port", help="read one dump from this serial port")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--nm", default="arm-none-eabi-nm")
+    ap.add_argument("--cxxfilt", default="arm-none-eabi-c++filt")
+    ap.add_argument("--top", type=int, default=25, help="rows per table")
+    args = ap.parse_args()
+
+    if args.port:
+        lines = read_port(args.port, args.baud)
+    elif args.capture:
+        with open(args.capture, errors="replace") as f:
+            lines = f.readlines()
+    else:
+        lines = sys.stdin.readlines()
+    header, hist = parse_dump(lines)
+
+    if args.symbols.endswith(".map"):
+        syms = demangle(symbols_from_map(args.symbols), args.cxxfilt)
+    else:
+        syms = symbols_from_elf(args.symbols, args.nm)
+
+    width = 1 << int(header["shift"])
+    samples = int(header["samples"])
+    print("%d samples, %d outside .text, %d lost, %d-byte buckets\n" %
+          (samples, int(header["other"]), int(header["lost"]), width))
+    report("Where time is spent (PC):", attribute(hist["pc"], width, syms),
+           samples, args.top)
+    report("Called from (LR):", attribute(hist["lr"], width, syms),
+           samples, args.top)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+#
+# Run QEMU builds of the examples headless and record benchmark results.
+#
+#   qemu-bench.py build/qemu qemu-bench test-print ...
+#   qemu-bench.py --csv now.csv --baseline before.csv build/qemu qemu-bench
+#
+# Each example runs on QEMU's netduinoplus2 machine with semihosting
+# for SerialUSB and -icount shift=0, which makes virtual time advance
+# exactly 1 ns per guest instruction.  SysTick, and so dwt_cycles() in
+# QEMU builds, is clocked at the 168 MHz core clock in virtual time, so
+#
+#     instructions = cycles reported by the guest * 1000 / 168
+#
+# Instruction counts are exact and reproducible; cycle estimates
+# multiply them by --cpi, since QEMU does not model pipeline stalls,
+# flash wait states or bus contention.
+#
+# Benchmark examples print "bench <name> <iterations> <cycles>" lines
+# and exit through semihosting.  Other examples never exit; they are
+# stopped after --timeout seconds and pass if they printed their
+# expected output (or, with none expected, did not lock up).
+
+import argparse
+import csv
+import os
+import subprocess
+import sys
+
+CORE_MHZ = 168
+
+# Keys to type at each example, and text its output must contain.
+EXAMPLES = {
+    "qemu-bench": ("", "done"),
+    "test-print": ("\n", "Test finished."),
+    "test-ring-buffer-insertion": ("\n", "Test finished."),
+    "test-session": ("?", "by leaflabs"),
+    "freertos-blinky": ("", None),
+    "test-irq-latency": ("", "done"),
+}
+
+
+def run_example(qemu, elf, keys, timeout):
+    cmd = [qemu, "-M", "netduinoplus2", "-nographic", "-monitor", "none",
+           "-serial", "null",
+           "-semihosting-config", "enable=on,target=native",
+           "-icount", "shift=0,align=off,sleep=off",
+           "-d", "guest_errors", "-kernel", elf]
+    try:
+        p = subprocess.run(cmd, input=keys.encode(), capture_output=True,
+                           timeout=timeout)
+        out, err, timed_out = p.stdout, p.stderr, False
+        status = p.returncode
+    except subprocess.TimeoutExpired as e:
+        out, err, timed_out = e.stdout or b"", e.stderr or b"", True
+        status = None
+    return (out.decode("ascii", "replace"), err.decode("ascii", "replace"),
+            status, timed_out)
+
+
+def parse_benches(text, example, cpi):
+    rows = []
+    for line in text.splitlines():
+        parts = line.split()
+        if len(parts) != 4 or parts[0] != "bench":
+            continue
+        name, iters, cycles = parts[1], int(parts[2]), int(parts[3])
+        insns = cycles * 1000.0 / CORE_MHZ
+        rows.append({
+            "example": example,
+            "bench": name,
+            "iterations": iters,
+            "instructions": int(round(insns)),
+            "insns_per_iter": round(insns / iters, 2),
+            "cycles_est_per_iter": round(insns * cpi / iters, 2),
+        })
+    return rows
+
+
+def load_baseline(path):
+    with open(path) as f:
+        return {(r["example"], r["bench"]): float(r["insns_per_iter"])
+                for r in csv.DictReader(f)}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("build", help="directory holding <example>.elf")
+    ap.add_argument("examples", nargs="+")
+    ap.add_argument("--qemu", default="qemu-system-arm")
+    ap.add_argument("--timeout", type=float, default=20.0)
+    ap.add_argument("--cpi", type=float, default=1.0,
+                    help="cycles per instruction for the estimate")
+    ap.add_argument("--csv", help="write benchmark rows here")
+    ap.add_argument("--baseline", help="CSV from an earlier run to compare")
+    args = ap.parse_args()
+
+    baseline = load_baseline(args.baseline) if args.baseline else {}
+    rows, failures = [], 0
+
+    for example in args.examples:
+        elf = os.path.join(args.build, example + ".elf")
+        keys, expect = EXAMPLES.get(example, ("", None))
+        out, err, status, timed_out = run_example(args.qemu, elf, keys,
+                                                  args.timeout)
+        with open(os.path.join(args.build, example + ".log"), "w") as f:
+            f.write(out)
+            f.write(err)
+
+        if expect is not None:
+            ok = expect in out
+        else:
+            ok = timed_out and "Lockup" not in err
+        if status not in (None, 0):
+            ok = False
+        failures += not ok
+        print("%-4s %s" % ("ok" if ok else "FAIL", example))
+
+        for r in parse_benches(out, example, args.cpi):
+            rows.append(r)
+            line = "     %-28s %10.2f insn/iter %10.2f cyc/iter" % (
+                r["bench"], r["insns_per_iter"], r["cycles_est_per_iter"])
+            old = baseline.get((example, r["bench"]))
+            if old:
+                line += "  %+6.1f%%" % (100.0 * (r["insns_per_iter"] - old) / old)
+            print(line)
+
+    if args.csv and rows:
+        with open(args.csv, "w", newline="") as f:
+            w = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+            w.writeheader()
+            w.writerows(rows)
+
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
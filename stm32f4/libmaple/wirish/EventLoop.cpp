@@ -0,0 +1,158 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file EventLoop.cpp
+ * @brief Run-to-completion event loop for sketches without an RTOS.
+ */
+
+#include "EventLoop.h"
+#include "wirish_time.h"
+
+EventLoop Events;
+
+static void callFunction(void *arg, uint32 data) {
+    ((EventHandler)arg)(data);
+}
+
+static void callTask(void *arg, uint32 data) {
+    ((EventTask*)arg)->run(data);
+}
+
+EventLoop::EventLoop(void) {
+    event_queue_init(&q);
+    this->sleep = true;
+    this->resetStats();
+}
+
+bool EventLoop::post(EventHandler handler, uint32 data) {
+    return event_queue_post(&q, callFunction, (void*)handler, data,
+                            dwt_cycles()) == 0;
+}
+
+bool EventLoop::post(EventTask &task, uint32 data) {
+    return event_queue_post(&q, callTask, &task, data, dwt_cycles()) == 0;
+}
+
+bool EventLoop::post(event_handler handler, void *arg, uint32 data) {
+    return event_queue_post(&q, handler, arg, data, dwt_cycles()) == 0;
+}
+
+bool EventLoop::dispatch(void) {
+    event ev;
+
+    if (!event_queue_take(&q, &ev)) {
+        return false;
+    }
+    /* The core was awake from the posting interrupt on, so the
+     * cycle counter covers the whole wait */
+    uint32 latency = dwt_cycles() - ev.stamp;
+    if (latency > maxLatency) {
+        maxLatency = latency;
+    }
+    totalLatency += latency;
+    dispatched++;
+    ev.handler(ev.arg, ev.data);
+    return true;
+}
+
+void EventLoop::run(void) {
+    uint32 n = event_queue_depth(&q);
+    uint32 primask;
+
+    if (n) {
+        /* Only the events already posted, so that a handler posting
+         * to itself cannot starve the rest of loop() */
+        while (n-- && this->dispatch())
+            ;
+        return;
+    }
+    if (!sleep) {
+        return;
+    }
+
+    /* With interrupts masked, a post between the check and the WFI
+     * still ends the sleep: the pending interrupt wakes the core, and
+     * its handler runs once PRIMASK is restored. */
+    asm volatile("mrs %0, primask \n\t"
+                 "cpsid i"
+                 : "=r"(primask) : : "memory");
+    if (!event_queue_ready(&q)) {
+        asm volatile("dsb \n\t"
+                     "wfi" : : : "memory");
+    }
+    asm volatile("msr primask, %0" : : "r"(primask) : "memory");
+}
+
+uint32 EventLoop::getMeanLatency(void) const {
+    if (dispatched == 0) {
+        return 0;
+    }
+    return (uint32)(totalLatency / dispatched);
+}
+
+uint32 EventLoop::getLoad(void) const {
+    uint64 awake = dwt_cycles64() - statsCycles;
+    uint32 ms = millis() - statsMillis;
+
+    if (ms == 0) {
+        return 1000;
+    }
+    /* Not dwt_div_small(): ms passes its 16-bit limit after 65 s */
+    uint64 load = awake * 1000 /
+        ((uint64)ms * CYCLES_PER_MICROSECOND * US_PER_MS);
+    return load > 1000 ? 1000 : (uint32)load;
+}
+
+void EventLoop::resetStats(void) {
+    dispatched = 0;
+    maxLatency = 0;
+    totalLatency = 0;
+    q.dropped = 0;
+    q.high_water = event_queue_depth(&q);
+    statsCycles = dwt_cycles64();
+    statsMillis = millis();
+}
+
+void EventLoop::printStats(Print &out) const {
+    uint32 load = this->getLoad();
+
+    out.print("events dispatched=");
+    out.print(dispatched);
+    out.print(" dropped=");
+    out.print(this->getDropped());
+    out.print(" high=");
+    out.print(this->getHighWater());
+    out.print(" latency_us mean=");
+    out.print(this->getMeanLatency() / CYCLES_PER_MICROSECOND);
+    out.print(" max=");
+    out.print(maxLatency / CYCLES_PER_MICROSECOND);
+    out.print(" load=");
+    out.print(load / 10);
+    out.print('.');
+    out.print(load % 10);
+    out.println('%');
+}
@@ -0,0 +1,177 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file EventLoop.h
+ * @brief Run-to-completion event loop for sketches without an RTOS.
+ *
+ * Interrupt handlers post events instead of doing the work
+ * themselves; the main loop calls the events' handlers one at a time
+ * and sleeps (WFI) whenever there is nothing to do.  A handler is
+ * either a plain function or an EventTask, whose run() makes a
+ * convenient home for a state machine.
+ *
+ *     void gotLine(uint32 len) { ... }
+ *
+ *     void rxDone(void) {                 // DMA interrupt
+ *         Events.post(gotLine, BUF_SIZE);
+ *     }
+ *
+ *     void loop() {
+ *         Events.run();
+ *     }
+ *
+ * Handlers run in thread mode and so may take as long as they need,
+ * but the next event waits for them; anything slow is better split
+ * into steps that post each other.  Posting never blocks and is safe
+ * from any interrupt priority (see event_queue.h); if the queue is
+ * full the event is dropped and counted.
+ *
+ * The loop keeps statistics: the time from posting to dispatch, and
+ * the CPU load, from the cycle counter which stops while the core
+ * sleeps.  A debugger that keeps the core clocked in sleep
+ * (DBGMCU_CR DBG_SLEEP) makes the load read 100%.
+ */
+
+#ifndef _EVENTLOOP_H_
+#define _EVENTLOOP_H_
+
+#include "libmaple_types.h"
+#include "event_queue.h"
+#include "Print.h"
+
+/** Event handler function; data is as passed to EventLoop::post(). */
+typedef void (*EventHandler)(uint32 data);
+
+/**
+ * @brief An event handler with state.
+ *
+ * Derive from EventTask and implement run(); each event posted to the
+ * task calls run() with the event's data.
+ */
+class EventTask {
+public:
+    virtual ~EventTask() {}
+    /** Handle one event. */
+    virtual void run(uint32 data) = 0;
+};
+
+class EventLoop {
+public:
+    EventLoop(void);
+
+    /**
+     * @brief Post an event; safe from interrupt handlers.
+     * @param handler Function to call from the loop
+     * @param data    Argument for handler
+     * @return false if the queue was full and the event was dropped.
+     */
+    bool post(EventHandler handler, uint32 data = 0);
+
+    /**
+     * @brief Post an event to a task; safe from interrupt handlers.
+     * @param task Task whose run() to call from the loop
+     * @param data Argument for run()
+     * @return false if the queue was full and the event was dropped.
+     */
+    bool post(EventTask &task, uint32 data = 0);
+
+    /**
+     * @brief Post an event with a C-style handler.
+     *
+     * For libmaple drivers, which can also post straight to queue()
+     * with event_queue_post().
+     */
+    bool post(event_handler handler, void *arg, uint32 data);
+
+    /**
+     * @brief Dispatch the events that are ready, or sleep.
+     *
+     * Calls the handlers of all events ready when it is called, in
+     * posting order.  If there were none, sleeps until an interrupt.
+     * Call it from loop().
+     */
+    void run(void);
+
+    /**
+     * @brief Dispatch one ready event.
+     * @return false if there was none.
+     */
+    bool dispatch(void);
+
+    /**
+     * @brief Allow or forbid sleeping in run().
+     *
+     * Without sleep, run() returns at once when there is nothing to
+     * do, which keeps polling code elsewhere in loop() running.
+     */
+    void setSleep(bool sleep) { this->sleep = sleep; }
+
+    /** The underlying queue, for posting from C. */
+    event_queue *queue(void) { return &q; }
+
+    /** Events dispatched since resetStats(). */
+    uint32 getDispatched(void) const { return dispatched; }
+    /** Events dropped, queue full, since resetStats(). */
+    uint32 getDropped(void) const { return q.dropped; }
+    /** Most events queued at once since resetStats(). */
+    uint32 getHighWater(void) const { return q.high_water; }
+    /** Longest posting-to-dispatch time, in cycles. */
+    uint32 getMaxLatency(void) const { return maxLatency; }
+    /** Mean posting-to-dispatch time, in cycles. */
+    uint32 getMeanLatency(void) const;
+    /**
+     * @brief CPU load since resetStats(), in tenths of a percent.
+     *
+     * The fraction of time the core was awake, in handlers,
+     * interrupts or anything else loop() does.
+     */
+    uint32 getLoad(void) const;
+
+    /** Clear the statistics. */
+    void resetStats(void);
+
+    /**
+     * @brief Print the statistics on one line:
+     *
+     *     events dispatched=N dropped=N high=N latency_us mean=N max=N load=N.N%
+     */
+    void printStats(Print &out) const;
+
+private:
+    event_queue q;
+    bool sleep;
+    uint32 dispatched;
+    uint32 maxLatency;
+    uint64 totalLatency;
+    uint64 statsCycles;
+    uint32 statsMillis;
+};
+
+/** The event loop. */
+extern EventLoop Events;
+
+#endif
@@ -0,0 +1,179 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file FastPin.h
+ * @brief Compile-time GPIO pin and port access.
+ *
+ * FastPin<N> is board pin N with its GPIO port and bit resolved at
+ * compile time from the board header's pin table (BOARD_PIN_PORT()
+ * and BOARD_PIN_BIT(), or BOARD_PIN_PORTS and BOARD_PIN_BITS).  Each
+ * call inlines to a single store to the port's BSRR or a single load
+ * of its IDR: no PIN_MAP lookup, no gpio_dev indirection and no range
+ * check at run time.  An out-of-range pin number does not compile.
+ *
+ * FastPort<'X'> drives several bits of GPIO port X with one BSRR
+ * store, for parallel buses and colour outputs.
+ *
+ * Neither configures the pin; call pinMode() (or FastPin<N>::mode())
+ * first.
+ */
+
+#ifndef _FASTPIN_H_
+#define _FASTPIN_H_
+
+#include "libmaple_types.h"
+#include "gpio.h"
+#include "boards.h"
+#include "io.h"
+
+#ifdef STM32F2
+#define FASTPIN_GPIO_BASE       0x40020000UL
+#else
+#define FASTPIN_GPIO_BASE       0x40010800UL
+#endif
+#define FASTPIN_GPIO_STRIDE     0x400UL
+
+#ifdef BOARD_PIN_PORT
+#define FASTPIN_PORT(pin)       BOARD_PIN_PORT(pin)
+#define FASTPIN_BIT(pin)        BOARD_PIN_BIT(pin)
+#else
+/* Lookups with a constant index fold to an immediate. */
+static const char fastPinPorts[] = BOARD_PIN_PORTS;
+static const uint8 fastPinBits[] = { BOARD_PIN_BITS };
+#define FASTPIN_PORT(pin)       (fastPinPorts[(pin)])
+#define FASTPIN_BIT(pin)        (fastPinBits[(pin)])
+#endif
+
+/**
+ * @brief Register map of GPIO port 'A', 'B', ...
+ */
+static inline gpio_reg_map* fastpin_regs(char port) {
+    return (gpio_reg_map*)(FASTPIN_GPIO_BASE +
+                           (port - 'A') * FASTPIN_GPIO_STRIDE);
+}
+
+/**
+ * @brief A port's BSRR as one 32-bit register: bits 0..15 set,
+ *        bits 16..31 reset.
+ */
+static inline __io uint32* fastpin_bsrr(gpio_reg_map *regs) {
+#ifdef STM32F2
+    return (__io uint32*)&regs->BSRRL;
+#else
+    return &regs->BSRR;
+#endif
+}
+
+/**
+ * @brief Board pin PIN, resolved at compile time.
+ *
+ * Example:
+ *
+ *     FastPin<BOARD_LED_PIN>::high();
+ *     if (FastPin<BOARD_BUTTON_PIN>::read()) ...
+ */
+template<uint8 PIN>
+class FastPin {
+    typedef char pinInRange[PIN < BOARD_NR_GPIO_PINS ? 1 : -1];
+
+public:
+    /** @brief The pin's GPIO register map. */
+    static inline gpio_reg_map* regs() {
+        return fastpin_regs(FASTPIN_PORT(PIN));
+    }
+
+    /** @brief The pin's BSRR; see fastpin_bsrr(). */
+    static inline __io uint32* bsrr() { return fastpin_bsrr(regs()); }
+
+    /** @brief The pin's bit within its port. */
+    static inline uint16 mask() { return (uint16)(1U << FASTPIN_BIT(PIN)); }
+
+    /** @brief Configure the pin; same as pinMode(PIN, mode). */
+    static inline void mode(WiringPinMode mode) { pinMode(PIN, mode); }
+
+    static inline void high() { *bsrr() = mask(); }
+
+    static inline void low() { *bsrr() = (uint32)mask() << 16; }
+
+    /** @brief Drive the pin high if val is nonzero, low otherwise. */
+    static inline void write(uint8 val) {
+        *bsrr() = val ? (uint32)mask() : (uint32)mask() << 16;
+    }
+
+    /**
+     * @brief Invert the pin's output.
+     *
+     * Reads ODR and writes BSRR, so unlike an ODR read-modify-write
+     * it cannot clobber other bits of the port changed by an ISR in
+     * between.
+     */
+    static inline void toggle() {
+        *bsrr() = (regs()->ODR & mask()) ? (uint32)mask() << 16 : mask();
+    }
+
+    /** @brief 1 if the pin's input is high, 0 otherwise. */
+    static inline uint32 read() { return (regs()->IDR & mask()) ? 1 : 0; }
+};
+
+/**
+ * @brief GPIO port PORT ('A', 'B', ...), several bits at a time.
+ */
+template<char PORT>
+class FastPort {
+public:
+    static inline gpio_reg_map* regs() { return fastpin_regs(PORT); }
+
+    static inline __io uint32* bsrr() { return fastpin_bsrr(regs()); }
+
+    /** @brief Drive bits high. */
+    static inline void set(uint16 bits) { *bsrr() = bits; }
+
+    /** @brief Drive bits low. */
+    static inline void clear(uint16 bits) { *bsrr() = (uint32)bits << 16; }
+
+    /**
+     * @brief Drive the bits in mask to the matching bits of value,
+     *        all in the same cycle; other bits are left alone.
+     */
+    static inline void write(uint16 mask, uint16 value) {
+        *bsrr() = ((uint32)(mask & ~value) << 16) | (mask & value);
+    }
+
+    /** @brief Invert bits. */
+    static inline void toggle(uint16 bits) {
+        uint32 odr = regs()->ODR;
+        *bsrr() = ((odr & bits) << 16) | (~odr & bits);
+    }
+
+    /** @brief The port's input bits. */
+    static inline uint16 read() { return (uint16)regs()->IDR; }
+
+    /** @brief The port's output bits. */
+    static inline uint16 readOutput() { return (uint16)regs()->ODR; }
+};
+
+#endif
@@ -25,7 +25,7 @@
  *****************************************************************************/
 
 #include "HardwareTimer.h"
-#include "boards.h"             // for CYCLES_PER_MICROSECOND
+#include "boards.h"
 #include "wirish_math.h"
 
 // TODO [0.1.0] Remove deprecated pieces
@@ -38,8 +38,6 @@
 #error "Unsupported density"
 #endif
 
-#define MAX_RELOAD ((1 << 16) - 1)
-
 HardwareTimer::HardwareTimer(uint8 timerNum) {
     if (timerNum > NR_TIMERS) {
         ASSERT(0);
@@ -56,18 +54,27 @@ HardwareTimer::HardwareTimer(uint8 timerNum) {
         TIMER8,
 #endif
     };
+    /* Timer1..Timer8 are constructed before setup(), so the timer is
+     * only configured on first use; see BOARD_INIT_TIMERS. */
     this->dev = devs[timerNum - 1];
 }
 
+void HardwareTimer::ensure(void) {
+    boardEnsureTimer(this->dev);
+}
+
 void HardwareTimer::pause(void) {
+    this->ensure();
     timer_pause(this->dev);
 }
 
 void HardwareTimer::resume(void) {
+    this->ensure();
     timer_resume(this->dev);
 }
 
 uint32 HardwareTimer::getPrescaleFactor(void) {
+    this->ensure();
     return timer_get_prescaler(this->dev) + 1;
 }
 
@@ -76,56 +83,118 @@ uint32 HardwareTimer::getClockSpeed(void) {
 }
 
 void HardwareTimer::setPrescaleFactor(uint32 factor) {
+    this->ensure();
     timer_set_prescaler(this->dev, (uint16)(factor - 1));
 }
 
-uint16 HardwareTimer::getOverflow() {
+uint32 HardwareTimer::getOverflow() {
+    this->ensure();
     return timer_get_reload(this->dev);
 }
 
-void HardwareTimer::setOverflow(uint16 val) {
+uint32 HardwareTimer::getMaxOverflow(void) {
+    return timer_max_reload(this->dev);
+}
+
+bool HardwareTimer::is32Bit(void) {
+    return timer_is_32bit(this->dev) != 0;
+}
+
+void HardwareTimer::setOverflow(uint32 val) {
+    this->ensure();
     timer_set_reload(this->dev, val);
 }
 
-uint16 HardwareTimer::getCount(void) {
+uint32 HardwareTimer::getCount(void) {
+    this->ensure();
     return timer_get_count(this->dev);
 }
 
-void HardwareTimer::setCount(uint16 val) {
-    uint16 ovf = this->getOverflow();
+void HardwareTimer::setCount(uint32 val) {
+    this->ensure();
+    uint32 ovf = this->getOverflow();
     timer_set_count(this->dev, min(val, ovf));
 }
 
-uint16 HardwareTimer::setPeriod(uint32 microseconds) {
-    // Not the best way to handle this edge case?
-    if (!microseconds) {
-        this->setPrescaleFactor(1);
-        this->setOverflow(1);
-        return this->getOverflow();
-    }
-
-    uint32 period_cyc = microseconds * CYCLES_PER_MICROSECOND;
-    uint16 prescaler = (uint16)(period_cyc / MAX_RELOAD + 1);
-    uint16 overflow = (uint16)round(period_cyc / prescaler);
-    this->setPrescaleFactor(prescaler);
+uint32 HardwareTimer::setPeriod(uint32 microseconds) {
+    uint32 factor, overflow;
+    timer_calc_period(this->getClockSpeed(), microseconds,
+                      this->getMaxOverflow(), &factor, &overflow);
+    this->setPrescaleFactor(factor);
     this->setOverflow(overflow);
     return overflow;
 }
 
 void HardwareTimer::setMode(int channel, timer_mode mode) {
+    this->ensure();
     timer_set_mode(this->dev, (uint8)channel, (timer_mode)mode);
 }
 
-uint16 HardwareTimer::getCompare(int channel) {
+uint32 HardwareTimer::getCompare(int channel) {
+    this->ensure();
     return timer_get_compare(this->dev, (uint8)channel);
 }
 
-void HardwareTimer::setCompare(int channel, uint16 val) {
-    uint16 ovf = this->getOverflow();
+void HardwareTimer::setCompare(int channel, uint32 val) {
+    this->ensure();
+    uint32 ovf = this->getOverflow();
     timer_set_compare(this->dev, (uint8)channel, min(val, ovf));
 }
 
+void HardwareTimer::setInputCapture(int channel,
+                                    timer_ic_edge edge,
+                                    uint8 filter,
+                                    timer_ic_prescaler psc) {
+    this->ensure();
+    timer_ic_setup(this->dev, (uint8)channel, edge, psc, filter);
+}
+
+bool HardwareTimer::setPwmInput(int channel, timer_ic_edge edge,
+                                uint8 filter) {
+    this->ensure();
+    return timer_ic_set_pwm_input(this->dev, (uint8)channel, edge,
+                                  filter) == 0;
+}
+
+bool HardwareTimer::setEncoderMode(timer_encoder_mode mode, uint8 filter,
+                                   bool reverse) {
+    this->ensure();
+    return timer_encoder_setup(this->dev, mode, filter, reverse) == 0;
+}
+
+bool HardwareTimer::setCountMode(timer_count_mode mode) {
+    this->ensure();
+    if (this->dev->type == TIMER_BASIC) {
+        return false;
+    }
+    timer_set_count_mode(this->dev, mode);
+    return true;
+}
+
+bool HardwareTimer::setDeadTime(uint32 nanoseconds) {
+    this->ensure();
+    uint64 ticks;
+
+    if (this->dev->type != TIMER_ADVANCED) {
+        return false;
+    }
+    ticks = ((uint64)this->getClockSpeed() * nanoseconds + 999999999) /
+        1000000000;
+    timer_set_dead_time(this->dev, ticks > 1008 ? 1008 : (uint32)ticks);
+    return true;
+}
+
+bool HardwareTimer::setMainOutput(bool enable) {
+    this->ensure();
+    if (this->dev->type != TIMER_ADVANCED) {
+        return false;
+    }
+    timer_set_main_output(this->dev, enable);
+    return true;
+}
+
 void HardwareTimer::attachInterrupt(int channel, voidFuncPtr handler) {
+    this->ensure();
     timer_attach_interrupt(this->dev, (uint8)channel, handler);
 }
 
@@ -134,6 +203,7 @@ void HardwareTimer::detachInterrupt(int channel) {
 }
 
 void HardwareTimer::refresh(void) {
+    this->ensure();
     timer_generate_update(this->dev);
 }
 
@@ -42,12 +42,18 @@ typedef timer_mode TimerMode;
 #define TIMER_OUTPUTCOMPARE TIMER_OUTPUT_COMPARE
 
 /**
- * @brief Interface to one of the 16-bit timer peripherals.
+ * @brief Interface to one of the timer peripherals.
+ *
+ * Most timers are 16 bits wide.  On STM32F2, TIMER2 and TIMER5 are
+ * 32 bits wide; counts, compares and overflow values use the full
+ * range there.
  */
 class HardwareTimer {
 private:
     timer_dev *dev;
 
+    void ensure(void);
+
 public:
     /**
      * @brief Construct a new HardwareTimer instance.
@@ -106,7 +112,16 @@ public:
      * @brief Get the timer overflow value.
      * @see HardwareTimer::setOverflow()
      */
-    uint16 getOverflow();
+    uint32 getOverflow();
+
+    /**
+     * @brief Get the largest overflow value this timer supports.
+     * @return 0xFFFFFFFF for 32-bit timers, 0xFFFF otherwise.
+     */
+    uint32 getMaxOverflow(void);
+
+    /** @brief Whether this timer has a 32-bit counter. */
+    bool is32Bit(void);
 
     /**
      * @brief Set the timer overflow (or "reload") value.
@@ -115,17 +130,17 @@ public:
      * overflows.  You can force the counter to reset using
      * HardwareTimer::refresh().
      *
-     * @param val The new overflow value to set
+     * @param val The new overflow value to set, at most getMaxOverflow()
      * @see HardwareTimer::refresh()
      */
-    void setOverflow(uint16 val);
+    void setOverflow(uint32 val);
 
     /**
      * @brief Get the current timer count.
      *
      * @return The timer's current count value
      */
-    uint16 getCount(void);
+    uint32 getCount(void);
 
     /**
      * @brief Set the current timer count.
@@ -134,20 +149,24 @@ public:
      *            the timer's overflow value, it is truncated to the
      *            overflow value.
      */
-    void setCount(uint16 val);
+    void setCount(uint32 val);
 
     /**
      * @brief Set the timer's period in microseconds.
      *
      * Configures the prescaler and overflow values to generate a timer
      * reload with a period as close to the given number of
-     * microseconds as possible.
+     * microseconds as possible.  The smallest prescaler that fits is
+     * used, so the overflow value (and the compare resolution) is as
+     * large as possible; 32-bit timers run unprescaled for periods up
+     * to 2^32 clock cycles.
      *
      * @param microseconds The desired period of the timer.  This must be
      *                     greater than zero.
      * @return The new overflow value.
+     * @see timer_calc_period()
      */
-    uint16 setPeriod(uint32 microseconds);
+    uint32 setPeriod(uint32 microseconds);
 
     /**
      * @brief Configure a timer channel's mode.
@@ -160,7 +179,7 @@ public:
      * @brief Get the compare value for the given channel.
      * @see HardwareTimer::setCompare()
      */
-    uint16 getCompare(int channel);
+    uint32 getCompare(int channel);
 
     /**
      * @brief Set the compare value for the given channel.
@@ -174,7 +193,96 @@ public:
      * @see HardwareTimer::setMode()
      * @see HardwareTimer::attachInterrupt()
      */
-    void setCompare(int channel, uint16 compare);
+    void setCompare(int channel, uint32 compare);
+
+    /**
+     * @brief Configure a channel for input capture.
+     *
+     * The channel latches the counter on the chosen edges of its
+     * input pin; getCompare() then returns the latest capture and
+     * attachInterrupt() fires on each one.  For captures streamed to
+     * memory without interrupts, see the InputCapture library.
+     *
+     * @param channel the channel to capture on, from 1 to 4.
+     * @param edge TIMER_IC_RISING, TIMER_IC_FALLING or, on STM32F2,
+     *             TIMER_IC_BOTH.
+     * @param filter Digital input filter, from 0 (off) to 15.
+     * @param psc Capture every edge, or every 2nd, 4th or 8th.
+     * @see timer_ic_setup()
+     */
+    void setInputCapture(int channel,
+                         timer_ic_edge edge,
+                         uint8 filter,
+                         timer_ic_prescaler psc);
+
+    /**
+     * @brief Measure a PWM signal on channel 1 or 2.
+     *
+     * Each period-starting edge resets the counter; afterwards
+     * getCompare(channel) holds the period and the other channel of
+     * the pair the pulse width, in timer ticks.  Set the prescale
+     * factor so the longest period fits in getMaxOverflow() ticks.
+     *
+     * @param channel 1 or 2, whose input pin carries the signal.
+     * @param edge TIMER_IC_RISING or TIMER_IC_FALLING: the edge a
+     *             period starts on.
+     * @param filter Digital input filter, from 0 (off) to 15.
+     * @return false if the channel or edge is not supported.
+     * @see timer_ic_set_pwm_input()
+     */
+    bool setPwmInput(int channel, timer_ic_edge edge, uint8 filter);
+
+    /**
+     * @brief Count a quadrature encoder on channels 1 and 2.
+     *
+     * getCount() then returns the position, modulo getMaxOverflow()
+     * + 1, and the counter counts without any interrupt.  For a
+     * 32-bit position on 16-bit timers, an index input and velocity,
+     * see the QuadratureEncoder library.
+     *
+     * @param mode TIMER_ENCODER_TI12 for 4 counts per cycle, or
+     *             TIMER_ENCODER_TI1 or TIMER_ENCODER_TI2 for 2.
+     * @param filter Digital input filter, from 0 (off) to 15.
+     * @param reverse Count the other way.
+     * @return false for a basic timer.
+     * @see timer_encoder_setup()
+     */
+    bool setEncoderMode(timer_encoder_mode mode, uint8 filter, bool reverse);
+
+    /**
+     * @brief Count edge-aligned or center-aligned.
+     *
+     * Center-aligned, the counter runs up to the overflow value and
+     * back down, halving the PWM frequency and centring the pulses of
+     * all channels on each other.  Pause the timer first.
+     *
+     * @return false for a basic timer, which only counts up.
+     * @see timer_set_count_mode()
+     */
+    bool setCountMode(timer_count_mode mode);
+
+    /**
+     * @brief Set the dead time of TIMER_PWM_COMPLEMENTARY channels.
+     *
+     * Rounded up to what the hardware can do, at most 1008 timer
+     * clock cycles: 6 us on TIMER1 and TIMER8 at 168 MHz.
+     *
+     * @return false if the timer is not an advanced timer.
+     * @see timer_set_dead_time()
+     */
+    bool setDeadTime(uint32 nanoseconds);
+
+    /**
+     * @brief Turn the outputs of an advanced timer on or off.
+     *
+     * The board setup turns them on.  A break turns them off again,
+     * and only this or the break's automatic restart turns them back
+     * on.
+     *
+     * @return false if the timer is not an advanced timer.
+     * @see timer_set_main_output()
+     */
+    bool setMainOutput(bool enable);
 
     /**
      * @brief Attach an interrupt handler to the given channel.
@@ -234,28 +342,28 @@ public:
     void setChannel4Mode(timer_mode mode) { setMode(TIMER_CH4, mode); }
 
     /** @brief Deprecated; use return getCompare(TIMER_CH1) instead. */
-    uint16 getCompare1() { return getCompare(TIMER_CH1); }
+    uint32 getCompare1() { return getCompare(TIMER_CH1); }
 
     /** @brief Deprecated; use return getCompare(TIMER_CH2) instead. */
-    uint16 getCompare2() { return getCompare(TIMER_CH2); }
+    uint32 getCompare2() { return getCompare(TIMER_CH2); }
 
     /** @brief Deprecated; use return getCompare(TIMER_CH3) instead. */
-    uint16 getCompare3() { return getCompare(TIMER_CH3); }
+    uint32 getCompare3() { return getCompare(TIMER_CH3); }
 
     /** @brief Deprecated; use return getCompare(TIMER_CH4) instead. */
-    uint16 getCompare4() { return getCompare(TIMER_CH4); }
+    uint32 getCompare4() { return getCompare(TIMER_CH4); }
 
     /** @brief Deprecated; use setCompare(TIMER_CH1, compare) instead. */
-    void setCompare1(uint16 compare) { setCompare(TIMER_CH1, compare); }
+    void setCompare1(uint32 compare) { setCompare(TIMER_CH1, compare); }
 
     /** @brief Deprecated; use setCompare(TIMER_CH2, compare) instead. */
-    void setCompare2(uint16 compare) { setCompare(TIMER_CH2, compare); }
+    void setCompare2(uint32 compare) { setCompare(TIMER_CH2, compare); }
 
     /** @brief Deprecated; use setCompare(TIMER_CH3, compare) instead. */
-    void setCompare3(uint16 compare) { setCompare(TIMER_CH3, compare); }
+    void setCompare3(uint32 compare) { setCompare(TIMER_CH3, compare); }
 
     /** @brief Deprecated; use setCompare(TIMER_CH4, compare) instead. */
-    void setCompare4(uint16 compare) { setCompare(TIMER_CH4, compare); }
+    void setCompare4(uint32 compare) { setCompare(TIMER_CH4, compare); }
 
     /** @brief Deprecated; use attachInterrupt(TIMER_CH1, handler) instead. */
     void attachCompare1Interrupt(voidFuncPtr handler) {
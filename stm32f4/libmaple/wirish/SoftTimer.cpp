@@ -0,0 +1,182 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file SoftTimer.cpp
+ * @brief Millisecond software timers on a timer wheel.
+ */
+
+#include "SoftTimer.h"
+#include "systick.h"
+
+/* Tickless mode: counter rate, and the longest wait before the
+ * interrupt resynchronises, well inside the 16-bit counter's range */
+#define TICKLESS_HZ 10000
+#define COUNTS_PER_TICK (TICKLESS_HZ / 1000)
+#define MAX_SLEEP 30000
+
+static timer_wheel wheel;
+static HardwareTimer *ticklessTimer;
+static bool running;
+
+/* Tickless mode: counter value up to which the wheel has been
+ * advanced, and counts past its last whole tick at that point. */
+static uint16 lastCount;
+static uint16 partialCounts;
+
+static inline uint32 irqSave(void) {
+    uint32 primask;
+    asm volatile("mrs %0, primask \n\t"
+                 "cpsid i"
+                 : "=r"(primask) : : "memory");
+    return primask;
+}
+
+static inline void irqRestore(uint32 primask) {
+    asm volatile("msr primask, %0" : : "r"(primask) : "memory");
+}
+
+static void systickTick(void) {
+    timer_wheel_advance(&wheel, 1);
+}
+
+/* Whole ticks elapsed that the wheel has not been advanced by yet */
+static uint32 ticklessLag(void) {
+    uint16 elapsed = ticklessTimer->getCount() - lastCount;
+    return (partialCounts + elapsed) / COUNTS_PER_TICK;
+}
+
+/* Set the compare interrupt for the wheel's next expiry.  A target
+ * already passed becomes "as soon as possible" rather than a wait for
+ * the counter to come round again. */
+static void ticklessProgram(void) {
+    uint32 ticks = timer_wheel_next_expiry(&wheel);
+    uint32 counts = MAX_SLEEP;
+    if (ticks < MAX_SLEEP / COUNTS_PER_TICK) {
+        counts = ticks * COUNTS_PER_TICK - partialCounts;
+    }
+    uint16 elapsed = ticklessTimer->getCount() - lastCount;
+    if (counts <= (uint32)elapsed + 1) {
+        counts = elapsed + 2;
+    }
+    ticklessTimer->setCompare(TIMER_CH1, (uint16)(lastCount + counts));
+}
+
+static void ticklessTick(void) {
+    uint16 count = ticklessTimer->getCount();
+    uint32 counts = partialCounts + (uint16)(count - lastCount);
+    lastCount = count;
+    partialCounts = counts % COUNTS_PER_TICK;
+    timer_wheel_advance(&wheel, counts / COUNTS_PER_TICK);
+    ticklessProgram();
+}
+
+SoftTimer::SoftTimer(voidFuncPtr handler) {
+    this->handler = handler;
+    wheel_timer_init(&timer, expired, this);
+}
+
+void SoftTimer::expired(void *arg) {
+    SoftTimer *timer = (SoftTimer*)arg;
+    if (timer->handler) {
+        timer->handler();
+    }
+}
+
+void SoftTimer::start(uint32 delayMs, uint32 periodMs) {
+    if (!running) {
+        begin();
+    }
+    uint32 primask = irqSave();
+    if (ticklessTimer) {
+        /* The wheel lags real time between interrupts */
+        timer_wheel_start(&wheel, &timer, delayMs + ticklessLag(), periodMs);
+        ticklessProgram();
+    } else {
+        timer_wheel_start(&wheel, &timer, delayMs, periodMs);
+    }
+    irqRestore(primask);
+}
+
+void SoftTimer::stop(void) {
+    uint32 primask = irqSave();
+    timer_wheel_stop(&wheel, &timer);
+    irqRestore(primask);
+}
+
+bool SoftTimer::isActive(void) const {
+    return wheel_timer_active(&timer);
+}
+
+void SoftTimer::begin(void) {
+    end();
+    running = systick_subscribe(systickTick) == 0;
+}
+
+void SoftTimer::beginTickless(HardwareTimer &timer) {
+    end();
+    timer.pause();
+    timer.setPrescaleFactor(timer.getClockSpeed() / TICKLESS_HZ);
+    timer.setOverflow(0xFFFF);
+    timer.setMode(TIMER_CH1, TIMER_OUTPUT_COMPARE);
+    timer.refresh();
+
+    uint32 primask = irqSave();
+    ticklessTimer = &timer;
+    lastCount = timer.getCount();
+    partialCounts = 0;
+    ticklessProgram();
+    irqRestore(primask);
+
+    timer.attachInterrupt(TIMER_CH1, ticklessTick);
+    timer.resume();
+    running = true;
+}
+
+void SoftTimer::end(void) {
+    if (ticklessTimer) {
+        ticklessTimer->pause();
+        ticklessTimer->detachInterrupt(TIMER_CH1);
+        /* Catch the wheel up before SysTick might take over */
+        uint32 primask = irqSave();
+        timer_wheel_advance(&wheel, ticklessLag());
+        ticklessTimer = NULL;
+        irqRestore(primask);
+    } else if (running) {
+        systick_unsubscribe(systickTick);
+    }
+    running = false;
+}
+
+uint32 SoftTimer::now(void) {
+    uint32 primask = irqSave();
+    uint32 ms = timer_wheel_now(&wheel);
+    if (ticklessTimer) {
+        ms += ticklessLag();
+    }
+    irqRestore(primask);
+    return ms;
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file SoftTimer.h
+ * @brief Millisecond software timers on a timer wheel.
+ *
+ * Any number of SoftTimers share one hierarchical timer wheel
+ * (timer_wheel.h), so starting and stopping one costs the same with
+ * ten or ten thousand running.  The wheel ticks every millisecond
+ * from a SysTick subscriber, which leaves systick_attach_callback()
+ * to FreeRTOS, or, after beginTickless(), from a hardware timer that
+ * only interrupts when a SoftTimer is due.
+ *
+ *     void blink(void) { toggleLED(); }
+ *     SoftTimer blinker(blink);
+ *
+ *     void setup() {
+ *         pinMode(BOARD_LED_PIN, OUTPUT);
+ *         blinker.start(500, 500);    // every 500 ms, from now + 500
+ *     }
+ *
+ * Handlers run in the SysTick or timer interrupt, so they should be
+ * short.  They may start and stop any SoftTimer, including their own.
+ */
+
+#ifndef _SOFTTIMER_H_
+#define _SOFTTIMER_H_
+
+#include "libmaple_types.h"
+#include "timer_wheel.h"
+#include "HardwareTimer.h"
+
+class SoftTimer {
+public:
+    /**
+     * @param handler Function to call when the timer expires.
+     */
+    SoftTimer(voidFuncPtr handler = NULL);
+
+    /** Set the function to call when the timer expires. */
+    void attachInterrupt(voidFuncPtr handler) { this->handler = handler; }
+
+    /**
+     * @brief Start, or restart, the timer.
+     * @param delayMs  Milliseconds until the first call of the handler.
+     * @param periodMs Milliseconds between later calls; 0 (the
+     *                 default) for a one-shot timer.
+     */
+    void start(uint32 delayMs, uint32 periodMs = 0);
+
+    /** Stop the timer; its handler will not be called again. */
+    void stop(void);
+
+    /** Whether the timer is running. One-shot timers stop when they fire. */
+    bool isActive(void) const;
+
+    /**
+     * @brief Tick the timers from SysTick.
+     *
+     * The first start() calls this if neither begin function was.
+     */
+    static void begin(void);
+
+    /**
+     * @brief Tick the timers from a hardware timer instead.
+     *
+     * The timer counts freely at 10 kHz, and its channel 1 compare
+     * interrupt is set for the next SoftTimer due, so an idle system
+     * takes no interrupts for SoftTimers (SysTick may even be
+     * stopped).  The timer is used exclusively.
+     */
+    static void beginTickless(HardwareTimer &timer);
+
+    /** Stop ticking the timers; running ones stay where they are. */
+    static void end(void);
+
+    /** Milliseconds counted by the wheel since the first begin. */
+    static uint32 now(void);
+
+private:
+    wheel_timer timer;
+    voidFuncPtr handler;
+
+    static void expired(void *arg);
+};
+
+#endif
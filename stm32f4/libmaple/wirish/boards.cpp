@@ -41,31 +41,84 @@
 #include "adc.h"
 #include "timer.h"
 #include "usb.h"
+#include "boot_trace.h"
 
 static void setupFlash(void);
 static void setupClocks(void);
 static void setupNVIC(void);
+static void setupADCCommon(void);
 static void setupADC(void);
 static void setupTimers(void);
+static void adcDefaultConfig(const adc_dev* dev);
+static void timerDefaultConfig(timer_dev*);
 
 void init(void) {
+    boot_trace_init();
+    boot_trace_mark(BOOT_TAG('i','n','i','t'));
 	setupFlash();
 
 	setupClocks();
+    boot_trace_mark(BOOT_TAG('c','l','k',' '));
     setupNVIC();
 	systick_init(SYSTICK_RELOAD_VAL);
 	gpio_init_all();
+    boot_trace_mark(BOOT_TAG('g','p','i','o'));
 
 #ifndef STM32F2
     afio_init();
 #endif
 
     boardInit();
+    boot_trace_mark(BOOT_TAG('b','r','d',' '));
+#if BOARD_INIT_ADC
     setupADC();
+    boot_trace_mark(BOOT_TAG('a','d','c',' '));
+#endif
+#if BOARD_INIT_TIMERS
     setupTimers();
+    boot_trace_mark(BOOT_TAG('t','i','m',' '));
+#endif
 
 #ifndef STM32F2
     setupUSB();
+    boot_trace_mark(BOOT_TAG('u','s','b',' '));
+#endif
+}
+
+/* Devices configured on first use, one bit per rcc_clk_id */
+#if !BOARD_INIT_ADC || !BOARD_INIT_TIMERS
+static uint32 lazyReady[4];
+
+static bool lazyFirstUse(rcc_clk_id id) {
+    uint32 bit = 1UL << (id % 32);
+
+    if (lazyReady[id / 32] & bit) {
+        return false;
+    }
+    lazyReady[id / 32] |= bit;
+    return true;
+}
+#endif
+
+void boardEnsureADC(const adc_dev *dev) {
+#if !BOARD_INIT_ADC
+    static bool common = false;
+
+    if (lazyFirstUse(dev->clk_id)) {
+        if (!common) {
+            setupADCCommon();
+            common = true;
+        }
+        adcDefaultConfig(dev);
+    }
+#endif
+}
+
+void boardEnsureTimer(timer_dev *dev) {
+#if !BOARD_INIT_TIMERS
+    if (lazyFirstUse(dev->clk_id)) {
+        timerDefaultConfig(dev);
+    }
 #endif
 }
 
@@ -115,18 +168,18 @@ static void setupNVIC() {
 #endif
 }
 
-static void adcDefaultConfig(const adc_dev* dev);
-
-static void setupADC() {
+static void setupADCCommon() {
 #ifdef STM32F2
 	setupADC_F2();
 #else
 	rcc_set_prescaler(RCC_PRESCALER_ADC, RCC_ADCPRE_PCLK_DIV_6);
 #endif
-    adc_foreach(adcDefaultConfig);
 }
 
-static void timerDefaultConfig(timer_dev*);
+static void setupADC() {
+    setupADCCommon();
+    adc_foreach(adcDefaultConfig);
+}
 
 static void setupTimers() {
     timer_foreach(timerDefaultConfig);
@@ -136,7 +189,10 @@ static void adcDefaultConfig(const adc_dev *dev) {
     adc_init(dev);
 
     adc_set_extsel(dev, ADC_SWSTART);
+#ifndef STM32F2
+    /* The F1 treats SWSTART as one of the external events */
     adc_set_exttrig(dev, true);
+#endif
 
     adc_enable(dev);
     adc_calibrate(dev);
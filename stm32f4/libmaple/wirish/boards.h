@@ -40,6 +40,7 @@
 #define _BOARDS_H_
 
 #include "libmaple.h"
+#include "adc.h"
 #include "gpio.h"
 #include "timer.h"
 
@@ -117,6 +118,24 @@ extern void boardInit(void);
  */
 bool boardUsesPin(uint8 pin);
 
+/**
+ * @brief Give an ADC its default configuration if init() skipped it.
+ *
+ * Only does something on boards with BOARD_INIT_ADC set to 0, the
+ * first time it is called for dev. pinMode() calls it for INPUT_ANALOG.
+ */
+void boardEnsureADC(const adc_dev *dev);
+
+/**
+ * @brief Give a timer its default (PWM) configuration if init()
+ *        skipped it.
+ *
+ * Only does something on boards with BOARD_INIT_TIMERS set to 0, the
+ * first time it is called for dev. pinMode() calls it for PWM, and
+ * HardwareTimer for its timer.
+ */
+void boardEnsureTimer(timer_dev *dev);
+
 /* Include the appropriate private header from boards/: */
 
 /* FIXME HACK put boards/ before these paths once IDE uses make. */
@@ -158,4 +177,17 @@ bool boardUsesPin(uint8 pin);
 #define CLOCK_SPEED_MHZ                 CYCLES_PER_MICROSECOND
 #define CLOCK_SPEED_HZ                  (CLOCK_SPEED_MHZ * 1000000UL)
 
+/*
+ * Peripheral setup done by init() before setup(). A board header (or
+ * -D in the build) can set these to 0 for a faster start: each ADC and
+ * timer then gets its default configuration on first use instead, see
+ * boardEnsureADC() and boardEnsureTimer().
+ */
+#ifndef BOARD_INIT_ADC
+#define BOARD_INIT_ADC                  1
+#endif
+#ifndef BOARD_INIT_TIMERS
+#define BOARD_INIT_TIMERS               1
+#endif
+
 #endif
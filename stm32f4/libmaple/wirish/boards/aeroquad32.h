@@ -37,6 +37,10 @@
 
 #define Port2Pin(port, bit) ((port-'A')*16+bit)
 
+/* Pin table for FastPin.h: pin n is bit n % 16 of port 'A' + n / 16. */
+#define BOARD_PIN_PORT(pin)     ('A' + (pin) / 16)
+#define BOARD_PIN_BIT(pin)      ((pin) % 16)
+
 #define CYCLES_PER_MICROSECOND  72
 #define SYSTICK_RELOAD_VAL      71999
 
@@ -69,6 +69,12 @@
 #define BOARD_NR_PWM_PINS       12
 #define BOARD_NR_ADC_PINS        8
 #define BOARD_NR_USED_PINS       7 // ala42 not set yet
+
+/* GPIO port and bit of each pin, in PIN_MAP order, for FastPin.h. */
+#define BOARD_PIN_PORTS         "AABABBBABABBAAAABBA"
+#define BOARD_PIN_BITS          9, 10, 7, 7, 6, 8, 9, 15, 3, 6, 0, 1, \
+                                2, 3, 0, 5, 11, 10, 4
+
 #define BOARD_JTMS_SWDIO_PIN    Port2Pin('A',13)
 #define BOARD_JTCK_SWCLK_PIN    Port2Pin('A',14)
 #define BOARD_JTDI_PIN          Port2Pin('A',15)
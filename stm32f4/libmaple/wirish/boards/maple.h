@@ -67,6 +67,13 @@
  * intended for general use. */
 #define BOARD_NR_GPIO_PINS      44
 
+/* GPIO port and bit of each pin, in PIN_MAP order, for FastPin.h. */
+#define BOARD_PIN_PORTS         "AAAABBAAABAAAABCCCCCCCCCBDCBBBBBBBBCCCCAAABB"
+#define BOARD_PIN_BITS          3, 2, 0, 1, 5, 6, 8, 9, 10, 7, 4, 7, \
+                                6, 5, 8, 0, 1, 2, 3, 4, 5, 13, 14, 15, \
+                                9, 2, 10, 0, 1, 10, 11, 12, 13, 14, 15, 6, \
+                                7, 8, 9, 13, 14, 15, 3, 4
+
 /* Number of pins capable of PWM output */
 #define BOARD_NR_PWM_PINS       15
 
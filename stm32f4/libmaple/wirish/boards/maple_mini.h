@@ -64,6 +64,12 @@
 #define BOARD_NR_ADC_PINS          9
 #define BOARD_NR_USED_PINS         4
 
+/* GPIO port and bit of each pin, in PIN_MAP order, for FastPin.h. */
+#define BOARD_PIN_PORTS         "BBBBAAAAAAAACCCBBBBBAAAAAAAABBBBBB"
+#define BOARD_PIN_BITS          11, 10, 2, 0, 7, 6, 5, 4, 3, 2, 1, 0, \
+                                15, 14, 13, 7, 6, 5, 4, 3, 15, 14, 13, 12, \
+                                11, 10, 9, 8, 15, 14, 13, 12, 8, 1
+
 #define BOARD_JTMS_SWDIO_PIN      22
 #define BOARD_JTCK_SWCLK_PIN      21
 #define BOARD_JTDI_PIN            20
@@ -71,6 +71,21 @@
 #define BOARD_NR_PWM_PINS       18
 #define BOARD_NR_ADC_PINS       21
 #define BOARD_NR_USED_PINS      43
+
+/* GPIO port and bit of each pin, in PIN_MAP order, for FastPin.h. */
+#define BOARD_PIN_PORTS         "BBBBBBGCCCCCCCCCCCCCCCCAAABDDDGGGGGGGBBBFFFFFFBB" \
+                                "AAAAAAAAFDDFDDFDDFEDFEEFEEFEEFEFGEFGEGDEGDEGEEGE" \
+                                "DGDGDAAABB"
+#define BOARD_PIN_BITS          10, 11, 12, 13, 14, 15, 15, 0, 1, 2, 3, 4, \
+                                5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 8, \
+                                9, 10, 9, 2, 3, 6, 11, 12, 13, 14, 8, 7, \
+                                6, 5, 6, 7, 11, 6, 7, 8, 9, 10, 1, 0, \
+                                0, 1, 2, 3, 4, 5, 6, 7, 0, 11, 14, 1, \
+                                12, 15, 2, 13, 0, 3, 3, 1, 4, 4, 7, 5, \
+                                5, 8, 12, 6, 9, 13, 10, 14, 9, 11, 15, 10, \
+                                12, 0, 5, 13, 1, 4, 14, 2, 1, 15, 3, 0, \
+                                8, 4, 9, 5, 10, 13, 14, 15, 3, 4
+
 #define BOARD_JTMS_SWDIO_PIN    101
 #define BOARD_JTCK_SWCLK_PIN    102
 #define BOARD_JTDI_PIN          103
@@ -31,7 +31,9 @@
 }
 
 int main(void) {
+    boot_trace_mark(BOOT_TAG('s','e','t','p'));
     setup();
+    boot_trace_mark(BOOT_TAG('l','o','o','p'));
 
     while (1) {
         loop();
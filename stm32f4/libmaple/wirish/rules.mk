@@ -27,15 +27,25 @@ cppSRCS_$(d) := wirish_math.cpp		 \
                 comm/HardwareSerial.cpp	 \
                 comm/HardwareSPI.cpp	 \
 		HardwareTimer.cpp	 \
-                usb_serial.cpp		 \
+		SoftTimer.cpp		 \
+		EventLoop.cpp		 \
                 cxxabi-compat.cpp	 \
 		wirish_shift.cpp	 \
 		wirish_analog.cpp	 \
 		wirish_time.cpp		 \
+		wirish_boot.cpp		 \
+		wirish_profile.cpp	 \
 		pwm.cpp 		 \
 		ext_interrupts.cpp	 \
 		wirish_digital.cpp
 
+# QEMU builds have no USB device; SerialUSB goes over semihosting
+ifeq ($(QEMU),1)
+	cppSRCS_$(d) += usb_serial_semihost.cpp
+else
+	cppSRCS_$(d) += usb_serial.cpp
+endif
+
 cFILES_$(d)   := $(cSRCS_$(d):%=$(d)/%)
 cppFILES_$(d) := $(cppSRCS_$(d):%=$(d)/%)
 
@@ -36,6 +36,8 @@
 #define USB_TIMEOUT 50
 
 USBSerial::USBSerial(void) {
+    this->wait_hook = NULL;
+    this->resetStats();
 }
 
 void USBSerial::begin(void) {
@@ -60,40 +62,145 @@ void USBSerial::write(const char *str) {
 }
 
 void USBSerial::write(const void *buf, uint32 len) {
-    if (!(usbIsConnected() && usbIsConfigured()) || !buf) {
-        return;
+    this->writeBytes(buf, len, USB_TIMEOUT);
+}
+
+uint32 USBSerial::available(void) {
+    return usbBytesAvailable();
+}
+
+/*
+ * Stall bookkeeping shared by readBytes() and writeBytes().  The
+ * timeout is an inactivity timeout: it restarts whenever the endpoint
+ * accepts or delivers bytes, as write() has always behaved.
+ */
+
+struct usb_serial_xfer {
+    uint32 last_progress;       /* millis() at the last transferred byte */
+    uint32 stall_start;         /* micros() when the current stall began */
+    uint8 stalled;
+};
+
+static inline void xfer_start(usb_serial_xfer *x) {
+    x->last_progress = millis();
+    x->stalled = 0;
+}
+
+static inline void xfer_progress(usb_serial_xfer *x, usb_serial_stats *st) {
+    if (x->stalled) {
+        st->stall_us += micros() - x->stall_start;
+        x->stalled = 0;
     }
+    x->last_progress = millis();
+}
 
-    uint32 txed = 0;
-    uint32 old_txed = 0;
-    uint32 start = millis();
+/* Returns nonzero if the caller should keep waiting. */
+static uint8 xfer_wait(usb_serial_xfer *x, usb_serial_stats *st,
+                       usb_serial_wait_hook hook, usb_serial_dir dir,
+                       uint32 timeout_ms) {
+    uint32 remaining = USB_SERIAL_WAIT_FOREVER;
 
-    while (txed < len && (millis() - start < USB_TIMEOUT)) {
-        txed += usbSendBytes((const uint8*)buf + txed, len - txed);
-        if (old_txed != txed) {
-            start = millis();
+    if (!x->stalled) {
+        x->stall_start = micros();
+        x->stalled = 1;
+    }
+    if (timeout_ms != USB_SERIAL_WAIT_FOREVER) {
+        uint32 elapsed = millis() - x->last_progress;
+        if (elapsed >= timeout_ms) {
+            st->timeouts++;
+            return 0;
         }
-        old_txed = txed;
+        remaining = timeout_ms - elapsed;
+    }
+    if (hook) {
+        hook(dir, remaining);
     }
+    return 1;
 }
 
-uint32 USBSerial::available(void) {
-    return usbBytesAvailable();
+static inline void xfer_finish(usb_serial_xfer *x, usb_serial_stats *st) {
+    if (x->stalled) {
+        st->stall_us += micros() - x->stall_start;
+    }
 }
 
-uint32 USBSerial::read(void *buf, uint32 len) {
+/**
+ * @brief Transmit up to len bytes, giving up after timeout_ms
+ *        milliseconds without progress.
+ *
+ * While the IN endpoint is busy the configured wait hook is called
+ * instead of spinning.  Bytes which could not be sent because the
+ * host is disconnected or the timeout expired are counted as dropped.
+ *
+ * @return Number of bytes actually queued for transmission.
+ */
+uint32 USBSerial::writeBytes(const void *buf, uint32 len, uint32 timeout_ms) {
     if (!buf) {
         return 0;
     }
+    if (!this->isConnected()) {
+        this->tx_stats.dropped += len;
+        return 0;
+    }
 
+    usb_serial_xfer x;
+    uint32 txed = 0;
+
+    xfer_start(&x);
+    while (txed < len) {
+        uint32 n = usbSendBytes((const uint8*)buf + txed, len - txed);
+        if (n) {
+            txed += n;
+            xfer_progress(&x, &this->tx_stats);
+        } else if (!this->isConnected() ||
+                   !xfer_wait(&x, &this->tx_stats, this->wait_hook,
+                              USB_SERIAL_TX, timeout_ms)) {
+            break;
+        }
+    }
+    xfer_finish(&x, &this->tx_stats);
+
+    this->tx_stats.bytes += txed;
+    this->tx_stats.dropped += len - txed;
+    return txed;
+}
+
+/**
+ * @brief Receive up to len bytes, giving up after timeout_ms
+ *        milliseconds without progress.
+ *
+ * @return Number of bytes stored in buf.
+ */
+uint32 USBSerial::readBytes(void *buf, uint32 len, uint32 timeout_ms) {
+    if (!buf) {
+        return 0;
+    }
+
+    usb_serial_xfer x;
     uint32 rxed = 0;
+
+    xfer_start(&x);
     while (rxed < len) {
-        rxed += usbReceiveBytes((uint8*)buf + rxed, len - rxed);
+        uint32 n = usbReceiveBytes((uint8*)buf + rxed, len - rxed);
+        if (n) {
+            rxed += n;
+            xfer_progress(&x, &this->rx_stats);
+        } else if (!xfer_wait(&x, &this->rx_stats, this->wait_hook,
+                              USB_SERIAL_RX, timeout_ms)) {
+            break;
+        }
     }
+    xfer_finish(&x, &this->rx_stats);
 
+    this->rx_stats.bytes += rxed;
     return rxed;
 }
 
+/* Blocks forever until len bytes are received */
+uint32 USBSerial::read(void *buf, uint32 len) {
+    return this->readBytes(buf, len, USB_SERIAL_WAIT_FOREVER);
+}
+
 /* Blocks forever until 1 byte is received */
 uint8 USBSerial::read(void) {
     uint8 buf[1];
@@ -101,6 +208,34 @@ uint8 USBSerial::read(void) {
     return buf[0];
 }
 
+/**
+ * @brief Select how blocking calls wait for the USB endpoints.
+ *
+ * NULL (the default) and waitSpin() busy-wait; waitWFI() sleeps until
+ * the next interrupt.  Under FreeRTOS, see usbSerialWaitYield() and
+ * usbSerialWaitSemaphore() in MapleFreeRTOS.h.
+ */
+void USBSerial::setWaitHook(usb_serial_wait_hook hook) {
+    this->wait_hook = hook;
+}
+
+const usb_serial_stats* USBSerial::getStats(usb_serial_dir dir) {
+    return dir == USB_SERIAL_TX ? &this->tx_stats : &this->rx_stats;
+}
+
+void USBSerial::resetStats(void) {
+    memset(&this->rx_stats, 0, sizeof(this->rx_stats));
+    memset(&this->tx_stats, 0, sizeof(this->tx_stats));
+}
+
+void USBSerial::waitSpin(usb_serial_dir, uint32) {
+}
+
+/* The USB interrupt or, at the latest, the next SysTick wakes us up. */
+void USBSerial::waitWFI(usb_serial_dir, uint32) {
+    asm volatile("wfi");
+}
+
 uint8 USBSerial::pending(void) {
     return usbGetPending();
 }
@@ -33,6 +33,34 @@
 
 #include "Print.h"
 
+/** Timeout value meaning "wait until the transfer completes". */
+#define USB_SERIAL_WAIT_FOREVER 0xFFFFFFFF
+
+/** Transfer direction, as seen from the board. */
+typedef enum usb_serial_dir {
+    USB_SERIAL_RX,              /**< Host to board (OUT endpoint) */
+    USB_SERIAL_TX               /**< Board to host (IN endpoint) */
+} usb_serial_dir;
+
+/**
+ * @brief Wait strategy used while a transfer cannot make progress.
+ *
+ * The hook is called with the direction being waited on and the
+ * number of milliseconds left before the caller gives up (or
+ * USB_SERIAL_WAIT_FOREVER).  It may return early at any time; the
+ * caller rechecks the endpoint and calls it again as needed.
+ */
+typedef void (*usb_serial_wait_hook)(usb_serial_dir dir, uint32 timeout_ms);
+
+/** Per-direction transfer statistics. */
+typedef struct usb_serial_stats {
+    uint32 bytes;               /**< Bytes successfully transferred */
+    uint32 dropped;             /**< Bytes discarded: disconnected or
+                                     timed out */
+    uint32 timeouts;            /**< Calls that ended in a timeout */
+    uint32 stall_us;            /**< Time spent waiting on the endpoint */
+} usb_serial_stats;
+
 /**
  * @brief Virtual serial terminal.
  */
@@ -53,10 +81,27 @@ public:
     void write(const char *str);
     void write(const void*, uint32);
 
+    uint32 readBytes(void *buf, uint32 len, uint32 timeout_ms);
+    uint32 writeBytes(const void *buf, uint32 len, uint32 timeout_ms);
+
+    void setWaitHook(usb_serial_wait_hook hook);
+
+    const usb_serial_stats* getStats(usb_serial_dir dir);
+    void resetStats(void);
+
     uint8 getRTS();
     uint8 getDTR();
     uint8 isConnected();
     uint8 pending();
+
+    /* Built-in wait strategies for setWaitHook(). */
+    static void waitSpin(usb_serial_dir dir, uint32 timeout_ms);
+    static void waitWFI(usb_serial_dir dir, uint32 timeout_ms);
+
+private:
+    usb_serial_wait_hook wait_hook;
+    usb_serial_stats rx_stats;
+    usb_serial_stats tx_stats;
 };
 
 extern USBSerial SerialUSB;
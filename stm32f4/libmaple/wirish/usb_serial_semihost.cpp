@@ -0,0 +1,138 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @brief SerialUSB over semihosting, for QEMU builds
+ *
+ * QEMU's netduinoplus2 machine has no USB device, so QEMU builds
+ * (make qemu) link this file instead of usb_serial.cpp: SerialUSB
+ * writes to QEMU's standard output and reads its standard input,
+ * which lets the examples run unchanged under a headless runner.
+ * Input has to be read with read(); available() is always 0.
+ */
+
+#include <string.h>
+
+#include "wirish.h"
+#include "semihost.h"
+
+USBSerial::USBSerial(void) {
+    this->wait_hook = NULL;
+    this->resetStats();
+}
+
+void USBSerial::begin(void) {
+}
+
+void USBSerial::begin(int) {
+}
+
+void USBSerial::end(void) {
+}
+
+void USBSerial::write(uint8 ch) {
+    this->write(&ch, 1);
+}
+
+void USBSerial::write(const char *str) {
+    this->write(str, strlen(str));
+}
+
+void USBSerial::write(const void *buf, uint32 len) {
+    this->writeBytes(buf, len, USB_SERIAL_WAIT_FOREVER);
+}
+
+/*
+ * Semihosting cannot poll stdin, so nothing is ever known to be
+ * waiting: a drain loop on available() ends at once.  read() still
+ * blocks until the host sends a byte.
+ */
+uint32 USBSerial::available(void) {
+    return 0;
+}
+
+uint32 USBSerial::writeBytes(const void *buf, uint32 len, uint32) {
+    semihost_write(buf, len);
+    this->tx_stats.bytes += len;
+    return len;
+}
+
+uint32 USBSerial::readBytes(void *buf, uint32 len, uint32) {
+    uint8 *dst = (uint8*)buf;
+    for (uint32 i = 0; i < len; i++) {
+        dst[i] = (uint8)semihost_readc();
+    }
+    this->rx_stats.bytes += len;
+    return len;
+}
+
+uint32 USBSerial::read(void *buf, uint32 len) {
+    return this->readBytes(buf, len, USB_SERIAL_WAIT_FOREVER);
+}
+
+uint8 USBSerial::read(void) {
+    uint8 buf[1];
+    this->read(buf, 1);
+    return buf[0];
+}
+
+void USBSerial::setWaitHook(usb_serial_wait_hook hook) {
+    this->wait_hook = hook;
+}
+
+const usb_serial_stats* USBSerial::getStats(usb_serial_dir dir) {
+    return dir == USB_SERIAL_TX ? &this->tx_stats : &this->rx_stats;
+}
+
+void USBSerial::resetStats(void) {
+    memset(&this->rx_stats, 0, sizeof(this->rx_stats));
+    memset(&this->tx_stats, 0, sizeof(this->tx_stats));
+}
+
+void USBSerial::waitSpin(usb_serial_dir, uint32) {
+}
+
+void USBSerial::waitWFI(usb_serial_dir, uint32) {
+    asm volatile("wfi");
+}
+
+uint8 USBSerial::pending(void) {
+    return 0;
+}
+
+uint8 USBSerial::isConnected(void) {
+    return 1;
+}
+
+uint8 USBSerial::getDTR(void) {
+    return 1;
+}
+
+uint8 USBSerial::getRTS(void) {
+    return 0;
+}
+
+USBSerial SerialUSB;
@@ -44,9 +44,14 @@
 #include "wirish_debug.h"
 #include "wirish_math.h"
 #include "wirish_time.h"
+#include "wirish_boot.h"
+#include "wirish_profile.h"
 #include "HardwareSPI.h"
 #include "HardwareSerial.h"
 #include "HardwareTimer.h"
+#include "SoftTimer.h"
+#include "EventLoop.h"
+#include "FastPin.h"
 #include "usb_serial.h"
 
 /* Arduino wiring macros and bit defines  */
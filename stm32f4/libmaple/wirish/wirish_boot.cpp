@@ -0,0 +1,55 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @brief Startup time report.
+ */
+
+#include "wirish_boot.h"
+#include "boards.h"
+
+void bootTraceDump(Print &out) {
+    uint32 n = boot_trace_count();
+    uint32 prev = 0;
+
+    out.println("stage     cycles        us");
+    for (uint32 i = 0; i < n; i++) {
+        const boot_stamp *s = boot_trace_get(i);
+        char tag[5];
+
+        for (int c = 0; c < 4; c++) {
+            tag[c] = (char)(s->tag >> (8 * c));
+        }
+        tag[4] = '\0';
+
+        out.print(tag);
+        out.print("  ");
+        out.print(s->cycles);
+        out.print("  +");
+        out.println((s->cycles - prev) / CYCLES_PER_MICROSECOND);
+        prev = s->cycles;
+    }
+}
@@ -0,0 +1,50 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file wirish_boot.h
+ * @brief Startup time report.
+ */
+
+#ifndef _WIRISH_BOOT_H_
+#define _WIRISH_BOOT_H_
+
+#include "boot_trace.h"
+#include "Print.h"
+
+/**
+ * Print the startup stages recorded since reset, one per line: tag,
+ * cycle count, and the time since the previous stage in microseconds.
+ *
+ * Stages stamped by the bootloader before it switches to the PLL run
+ * from the internal oscillator, so their microsecond figures are only
+ * an upper bound; the cycle counts are exact.
+ *
+ * @param out Where to print, e.g. SerialUSB or Serial1.
+ */
+void bootTraceDump(Print &out);
+
+#endif
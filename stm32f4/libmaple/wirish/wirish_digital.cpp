@@ -74,7 +74,14 @@ void pinMode(uint8 pin, WiringPinMode mode) {
 
     gpio_set_mode(PIN_MAP[pin].gpio_device, PIN_MAP[pin].gpio_bit, outputMode);
 
+    if (mode == INPUT_ANALOG && PIN_MAP[pin].adc_device != NULL) {
+        boardEnsureADC(PIN_MAP[pin].adc_device);
+    }
+
     if (PIN_MAP[pin].timer_device != NULL) {
+        if (pwm) {
+            boardEnsureTimer(PIN_MAP[pin].timer_device);
+        }
         /* Enable/disable timer channels if we're switching into or
          * out of PWM. */
         timer_set_mode(PIN_MAP[pin].timer_device,
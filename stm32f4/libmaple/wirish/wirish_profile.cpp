@@ -0,0 +1,112 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @brief Cycle-count profiling of named code sections.
+ */
+
+#include <string.h>
+
+#include "wirish_profile.h"
+#include "boards.h"
+
+/* All sections, most recently constructed first. Zero-initialized
+ * before any constructor runs, so construction order does not matter. */
+static ProfileSection *profileSections;
+
+ProfileSection::ProfileSection(const char *name) : name(name) {
+    reset();
+    next = profileSections;
+    profileSections = this;
+}
+
+void ProfileSection::add(uint32 cycles) {
+    /* sections may be timed from interrupt handlers too */
+    uint32 primask;
+    asm volatile("mrs %0, primask \n\t"
+                 "cpsid i"
+                 : "=r" (primask) : : "memory");
+    if (cycles < min) {
+        min = cycles;
+    }
+    if (cycles > max) {
+        max = cycles;
+    }
+    total += cycles;
+    count++;
+    asm volatile("msr primask, %0" : : "r" (primask) : "memory");
+}
+
+void ProfileSection::reset(void) {
+    count = 0;
+    min = 0xFFFFFFFF;
+    max = 0;
+    total = 0;
+}
+
+uint32 ProfileSection::getMean(void) const {
+    uint32 n = count;
+    return n ? (uint32)(total / n) : 0;
+}
+
+static void printColumn(Print &out, uint32 value) {
+    char digits[11];
+    int i = sizeof(digits) - 1;
+
+    digits[i] = '\0';
+    do {
+        digits[--i] = '0' + value % 10;
+        value /= 10;
+    } while (value && i > 0);
+    while (i > 0) {
+        digits[--i] = ' ';
+    }
+    out.print(' ');
+    out.print(digits);
+}
+
+void profileDump(Print &out) {
+    out.println("section       count        min        max       mean    mean us");
+    for (ProfileSection *s = profileSections; s != NULL; s = s->next) {
+        const char *name = s->getName();
+        out.print(name);
+        for (uint32 len = strlen(name); len < 12; len++) {
+            out.print(' ');
+        }
+        printColumn(out, s->getCount());
+        printColumn(out, s->getMin());
+        printColumn(out, s->getMax());
+        printColumn(out, s->getMean());
+        printColumn(out, s->getMean() / CYCLES_PER_MICROSECOND);
+        out.println();
+    }
+}
+
+void profileReset(void) {
+    for (ProfileSection *s = profileSections; s != NULL; s = s->next) {
+        s->reset();
+    }
+}
@@ -0,0 +1,103 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file wirish_profile.h
+ * @brief Cycle-count profiling of named code sections.
+ *
+ * Declare a section at file scope and time a block with a scope
+ * object; the scope measures from its construction to the end of the
+ * block:
+ *
+ *     ProfileSection fftSection("fft");
+ *
+ *     void loop() {
+ *         ProfileScope p(fftSection);
+ *         fft(samples);
+ *     }
+ *
+ * profileDump() prints count, min, max and mean cycles of every
+ * section. Sections live at file scope because function-local statics
+ * with constructors are not supported (no guard variables without the
+ * C++ runtime).
+ */
+
+#ifndef _WIRISH_PROFILE_H_
+#define _WIRISH_PROFILE_H_
+
+#include "dwt.h"
+#include "Print.h"
+
+class ProfileSection {
+public:
+    ProfileSection(const char *name);
+
+    /** Add one measurement of the given number of cycles. */
+    void add(uint32 cycles);
+    /** Forget all measurements. */
+    void reset(void);
+
+    const char *getName(void) const { return name; }
+    uint32 getCount(void) const { return count; }
+    uint32 getMin(void) const { return count ? min : 0; }
+    uint32 getMax(void) const { return max; }
+    uint32 getMean(void) const;
+
+    ProfileSection *next;       /**< Next section in the list profileDump() walks */
+
+private:
+    const char *name;
+    volatile uint32 count;
+    volatile uint32 min;
+    volatile uint32 max;
+    volatile uint64 total;
+};
+
+/**
+ * Times its own lifetime into a ProfileSection.
+ */
+class ProfileScope {
+public:
+    ProfileScope(ProfileSection &section)
+        : section(section), start(dwt_cycles()) {}
+    ~ProfileScope() { section.add(dwt_cycles() - start); }
+
+private:
+    ProfileSection &section;
+    uint32 start;
+};
+
+/**
+ * Print one line per section: name, count, min, max and mean cycles,
+ * and the mean in microseconds.
+ * @param out Where to print, e.g. SerialUSB.
+ */
+void profileDump(Print &out);
+
+/** Reset the measurements of every section. */
+void profileReset(void);
+
+#endif
@@ -35,6 +35,7 @@
 #include "libmaple.h"
 #include "nvic.h"
 #include "systick.h"
+#include "dwt.h"
 #include "boards.h"
 
 #define US_PER_MS               1000
@@ -49,26 +50,31 @@ static inline uint32 millis(void) {
 }
 
 /**
- * Returns time (in microseconds) since the beginning of program
- * execution.  On overflow, restarts at 0.
+ * Returns time (in microseconds) since reset, from the DWT cycle
+ * counter.  On overflow, restarts at 0.
  * @see millis()
+ * @see nanos()
  */
 static inline uint32 micros(void) {
-    uint32 ms;
-    uint32 cycle_cnt;
-    uint32 res;
-
-    do {
-        ms = millis();
-        cycle_cnt = systick_get_count();
-    } while (ms != millis());
+    return (uint32)dwt_div_small(dwt_cycles64(), CYCLES_PER_MICROSECOND);
+}
 
-    /* SYSTICK_RELOAD_VAL is 1 less than the number of cycles it
-       actually takes to complete a SysTick reload */
-    res = (ms * US_PER_MS) +
-        (SYSTICK_RELOAD_VAL + 1 - cycle_cnt) / CYCLES_PER_MICROSECOND;
+/**
+ * Returns time (in nanoseconds) since reset, with a resolution of one
+ * core clock cycle.
+ * @see micros()
+ */
+static inline uint64 nanos(void) {
+    return dwt_div_small(dwt_cycles64() * 1000, CYCLES_PER_MICROSECOND);
+}
 
-    return res;
+/**
+ * Delay for exactly the given number of core clock cycles, plus any
+ * time spent in interrupts.
+ * @see delayMicroseconds()
+ */
+static inline void delayCycles(uint32 cycles) {
+    dwt_delay_cycles(cycles);
 }
 
 /**
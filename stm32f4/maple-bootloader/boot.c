@@ -0,0 +1,56 @@
+/* *****************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ****************************************************************************/
+
+/**
+ *  @file boot.c
+ *
+ *  @brief startup trace and dfu request handoff, see boot.h
+ *
+ */
+
+#include "common.h"
+#include "boot.h"
+
+bool bootTakeDfuRequest(void) {
+  bool requested = bootHandoff->magic == BOOT_HANDOFF_MAGIC &&
+                   bootHandoff->dfuRequest == BOOT_DFU_REQUEST;
+
+  bootHandoff->magic = BOOT_HANDOFF_MAGIC;
+  bootHandoff->dfuRequest = 0;
+  bootHandoff->count = 0;
+
+  cycleCounterEnable();
+  return requested;
+}
+
+void bootMark(u32 tag) {
+  u32 cycles = cycleCount();
+  u32 n = bootHandoff->count;
+
+  if (n < BOOT_TRACE_MAX) {
+    bootHandoff->stamp[n].tag = tag;
+    bootHandoff->stamp[n].cycles = cycles;
+    bootHandoff->count = n + 1;
+  }
+}
@@ -0,0 +1,66 @@
+/* *****************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ****************************************************************************/
+
+/**
+ *  @file boot.h
+ *
+ *  @brief RAM block handed to the user program: startup timestamps
+ *  from the DWT cycle counter, and the program's request to stay in
+ *  DFU mode after a reset. Layout must match libmaple's boot_trace.h.
+ *
+ *  The block lives at the start of RAM, which the linker scripts keep
+ *  free for it, and is not touched by the program's startup code.
+ *
+ */
+
+#ifndef __BOOT_H
+#define __BOOT_H
+
+#include "stm32f10x_type.h"
+
+#define BOOT_HANDOFF_ADDR  ((u32)0x20000000)
+#define BOOT_HANDOFF_MAGIC 0xB0071ACE
+#define BOOT_DFU_REQUEST   0x1EAF1EAF
+#define BOOT_TRACE_MAX     15
+
+#define BOOT_TAG(a,b,c,d) ((u32)(a) | ((u32)(b) << 8) | ((u32)(c) << 16) | ((u32)(d) << 24))
+
+typedef struct _BootStamp {
+  u32 tag;
+  u32 cycles;
+} BootStamp;
+
+typedef struct _BootHandoff {
+  u32 magic;
+  u32 dfuRequest;
+  u32 count;
+  BootStamp stamp[BOOT_TRACE_MAX];
+} BootHandoff;
+
+#define bootHandoff ((volatile BootHandoff*)BOOT_HANDOFF_ADDR)
+
+bool bootTakeDfuRequest(void);  /* also starts a fresh trace */
+void bootMark(u32 tag);
+
+#endif
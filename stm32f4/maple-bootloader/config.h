@@ -61,6 +61,7 @@
 #ifdef BOARD_aeroquad32
 	#define FLASH_PAGE_SIZE  0x800 /* 2KB pages for high density devices */
 	#define USER_CODE_FLASH  ((u32)0x08010000)   /* ala42 */
+	#define USER_CODE_FLASH_END ((u32)0x08080000) /* 512KB */
 
 	// LED is PE5
 	#define LED_BANK         GPIOE
@@ -99,6 +100,7 @@
 #ifdef BOARD_DiscoveryF4
 	#define FLASH_PAGE_SIZE  0x800 /* 2KB pages for high density devices */
 	#define USER_CODE_FLASH  ((u32)0x08010000)   /* ala42 */
+	#define USER_CODE_FLASH_END ((u32)0x08080000) /* 512KB */
 
 	// LED is PD13
 	#define LED_BANK         GPIOD
@@ -118,6 +120,14 @@
 	//#define BUT_CR_INPUTMODE    0x00000008 // input pull up/down, output pin has to be set for pull up, cleared for pull down
 	#define RCC_AHB1ENR_BUT  0x00000001 /* F2 enable PA */
 	//#define BUTTON_SETUP     resetPin
+
+	/* RAM the bootloader's linker script leaves alone (CCM and the
+	   SRAM above 64K), holds the unchanged head of a sector across
+	   its erase when a download skips unchanged sectors */
+	#define SKIP_STAGE0      ((u32)0x10000000)
+	#define SKIP_STAGE0_SIZE 0x10000
+	#define SKIP_STAGE1      ((u32)0x20010000)
+	#define SKIP_STAGE1_SIZE 0x10000
 #endif
 
 
@@ -126,6 +136,7 @@
 #ifdef BOARD_aeroquad32mini
 	#define FLASH_PAGE_SIZE  0x400 /* 1KB pages for medium density devices */
 	#define USER_CODE_FLASH  ((u32)0x08005000)  /* ala42 */
+	#define USER_CODE_FLASH_END ((u32)0x08020000) /* 128KB */
 	// LED is PA3
 	#define LED_BANK         GPIOA
 	#define LED              3
@@ -157,6 +168,11 @@
 #endif
 
 #define STARTUP_BLINKS   5
+
+/* start a valid user program right away, without the startup blinks
+   and BOOTLOADER_WAIT, unless the button is held or the program asked
+   for DFU mode before resetting (libmaple's boot_request_dfu()) */
+#define FAST_BOOT
 //#define BOOTLOADER_WAIT  10 // ala42: was 6
 #define BOOTLOADER_WAIT  3 // ala42: was 6
 
@@ -33,6 +33,7 @@
 
 #include "dfu.h"
 #include "usb.h"
+#include "patch.h"
 
 /* DFU globals */
 volatile u32 userAppAddr = USER_CODE_RAM; /* default RAM user code location */
@@ -40,12 +41,46 @@ volatile DFUStatus dfuAppStatus;       /* includes state */
 volatile bool userFlash = FALSE;
 volatile bool dfuBusy = FALSE;
 
-volatile u8 recvBuffer[wTransferSize];
+/* two receive buffers, so the host can send the next block while
+   the main loop programs the previous one into flash */
+volatile u8 recvBuffer[2][wTransferSize] __attribute__((aligned(4)));
+volatile u8 recvIndex = 0;          /* buffer the next DNLOAD lands in */
 volatile u32 userFirmwareLen = 0;
 volatile u16 thisBlockLen = 0;
 
+/* block handed from the usb isr to the main loop */
+volatile u8 *progBuffer;
+volatile u32 progAddr;
+volatile u16 progLen;
+volatile u32 flashErasedEnd;        /* first address past the erased (or skipped) area */
+volatile u8 flashStatus = OK;
 
 volatile PLOT code_copy_lock;
+volatile DFUFlashStats dfuFlashStats;
+
+/* a flash download is either a plain image or a patch stream (see
+   patch.h), decided by the first block */
+#define DFU_IMAGE_UNKNOWN 0
+#define DFU_IMAGE_RAW     1
+#define DFU_IMAGE_PATCH   2
+volatile u8 dfuImageKind;
+volatile bool dfuImageFinished;
+
+static bool dfuPatchProgram(u32 addr, const u8 *data, u32 len);
+static u32 dfuPatchErase(u32 addr);
+
+static const PatchTarget dfuPatchTarget = {
+  USER_CODE_FLASH,
+  (const u8*)USER_CODE_FLASH,
+  USER_CODE_FLASH_END - USER_CODE_FLASH,
+  dfuPatchErase,
+  flashUnitEnd,
+  dfuPatchProgram,
+  crcCompute
+};
+static PatchState dfuPatch;
+
+volatile bool dfuSkipOpen;          /* unit at flashErasedEnd matches so far */
 
 /* todo: force dfu globals to be singleton to avoid re-inits? */
 void dfuInit(void) {
@@ -57,12 +92,32 @@ void dfuInit(void) {
   dfuAppStatus.iString = 0x00;          /* all strings must be 0x00 until we make them! */
   userFirmwareLen = 0;
   thisBlockLen = 0;;
+  recvIndex = 0;
+  progLen = 0;
+  flashStatus = OK;
   userAppAddr = USER_CODE_RAM; /* default RAM user code location */
   userFlash = FALSE;
   code_copy_lock = WAIT;
   dfuBusy=FALSE;
 }
 
+/* the main loop is free to take another block */
+static bool dfuCopySlotFree(void) {
+  return code_copy_lock == WAIT || code_copy_lock == END;
+}
+
+/* hand the block just received to the main loop and flip buffers */
+static void dfuQueueBlock(void) {
+  progBuffer = recvBuffer[recvIndex];
+  progAddr = USER_CODE_FLASH + userFirmwareLen;
+  progLen = thisBlockLen;
+  userFirmwareLen += thisBlockLen;
+  dfuFlashStats.bytes += thisBlockLen;
+  thisBlockLen = 0;
+  recvIndex ^= 1;
+  code_copy_lock = BEGINNING;
+}
+
 bool dfuUpdateByRequest(void) {
   /* were using the global pInformation struct from usb_lib here,
      see comment in maple_dfu.h around DFUEvent struct */
@@ -84,11 +139,23 @@ bool dfuUpdateByRequest(void) {
         if (pInformation->Current_AlternateSetting == 1) {
           userAppAddr = USER_CODE_FLASH;
           userFlash = TRUE;
+          flashErasedEnd = USER_CODE_FLASH;
+          dfuImageKind = DFU_IMAGE_UNKNOWN;
+          dfuImageFinished = FALSE;
 
           /* make sure the flash is setup properly, unlock it */
           setupFLASH();
           flashUnlock();
 
+          cycleCounterEnable();
+          dfuFlashStats.bytes = 0;
+          dfuFlashStats.erases = 0;
+          dfuFlashStats.eraseCycles = 0;
+          dfuFlashStats.programCycles = 0;
+          dfuFlashStats.totalCycles = 0;
+          dfuFlashStats.skipped = 0;
+          dfuSkipOpen = FALSE;
+
         } else {
           userAppAddr = USER_CODE_RAM;
           userFlash = FALSE;
@@ -115,24 +182,24 @@ bool dfuUpdateByRequest(void) {
     /* device received block, waiting for DFU_GETSTATUS request */
 
     if (pInformation->USBbRequest == DFU_GETSTATUS) {
-      /* todo, add routine to wait for last block write to finish */
       if (userFlash) {
-        if (code_copy_lock==WAIT) {
-          code_copy_lock=BEGINNING;
-          dfuAppStatus.bwPollTimeout0 = 0xFF; /* is this enough? */
-          dfuAppStatus.bwPollTimeout1 = 0x01; /* is this enough? */
-          dfuAppStatus.bState=dfuDNBUSY;
-
-        } else if (code_copy_lock==BEGINNING) {
-          dfuAppStatus.bState=dfuDNLOAD_SYNC;
-
-        } else if (code_copy_lock==MIDDLE) {
-          dfuAppStatus.bState=dfuDNLOAD_SYNC;
-
-        } else if (code_copy_lock==END) {
+        if (flashStatus != OK) {
+          dfuAppStatus.bState  = dfuERROR;
+          dfuAppStatus.bStatus = flashStatus;
+
+        } else if (dfuCopySlotFree()) {
+          /* accept the next block right away, it is programmed
+             while the host sends the one after it */
+          dfuQueueBlock();
           dfuAppStatus.bwPollTimeout0 = 0x00;
-          code_copy_lock=WAIT;
+          dfuAppStatus.bwPollTimeout1 = 0x00;
           dfuAppStatus.bState=dfuDNLOAD_IDLE;
+
+        } else {
+          /* previous block still programming, host retries later */
+          dfuAppStatus.bwPollTimeout0 = DFU_BUSY_POLL_MS;
+          dfuAppStatus.bwPollTimeout1 = 0x00;
+          dfuAppStatus.bState=dfuDNBUSY;
         }
 
       } else {
@@ -148,10 +215,13 @@ bool dfuUpdateByRequest(void) {
     }
 
   } else if (startState == dfuDNBUSY)              {
-    /* if were actually done writing, goto sync, else stay busy */
-    if (code_copy_lock == END) {
+    /* once the previous block is written, queue this one */
+    if (flashStatus != OK) {
+      dfuAppStatus.bState  = dfuERROR;
+      dfuAppStatus.bStatus = flashStatus;
+    } else if (dfuCopySlotFree()) {
+      dfuQueueBlock();
       dfuAppStatus.bwPollTimeout0 = 0x00;
-      code_copy_lock=WAIT;
       dfuAppStatus.bState = dfuDNLOAD_IDLE;
     } else {
       dfuAppStatus.bState= dfuDNBUSY;
@@ -164,10 +234,8 @@ bool dfuUpdateByRequest(void) {
         dfuAppStatus.bState  = dfuDNLOAD_SYNC;
       } else {
         /* todo, support "disagreement" if device expects more data than this */
+        /* the flash is relocked once the last block is written */
         dfuAppStatus.bState  = dfuMANIFEST_SYNC;
-
-        /* relock the flash */
-        flashLock();
       }
     } else if (pInformation->USBbRequest == DFU_ABORT) {
       dfuAppStatus.bState  = dfuIDLE;
@@ -184,8 +252,30 @@ bool dfuUpdateByRequest(void) {
     /* device has received last block, waiting DFU_GETSTATUS request */
 
     if (pInformation->USBbRequest == DFU_GETSTATUS) {
-      dfuAppStatus.bState  = dfuMANIFEST_WAIT_RESET;
-      dfuAppStatus.bStatus = OK;
+      if (userFlash && !dfuCopySlotFree()) {
+        /* still draining the pipeline */
+        dfuAppStatus.bwPollTimeout0 = DFU_BUSY_POLL_MS;
+        dfuAppStatus.bState  = dfuMANIFEST_SYNC;
+      } else if (userFlash && flashStatus == OK && !dfuImageFinished) {
+        /* an empty block tells the main loop to finish (and for a
+           patch, crc check) the image */
+        progLen = 0;
+        code_copy_lock = BEGINNING;
+        dfuAppStatus.bwPollTimeout0 = DFU_BUSY_POLL_MS;
+        dfuAppStatus.bState  = dfuMANIFEST_SYNC;
+      } else if (userFlash && flashStatus != OK) {
+        flashLock();
+        dfuAppStatus.bState  = dfuERROR;
+        dfuAppStatus.bStatus = flashStatus;
+      } else {
+        if (userFlash) {
+          flashLock();
+          dfuFlashStats.totalCycles = cycleCount();
+        }
+        dfuAppStatus.bwPollTimeout0 = 0x00;
+        dfuAppStatus.bState  = dfuMANIFEST_WAIT_RESET;
+        dfuAppStatus.bStatus = OK;
+      }
     } else if (pInformation->USBbRequest == DFU_GETSTATE) {
       dfuAppStatus.bState  = dfuMANIFEST_SYNC;
     } else {
@@ -308,7 +398,7 @@ vu8* dfuCopyDNLOAD(u16 length) {
     thisBlockLen = pInformation->USBwLengths.w;
     return NULL;
   } else {
-    return ((vu8*)recvBuffer + pInformation->Ctrl_Info.Usb_wOffset);
+    return ((vu8*)recvBuffer[recvIndex] + pInformation->Ctrl_Info.Usb_wOffset);
   }
 }
 
@@ -317,30 +407,195 @@ vu8* dfuCopyUPLOAD(u16 length) {
   return NULL;
 }
 
+/* erase every page/sector up to (not including) end */
+static bool dfuEraseUpTo(u32 end) {
+  while (flashErasedEnd < end) {
+    u32 start = cycleCount();
+    u32 next = flashEraseContaining(flashErasedEnd);
+    dfuFlashStats.eraseCycles += cycleCount() - start;
+    if (!next) {
+      return FALSE;
+    }
+    dfuFlashStats.erases++;
+    flashErasedEnd = next;
+  }
+  return TRUE;
+}
+
+/* copy len bytes of flash at addr to the stage, or back when toFlash */
+static bool dfuStageCopy(u32 addr, u32 len, bool toFlash) {
+  u32 stage = SKIP_STAGE0;
+  u32 room = SKIP_STAGE0_SIZE;
+  bool second = FALSE;
+
+  while (len > 0) {
+    if (room == 0) {
+      if (second) {
+        return FALSE;
+      }
+      second = TRUE;
+      stage = SKIP_STAGE1;
+      room = SKIP_STAGE1_SIZE;
+      continue;
+    }
+    u32 n = len < room ? len : room;
+    if (toFlash) {
+      if (!flashWriteBlock(addr, (const u32*)stage, n / 4)) {
+        return FALSE;
+      }
+    } else {
+      u32 i;
+      for (i = 0; i < n; i += 4) {
+        *(u32*)(stage + i) = *(const u32*)(addr + i);
+      }
+    }
+    addr += n;
+    stage += n;
+    room -= n;
+    len -= n;
+  }
+  return TRUE;
+}
+
+/* Program a queued block. A page/sector not erased yet is compared
+   block by block with the new data and only erased at the first
+   difference, its matching head is staged in RAM and put back. A unit
+   that matches to its end is not touched at all. */
+static void dfuProgramBlock(u32 addr, const u8 *data, u32 len) {
+  u32 end = addr + ((len + 3) & ~3);
+
+  while (addr < end) {
+    u32 unitEnd = flashUnitEnd(addr);
+    u32 sliceEnd = end < unitEnd ? end : unitEnd;
+    u32 n = sliceEnd - addr;
+
+    if (DFU_SKIP_UNCHANGED && addr >= flashErasedEnd) {
+      u32 unitStart = flashErasedEnd;
+      u32 head = addr - unitStart;
+
+      if (crcCompute(data, n) == crcCompute((const u8*)addr, n)) {
+        if (sliceEnd == unitEnd) {
+          dfuFlashStats.skipped++;
+          flashErasedEnd = unitEnd;
+          dfuSkipOpen = FALSE;
+          addr += n;
+          data += n;
+          continue;
+        } else if (sliceEnd - unitStart <= DFU_STAGE_SIZE) {
+          /* a later difference can still restore everything so far */
+          dfuSkipOpen = TRUE;
+          addr += n;
+          data += n;
+          continue;
+        }
+      }
+
+      dfuSkipOpen = FALSE;
+      if (!dfuStageCopy(unitStart, head, FALSE) || !dfuEraseUpTo(sliceEnd)) {
+        flashStatus = errERASE;
+        return;
+      }
+      if (!dfuStageCopy(unitStart, head, TRUE)) {
+        flashStatus = errPROG;
+        return;
+      }
+    } else if (!dfuEraseUpTo(sliceEnd)) {
+      flashStatus = errERASE;
+      return;
+    }
+
+    u32 start = cycleCount();
+    if (!flashWriteBlock(addr, (const u32*)data, n / 4)) {
+      flashStatus = errPROG;
+    }
+    dfuFlashStats.programCycles += cycleCount() - start;
+    if (flashStatus != OK) {
+      return;
+    }
+    addr += n;
+    data += n;
+  }
+}
+
+/* Erase ahead of the data: as soon as the host announces the next
+   block (wLength of its DNLOAD), erase whatever it will land on. */
+static void dfuEraseAhead(void) {
+  /* read in this order: if the isr queues the block in between,
+     announced reads back as 0 and nothing is erased early */
+  u32 base = userFirmwareLen;
+  u16 announced = thisBlockLen;
+
+  /* a patch erases as it decodes, the input length says nothing */
+  if (dfuImageKind != DFU_IMAGE_RAW) {
+    return;
+  }
+
+  if (announced && flashStatus == OK &&
+      !dfuEraseUpTo(USER_CODE_FLASH + base + announced)) {
+    flashStatus = errERASE;
+  }
+}
+
 void dfuCopyBufferToExec() {
   int i;
   u32* userSpace;
 
-    if (!userFlash) {
+  if (!userFlash) {
+    volatile u8 *buf = recvBuffer[recvIndex];
     userSpace = (u32*)(USER_CODE_RAM+userFirmwareLen);
     /* we dont need to handle when thisBlock len is not divisible by 4,
        since the linker will align everything to 4B anyway */
     for (i=0;i<thisBlockLen;i=i+4) {
-      *userSpace++ = *(u32*)(recvBuffer+i);
+      *userSpace++ = *(u32*)(buf+i);
     }
+    userFirmwareLen += thisBlockLen;
+    thisBlockLen = 0;
   } else {
-    userSpace = (u32*)(USER_CODE_FLASH+userFirmwareLen);
+    if (dfuImageKind == DFU_IMAGE_UNKNOWN) {
+      if (progLen && patchIsPatch((const u8*)progBuffer, progLen)) {
+        dfuImageKind = DFU_IMAGE_PATCH;
+        patchBegin(&dfuPatch, &dfuPatchTarget);
+      } else {
+        dfuImageKind = DFU_IMAGE_RAW;
+      }
+    }
 
-    flashErasePage((u32)(userSpace));
+    if (progLen == 0) {
+      /* end of download, queued from dfuMANIFEST_SYNC */
+      if (dfuImageKind == DFU_IMAGE_PATCH) {
+        flashStatus = patchFinish(&dfuPatch);
+      } else if (dfuSkipOpen) {
+        /* the image ended inside a unit that matched throughout */
+        dfuFlashStats.skipped++;
+        dfuSkipOpen = FALSE;
+      }
+      dfuImageFinished = TRUE;
+      return;
+    }
 
-    for (i=0;i<thisBlockLen;i=i+4) {
-      flashWriteWord(userSpace++,*(u32*)(recvBuffer+i));
+    if (dfuImageKind == DFU_IMAGE_PATCH) {
+      flashStatus = patchFeed(&dfuPatch, (const u8*)progBuffer, progLen);
+      return;
     }
 
+    /* program the block queued by dfuQueueBlock() */
+    dfuProgramBlock(progAddr, (const u8*)progBuffer, progLen);
   }
-  userFirmwareLen += thisBlockLen;
+}
 
-  thisBlockLen = 0;
+static u32 dfuPatchErase(u32 addr) {
+  u32 start = cycleCount();
+  u32 end = flashEraseContaining(addr);
+  dfuFlashStats.eraseCycles += cycleCount() - start;
+  dfuFlashStats.erases++;
+  return end;
+}
+
+static bool dfuPatchProgram(u32 addr, const u8 *data, u32 len) {
+  u32 start = cycleCount();
+  bool ok = flashWriteBlock(addr, (const u32*)data, len / 4);
+  dfuFlashStats.programCycles += cycleCount() - start;
+  return ok;
 }
 
 u8 dfuGetState(void) {
@@ -360,10 +615,12 @@ void dfuFinishUpload() {
     if (userFlash) {
       if (code_copy_lock == BEGINNING) {
         code_copy_lock=MIDDLE;
-        strobePin(LED_BANK,LED,2,0x1000);
+        setPin(LED_BANK,LED);
         dfuCopyBufferToExec();
-        strobePin(LED_BANK,LED,2,0x500);
+        resetPin(LED_BANK,LED);
         code_copy_lock = END;
+      } else if (!DFU_SKIP_UNCHANGED) {
+        dfuEraseAhead();
       }
     }
     /* otherwise do nothing, dfu state machine resets itself */
@@ -47,6 +47,40 @@ typedef enum _PLOT {
   WAIT
 }PLOT;
 
+/* flash timing, in DWT cycles, for the last download to flash;
+   inspect with the debugger (or openocd mdw) after a transfer */
+typedef struct _DFUFlashStats {
+  u32 bytes;
+  u32 erases;
+  u32 eraseCycles;
+  u32 programCycles;
+  u32 totalCycles;     /* first DNLOAD until the pipeline drained */
+  u32 skipped;         /* pages/sectors left alone, already up to date */
+} DFUFlashStats;
+
+/* bwPollTimeout the host waits while the previous block programs */
+#define DFU_BUSY_POLL_MS 0x0A
+
+/* where the matching head of a sector waits while the sector is
+   erased, set per board in config.h */
+#ifndef SKIP_STAGE0
+#define SKIP_STAGE0      0
+#define SKIP_STAGE0_SIZE 0
+#endif
+#ifndef SKIP_STAGE1
+#define SKIP_STAGE1      0
+#define SKIP_STAGE1_SIZE 0
+#endif
+#define DFU_STAGE_SIZE   (SKIP_STAGE0_SIZE + SKIP_STAGE1_SIZE)
+
+/* compare each block with flash (hardware CRC) and leave pages/sectors
+   that do not change alone; replaces erase-ahead when enabled.  Without
+   staging RAM a unit is only skipped when a block ends on its boundary,
+   which is rarely worth losing erase-ahead for. */
+#ifndef DFU_SKIP_UNCHANGED
+#define DFU_SKIP_UNCHANGED (DFU_STAGE_SIZE != 0)
+#endif
+
 
 /*** DFU bRequest Values ******/
 /* bmRequestType, wValue,    wIndex,    wLength, Data */
@@ -94,6 +128,7 @@ typedef enum _PLOT {
 
 
 extern volatile bool dfuBusy;
+extern volatile DFUFlashStats dfuFlashStats;
 
 /* exposed functions */
 void dfuInit(void);  /* singleton dfu initializer */
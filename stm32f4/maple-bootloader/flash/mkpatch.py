@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+#
+# Build compressed or differential firmware images for the maple
+# bootloader's patch decoder (see patch.h for the stream layout).
+#
+#   mkpatch.py [--base installed.bin] [--layout f4|page:N] new.bin out.patch
+#   mkpatch.py --selftest path/to/patchsim
+#
+# Without --base the whole image is sent LZ4 compressed.  With --base,
+# erase units that are identical in both images are sent as KEEP records
+# and are neither erased nor reprogrammed on the board.
+
+import argparse
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+
+PATCH_MAGIC = 0x5441504D
+PATCH_VERSION = 1
+OP_END, OP_KEEP, OP_RAW, OP_LZ4 = 0, 1, 2, 3
+
+ORIGIN = 0x08010000          # USER_CODE_FLASH on the F4 boards
+FLASH_END = 0x08100000
+
+
+def stm32_crc(data):
+    """CRC-32 as computed by the STM32 CRC unit over 32-bit words."""
+    crc = 0xFFFFFFFF
+    for (word,) in struct.iter_unpack("<I", data):
+        crc ^= word
+        for _ in range(32):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else crc << 1
+            crc &= 0xFFFFFFFF
+    return crc
+
+
+def pad4(data):
+    return data + b"\xff" * (-len(data) % 4)
+
+
+def erase_units(layout, length):
+    """Yield (start, end) image offsets of the erase units covering length."""
+    addr = ORIGIN
+    while addr - ORIGIN < length:
+        if layout.startswith("page:"):
+            size = int(layout[5:], 0)
+        elif addr < 0x08010000:
+            size = 0x4000
+        elif addr < 0x08020000:
+            size = 0x10000
+        else:
+            size = 0x20000
+        start = addr - ORIGIN
+        yield start, min(start + size, length)
+        addr += size
+
+
+def lz4_block(data, start, end):
+    """Greedy LZ4 block compressor for data[start:end].
+
+    Matches may reach back before start (up to 64 KB), the decoder
+    reads them from flash that has already been written."""
+    out = bytearray()
+    table = {}
+    for i in range(max(0, start - 65535), start - 3):
+        table[data[i:i + 4]] = i
+
+    def emit(lits, offset=0, mlen=0):
+        ln = len(lits)
+        ml = mlen - 4 if mlen else 0
+        out.append((min(ln, 15) << 4) | min(ml, 15))
+        if ln >= 15:
+            ln -= 15
+            while ln >= 255:
+                out.append(255)
+                ln -= 255
+            out.append(ln)
+        out.extend(lits)
+        if mlen:
+            out.extend(struct.pack("<H", offset))
+            if ml >= 15:
+                ml -= 15
+                while ml >= 255:
+                    out.append(255)
+                    ml -= 255
+                out.append(ml)
+
+    anchor = i = start
+    limit = end - 12            # LZ4: last match starts 12 bytes from the end
+    while i < limit:
+        key = data[i:i + 4]
+        cand = table.get(key)
+        table[key] = i
+        if cand is None or i - cand > 65535:
+            i += 1
+            continue
+        mlen = 4
+        while i + mlen < end - 5 and data[cand + mlen] == data[i + mlen]:
+            mlen += 1
+        emit(data[anchor:i], i - cand, mlen)
+        i += mlen
+        anchor = i
+    emit(data[anchor:end])
+    return bytes(out)
+
+
+def make_patch(new, base=None, layout="f4"):
+    new = pad4(new)
+    base = pad4(base) if base else b""
+    records = []
+    for start, end in erase_units(layout, len(new)):
+        if end <= len(base) and base[start:end] == new[start:end]:
+            if records and records[-1][0] == OP_KEEP:
+                records[-1] = (OP_KEEP, records[-1][1] + end - start, b"")
+            else:
+                records.append((OP_KEEP, end - start, b""))
+            continue
+        comp = lz4_block(new, start, end)
+        if len(comp) + 4 < end - start:
+            records.append((OP_LZ4, end - start,
+                            struct.pack("<I", len(comp)) + comp))
+        else:
+            records.append((OP_RAW, end - start, new[start:end]))
+
+    out = bytearray(struct.pack("<6I", PATCH_MAGIC, PATCH_VERSION, len(new),
+                                stm32_crc(new), len(base),
+                                stm32_crc(base) if base else 0))
+    for op, length, payload in records:
+        out += struct.pack("<BI", op, length) + payload
+    out += struct.pack("<BI", OP_END, 0)
+    return bytes(out)
+
+
+def selftest(patchsim):
+    rnd = random.Random(1)
+    words = [rnd.getrandbits(32) for _ in range(64)]
+    # firmware-like: a small vocabulary of instruction words
+    base = b"".join(struct.pack("<I", rnd.choice(words))
+                    for _ in range(300 * 1024 // 4))
+    new = bytearray(base)
+    new[0x30000:0x30010] = b"config-changed!!"        # one sector differs
+    new += b"\x00\x01" * 1000                         # image grew
+    cases = [("full", None, "f4"), ("delta", base, "f4"),
+             ("delta-pages", base, "page:2048")]
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        paths = {n: os.path.join(tmp, n) for n in ("base", "patch", "out")}
+        with open(paths["base"], "wb") as f:
+            f.write(base)
+        for name, b, layout in cases:
+            patch = make_patch(bytes(new), b, layout)
+            with open(paths["patch"], "wb") as f:
+                f.write(patch)
+            args = [patchsim] + (["-p", layout[5:]] if layout != "f4" else [])
+            res = subprocess.run(args + [paths["base"], paths["patch"],
+                                         paths["out"]],
+                                 capture_output=True, text=True)
+            ok = res.returncode == 0
+            if ok:
+                with open(paths["out"], "rb") as f:
+                    ok = f.read() == pad4(bytes(new))
+            print("%-12s %7d -> %7d bytes  %s  %s" %
+                  (name, len(new), len(patch), res.stdout.strip(),
+                   "ok" if ok else "FAILED"))
+            failed += not ok
+        # a delta against the wrong base must be refused
+        with open(paths["patch"], "wb") as f:
+            f.write(make_patch(bytes(new), bytes(new)))
+        res = subprocess.run([patchsim, paths["base"], paths["patch"],
+                              paths["out"]], capture_output=True, text=True)
+        ok = res.returncode != 0
+        print("%-12s %s" % ("wrong-base", "ok" if ok else "FAILED"))
+        failed += not ok
+        # lengths past the end of the application area must be refused
+        # before anything is read or written
+        for name, field in (("big-image", 8), ("big-base", 16)):
+            patch = bytearray(make_patch(bytes(new)))
+            struct.pack_into("<I", patch, field, 0x7FFFFFFC)
+            with open(paths["patch"], "wb") as f:
+                f.write(patch)
+            res = subprocess.run([patchsim, paths["base"], paths["patch"],
+                                  paths["out"]], capture_output=True,
+                                 text=True)
+            ok = res.returncode != 0 and "status 8," in res.stdout
+            print("%-12s %s" % (name, "ok" if ok else "FAILED"))
+            failed += not ok
+    return 1 if failed else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("--base", help="image currently installed on the board")
+    ap.add_argument("--layout", default="f4",
+                    help="erase units: f4 (sector map) or page:SIZE")
+    ap.add_argument("--selftest", metavar="PATCHSIM",
+                    help="round-trip test images through host patchsim")
+    ap.add_argument("new", nargs="?")
+    ap.add_argument("out", nargs="?")
+    args = ap.parse_args()
+
+    if args.selftest:
+        return selftest(args.selftest)
+    if not args.new or not args.out:
+        ap.error("new and out images are required")
+
+    with open(args.new, "rb") as f:
+        new = f.read()
+    base = None
+    if args.base:
+        with open(args.base, "rb") as f:
+            base = f.read()
+    patch = make_patch(new, base, args.layout)
+    with open(args.out, "wb") as f:
+        f.write(patch)
+    print("%s: %d bytes -> %d bytes" % (args.out, len(new), len(patch)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -331,6 +331,95 @@ void systemHardReset(void) {
   }
 }
 
+#ifdef STM32F2
+/* F2/F4 sectors: 4 x 16KB, 1 x 64KB, then 128KB up to the end of flash */
+static u32 flashSectorOf(u32 addr, u32 *start, u32 *end) {
+  u32 offset = addr - 0x08000000;
+
+  if (offset < 0x10000) {
+    *start = 0x08000000 + (offset & ~0x3FFF);
+    *end = *start + 0x4000;
+    return offset >> 14;
+  } else if (offset < 0x20000) {
+    *start = 0x08010000;
+    *end = 0x08020000;
+    return 4;
+  } else {
+    *start = 0x08000000 + (offset & ~0x1FFFF);
+    *end = *start + 0x20000;
+    return 4 + (offset >> 17);
+  }
+}
+
+static bool flashWaitReady(void) {
+  while (GET_REG(FLASH_SR) & FLASH_SR_BSY) {}
+  return (GET_REG(FLASH_SR) & FLASH_SR_ERRORS) == 0;
+}
+
+/* the data cache keeps serving the old contents of a reprogrammed
+   location, reset it so verify and readback see what is in the array */
+static void flashFlushDataCache(void) {
+  u32 acr = GET_REG(FLASH_ACR);
+
+  if (acr & FLASH_ACR_DCEN) {
+    SET_REG(FLASH_ACR, acr & ~FLASH_ACR_DCEN);
+    SET_REG(FLASH_ACR, (acr & ~FLASH_ACR_DCEN) | FLASH_ACR_DCRST);
+    SET_REG(FLASH_ACR, acr);
+  }
+}
+
+u32 flashUnitEnd(u32 addr) {
+  u32 start, end;
+  flashSectorOf(addr, &start, &end);
+  return end;
+}
+
+u32 flashEraseContaining(u32 addr) {
+  u32 start, end;
+  u32 sector = flashSectorOf(addr, &start, &end);
+
+  flashWaitReady();
+  SET_REG(FLASH_SR, FLASH_SR_ERRORS | FLASH_SR_EOP); /* clear stale flags */
+  SET_REG(FLASH_CR, FLASH_CR_PSIZE_32 | FLASH_CR_SER | FLASH_CR_SNB(sector));
+  SET_REG(FLASH_CR, GET_REG(FLASH_CR) | FLASH_CR_STRT);
+  bool ok = flashWaitReady();
+  SET_REG(FLASH_CR, 0);
+  flashFlushDataCache();
+
+  return ok ? end : 0;
+}
+
+bool flashErasePage(u32 pageAddr) {
+  return flashEraseContaining(pageAddr) != 0;
+}
+
+bool flashWriteBlock(u32 addr, const u32 *words, u32 n) {
+  vu32 *flashAddr = (vu32*)addr;
+  u32 i;
+
+  flashWaitReady();
+  SET_REG(FLASH_SR, FLASH_SR_ERRORS | FLASH_SR_EOP);
+  /* PSIZE stays at x32 for the whole block, one bus write per word */
+  SET_REG(FLASH_CR, FLASH_CR_PSIZE_32 | FLASH_CR_PG);
+  for (i = 0; i < n; i++) {
+    flashAddr[i] = words[i];
+    while (GET_REG(FLASH_SR) & FLASH_SR_BSY) {}
+  }
+  bool ok = flashWaitReady();
+  SET_REG(FLASH_CR, 0);
+  flashFlushDataCache();
+
+  /* verify the write */
+  for (i = 0; ok && i < n; i++) {
+    ok = flashAddr[i] == words[i];
+  }
+  return ok;
+}
+
+bool flashWriteWord(u32 addr, u32 word) {
+  return flashWriteBlock(addr, &word, 1);
+}
+#else
 bool flashErasePage(u32 pageAddr) {
   u32 rwmVal = GET_REG(FLASH_CR);
   rwmVal = FLASH_CR_PER;
@@ -349,14 +438,17 @@ bool flashErasePage(u32 pageAddr) {
   return TRUE;
 }
 
-bool flashErasePages(u32 pageAddr, u16 n) {
-  while (n-->0) {
-    if (!flashErasePage(pageAddr+FLASH_PAGE_SIZE*n)) {
-      return FALSE;
-    }
-  }
+u32 flashUnitEnd(u32 addr) {
+  return (addr & ~(FLASH_PAGE_SIZE - 1)) + FLASH_PAGE_SIZE;
+}
 
-  return TRUE;
+u32 flashEraseContaining(u32 addr) {
+  u32 start = addr & ~(FLASH_PAGE_SIZE - 1);
+
+  if (!flashErasePage(start)) {
+    return 0;
+  }
+  return start + FLASH_PAGE_SIZE;
 }
 
 bool flashWriteWord(u32 addr, u32 word) {
@@ -386,11 +478,36 @@ bool flashWriteWord(u32 addr, u32 word) {
   return TRUE;
 }
 
+bool flashWriteBlock(u32 addr, const u32 *words, u32 n) {
+  while (n-- > 0) {
+    if (!flashWriteWord(addr, *words++)) {
+      return FALSE;
+    }
+    addr += 4;
+  }
+  return TRUE;
+}
+#endif
+
+bool flashErasePages(u32 pageAddr, u16 n) {
+  while (n-->0) {
+    if (!flashErasePage(pageAddr+FLASH_PAGE_SIZE*n)) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
 void flashLock() {
   /* take down the HSI oscillator? it may be in use elsewhere */
 
   /* ensure all FPEC functions disabled and lock the FPEC */
+#ifdef STM32F2
+  SET_REG(FLASH_CR,FLASH_CR_LOCK);
+#else
   SET_REG(FLASH_CR,0x00000080);
+#endif
 }
 
 void flashUnlock() {
@@ -399,6 +516,25 @@ void flashUnlock() {
   SET_REG(FLASH_KEYR,FLASH_KEY2);
 }
 
+void cycleCounterEnable(void) {
+  SET_REG(DEMCR, GET_REG(DEMCR) | DEMCR_TRCENA);
+  SET_REG(DWT_CYCCNT, 0);
+  SET_REG(DWT_CTRL, GET_REG(DWT_CTRL) | DWT_CTRL_CYCCNTENA);
+}
 
+/* CRC-32 of len bytes (a multiple of 4) on the hardware CRC unit:
+   poly 0x04C11DB7, init 0xFFFFFFFF, words fed little endian */
+u32 crcCompute(const u8 *data, u32 len) {
+  const u32 *words = (const u32*)data;
 
-
+#ifdef STM32F2
+  pRCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+#else
+  pRCC->AHBENR |= RCC_AHBENR_CRC;
+#endif
+  SET_REG(CRC_CR, CRC_CR_RESET);
+  for (len /= 4; len > 0; len--) {
+    SET_REG(CRC_DR, *words++);
+  }
+  return GET_REG(CRC_DR);
+}
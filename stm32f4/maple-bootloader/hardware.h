@@ -92,10 +92,22 @@
 #define FLASH_KEY1     0x45670123
 #define FLASH_KEY2     0xCDEF89AB
 #define FLASH_RDPRT    0x00A5
+#ifdef STM32F2
+#define FLASH_SR_EOP      0x00000001
+#define FLASH_SR_ERRORS   0x000000F0 /* PGSERR | PGPERR | PGAERR | WRPERR */
+#define FLASH_SR_BSY      0x00010000
+#define FLASH_CR_PG       0x00000001
+#define FLASH_CR_SER      0x00000002
+#define FLASH_CR_SNB(n)   ((n) << 3)
+#define FLASH_CR_PSIZE_32 0x00000200 /* x32 parallelism, needs VDD >= 2.7V */
+#define FLASH_CR_STRT     0x00010000
+#define FLASH_CR_LOCK     0x80000000
+#else
 #define FLASH_SR_BSY   0x01
 #define FLASH_CR_PER   0x02
 #define FLASH_CR_PG    0x01
 #define FLASH_CR_START 0x40
+#endif
 
 #define GPIO_CRL(port)  port
 #define GPIO_CRH(port)  (port+0x04)
@@ -121,6 +133,21 @@
 #define SCB_VTOR (SCB+0x08)
 #define STK_CTRL (STK+0x00)
 
+/* CRC unit, same address and polynomial on F1 and F2/F4 */
+#define CRC_DR     ((u32)0x40023000)
+#define CRC_CR     ((u32)0x40023008)
+#define CRC_CR_RESET 0x01
+#ifndef STM32F2
+#define RCC_AHBENR_CRC 0x00000040
+#endif
+
+/* DWT cycle counter, used to time flash and boot operations */
+#define DEMCR            (SCS+0xDFC)
+#define DEMCR_TRCENA     0x01000000
+#define DWT_CTRL         ((u32)0xE0001000)
+#define DWT_CYCCNT       ((u32)0xE0001004)
+#define DWT_CTRL_CYCCNTENA 0x01
+
 /*
 #define TIM1_APB2_ENB ((u32)0x00000800)
 #define TIM1          ((u32)0x40012C00)
@@ -494,11 +521,18 @@ bool checkUserCode (u32 usrAddr);
 void jumpToUser    (u32 usrAddr);
 
 bool flashWriteWord  (u32 addr, u32 word);
+bool flashWriteBlock (u32 addr, const u32 *words, u32 n);
 bool flashErasePage  (u32 addr);
 bool flashErasePages (u32 addr, u16 n);
+u32  flashEraseContaining(u32 addr);
+u32  flashUnitEnd    (u32 addr);
 void flashLock       (void);
 void flashUnlock     (void);
 void nvicInit        (NVIC_InitTypeDef*);
 void nvicDisableInterrupts(void);
 
+void cycleCounterEnable(void);
+#define cycleCount() GET_REG(DWT_CYCCNT)
+u32  crcCompute      (const u8 *data, u32 len);
+
 #endif
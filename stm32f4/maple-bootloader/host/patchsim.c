@@ -0,0 +1,214 @@
+/* *****************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ****************************************************************************/
+
+/**
+ *  @file patchsim.c
+ *
+ *  @brief runs the bootloader's patch decoder on the host against image
+ *  files. Flash is simulated in memory with NOR semantics (erase sets
+ *  0xFF, programming can only clear bits) and the CRC unit in software.
+ *
+ *    patchsim [-f4 | -p pagesize] base.bin patch.bin out.bin
+ *
+ *  base.bin is the installed image ("-" for an empty flash), out.bin
+ *  receives the resulting image. Exits non-zero on any patch error.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "patch.h"
+
+#define SIM_ORIGIN    0x08010000  /* USER_CODE_FLASH on the F4 boards */
+#define SIM_FLASH_END 0x08100000
+#define SIM_SIZE      (SIM_FLASH_END - SIM_ORIGIN)
+#define SIM_BLOCK     2048        /* DFU wTransferSize */
+
+static u8 simFlash[SIM_SIZE];
+static u32 simPage;               /* 0 selects the F4 sector map */
+static u32 simErases, simProgrammed;
+
+static u32 simUnitEnd(u32 addr) {
+  if (simPage) {
+    return (addr - SIM_ORIGIN) / simPage * simPage + simPage + SIM_ORIGIN;
+  }
+  if (addr < 0x08010000) {
+    return (addr & ~0x3FFF) + 0x4000;
+  } else if (addr < 0x08020000) {
+    return 0x08020000;
+  }
+  return (addr & ~0x1FFFF) + 0x20000;
+}
+
+static u32 simEraseUnit(u32 addr) {
+  u32 end = simUnitEnd(addr);
+  u32 start;
+
+  if (simPage) {
+    start = end - simPage;
+  } else if (end <= 0x08010000) {
+    start = end - 0x4000;
+  } else if (end == 0x08020000) {
+    start = 0x08010000;
+  } else {
+    start = end - 0x20000;
+  }
+  if (start < SIM_ORIGIN || end > SIM_FLASH_END) {
+    return 0;
+  }
+  memset(simFlash + (start - SIM_ORIGIN), 0xFF, end - start);
+  simErases++;
+  return end;
+}
+
+static bool simProgram(u32 addr, const u8 *data, u32 len) {
+  u8 *p = simFlash + (addr - SIM_ORIGIN);
+  u32 i;
+
+  if (addr < SIM_ORIGIN || addr + len > SIM_FLASH_END || (addr & 3)) {
+    return FALSE;
+  }
+  for (i = 0; i < len; i++) {
+    if ((p[i] & data[i]) != data[i]) {
+      fprintf(stderr, "patchsim: programming unerased byte at 0x%08x\n",
+              (unsigned)(addr + i));
+      return FALSE;
+    }
+    p[i] = data[i];
+  }
+  simProgrammed += len;
+  return TRUE;
+}
+
+/* software model of the STM32 CRC unit */
+static u32 simCrc(const u8 *data, u32 len) {
+  u32 crc = 0xFFFFFFFF;
+  u32 i, bit;
+
+  for (i = 0; i < len; i += 4) {
+    crc ^= (u32)data[i] | ((u32)data[i+1] << 8) |
+           ((u32)data[i+2] << 16) | ((u32)data[i+3] << 24);
+    for (bit = 0; bit < 32; bit++) {
+      crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+static u8 *readFile(const char *name, u32 *len) {
+  FILE *f = fopen(name, "rb");
+  u8 *data;
+  long size;
+
+  if (!f) {
+    perror(name);
+    exit(2);
+  }
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  data = malloc(size ? size : 1);
+  if (fread(data, 1, size, f) != (size_t)size) {
+    perror(name);
+    exit(2);
+  }
+  fclose(f);
+  *len = (u32)size;
+  return data;
+}
+
+int main(int argc, char **argv) {
+  static PatchState st;
+  PatchTarget tgt;
+  u8 *patch;
+  u32 patchLen, off;
+  u8 status;
+  FILE *out;
+  int arg = 1;
+
+  if (arg < argc && !strcmp(argv[arg], "-f4")) {
+    arg++;
+  } else if (arg + 1 < argc && !strcmp(argv[arg], "-p")) {
+    simPage = strtoul(argv[arg + 1], NULL, 0);
+    arg += 2;
+  }
+  if (argc - arg != 3) {
+    fprintf(stderr, "usage: patchsim [-f4 | -p pagesize] base.bin patch.bin out.bin\n");
+    return 2;
+  }
+
+  memset(simFlash, 0xFF, sizeof(simFlash));
+  if (strcmp(argv[arg], "-")) {
+    u32 baseLen;
+    u8 *base = readFile(argv[arg], &baseLen);
+    if (baseLen > SIM_SIZE) {
+      fprintf(stderr, "patchsim: base image too large\n");
+      return 2;
+    }
+    memcpy(simFlash, base, baseLen);
+    free(base);
+  }
+  patch = readFile(argv[arg + 1], &patchLen);
+
+  tgt.origin = SIM_ORIGIN;
+  tgt.mem = simFlash;
+  tgt.size = SIM_SIZE;
+  tgt.eraseUnit = simEraseUnit;
+  tgt.unitEnd = simUnitEnd;
+  tgt.program = simProgram;
+  tgt.crc = simCrc;
+
+  if (!patchIsPatch(patch, patchLen)) {
+    fprintf(stderr, "patchsim: not a patch stream\n");
+    return 1;
+  }
+
+  /* feed it the way DFU hands over blocks */
+  patchBegin(&st, &tgt);
+  status = PATCH_OK;
+  for (off = 0; off < patchLen && status == PATCH_OK; off += SIM_BLOCK) {
+    u32 n = patchLen - off < SIM_BLOCK ? patchLen - off : SIM_BLOCK;
+    status = patchFeed(&st, patch + off, n);
+  }
+  if (status == PATCH_OK) {
+    status = patchFinish(&st);
+  }
+  printf("patchsim: status %u, %u bytes in, %u erases, %u bytes programmed\n",
+         status, (unsigned)patchLen, (unsigned)simErases,
+         (unsigned)simProgrammed);
+  if (status != PATCH_OK) {
+    return 1;
+  }
+
+  out = fopen(argv[arg + 2], "wb");
+  if (!out || fwrite(simFlash, 1, st.imageLen, out) != st.imageLen) {
+    perror(argv[arg + 2]);
+    return 2;
+  }
+  fclose(out);
+  free(patch);
+  return 0;
+}
@@ -33,19 +33,17 @@
 
 #include "common.h"
 #include "dfu.h"
+#include "boot.h"
 
 
 int main() {
+  bool dfuRequested = bootTakeDfuRequest();
+
   systemReset(); // peripherals but not PC
   setupCLK();
+  bootMark(BOOT_TAG('c','l','k',' '));
   setupLED();
   setupBUTTON();
-#ifndef STM32F2
-  setupUSB();
-  setupFLASH();
-#endif
-
-  strobePin(LED_BANK,LED,STARTUP_BLINKS,BLINK_FAST);
 
 	bool buttonStatusHigh = TRUE;
 	bool buttonStatusLow  = FALSE;
@@ -55,6 +53,21 @@ int main() {
 		buttonStatusHigh = buttonStatusHigh && pinState;
 		buttonStatusLow  = buttonStatusLow || pinState;
 	}
+  bootMark(BOOT_TAG('b','t','n',' '));
+
+#ifdef FAST_BOOT
+  if (!dfuRequested && !buttonStatusHigh && checkUserCode(USER_CODE_FLASH)) {
+    bootMark(BOOT_TAG('j','u','m','p'));
+    jumpToUser(USER_CODE_FLASH);
+  }
+#endif
+
+#ifndef STM32F2
+  setupUSB();
+  setupFLASH();
+#endif
+
+  strobePin(LED_BANK,LED,STARTUP_BLINKS,BLINK_FAST);
 
   /* wait for host to upload program or halt bootloader */
   bool no_user_jump = (!checkUserCode(USER_CODE_FLASH) && !checkUserCode(USER_CODE_RAM))
@@ -73,6 +86,7 @@ int main() {
 #endif
   }
 
+  bootMark(BOOT_TAG('j','u','m','p'));
   if (checkUserCode(USER_CODE_RAM)) {
     jumpToUser(USER_CODE_RAM);
   } else if (checkUserCode(USER_CODE_FLASH)) {
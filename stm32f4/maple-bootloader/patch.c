@@ -0,0 +1,364 @@
+/* *****************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ****************************************************************************/
+
+/**
+ *  @file patch.c
+ *
+ *  @brief streaming decoder for compressed and differential firmware
+ *  images, see patch.h for the stream layout. Output is staged in a
+ *  small RAM buffer and programmed through the PatchTarget callbacks;
+ *  LZ4 back references into data that has already been programmed are
+ *  read back from flash, so no window has to be kept in RAM.
+ *
+ */
+
+#include "patch.h"
+
+enum {
+  PH_HEADER,
+  PH_OP,
+  PH_CLEN,
+  PH_RAW,
+  PH_LZ_TOKEN,
+  PH_LZ_LITLEN,
+  PH_LZ_LIT,
+  PH_LZ_OFFSET,
+  PH_LZ_MATCHLEN,
+  PH_DONE
+};
+
+static u32 getLE32(const u8 *p) {
+  return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+static u8 patchFail(PatchState *st, u8 status) {
+  if (st->status == PATCH_OK) {
+    st->status = status;
+  }
+  return st->status;
+}
+
+static bool patchIsBoundary(PatchState *st, u32 off) {
+  const PatchTarget *t = st->tgt;
+  return off == 0 || t->unitEnd(t->origin + off - 1) == t->origin + off;
+}
+
+/* program the RAM buffer, erasing the units it lands on first */
+static bool patchFlush(PatchState *st) {
+  const PatchTarget *t = st->tgt;
+  u8 *buf = (u8*)st->buf;
+  u32 len = st->bufFill;
+
+  while (len & 3) {
+    buf[len++] = 0xFF;
+  }
+  if (len == 0) {
+    return TRUE;
+  }
+
+  while (st->erasedEnd < st->bufStart + len) {
+    u32 next = t->eraseUnit(t->origin + st->erasedEnd);
+    if (!next) {
+      patchFail(st, PATCH_ERR_ERASE);
+      return FALSE;
+    }
+    st->erasedEnd = next - t->origin;
+  }
+
+  if (!t->program(t->origin + st->bufStart, buf, len)) {
+    patchFail(st, PATCH_ERR_PROG);
+    return FALSE;
+  }
+
+  st->bufStart = st->out;
+  st->bufFill = 0;
+  return TRUE;
+}
+
+static bool patchPut(PatchState *st, u8 c) {
+  if (st->opLeft == 0 || st->out >= st->imageLen) {
+    patchFail(st, PATCH_ERR_FILE);
+    return FALSE;
+  }
+  ((u8*)st->buf)[st->bufFill++] = c;
+  st->out++;
+  st->opLeft--;
+
+  if (st->bufFill == PATCH_BUF_SIZE) {
+    return patchFlush(st);
+  }
+  return TRUE;
+}
+
+/* output byte at off, either still buffered or already in flash */
+static u8 patchPeek(PatchState *st, u32 off) {
+  if (off >= st->bufStart) {
+    return ((u8*)st->buf)[off - st->bufStart];
+  }
+  return st->tgt->mem[off];
+}
+
+static void patchHeader(PatchState *st) {
+  const PatchTarget *t = st->tgt;
+  u8 *f = st->field;
+
+  st->imageLen = getLE32(f + 8);
+  st->imageCrc = getLE32(f + 12);
+  st->baseLen  = getLE32(f + 16);
+
+  if (getLE32(f) != PATCH_MAGIC || getLE32(f + 4) != PATCH_VERSION ||
+      st->imageLen == 0 || (st->imageLen & 3) || (st->baseLen & 3)) {
+    patchFail(st, PATCH_ERR_FILE);
+    return;
+  }
+
+  /* everything below writes imageLen and reads baseLen bytes of flash */
+  if (st->imageLen > t->size || st->baseLen > t->size) {
+    patchFail(st, PATCH_ERR_ADDRESS);
+    return;
+  }
+
+  /* the installed image has to be the one the delta was made against */
+  if (st->baseLen && t->crc(t->mem, st->baseLen) != getLE32(f + 20)) {
+    patchFail(st, PATCH_ERR_TARGET);
+    return;
+  }
+  st->phase = PH_OP;
+}
+
+static void patchOp(PatchState *st) {
+  u32 end;
+
+  st->op = st->field[0];
+  st->opLeft = getLE32(st->field + 1);
+
+  switch (st->op) {
+  case PATCH_OP_END:
+    st->phase = PH_DONE;
+    break;
+
+  case PATCH_OP_KEEP:
+    /* must sit on whole erase units, nothing here gets erased */
+    end = st->out + st->opLeft;
+    if (!patchFlush(st)) {
+      return;
+    }
+    if (st->erasedEnd != st->out || end > st->baseLen || end > st->imageLen ||
+        (end != st->imageLen && !patchIsBoundary(st, end))) {
+      patchFail(st, PATCH_ERR_FILE);
+      return;
+    }
+    st->out = end;
+    st->erasedEnd = end;
+    st->bufStart = end;
+    st->opLeft = 0;
+    break;
+
+  case PATCH_OP_RAW:
+    st->phase = st->opLeft ? PH_RAW : PH_OP;
+    break;
+
+  case PATCH_OP_LZ4:
+    st->phase = PH_CLEN;
+    break;
+
+  default:
+    patchFail(st, PATCH_ERR_FILE);
+    break;
+  }
+}
+
+/* end of a literal run: either the block is done or an offset follows */
+static void patchLzLiteralsDone(PatchState *st) {
+  if (st->inLeft) {
+    st->phase = PH_LZ_OFFSET;
+  } else if (st->opLeft) {
+    patchFail(st, PATCH_ERR_FILE);
+  } else {
+    st->phase = PH_OP;
+  }
+}
+
+static void patchLzMatch(PatchState *st) {
+  while (st->lzLen-- > 0) {
+    if (!patchPut(st, patchPeek(st, st->out - st->lzOffset))) {
+      return;
+    }
+  }
+  st->lzLen = 0;
+  if (st->inLeft) {
+    st->phase = PH_LZ_TOKEN;
+  } else if (st->opLeft) {
+    patchFail(st, PATCH_ERR_FILE);
+  } else {
+    st->phase = PH_OP;
+  }
+}
+
+void patchBegin(PatchState *st, const PatchTarget *tgt) {
+  st->tgt = tgt;
+  st->phase = PH_HEADER;
+  st->status = PATCH_OK;
+  st->fill = 0;
+  st->opLeft = 0;
+  st->inLeft = 0;
+  st->out = 0;
+  st->erasedEnd = 0;
+  st->bufStart = 0;
+  st->bufFill = 0;
+}
+
+bool patchIsPatch(const u8 *data, u32 len) {
+  return len >= PATCH_HEADER_SIZE && getLE32(data) == PATCH_MAGIC;
+}
+
+u8 patchFeed(PatchState *st, const u8 *data, u32 len) {
+  while (len-- > 0 && st->status == PATCH_OK) {
+    u8 c = *data++;
+
+    if (st->phase >= PH_LZ_TOKEN && st->phase <= PH_LZ_MATCHLEN) {
+      st->inLeft--;
+    }
+
+    switch (st->phase) {
+    case PH_HEADER:
+      st->field[st->fill++] = c;
+      if (st->fill == PATCH_HEADER_SIZE) {
+        st->fill = 0;
+        patchHeader(st);
+      }
+      break;
+
+    case PH_OP:
+      st->field[st->fill++] = c;
+      if (st->fill == 5) {
+        st->fill = 0;
+        patchOp(st);
+      }
+      break;
+
+    case PH_CLEN:
+      st->field[st->fill++] = c;
+      if (st->fill == 4) {
+        st->fill = 0;
+        st->inLeft = getLE32(st->field);
+        if (st->inLeft) {
+          st->phase = PH_LZ_TOKEN;
+        } else if (st->opLeft) {
+          patchFail(st, PATCH_ERR_FILE);
+        } else {
+          st->phase = PH_OP;
+        }
+      }
+      break;
+
+    case PH_RAW:
+      if (patchPut(st, c) && st->opLeft == 0) {
+        st->phase = PH_OP;
+      }
+      break;
+
+    case PH_LZ_TOKEN:
+      st->field[0] = c;
+      st->lzLen = c >> 4;
+      if (st->lzLen == 15) {
+        st->phase = PH_LZ_LITLEN;
+      } else if (st->lzLen) {
+        st->phase = PH_LZ_LIT;
+      } else {
+        patchLzLiteralsDone(st);
+      }
+      break;
+
+    case PH_LZ_LITLEN:
+      st->lzLen += c;
+      if (c != 255) {
+        if (st->lzLen) {
+          st->phase = PH_LZ_LIT;
+        } else {
+          patchLzLiteralsDone(st);
+        }
+      }
+      break;
+
+    case PH_LZ_LIT:
+      if (patchPut(st, c) && --st->lzLen == 0) {
+        patchLzLiteralsDone(st);
+      }
+      break;
+
+    case PH_LZ_OFFSET:
+      st->field[1 + st->fill++] = c;
+      if (st->fill == 2) {
+        st->fill = 0;
+        st->lzOffset = st->field[1] | ((u32)st->field[2] << 8);
+        if (st->lzOffset == 0 || st->lzOffset > st->out) {
+          patchFail(st, PATCH_ERR_FILE);
+          break;
+        }
+        st->lzLen = (st->field[0] & 0x0F) + 4;
+        if ((st->field[0] & 0x0F) == 15) {
+          st->phase = PH_LZ_MATCHLEN;
+        } else {
+          patchLzMatch(st);
+        }
+      }
+      break;
+
+    case PH_LZ_MATCHLEN:
+      st->lzLen += c;
+      if (c != 255) {
+        patchLzMatch(st);
+      }
+      break;
+
+    case PH_DONE:
+      /* padding after the end record is ignored */
+      break;
+    }
+  }
+  return st->status;
+}
+
+u8 patchFinish(PatchState *st) {
+  const PatchTarget *t = st->tgt;
+
+  if (st->status != PATCH_OK) {
+    return st->status;
+  }
+  if (st->phase != PH_DONE) {
+    return patchFail(st, PATCH_ERR_FILE);
+  }
+  if (!patchFlush(st)) {
+    return st->status;
+  }
+  if (st->out != st->imageLen) {
+    return patchFail(st, PATCH_ERR_FILE);
+  }
+  /* read back what actually landed in flash */
+  if (t->crc(t->mem, st->imageLen) != st->imageCrc) {
+    return patchFail(st, PATCH_ERR_VERIFY);
+  }
+  return PATCH_OK;
+}
@@ -0,0 +1,120 @@
+/* *****************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2012 openstm32sw project.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ****************************************************************************/
+
+/**
+ *  @file patch.h
+ *
+ *  @brief streaming decoder for compressed and differential firmware
+ *  images. Independent of the hardware so it can be exercised on a host
+ *  against image files (see host/patchsim.c and flash/mkpatch.py).
+ *
+ */
+
+#ifndef __PATCH_H
+#define __PATCH_H
+
+#ifdef PATCH_HOST
+#include <stdint.h>
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef enum {FALSE = 0, TRUE = !FALSE} bool;
+#else
+#include "stm32f10x_type.h"
+#endif
+
+/* Patch stream layout, all fields little endian:
+ *
+ *   header  u32 magic, version, imageLen, imageCrc, baseLen, baseCrc
+ *   records u8 op, u32 len, then op specific data:
+ *     PATCH_OP_KEEP  len bytes equal to the installed image, not rewritten
+ *     PATCH_OP_RAW   len literal bytes
+ *     PATCH_OP_LZ4   u32 clen, then an LZ4 block of clen bytes that
+ *                    expands to len bytes
+ *     PATCH_OP_END   len is 0, ends the stream
+ *
+ * CRCs are the STM32 CRC unit's CRC-32 (poly 0x04C11DB7, init
+ * 0xFFFFFFFF, 32-bit words, no reflection) over the image padded to a
+ * multiple of 4 bytes.  A baseLen of 0 means no installed image is
+ * needed.  KEEP ranges must start and end on erase unit boundaries
+ * (or at the end of the image), since erasing a unit loses all of it.
+ */
+#define PATCH_MAGIC        0x5441504D  /* "MPAT" */
+#define PATCH_VERSION      1
+#define PATCH_HEADER_SIZE  24
+
+#define PATCH_OP_END       0
+#define PATCH_OP_KEEP      1
+#define PATCH_OP_RAW       2
+#define PATCH_OP_LZ4       3
+
+/* status codes, numerically the same as the DFU status values */
+#define PATCH_OK           0x00
+#define PATCH_ERR_TARGET   0x01  /* installed image does not match baseCrc */
+#define PATCH_ERR_FILE     0x02  /* malformed stream */
+#define PATCH_ERR_ERASE    0x04
+#define PATCH_ERR_PROG     0x06
+#define PATCH_ERR_VERIFY   0x07  /* result does not match imageCrc */
+#define PATCH_ERR_ADDRESS  0x08  /* image or base larger than the target */
+
+/* bytes buffered in RAM before they are programmed */
+#define PATCH_BUF_SIZE     256
+
+typedef struct _PatchTarget {
+  u32 origin;                   /* flash address of the image's first byte */
+  const u8 *mem;                /* where origin can be read from */
+  u32 size;                     /* bytes from origin the image may use */
+  u32  (*eraseUnit)(u32 addr);  /* erase the unit at addr, return its end or 0 */
+  u32  (*unitEnd)(u32 addr);    /* end address of the unit containing addr */
+  bool (*program)(u32 addr, const u8 *data, u32 len); /* len % 4 == 0 */
+  u32  (*crc)(const u8 *data, u32 len);              /* len % 4 == 0 */
+} PatchTarget;
+
+typedef struct _PatchState {
+  const PatchTarget *tgt;
+  u8  phase;
+  u8  status;
+  u8  op;
+  u8  fill;             /* bytes collected into field */
+  u8  field[PATCH_HEADER_SIZE];
+  u32 imageLen;
+  u32 imageCrc;
+  u32 baseLen;
+  u32 opLeft;           /* output bytes left in the current record */
+  u32 inLeft;           /* compressed input bytes left (LZ4) */
+  u32 lzLen;            /* pending literal or match length */
+  u32 lzOffset;
+  u32 out;              /* output offset */
+  u32 erasedEnd;        /* output offset past the last erased unit */
+  u32 bufStart;         /* output offset of buf[0] */
+  u32 bufFill;
+  u32 buf[PATCH_BUF_SIZE / 4];
+} PatchState;
+
+bool patchIsPatch(const u8 *data, u32 len);
+void patchBegin  (PatchState *st, const PatchTarget *tgt);
+u8   patchFeed   (PatchState *st, const u8 *data, u32 len);
+u8   patchFinish (PatchState *st);
+
+#endif